@@ -0,0 +1,156 @@
+#include "bitset_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/bitset.h>
+#include <defines.h>
+#include <threads/kthread.h>
+
+u8 bitset_should_set_clear_and_test(void) {
+    bitset set;
+    expect_to_be_true(bitset_create(130, 0, &set));
+    expect_should_be(3, set.word_count);
+    expect_should_be(0, bitset_popcount(&set));
+
+    bitset_set(&set, 0);
+    bitset_set(&set, 63);
+    bitset_set(&set, 64);
+    bitset_set(&set, 129);
+    expect_to_be_true(bitset_test(&set, 0));
+    expect_to_be_true(bitset_test(&set, 63));
+    expect_to_be_true(bitset_test(&set, 64));
+    expect_to_be_true(bitset_test(&set, 129));
+    expect_to_be_false(bitset_test(&set, 1));
+    expect_to_be_false(bitset_test(&set, 128));
+    expect_should_be(4, bitset_popcount(&set));
+
+    bitset_clear(&set, 63);
+    expect_to_be_false(bitset_test(&set, 63));
+    expect_should_be(3, bitset_popcount(&set));
+
+    // Atomic versions report the previous state.
+    expect_to_be_false(bitset_set_atomic(&set, 100));
+    expect_to_be_true(bitset_set_atomic(&set, 100));
+    expect_to_be_true(bitset_test_atomic(&set, 100));
+    expect_to_be_true(bitset_clear_atomic(&set, 100));
+    expect_to_be_false(bitset_clear_atomic(&set, 100));
+
+    // Setting all must not touch the unused bits of the last word.
+    bitset_set_all(&set);
+    expect_should_be(130, bitset_popcount(&set));
+    bitset_clear_all(&set);
+    expect_should_be(0, bitset_popcount(&set));
+
+    bitset_destroy(&set);
+    return true;
+}
+
+u8 bitset_should_find_first(void) {
+    u64 memory[4];
+    bitset set;
+    expect_to_be_true(bitset_create(200, memory, &set));
+
+    u32 index = 0;
+    expect_to_be_false(bitset_find_first_set(&set, 0, &index));
+    expect_to_be_true(bitset_find_first_clear(&set, 0, &index));
+    expect_should_be(0, index);
+
+    bitset_set(&set, 70);
+    bitset_set(&set, 150);
+    expect_to_be_true(bitset_find_first_set(&set, 0, &index));
+    expect_should_be(70, index);
+    expect_to_be_true(bitset_find_first_set(&set, 70, &index));
+    expect_should_be(70, index);
+    expect_to_be_true(bitset_find_first_set(&set, 71, &index));
+    expect_should_be(150, index);
+    expect_to_be_false(bitset_find_first_set(&set, 151, &index));
+    expect_to_be_false(bitset_find_first_set(&set, 500, &index));
+
+    // Every bit set but one.
+    bitset_set_all(&set);
+    bitset_clear(&set, 131);
+    expect_to_be_true(bitset_find_first_clear(&set, 5, &index));
+    expect_should_be(131, index);
+    bitset_set(&set, 131);
+    // The unused bits past 200 must not be reported as clear.
+    expect_to_be_false(bitset_find_first_clear(&set, 0, &index));
+
+    bitset_destroy(&set);
+    return true;
+}
+
+u8 bitset_should_iterate_set_bits(void) {
+    bitset set;
+    expect_to_be_true(bitset_create(1000, 0, &set));
+
+    bitset_iterator empty = bitset_iterator_begin(&set);
+    u32 index = 0;
+    expect_to_be_false(bitset_iterator_next(&empty, &index));
+
+    for (u32 i = 0; i < 1000; i += 7) {
+        bitset_set(&set, i);
+    }
+    bitset_set(&set, 999);
+
+    bitset_iterator it = bitset_iterator_begin(&set);
+    u32 expected = 0;
+    u32 count = 0;
+    while (bitset_iterator_next(&it, &index)) {
+        expect_should_be(expected, index);
+        count++;
+        expected += 7;
+        if (expected >= 1000) {
+            expected = 999;
+        }
+    }
+    expect_should_be(bitset_popcount(&set), count);
+    expect_to_be_false(bitset_iterator_next(&it, &index));
+
+    bitset_destroy(&set);
+    return true;
+}
+
+typedef struct bitset_thread_params {
+    bitset* set;
+    u32 offset;
+    u32 stride;
+} bitset_thread_params;
+
+static u32 bitset_setter_thread(void* params) {
+    bitset_thread_params* p = params;
+    for (u32 i = p->offset; i < p->set->bit_count; i += p->stride) {
+        bitset_set_atomic(p->set, i);
+    }
+    return 0;
+}
+
+u8 bitset_atomic_should_not_lose_bits(void) {
+    bitset set;
+    expect_to_be_true(bitset_create(40000, 0, &set));
+
+    // Each thread sets interleaved bits, so all of them write to every word.
+    const u32 thread_count = 4;
+    kthread threads[4];
+    bitset_thread_params params[4];
+    for (u32 i = 0; i < thread_count; ++i) {
+        params[i].set = &set;
+        params[i].offset = i;
+        params[i].stride = thread_count;
+        expect_to_be_true(kthread_create(bitset_setter_thread, &params[i], false, &threads[i]));
+    }
+    for (u32 i = 0; i < thread_count; ++i) {
+        kthread_wait(&threads[i]);
+    }
+
+    expect_should_be(40000, bitset_popcount(&set));
+
+    bitset_destroy(&set);
+    return true;
+}
+
+void bitset_register_tests(void) {
+    test_manager_register_test(bitset_should_set_clear_and_test, "bitset should set, clear and test bits");
+    test_manager_register_test(bitset_should_find_first, "bitset should find first set and clear bits");
+    test_manager_register_test(bitset_should_iterate_set_bits, "bitset should iterate set bits in order");
+    test_manager_register_test(bitset_atomic_should_not_lose_bits, "bitset atomic operations should not lose bits");
+}
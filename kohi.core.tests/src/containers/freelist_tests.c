@@ -409,6 +409,144 @@ u8 freelist_multiple_alloc_and_free_random(void) {
     return true;
 }
 
+u8 freelist_should_allocate_aligned(void) {
+    freelist list;
+
+    // Get the memory requirement
+    u64 memory_requirement = 0;
+    u64 total_size = 1024;
+    freelist_create(total_size, &memory_requirement, 0, 0);
+
+    // Allocate and create the freelist.
+    void* block = kallocate(memory_requirement, MEMORY_TAG_ENGINE);
+    freelist_create(total_size, &memory_requirement, block, &list);
+
+    // Knock the next free offset off of any useful alignment.
+    u64 offset = INVALID_ID;
+    b8 result = freelist_allocate_block(&list, 10, &offset);
+    expect_to_be_true(result);
+    expect_should_be(0, offset);
+
+    // The aligned block should skip ahead, leaving the skipped space free.
+    u64 offset2 = INVALID_ID;
+    result = freelist_allocate_block_aligned(&list, 100, 256, &offset2);
+    expect_to_be_true(result);
+    expect_should_be(256, offset2);
+    expect_should_be(total_size - 110, freelist_free_space(&list));
+    expect_should_be(2, freelist_free_block_count(&list));
+
+    // The skipped space should be usable by a block which fits in it.
+    u64 offset3 = INVALID_ID;
+    result = freelist_allocate_block_aligned(&list, 64, 16, &offset3);
+    expect_to_be_true(result);
+    expect_should_be(16, offset3);
+
+    // Non-power-of-two alignments are rejected.
+    u64 offset4 = INVALID_ID;
+    KDEBUG("The following error message is intentional.");
+    result = freelist_allocate_block_aligned(&list, 16, 24, &offset4);
+    expect_to_be_false(result);
+
+    // Free everything, which should join back into a single block.
+    expect_to_be_true(freelist_free_block(&list, 10, offset));
+    expect_to_be_true(freelist_free_block(&list, 100, offset2));
+    expect_to_be_true(freelist_free_block(&list, 64, offset3));
+    expect_should_be(total_size, freelist_free_space(&list));
+    expect_should_be(1, freelist_free_block_count(&list));
+    expect_should_be(total_size, freelist_largest_free_block(&list));
+
+    freelist_destroy(&list);
+    kfree(block, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+u8 freelist_should_report_fragmentation(void) {
+    freelist list;
+
+    // Get the memory requirement
+    u64 memory_requirement = 0;
+    u64 total_size = 1024;
+    freelist_create(total_size, &memory_requirement, 0, 0);
+
+    // Allocate and create the freelist.
+    void* block = kallocate(memory_requirement, MEMORY_TAG_ENGINE);
+    freelist_create(total_size, &memory_requirement, block, &list);
+
+    // Fill entirely with 64 byte blocks.
+    u64 offsets[16];
+    for (u32 i = 0; i < 16; ++i) {
+        expect_to_be_true(freelist_allocate_block(&list, 64, &offsets[i]));
+    }
+    expect_should_be(0, freelist_free_block_count(&list));
+    expect_should_be(0, freelist_largest_free_block(&list));
+
+    // Free every other block, leaving 8 separate holes.
+    for (u32 i = 0; i < 16; i += 2) {
+        expect_to_be_true(freelist_free_block(&list, 64, offsets[i]));
+    }
+    expect_should_be(8, freelist_free_block_count(&list));
+    expect_should_be(64, freelist_largest_free_block(&list));
+    expect_should_be(512, freelist_free_space(&list));
+
+    // Can't fit anything bigger than a hole, despite there being enough space overall.
+    u64 offset = INVALID_ID;
+    KDEBUG("The following warning message is intentional.");
+    expect_to_be_false(freelist_allocate_block(&list, 128, &offset));
+
+    // Freeing a block between two holes joins all three.
+    expect_to_be_true(freelist_free_block(&list, 64, offsets[1]));
+    expect_should_be(7, freelist_free_block_count(&list));
+    expect_should_be(192, freelist_largest_free_block(&list));
+
+    freelist_destroy(&list);
+    kfree(block, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+u8 freelist_should_resize(void) {
+    freelist list;
+
+    // Get the memory requirement
+    u64 memory_requirement = 0;
+    u64 total_size = 512;
+    freelist_create(total_size, &memory_requirement, 0, 0);
+
+    // Allocate and create the freelist.
+    void* block = kallocate(memory_requirement, MEMORY_TAG_ENGINE);
+    freelist_create(total_size, &memory_requirement, block, &list);
+
+    // Leave a hole in the middle, and allocate up to the end.
+    u64 offsets[3];
+    expect_to_be_true(freelist_allocate_block(&list, 128, &offsets[0]));
+    expect_to_be_true(freelist_allocate_block(&list, 128, &offsets[1]));
+    expect_to_be_true(freelist_allocate_block(&list, 256, &offsets[2]));
+    expect_to_be_true(freelist_free_block(&list, 128, offsets[1]));
+
+    // Resize.
+    u64 new_size = 2048;
+    u64 new_memory_requirement = 0;
+    expect_to_be_true(freelist_resize(&list, &new_memory_requirement, 0, new_size, 0));
+    void* new_block = kallocate(new_memory_requirement, MEMORY_TAG_ENGINE);
+    void* old_block = 0;
+    expect_to_be_true(freelist_resize(&list, &new_memory_requirement, new_block, new_size, &old_block));
+    expect_should_be(block, old_block);
+    kfree(old_block, memory_requirement, MEMORY_TAG_ENGINE);
+
+    // The hole remains, and the new space is added at the end.
+    expect_should_be(new_size - 384, freelist_free_space(&list));
+    expect_should_be(2, freelist_free_block_count(&list));
+    expect_should_be(new_size - 512, freelist_largest_free_block(&list));
+
+    // Freeing the last block should join the hole and the new space.
+    expect_to_be_true(freelist_free_block(&list, 256, offsets[2]));
+    expect_should_be(1, freelist_free_block_count(&list));
+    expect_should_be(new_size - 128, freelist_largest_free_block(&list));
+
+    freelist_destroy(&list);
+    kfree(new_block, new_memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
 void freelist_register_tests(void) {
     test_manager_register_test(freelist_should_create_and_destroy, "Freelist should create and destroy");
     test_manager_register_test(freelist_should_allocate_one_and_free_one, "Freelist allocate and free one entry.");
@@ -416,4 +554,7 @@ void freelist_register_tests(void) {
     test_manager_register_test(freelist_should_allocate_one_and_free_multi_varying_sizes, "Freelist allocate and free multiple entries of varying sizes.");
     test_manager_register_test(freelist_should_allocate_to_full_and_fail_to_allocate_more, "Freelist allocate to full and fail when trying to allocate more.");
     test_manager_register_test(freelist_multiple_alloc_and_free_random, "Freelist should randomly allocate and free.");
+    test_manager_register_test(freelist_should_allocate_aligned, "Freelist should allocate aligned blocks.");
+    test_manager_register_test(freelist_should_report_fragmentation, "Freelist should report fragmentation.");
+    test_manager_register_test(freelist_should_resize, "Freelist should resize.");
 }
@@ -0,0 +1,153 @@
+#include "mpmc_queue_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/mpmc_queue.h>
+#include <defines.h>
+#include <threads/katomic.h>
+#include <threads/kthread.h>
+
+u8 mpmc_queue_should_enqueue_and_dequeue_in_order(void) {
+    mpmc_queue queue;
+    expect_to_be_true(mpmc_queue_create(sizeof(u32), 8, 0, &queue));
+    expect_should_be(0, mpmc_queue_length(&queue));
+
+    u32 value = 0;
+    expect_to_be_false(mpmc_queue_dequeue(&queue, &value));
+
+    // Go around the ring a few times.
+    u32 next_in = 0;
+    u32 next_out = 0;
+    for (u32 lap = 0; lap < 4; ++lap) {
+        for (u32 i = 0; i < 8; ++i) {
+            expect_to_be_true(mpmc_queue_enqueue(&queue, &next_in));
+            next_in++;
+        }
+        expect_should_be(8, mpmc_queue_length(&queue));
+        // Full now.
+        expect_to_be_false(mpmc_queue_enqueue(&queue, &next_in));
+
+        for (u32 i = 0; i < 8; ++i) {
+            expect_to_be_true(mpmc_queue_dequeue(&queue, &value));
+            expect_should_be(next_out, value);
+            next_out++;
+        }
+        expect_to_be_false(mpmc_queue_dequeue(&queue, &value));
+    }
+
+    mpmc_queue_destroy(&queue);
+    expect_should_be(0, queue.block);
+    return true;
+}
+
+u8 mpmc_queue_should_reject_bad_capacity(void) {
+    mpmc_queue queue;
+    // Not a power of two.
+    expect_to_be_false(mpmc_queue_create(sizeof(u32), 12, 0, &queue));
+    expect_to_be_false(mpmc_queue_create(sizeof(u32), 1, 0, &queue));
+    expect_to_be_false(mpmc_queue_create(0, 16, 0, &queue));
+    return true;
+}
+
+#define MPMC_PRODUCER_COUNT 4
+#define MPMC_CONSUMER_COUNT 4
+#define MPMC_ITEMS_PER_PRODUCER 50000
+
+typedef struct mpmc_stress_state {
+    mpmc_queue queue;
+    // The number of times each item was received, indexed by producer then sequence.
+    u32* received;
+    // The total number of items received across all consumers.
+    u32 received_count;
+} mpmc_stress_state;
+
+typedef struct mpmc_stress_params {
+    mpmc_stress_state* state;
+    u32 index;
+    b8 success;
+} mpmc_stress_params;
+
+static u32 mpmc_producer(void* params) {
+    mpmc_stress_params* p = params;
+    for (u32 i = 0; i < MPMC_ITEMS_PER_PRODUCER; ++i) {
+        u64 item = ((u64)p->index << 32) | i;
+        while (!mpmc_queue_enqueue(&p->state->queue, &item)) {
+            kthread_yield();
+        }
+    }
+    p->success = true;
+    return 0;
+}
+
+static u32 mpmc_consumer(void* params) {
+    mpmc_stress_params* p = params;
+    p->success = true;
+    // Items from any one producer must arrive in the order they were sent.
+    i64 last_seen[MPMC_PRODUCER_COUNT];
+    for (u32 i = 0; i < MPMC_PRODUCER_COUNT; ++i) {
+        last_seen[i] = -1;
+    }
+    const u32 total = MPMC_PRODUCER_COUNT * MPMC_ITEMS_PER_PRODUCER;
+    while (katomic_load_u32(&p->state->received_count) < total) {
+        u64 item;
+        if (!mpmc_queue_dequeue(&p->state->queue, &item)) {
+            kthread_yield();
+            continue;
+        }
+        u32 producer = (u32)(item >> 32);
+        u32 sequence = (u32)item;
+        if (producer >= MPMC_PRODUCER_COUNT || (i64)sequence <= last_seen[producer]) {
+            p->success = false;
+        } else {
+            last_seen[producer] = sequence;
+            katomic_fetch_add_u32(&p->state->received[(producer * MPMC_ITEMS_PER_PRODUCER) + sequence], 1);
+        }
+        katomic_fetch_add_u32(&p->state->received_count, 1);
+    }
+    return 0;
+}
+
+u8 mpmc_queue_stress_many_producers_many_consumers(void) {
+    static u32 received[MPMC_PRODUCER_COUNT * MPMC_ITEMS_PER_PRODUCER];
+    static mpmc_stress_state state;
+    // Small, so that producers frequently find it full and consumers frequently find it empty.
+    expect_to_be_true(mpmc_queue_create(sizeof(u64), 64, 0, &state.queue));
+    state.received = received;
+    state.received_count = 0;
+
+    kthread producers[MPMC_PRODUCER_COUNT];
+    kthread consumers[MPMC_CONSUMER_COUNT];
+    mpmc_stress_params producer_params[MPMC_PRODUCER_COUNT];
+    mpmc_stress_params consumer_params[MPMC_CONSUMER_COUNT];
+    for (u32 i = 0; i < MPMC_CONSUMER_COUNT; ++i) {
+        consumer_params[i] = (mpmc_stress_params){&state, i, false};
+        expect_to_be_true(kthread_create(mpmc_consumer, &consumer_params[i], false, &consumers[i]));
+    }
+    for (u32 i = 0; i < MPMC_PRODUCER_COUNT; ++i) {
+        producer_params[i] = (mpmc_stress_params){&state, i, false};
+        expect_to_be_true(kthread_create(mpmc_producer, &producer_params[i], false, &producers[i]));
+    }
+    for (u32 i = 0; i < MPMC_PRODUCER_COUNT; ++i) {
+        kthread_wait(&producers[i]);
+        expect_to_be_true(producer_params[i].success);
+    }
+    for (u32 i = 0; i < MPMC_CONSUMER_COUNT; ++i) {
+        kthread_wait(&consumers[i]);
+        expect_to_be_true(consumer_params[i].success);
+    }
+
+    // Every item should have been received exactly once.
+    for (u32 i = 0; i < MPMC_PRODUCER_COUNT * MPMC_ITEMS_PER_PRODUCER; ++i) {
+        expect_should_be(1, received[i]);
+    }
+    expect_should_be(0, mpmc_queue_length(&state.queue));
+
+    mpmc_queue_destroy(&state.queue);
+    return true;
+}
+
+void mpmc_queue_register_tests(void) {
+    test_manager_register_test(mpmc_queue_should_enqueue_and_dequeue_in_order, "mpmc_queue should enqueue and dequeue in order");
+    test_manager_register_test(mpmc_queue_should_reject_bad_capacity, "mpmc_queue should reject bad capacity");
+    test_manager_register_test(mpmc_queue_stress_many_producers_many_consumers, "mpmc_queue stress test with many producers and consumers");
+}
@@ -0,0 +1,116 @@
+#include "mpsc_queue_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/mpsc_queue.h>
+#include <defines.h>
+#include <threads/kthread.h>
+
+typedef struct mpsc_test_item {
+    mpsc_queue_node node;
+    u32 producer;
+    u32 value;
+} mpsc_test_item;
+
+u8 mpsc_queue_should_take_all_in_push_order(void) {
+    mpsc_queue queue = {0};
+    expect_to_be_true(mpsc_queue_is_empty(&queue));
+    expect_should_be(0, mpsc_queue_take_all(&queue));
+
+    mpsc_test_item items[5] = {0};
+    for (u32 i = 0; i < 3; ++i) {
+        items[i].value = i;
+        mpsc_queue_push(&queue, &items[i].node);
+    }
+    expect_to_be_false(mpsc_queue_is_empty(&queue));
+
+    mpsc_queue_node* node = mpsc_queue_take_all(&queue);
+    expect_to_be_true(mpsc_queue_is_empty(&queue));
+    for (u32 i = 0; i < 3; ++i) {
+        expect_should_not_be(0, node);
+        expect_should_be(i, ((mpsc_test_item*)node)->value);
+        node = node->next;
+    }
+    expect_should_be(0, node);
+
+    // Items taken may be pushed again.
+    for (u32 i = 0; i < 5; ++i) {
+        items[i].value = 10 + i;
+        mpsc_queue_push(&queue, &items[i].node);
+    }
+    u32 count = 0;
+    for (node = mpsc_queue_take_all(&queue); node; node = node->next) {
+        expect_should_be(10 + count, ((mpsc_test_item*)node)->value);
+        count++;
+    }
+    expect_should_be(5, count);
+    expect_to_be_true(mpsc_queue_is_empty(&queue));
+
+    return true;
+}
+
+#define MPSC_PRODUCER_COUNT 4
+#define MPSC_ITEMS_PER_PRODUCER 50000
+
+typedef struct mpsc_stress_params {
+    mpsc_queue* queue;
+    mpsc_test_item* items;
+    u32 producer;
+} mpsc_stress_params;
+
+static u32 mpsc_producer(void* params) {
+    mpsc_stress_params* p = params;
+    for (u32 i = 0; i < MPSC_ITEMS_PER_PRODUCER; ++i) {
+        p->items[i].producer = p->producer;
+        p->items[i].value = i;
+        mpsc_queue_push(p->queue, &p->items[i].node);
+        if ((i % 1000) == 0) {
+            kthread_yield();
+        }
+    }
+    return 0;
+}
+
+u8 mpsc_queue_stress_producers_consumer(void) {
+    mpsc_queue queue = {0};
+    static mpsc_test_item items[MPSC_PRODUCER_COUNT][MPSC_ITEMS_PER_PRODUCER];
+    mpsc_stress_params params[MPSC_PRODUCER_COUNT];
+    kthread producers[MPSC_PRODUCER_COUNT];
+    for (u32 i = 0; i < MPSC_PRODUCER_COUNT; ++i) {
+        params[i] = (mpsc_stress_params){&queue, items[i], i};
+        expect_to_be_true(kthread_create(mpsc_producer, &params[i], false, &producers[i]));
+    }
+
+    // Take items while the producers run. Nothing may be lost, and each producer's items
+    // must arrive in the order it pushed them.
+    u32 next_expected[MPSC_PRODUCER_COUNT] = {0};
+    u32 total = 0;
+    b8 in_order = true;
+    while (total < MPSC_PRODUCER_COUNT * MPSC_ITEMS_PER_PRODUCER) {
+        mpsc_queue_node* node = mpsc_queue_take_all(&queue);
+        if (!node) {
+            kthread_yield();
+            continue;
+        }
+        for (; node; node = node->next) {
+            mpsc_test_item* item = (mpsc_test_item*)node;
+            if (item->value != next_expected[item->producer]) {
+                in_order = false;
+            }
+            next_expected[item->producer] = item->value + 1;
+            total++;
+        }
+    }
+
+    for (u32 i = 0; i < MPSC_PRODUCER_COUNT; ++i) {
+        kthread_wait(&producers[i]);
+    }
+    expect_to_be_true(in_order);
+    expect_to_be_true(mpsc_queue_is_empty(&queue));
+    return true;
+}
+
+void mpsc_queue_register_tests(void) {
+    test_manager_register_test(mpsc_queue_should_take_all_in_push_order, "mpsc_queue should take all in push order");
+    test_manager_register_test(mpsc_queue_stress_producers_consumer, "mpsc_queue stress test with several producers and a consumer");
+}
@@ -0,0 +1,132 @@
+#include "slot_map_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/slot_map.h>
+#include <defines.h>
+#include <identifiers/khandle.h>
+
+typedef struct slot_map_test_element {
+    u32 value;
+    f32 other;
+} slot_map_test_element;
+
+u8 slot_map_should_acquire_and_get(void) {
+    slot_map map;
+    expect_to_be_true(slot_map_create(sizeof(slot_map_test_element), 0, &map));
+
+    khandle handles[100];
+    for (u32 i = 0; i < 100; ++i) {
+        slot_map_test_element* e = slot_map_acquire(&map, &handles[i]);
+        expect_should_not_be(0, e);
+        // New elements are zeroed.
+        expect_should_be(0, e->value);
+        e->value = i * 3;
+    }
+    expect_should_be(100, slot_map_count(&map));
+
+    for (u32 i = 0; i < 100; ++i) {
+        slot_map_test_element* e = slot_map_get(&map, handles[i]);
+        expect_should_not_be(0, e);
+        expect_should_be(i * 3, e->value);
+        expect_to_be_true(slot_map_contains(&map, handles[i]));
+    }
+
+    expect_should_be(0, slot_map_get(&map, khandle_invalid()));
+
+    slot_map_destroy(&map);
+    return true;
+}
+
+u8 slot_map_should_detect_stale_handles(void) {
+    slot_map map;
+    expect_to_be_true(slot_map_create(sizeof(slot_map_test_element), 4, &map));
+
+    khandle first;
+    slot_map_test_element* e = slot_map_acquire(&map, &first);
+    e->value = 1;
+
+    expect_to_be_true(slot_map_release(&map, first));
+    expect_to_be_false(slot_map_contains(&map, first));
+    expect_should_be(0, slot_map_get(&map, first));
+    // Releasing twice does nothing.
+    expect_to_be_false(slot_map_release(&map, first));
+    expect_should_be(0, slot_map_count(&map));
+
+    // The slot is reused, but the old handle must not see the new element.
+    khandle second;
+    e = slot_map_acquire(&map, &second);
+    e->value = 2;
+    expect_should_be(first.handle_index, second.handle_index);
+    expect_should_not_be(first.unique_id.uniqueid, second.unique_id.uniqueid);
+    expect_should_be(0, slot_map_get(&map, first));
+    e = slot_map_get(&map, second);
+    expect_should_not_be(0, e);
+    expect_should_be(2, e->value);
+
+    // Clearing makes everything stale.
+    slot_map_clear(&map);
+    expect_should_be(0, slot_map_count(&map));
+    expect_should_be(0, slot_map_get(&map, second));
+
+    slot_map_destroy(&map);
+    return true;
+}
+
+u8 slot_map_should_keep_elements_dense(void) {
+    slot_map map;
+    expect_to_be_true(slot_map_create(sizeof(slot_map_test_element), 0, &map));
+
+    khandle handles[64];
+    for (u32 i = 0; i < 64; ++i) {
+        slot_map_test_element* e = slot_map_acquire(&map, &handles[i]);
+        e->value = i;
+    }
+
+    // Release every odd element.
+    for (u32 i = 1; i < 64; i += 2) {
+        expect_to_be_true(slot_map_release(&map, handles[i]));
+    }
+    expect_should_be(32, slot_map_count(&map));
+
+    // Every even element is still present exactly once in the dense array, and
+    // the handle at each position refers back to the same element.
+    slot_map_test_element* elements = slot_map_elements(&map);
+    u32 seen = 0;
+    for (u32 i = 0; i < slot_map_count(&map); ++i) {
+        expect_should_be(0, elements[i].value % 2);
+        seen += elements[i].value;
+        khandle h = slot_map_handle_at(&map, i);
+        expect_should_be(&elements[i], slot_map_get(&map, h));
+    }
+    // 0 + 2 + ... + 62
+    expect_should_be(992, seen);
+
+    for (u32 i = 0; i < 64; i += 2) {
+        slot_map_test_element* e = slot_map_get(&map, handles[i]);
+        expect_should_not_be(0, e);
+        expect_should_be(i, e->value);
+    }
+
+    // Reacquiring reuses the released slots rather than growing.
+    u32 slot_count = map.slot_count;
+    for (u32 i = 1; i < 64; i += 2) {
+        slot_map_test_element* e = slot_map_acquire(&map, &handles[i]);
+        e->value = i;
+    }
+    expect_should_be(slot_count, map.slot_count);
+    for (u32 i = 0; i < 64; ++i) {
+        slot_map_test_element* e = slot_map_get(&map, handles[i]);
+        expect_should_not_be(0, e);
+        expect_should_be(i, e->value);
+    }
+
+    slot_map_destroy(&map);
+    return true;
+}
+
+void slot_map_register_tests(void) {
+    test_manager_register_test(slot_map_should_acquire_and_get, "slot_map should acquire and get elements");
+    test_manager_register_test(slot_map_should_detect_stale_handles, "slot_map should detect stale handles");
+    test_manager_register_test(slot_map_should_keep_elements_dense, "slot_map should keep elements dense");
+}
@@ -0,0 +1,98 @@
+#include "spsc_queue_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/spsc_queue.h>
+#include <defines.h>
+#include <threads/katomic.h>
+#include <threads/kthread.h>
+
+u8 spsc_queue_should_enqueue_and_dequeue_in_order(void) {
+    spsc_queue queue;
+    expect_to_be_true(spsc_queue_create(sizeof(u32), 4, 0, &queue));
+
+    u32 value = 0;
+    expect_to_be_false(spsc_queue_dequeue(&queue, &value));
+
+    u32 next_in = 0;
+    u32 next_out = 0;
+    for (u32 lap = 0; lap < 4; ++lap) {
+        for (u32 i = 0; i < 4; ++i) {
+            expect_to_be_true(spsc_queue_enqueue(&queue, &next_in));
+            next_in++;
+        }
+        expect_should_be(4, spsc_queue_length(&queue));
+        expect_to_be_false(spsc_queue_enqueue(&queue, &next_in));
+
+        for (u32 i = 0; i < 4; ++i) {
+            expect_to_be_true(spsc_queue_dequeue(&queue, &value));
+            expect_should_be(next_out, value);
+            next_out++;
+        }
+        expect_to_be_false(spsc_queue_dequeue(&queue, &value));
+    }
+
+    spsc_queue_destroy(&queue);
+    expect_should_be(0, queue.block);
+    return true;
+}
+
+#define SPSC_ITEM_COUNT 500000
+
+typedef struct spsc_stress_params {
+    spsc_queue* queue;
+    b8 success;
+} spsc_stress_params;
+
+static u32 spsc_producer(void* params) {
+    spsc_stress_params* p = params;
+    for (u64 i = 0; i < SPSC_ITEM_COUNT; ++i) {
+        while (!spsc_queue_enqueue(p->queue, &i)) {
+            kthread_yield();
+        }
+    }
+    p->success = true;
+    return 0;
+}
+
+static u32 spsc_consumer(void* params) {
+    spsc_stress_params* p = params;
+    p->success = true;
+    for (u64 expected = 0; expected < SPSC_ITEM_COUNT;) {
+        u64 item;
+        if (!spsc_queue_dequeue(p->queue, &item)) {
+            kthread_yield();
+            continue;
+        }
+        if (item != expected) {
+            p->success = false;
+        }
+        expected++;
+    }
+    return 0;
+}
+
+u8 spsc_queue_stress_producer_consumer(void) {
+    spsc_queue queue;
+    expect_to_be_true(spsc_queue_create(sizeof(u64), 256, 0, &queue));
+
+    spsc_stress_params producer_params = {&queue, false};
+    spsc_stress_params consumer_params = {&queue, false};
+    kthread producer;
+    kthread consumer;
+    expect_to_be_true(kthread_create(spsc_consumer, &consumer_params, false, &consumer));
+    expect_to_be_true(kthread_create(spsc_producer, &producer_params, false, &producer));
+    kthread_wait(&producer);
+    kthread_wait(&consumer);
+    expect_to_be_true(producer_params.success);
+    expect_to_be_true(consumer_params.success);
+    expect_should_be(0, spsc_queue_length(&queue));
+
+    spsc_queue_destroy(&queue);
+    return true;
+}
+
+void spsc_queue_register_tests(void) {
+    test_manager_register_test(spsc_queue_should_enqueue_and_dequeue_in_order, "spsc_queue should enqueue and dequeue in order");
+    test_manager_register_test(spsc_queue_stress_producer_consumer, "spsc_queue stress test with a producer and consumer");
+}
@@ -0,0 +1,180 @@
+#include "u64_hashmap_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/u64_hashmap.h>
+#include <defines.h>
+
+u8 u64_hashmap_should_create_and_destroy(void) {
+    u64_hashmap map;
+    expect_to_be_true(u64_hashmap_create(sizeof(u32), 100, &map));
+
+    expect_should_be(0, map.count);
+    expect_should_be(sizeof(u32), map.element_size);
+    // Capacity is a power of two large enough to hold 100 entries below the max load factor.
+    expect_should_be(128, map.capacity);
+
+    u64_hashmap_destroy(&map);
+    expect_should_be(0, map.distances);
+    expect_should_be(0, map.capacity);
+
+    return true;
+}
+
+u8 u64_hashmap_should_set_get_and_replace(void) {
+    u64_hashmap map;
+    u64_hashmap_create(sizeof(u64), 0, &map);
+
+    u64 value = 23;
+    expect_to_be_true(u64_hashmap_set(&map, 1, &value));
+    value = 42;
+    expect_to_be_true(u64_hashmap_set(&map, 2, &value));
+    expect_should_be(2, map.count);
+
+    u64 result = 0;
+    expect_to_be_true(u64_hashmap_get(&map, 1, &result));
+    expect_should_be(23, result);
+    expect_to_be_true(u64_hashmap_get(&map, 2, &result));
+    expect_should_be(42, result);
+    expect_to_be_false(u64_hashmap_get(&map, 3, &result));
+    expect_to_be_false(u64_hashmap_contains(&map, 3));
+    expect_should_be(0, u64_hashmap_get_ptr(&map, 3));
+
+    // Setting an existing key replaces the value without adding an entry.
+    value = 99;
+    u64_hashmap_set(&map, 1, &value);
+    expect_should_be(2, map.count);
+    u64* ptr = u64_hashmap_get_ptr(&map, 1);
+    expect_should_not_be(0, ptr);
+    expect_should_be(99, *ptr);
+
+    u64_hashmap_destroy(&map);
+    return true;
+}
+
+u8 u64_hashmap_should_not_overwrite_colliding_keys(void) {
+    u64_hashmap map;
+    u64_hashmap_create(sizeof(u32), 0, &map);
+
+    // Keys which only differ above the capacity would share a slot if the key
+    // were simply reduced modulo the capacity.
+    for (u32 i = 0; i < 6; ++i) {
+        u64 key = (u64)i << 32;
+        u64_hashmap_set(&map, key, &i);
+    }
+    expect_should_be(6, map.count);
+    for (u32 i = 0; i < 6; ++i) {
+        u32 result = INVALID_ID;
+        expect_to_be_true(u64_hashmap_get(&map, (u64)i << 32, &result));
+        expect_should_be(i, result);
+    }
+
+    u64_hashmap_destroy(&map);
+    return true;
+}
+
+u8 u64_hashmap_should_grow(void) {
+    u64_hashmap map;
+    u64_hashmap_create(sizeof(u64), 0, &map);
+    expect_should_be(U64_HASHMAP_MIN_CAPACITY, map.capacity);
+
+    const u32 count = 10000;
+    for (u64 i = 0; i < count; ++i) {
+        u64 key = i * 0x9E3779B97F4A7C15ULL;
+        u64 value = i * 3;
+        expect_to_be_true(u64_hashmap_set(&map, key, &value));
+    }
+    expect_should_be(count, map.count);
+
+    u64_hashmap_stats stats;
+    u64_hashmap_stats_get(&map, &stats);
+    expect_should_be(count, stats.count);
+    expect_should_be(map.capacity, stats.capacity);
+    b8 load_within_limit = stats.load_factor <= U64_HASHMAP_MAX_LOAD_FACTOR;
+    expect_to_be_true(load_within_limit);
+    b8 probes_short = stats.average_probe_length < 4.0f;
+    expect_to_be_true(probes_short);
+    b8 max_at_least_average = (f32)stats.max_probe_length >= stats.average_probe_length;
+    expect_to_be_true(max_at_least_average);
+
+    for (u64 i = 0; i < count; ++i) {
+        u64 result = 0;
+        expect_to_be_true(u64_hashmap_get(&map, i * 0x9E3779B97F4A7C15ULL, &result));
+        expect_should_be(i * 3, result);
+    }
+
+    u64_hashmap_destroy(&map);
+    return true;
+}
+
+u8 u64_hashmap_should_remove(void) {
+    u64_hashmap map;
+    u64_hashmap_create(sizeof(u32), 64, &map);
+
+    for (u32 i = 0; i < 50; ++i) {
+        u64_hashmap_set(&map, i, &i);
+    }
+
+    // Remove every other entry, and ensure the entries shifted back are still found.
+    for (u32 i = 0; i < 50; i += 2) {
+        u32 removed = INVALID_ID;
+        expect_to_be_true(u64_hashmap_remove(&map, i, &removed));
+        expect_should_be(i, removed);
+    }
+    expect_should_be(25, map.count);
+    expect_to_be_false(u64_hashmap_remove(&map, 0, 0));
+
+    for (u32 i = 0; i < 50; ++i) {
+        u32 result = INVALID_ID;
+        b8 found = u64_hashmap_get(&map, i, &result);
+        if (i % 2) {
+            expect_to_be_true(found);
+            expect_should_be(i, result);
+        } else {
+            expect_to_be_false(found);
+        }
+    }
+
+    u64_hashmap_clear(&map);
+    expect_should_be(0, map.count);
+    expect_to_be_false(u64_hashmap_contains(&map, 1));
+
+    u64_hashmap_destroy(&map);
+    return true;
+}
+
+u8 u64_hashmap_should_iterate(void) {
+    u64_hashmap map;
+    u64_hashmap_create(sizeof(u32), 0, &map);
+
+    u64 key_sum = 0;
+    for (u32 i = 1; i <= 20; ++i) {
+        u64_hashmap_set(&map, i, &i);
+        key_sum += i;
+    }
+
+    u32 iterator = 0;
+    u64 key = 0;
+    void* value = 0;
+    u32 visited = 0;
+    u64 visited_key_sum = 0;
+    while (u64_hashmap_iterate(&map, &iterator, &key, &value)) {
+        expect_should_be(key, *(u32*)value);
+        visited_key_sum += key;
+        visited++;
+    }
+    expect_should_be(20, visited);
+    expect_should_be(key_sum, visited_key_sum);
+
+    u64_hashmap_destroy(&map);
+    return true;
+}
+
+void u64_hashmap_register_tests(void) {
+    test_manager_register_test(u64_hashmap_should_create_and_destroy, "u64_hashmap should create and destroy");
+    test_manager_register_test(u64_hashmap_should_set_get_and_replace, "u64_hashmap should set, get and replace values");
+    test_manager_register_test(u64_hashmap_should_not_overwrite_colliding_keys, "u64_hashmap should not overwrite colliding keys");
+    test_manager_register_test(u64_hashmap_should_grow, "u64_hashmap should grow and keep probes short");
+    test_manager_register_test(u64_hashmap_should_remove, "u64_hashmap should remove entries");
+    test_manager_register_test(u64_hashmap_should_iterate, "u64_hashmap should iterate all entries");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void u64_hashmap_register_tests(void);
@@ -0,0 +1,129 @@
+#include "ws_deque_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/ws_deque.h>
+#include <defines.h>
+#include <memory/kmemory.h>
+#include <threads/katomic.h>
+#include <threads/kthread.h>
+
+u8 ws_deque_owner_should_pop_in_reverse(void) {
+    ws_deque deque;
+    expect_to_be_true(ws_deque_create(4, 0, &deque));
+
+    u64 value = 0;
+    expect_to_be_false(ws_deque_pop(&deque, &value));
+    expect_to_be_false(ws_deque_steal(&deque, &value));
+
+    for (u64 i = 0; i < 4; ++i) {
+        expect_to_be_true(ws_deque_push(&deque, i));
+    }
+    // Full.
+    expect_to_be_false(ws_deque_push(&deque, 99));
+    expect_should_be(4, ws_deque_length(&deque));
+
+    // The owner takes the newest, thieves take the oldest.
+    expect_to_be_true(ws_deque_pop(&deque, &value));
+    expect_should_be(3, value);
+    expect_to_be_true(ws_deque_steal(&deque, &value));
+    expect_should_be(0, value);
+    expect_to_be_true(ws_deque_pop(&deque, &value));
+    expect_should_be(2, value);
+    expect_to_be_true(ws_deque_pop(&deque, &value));
+    expect_should_be(1, value);
+    expect_to_be_false(ws_deque_pop(&deque, &value));
+    expect_should_be(0, ws_deque_length(&deque));
+
+    // Wrap around the ring a few times.
+    for (u64 lap = 0; lap < 10; ++lap) {
+        expect_to_be_true(ws_deque_push(&deque, lap));
+        expect_to_be_true(ws_deque_push(&deque, lap + 100));
+        expect_to_be_true(ws_deque_steal(&deque, &value));
+        expect_should_be(lap, value);
+        expect_to_be_true(ws_deque_pop(&deque, &value));
+        expect_should_be(lap + 100, value);
+    }
+
+    ws_deque_destroy(&deque);
+    return true;
+}
+
+#define WS_DEQUE_STRESS_ITEMS 100000
+#define WS_DEQUE_THIEF_COUNT 3
+
+typedef struct ws_deque_stress_state {
+    ws_deque deque;
+    u32 done;
+    // Number of times each value was taken.
+    u8 taken[WS_DEQUE_STRESS_ITEMS];
+} ws_deque_stress_state;
+
+static u32 ws_deque_thief(void* params) {
+    ws_deque_stress_state* state = params;
+    u64 value;
+    while (true) {
+        if (ws_deque_steal(&state->deque, &value)) {
+            state->taken[value]++;
+        } else if (katomic_load_u32(&state->done)) {
+            // One last look, as the owner may have pushed more before finishing.
+            if (!ws_deque_steal(&state->deque, &value)) {
+                break;
+            }
+            state->taken[value]++;
+        } else {
+            kthread_yield();
+        }
+    }
+    return 0;
+}
+
+u8 ws_deque_stress_owner_and_thieves(void) {
+    static ws_deque_stress_state state;
+    kzero_memory(&state, sizeof(ws_deque_stress_state));
+    expect_to_be_true(ws_deque_create(256, 0, &state.deque));
+
+    kthread thieves[WS_DEQUE_THIEF_COUNT];
+    for (u32 i = 0; i < WS_DEQUE_THIEF_COUNT; ++i) {
+        expect_to_be_true(kthread_create(ws_deque_thief, &state, false, &thieves[i]));
+    }
+
+    // The owner pushes everything, popping some back itself along the way.
+    u64 next = 0;
+    u64 value;
+    while (next < WS_DEQUE_STRESS_ITEMS) {
+        if (ws_deque_push(&state.deque, next)) {
+            ++next;
+        } else {
+            kthread_yield();
+        }
+        if ((next % 3) == 0 && ws_deque_pop(&state.deque, &value)) {
+            state.taken[value]++;
+        }
+    }
+    while (ws_deque_pop(&state.deque, &value)) {
+        state.taken[value]++;
+    }
+    katomic_store_u32(&state.done, 1);
+
+    for (u32 i = 0; i < WS_DEQUE_THIEF_COUNT; ++i) {
+        kthread_wait(&thieves[i]);
+    }
+
+    // Every value must have been taken exactly once.
+    u32 wrong = 0;
+    for (u32 i = 0; i < WS_DEQUE_STRESS_ITEMS; ++i) {
+        if (state.taken[i] != 1) {
+            wrong++;
+        }
+    }
+    expect_should_be(0, wrong);
+
+    ws_deque_destroy(&state.deque);
+    return true;
+}
+
+void ws_deque_register_tests(void) {
+    test_manager_register_test(ws_deque_owner_should_pop_in_reverse, "ws_deque owner should pop newest and thieves steal oldest");
+    test_manager_register_test(ws_deque_stress_owner_and_thieves, "ws_deque stress test with an owner and thieves");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void ws_deque_register_tests(void);
@@ -1,15 +1,31 @@
 #include <logger.h>
 
 #include "containers/array_tests.h"
+#include "containers/bitset_tests.h"
 #include "containers/darray_tests.h"
 #include "containers/freelist_tests.h"
 #include "containers/hashtable_tests.h"
+#include "containers/mpmc_queue_tests.h"
+#include "containers/mpsc_queue_tests.h"
+#include "containers/slot_map_tests.h"
+#include "containers/spsc_queue_tests.h"
 #include "containers/stackarray_tests.h"
+#include "containers/u64_hashmap_tests.h"
+#include "containers/ws_deque_tests.h"
 #include "memory/dynamic_allocator_tests.h"
+#include "memory/kmemory_tests.h"
 #include "memory/linear_allocator_tests.h"
+#include "memory/slab_allocator_tests.h"
 #include "parsers/kson_parser_tests.h"
+#include "platform/async_io_tests.h"
+#include "platform/filesystem_tests.h"
+#include "platform/kpackage_tests.h"
+#include "strings/kname_tests.h"
 #include "strings/string_tests.h"
 #include "test_manager.h"
+#include "threads/job_system_tests.h"
+#include "utils/klz_tests.h"
+#include "utils/ksort_tests.h"
 
 int main(void) {
     // Always initalize the test manager first.
@@ -17,14 +33,30 @@ int main(void) {
 
     // TODO: add test registrations here.
     string_register_tests();
+    kname_register_tests();
     array_register_tests();
     darray_register_tests();
     stackarray_register_tests();
     kson_parser_register_tests();
     linear_allocator_register_tests();
     hashtable_register_tests();
+    u64_hashmap_register_tests();
+    mpmc_queue_register_tests();
+    mpsc_queue_register_tests();
+    spsc_queue_register_tests();
+    slot_map_register_tests();
+    bitset_register_tests();
+    ws_deque_register_tests();
     freelist_register_tests();
     dynamic_allocator_register_tests();
+    slab_allocator_register_tests();
+    kmemory_register_tests();
+    ksort_register_tests();
+    job_system_register_tests();
+    filesystem_register_tests();
+    async_io_register_tests();
+    kpackage_register_tests();
+    klz_register_tests();
     string_register_tests();
 
     KDEBUG("Starting tests...");
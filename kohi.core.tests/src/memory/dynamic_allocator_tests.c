@@ -6,6 +6,7 @@
 
 #include <memory/allocators/dynamic_allocator.h>
 #include <memory/kmemory.h>
+#include <platform/platform.h>
 
 u8 dynamic_allocator_should_create_and_destroy(void) {
     dynamic_allocator alloc;
@@ -33,9 +34,8 @@ u8 dynamic_allocator_single_allocation_all_space(void) {
     dynamic_allocator alloc;
     u64 memory_requirement = 0;
     const u64 allocator_size = 1024;
-    const u64 alignment = 1;
     // Total size needed, including headers.
-    const u64 total_allocator_size = allocator_size + (dynamic_allocator_header_size() + alignment);
+    const u64 total_allocator_size = allocator_size + dynamic_allocator_header_size();
     // Get the memory requirement
     b8 result = dynamic_allocator_create(total_allocator_size, &memory_requirement, 0, 0);
     expect_to_be_true(result);
@@ -75,8 +75,7 @@ u8 dynamic_allocator_multi_allocation_all_space(void) {
     u64 memory_requirement = 0;
 
     const u64 allocator_size = 1024;
-    const u64 alignment = 1;
-    u64 header_size = (dynamic_allocator_header_size() + alignment);
+    u64 header_size = dynamic_allocator_header_size();
     // Total size needed, including headers.
     const u64 total_allocator_size = allocator_size + (header_size * 3);
 
@@ -149,8 +148,7 @@ u8 dynamic_allocator_multi_allocation_over_allocate(void) {
     u64 memory_requirement = 0;
 
     const u64 allocator_size = 1024;
-    const u64 alignment = 1;
-    u64 header_size = (dynamic_allocator_header_size() + alignment);
+    u64 header_size = dynamic_allocator_header_size();
     // Total size needed, including headers.
     const u64 total_allocator_size = allocator_size + (header_size * 3);
 
@@ -211,8 +209,7 @@ u8 dynamic_allocator_multi_allocation_most_space_request_too_big(void) {
     u64 memory_requirement = 0;
 
     const u64 allocator_size = 1024;
-    const u64 alignment = 1;
-    u64 header_size = (dynamic_allocator_header_size() + alignment);
+    u64 header_size = dynamic_allocator_header_size();
     // Total size needed, including headers.
     const u64 total_allocator_size = allocator_size + (header_size * 3);
 
@@ -274,7 +271,7 @@ u8 dynamic_allocator_single_alloc_aligned(void) {
     const u64 allocator_size = 1024;
     const u64 alignment = 16;
     // Total size needed, including headers.
-    const u64 total_allocator_size = allocator_size + (dynamic_allocator_header_size() + alignment);
+    const u64 total_allocator_size = allocator_size + dynamic_allocator_header_size();
     // Get the memory requirement
     b8 result = dynamic_allocator_create(total_allocator_size, &memory_requirement, 0, 0);
     expect_to_be_true(result);
@@ -368,7 +365,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         expect_should_be(alloc_datas[idx].size, block_size);
 
         // Track it.
-        currently_allocated += (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated += (alloc_datas[idx].size + header_size);
 
         // Verify free space
         free_space = dynamic_allocator_free_space(&alloc);
@@ -390,7 +387,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         expect_should_be(alloc_datas[idx].size, block_size);
 
         // Track it.
-        currently_allocated += (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated += (alloc_datas[idx].size + header_size);
 
         // Verify free space
         free_space = dynamic_allocator_free_space(&alloc);
@@ -412,7 +409,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         expect_should_be(alloc_datas[idx].size, block_size);
 
         // Track it.
-        currently_allocated += (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated += (alloc_datas[idx].size + header_size);
 
         // Verify free space
         free_space = dynamic_allocator_free_space(&alloc);
@@ -434,7 +431,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         expect_should_be(alloc_datas[idx].size, block_size);
 
         // Track it.
-        currently_allocated += (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated += (alloc_datas[idx].size + header_size);
 
         // Verify free space
         free_space = dynamic_allocator_free_space(&alloc);
@@ -448,7 +445,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         u32 idx = 1;
         dynamic_allocator_free_aligned(&alloc, alloc_datas[idx].block);
         alloc_datas[idx].block = 0;
-        currently_allocated -= (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated -= (alloc_datas[idx].size + header_size);
 
         // Verify free space.
         free_space = dynamic_allocator_free_space(&alloc);
@@ -459,7 +456,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         u32 idx = 3;
         dynamic_allocator_free_aligned(&alloc, alloc_datas[idx].block);
         alloc_datas[idx].block = 0;
-        currently_allocated -= (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated -= (alloc_datas[idx].size + header_size);
 
         // Verify free space.
         free_space = dynamic_allocator_free_space(&alloc);
@@ -471,7 +468,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         u32 idx = 2;
         dynamic_allocator_free_aligned(&alloc, alloc_datas[idx].block);
         alloc_datas[idx].block = 0;
-        currently_allocated -= (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated -= (alloc_datas[idx].size + header_size);
 
         // Verify free space.
         free_space = dynamic_allocator_free_space(&alloc);
@@ -483,7 +480,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         u32 idx = 0;
         dynamic_allocator_free_aligned(&alloc, alloc_datas[idx].block);
         alloc_datas[idx].block = 0;
-        currently_allocated -= (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated -= (alloc_datas[idx].size + header_size);
 
         // Verify free space.
         free_space = dynamic_allocator_free_space(&alloc);
@@ -500,6 +497,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
 u8 util_allocate(dynamic_allocator* allocator, alloc_data* data, u64* currently_allocated, u64 header_size, u64 total_allocator_size) {
     data->block = dynamic_allocator_allocate_aligned(allocator, data->size, data->alignment);
     expect_should_not_be(0, data->block);
+    expect_should_be(0, ((u64)data->block & (data->alignment - 1)));
 
     // Verify size and alignment
     u64 block_size;
@@ -510,7 +508,7 @@ u8 util_allocate(dynamic_allocator* allocator, alloc_data* data, u64* currently_
     expect_should_be(data->size, block_size);
 
     // Track it.
-    *currently_allocated += (data->size + header_size + data->alignment);
+    *currently_allocated += (data->size + header_size);
 
     // Verify free space
     u64 free_space = dynamic_allocator_free_space(allocator);
@@ -525,7 +523,7 @@ u8 util_free(dynamic_allocator* allocator, alloc_data* data, u64* currently_allo
         return false;
     }
     data->block = 0;
-    *currently_allocated -= (data->size + header_size + data->alignment);
+    *currently_allocated -= (data->size + header_size);
 
     // Verify free space.
     u64 free_space = dynamic_allocator_free_space(allocator);
@@ -701,6 +699,65 @@ u8 dynamic_allocator_multiple_alloc_and_free_aligned_different_alignments_random
     return true;
 }
 
+u8 dynamic_allocator_reserved_commit_and_trim(void) {
+    dynamic_allocator alloc;
+    u64 memory_requirement = 0;
+    const u64 total_size = MEBIBYTES(64);
+    const u64 granularity = KIBIBYTES(64);
+    expect_to_be_true(dynamic_allocator_create_reserved(total_size, granularity, platform_memory_commit, platform_memory_decommit, &memory_requirement, 0, 0));
+
+    void* memory = platform_memory_reserve(memory_requirement, false);
+    expect_should_not_be(0, memory);
+    expect_to_be_true(dynamic_allocator_create_reserved(total_size, granularity, platform_memory_commit, platform_memory_decommit, &memory_requirement, memory, &alloc));
+
+    // Nothing is committed until it is needed.
+    expect_should_be(0, dynamic_allocator_committed_space(&alloc));
+    expect_should_be(total_size, dynamic_allocator_free_space(&alloc));
+
+    // Allocations commit as they go, and must be writable across their whole size.
+    const u32 block_count = 8;
+    const u64 block_size = MEBIBYTES(1);
+    void* blocks[8];
+    for (u32 i = 0; i < block_count; ++i) {
+        blocks[i] = dynamic_allocator_allocate_aligned(&alloc, block_size, 16);
+        expect_should_not_be(0, blocks[i]);
+        kset_memory(blocks[i], 0xCD, block_size);
+    }
+    u64 committed = dynamic_allocator_committed_space(&alloc);
+    b8 committed_enough = committed >= block_count * block_size;
+    b8 committed_too_much = committed > block_count * (block_size + granularity);
+    expect_to_be_true(committed_enough);
+    expect_to_be_false(committed_too_much);
+
+    // Nothing can be trimmed while the last block is live.
+    expect_should_be(0, dynamic_allocator_trim(&alloc));
+
+    // Free the back half, which should then be able to be trimmed.
+    for (u32 i = block_count / 2; i < block_count; ++i) {
+        expect_to_be_true(dynamic_allocator_free_aligned(&alloc, blocks[i]));
+    }
+    u64 trimmed = dynamic_allocator_trim(&alloc);
+    b8 trimmed_enough = trimmed >= (block_count / 2 - 1) * block_size;
+    expect_to_be_true(trimmed_enough);
+    expect_should_be(committed - trimmed, dynamic_allocator_committed_space(&alloc));
+
+    // Allocating again should recommit.
+    blocks[block_count / 2] = dynamic_allocator_allocate_aligned(&alloc, block_size * 2, 16);
+    expect_should_not_be(0, blocks[block_count / 2]);
+    kset_memory(blocks[block_count / 2], 0xEF, block_size * 2);
+    expect_to_be_true(dynamic_allocator_free_aligned(&alloc, blocks[block_count / 2]));
+
+    for (u32 i = 0; i < block_count / 2; ++i) {
+        expect_to_be_true(dynamic_allocator_free_aligned(&alloc, blocks[i]));
+    }
+    dynamic_allocator_trim(&alloc);
+    expect_should_be(0, dynamic_allocator_committed_space(&alloc));
+
+    dynamic_allocator_destroy(&alloc);
+    platform_memory_release(memory, memory_requirement);
+    return true;
+}
+
 void dynamic_allocator_register_tests(void) {
     test_manager_register_test(dynamic_allocator_should_create_and_destroy, "Dynamic allocator should create and destroy");
     test_manager_register_test(dynamic_allocator_single_allocation_all_space, "Dynamic allocator single alloc for all space");
@@ -711,4 +768,5 @@ void dynamic_allocator_register_tests(void) {
     test_manager_register_test(dynamic_allocator_multiple_alloc_aligned_different_alignments, "Dynamic allocator multiple aligned allocations with different alignments");
     test_manager_register_test(dynamic_allocator_multiple_alloc_aligned_different_alignments_random, "Dynamic allocator multiple aligned allocations with different alignments in random order.");
     test_manager_register_test(dynamic_allocator_multiple_alloc_and_free_aligned_different_alignments_random, "Dynamic allocator randomization test.");
+    test_manager_register_test(dynamic_allocator_reserved_commit_and_trim, "Dynamic allocator over reserved memory should commit and trim");
 }
@@ -0,0 +1,219 @@
+#include "kmemory_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <memory/allocators/slab_allocator.h>
+#include <memory/kmemory.h>
+#include <threads/kthread.h>
+
+#define SMALL_ALLOC_THREAD_COUNT 4
+#define SMALL_ALLOC_ITERATIONS 20000
+#define SMALL_ALLOC_LIVE_COUNT 64
+
+u8 kmemory_small_allocations_should_track_stats(void) {
+    memory_system_configuration config = {0};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    u64 base_count = get_memory_alloc_count();
+
+    // Sizes on either side of the small size class boundaries.
+    const u64 sizes[] = {1, 15, 16, 17, 100, 128, 255, 256, 511, 512, 513, 4096};
+    const u32 size_count = sizeof(sizes) / sizeof(u64);
+    void* blocks[sizeof(sizes) / sizeof(u64)];
+    for (u32 i = 0; i < size_count; ++i) {
+        blocks[i] = kallocate(sizes[i], MEMORY_TAG_ARRAY);
+        expect_should_not_be(0, blocks[i]);
+        // Should be writable over the entire requested size.
+        kset_memory(blocks[i], 0xAB, sizes[i]);
+    }
+    expect_should_be(base_count + size_count, get_memory_alloc_count());
+
+    // Blocks must not overlap.
+    for (u32 i = 0; i < size_count; ++i) {
+        for (u32 j = 0; j < size_count; ++j) {
+            if (i == j) {
+                continue;
+            }
+            b8 overlap = (u8*)blocks[i] < (u8*)blocks[j] + sizes[j] && (u8*)blocks[j] < (u8*)blocks[i] + sizes[i];
+            expect_to_be_false(overlap);
+        }
+    }
+
+    for (u32 i = 0; i < size_count; ++i) {
+        kfree(blocks[i], sizes[i], MEMORY_TAG_ARRAY);
+    }
+    expect_should_be(base_count, get_memory_alloc_count());
+
+    // Blocks freed to the cache should be handed out again, and zeroed.
+    u8* reused = kallocate(64, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, reused);
+    for (u32 i = 0; i < 64; ++i) {
+        expect_should_be(0, reused[i]);
+    }
+    kfree(reused, 64, MEMORY_TAG_ARRAY);
+
+    kmemory_thread_cache_flush();
+    memory_system_shutdown();
+    return true;
+}
+
+typedef struct small_alloc_thread_params {
+    u32 seed;
+    b8 success;
+} small_alloc_thread_params;
+
+static u32 small_alloc_thread(void* params) {
+    small_alloc_thread_params* typed_params = params;
+    void* live[SMALL_ALLOC_LIVE_COUNT] = {0};
+    u64 live_sizes[SMALL_ALLOC_LIVE_COUNT] = {0};
+    u32 state = typed_params->seed;
+    typed_params->success = true;
+
+    for (u32 i = 0; i < SMALL_ALLOC_ITERATIONS; ++i) {
+        // xorshift32, to avoid sharing the global random state between threads.
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        u32 slot = state % SMALL_ALLOC_LIVE_COUNT;
+        if (live[slot]) {
+            // Verify the block was not trampled by another thread before freeing it.
+            u8* bytes = live[slot];
+            for (u64 b = 0; b < live_sizes[slot]; ++b) {
+                if (bytes[b] != (u8)slot) {
+                    typed_params->success = false;
+                }
+            }
+            kfree(live[slot], live_sizes[slot], MEMORY_TAG_JOB);
+            live[slot] = 0;
+        } else {
+            live_sizes[slot] = 1 + (state >> 8) % 600;
+            live[slot] = kallocate(live_sizes[slot], MEMORY_TAG_JOB);
+            kset_memory(live[slot], (u8)slot, live_sizes[slot]);
+        }
+    }
+
+    for (u32 i = 0; i < SMALL_ALLOC_LIVE_COUNT; ++i) {
+        if (live[i]) {
+            kfree(live[i], live_sizes[i], MEMORY_TAG_JOB);
+        }
+    }
+
+    kmemory_thread_cache_flush();
+    return 1;
+}
+
+u8 kmemory_small_allocations_multithreaded(void) {
+    memory_system_configuration config = {0};
+    config.total_alloc_size = MEBIBYTES(64);
+    config.small_alloc_pool_size = MEBIBYTES(1);
+    expect_to_be_true(memory_system_initialize(config));
+
+    u64 base_count = get_memory_alloc_count();
+
+    kthread threads[SMALL_ALLOC_THREAD_COUNT];
+    small_alloc_thread_params params[SMALL_ALLOC_THREAD_COUNT];
+    for (u32 i = 0; i < SMALL_ALLOC_THREAD_COUNT; ++i) {
+        params[i].seed = 0x9E3779B9u * (i + 1);
+        params[i].success = false;
+        expect_to_be_true(kthread_create(small_alloc_thread, &params[i], false, &threads[i]));
+    }
+    for (u32 i = 0; i < SMALL_ALLOC_THREAD_COUNT; ++i) {
+        kthread_wait(&threads[i]);
+        expect_to_be_true(params[i].success);
+    }
+
+    // All allocations made on the threads were freed, so the count should be back where it started.
+    expect_should_be(base_count, get_memory_alloc_count());
+
+    memory_system_shutdown();
+    return true;
+}
+
+u8 kmemory_small_allocations_from_pool(void) {
+    memory_system_configuration config = {0};
+    config.total_alloc_size = MEBIBYTES(16);
+    // Only a single page, so the pool runs out quickly and allocations fall back to the internal allocator.
+    config.small_alloc_pool_size = SLAB_ALLOCATOR_PAGE_SIZE;
+    expect_to_be_true(memory_system_initialize(config));
+
+    u64 base_count = get_memory_alloc_count();
+
+    const u32 block_count = (SLAB_ALLOCATOR_PAGE_SIZE / 64) * 2;
+    void** blocks = kallocate(sizeof(void*) * block_count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < block_count; ++i) {
+        blocks[i] = kallocate(48, MEMORY_TAG_ARRAY);
+        expect_should_not_be(0, blocks[i]);
+        kset_memory(blocks[i], (i32)(i & 0xFF), 48);
+
+        // Pool blocks report their class size, others their requested size.
+        u64 size = 0;
+        u16 alignment = 0;
+        expect_to_be_true(kmemory_get_size_alignment(blocks[i], &size, &alignment));
+        b8 size_valid = size == 48 || size == 64;
+        expect_to_be_true(size_valid);
+    }
+
+    for (u32 i = 0; i < block_count; ++i) {
+        u8* b = blocks[i];
+        expect_should_be((u8)(i & 0xFF), b[47]);
+        kfree(blocks[i], 48, MEMORY_TAG_ARRAY);
+    }
+    kfree(blocks, sizeof(void*) * block_count, MEMORY_TAG_ARRAY);
+    expect_should_be(base_count, get_memory_alloc_count());
+
+    kmemory_thread_cache_flush();
+    memory_system_shutdown();
+    return true;
+}
+
+u8 kmemory_virtual_memory_should_trim(void) {
+    memory_system_configuration config = {0};
+    // Far more than will be used, since it is only reserved.
+    config.total_alloc_size = GIBIBYTES(4);
+    config.small_alloc_pool_size = MEBIBYTES(1);
+    config.use_virtual_memory = true;
+    config.use_huge_pages = true;
+    expect_to_be_true(memory_system_initialize(config));
+
+    // Nothing to give back yet.
+    expect_should_be(0, kmemory_trim());
+
+    const u64 block_size = MEBIBYTES(4);
+    void* blocks[4];
+    for (u32 i = 0; i < 4; ++i) {
+        blocks[i] = kallocate(block_size, MEMORY_TAG_ARRAY);
+        expect_should_not_be(0, blocks[i]);
+        kset_memory(blocks[i], 0x5A, block_size);
+    }
+    // Small allocations come from the pool, which is committed up front.
+    void* small = kallocate(64, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, small);
+
+    for (u32 i = 0; i < 4; ++i) {
+        kfree(blocks[i], block_size, MEMORY_TAG_ARRAY);
+    }
+    u64 trimmed = kmemory_trim();
+    b8 trimmed_enough = trimmed >= block_size * 3;
+    expect_to_be_true(trimmed_enough);
+
+    // Should still be able to allocate after trimming.
+    u8* block = kallocate(block_size, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, block);
+    expect_should_be(0, block[block_size - 1]);
+    kfree(block, block_size, MEMORY_TAG_ARRAY);
+    kfree(small, 64, MEMORY_TAG_ARRAY);
+
+    kmemory_thread_cache_flush();
+    memory_system_shutdown();
+    return true;
+}
+
+void kmemory_register_tests(void) {
+    test_manager_register_test(kmemory_small_allocations_should_track_stats, "Memory system small allocations should track stats");
+    test_manager_register_test(kmemory_small_allocations_multithreaded, "Memory system small allocations from multiple threads");
+    test_manager_register_test(kmemory_small_allocations_from_pool, "Memory system small allocations from the small allocation pool");
+    test_manager_register_test(kmemory_virtual_memory_should_trim, "Memory system using virtual memory should commit and trim");
+}
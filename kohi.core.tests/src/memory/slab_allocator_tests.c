@@ -0,0 +1,211 @@
+#include "slab_allocator_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <logger.h>
+#include <memory/allocators/dynamic_allocator.h>
+#include <memory/allocators/slab_allocator.h>
+#include <memory/kmemory.h>
+#include <platform/platform.h>
+
+#define SLAB_BENCHMARK_LIVE_COUNT 1024
+#define SLAB_BENCHMARK_ITERATIONS 200
+
+u8 slab_allocator_should_create_and_destroy(void) {
+    slab_allocator alloc;
+    u64 memory_requirement = 0;
+    // Get the memory requirement
+    b8 result = slab_allocator_create(SLAB_ALLOCATOR_PAGE_SIZE * 4, &memory_requirement, 0, 0);
+    expect_to_be_true(result);
+
+    // Actually create the allocator.
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_ENGINE);
+    result = slab_allocator_create(SLAB_ALLOCATOR_PAGE_SIZE * 4, &memory_requirement, memory, &alloc);
+    expect_to_be_true(result);
+    expect_should_not_be(0, alloc.memory);
+    expect_should_be(SLAB_ALLOCATOR_PAGE_SIZE * 4, slab_allocator_total_space(&alloc));
+    expect_should_be(SLAB_ALLOCATOR_PAGE_SIZE * 4, slab_allocator_free_space(&alloc));
+
+    // Destroy the allocator.
+    slab_allocator_destroy(&alloc);
+    expect_should_be(0, alloc.memory);
+    kfree(memory, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+u8 slab_allocator_should_reject_too_small(void) {
+    u64 memory_requirement = 0;
+    KDEBUG("The following error is intentionally caused by this test.");
+    b8 result = slab_allocator_create(SLAB_ALLOCATOR_PAGE_SIZE - 1, &memory_requirement, 0, 0);
+    expect_to_be_false(result);
+    return true;
+}
+
+u8 slab_allocator_class_sizes(void) {
+    expect_should_be(16, slab_allocator_class_size_get(1));
+    expect_should_be(16, slab_allocator_class_size_get(16));
+    expect_should_be(32, slab_allocator_class_size_get(17));
+    expect_should_be(128, slab_allocator_class_size_get(100));
+    expect_should_be(512, slab_allocator_class_size_get(512));
+    expect_should_be(0, slab_allocator_class_size_get(513));
+    expect_should_be(0, slab_allocator_class_size_get(0));
+    return true;
+}
+
+u8 slab_allocator_allocate_and_free(void) {
+    slab_allocator alloc;
+    u64 memory_requirement = 0;
+    const u64 total_size = SLAB_ALLOCATOR_PAGE_SIZE * 4;
+    slab_allocator_create(total_size, &memory_requirement, 0, 0);
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_ENGINE);
+    expect_to_be_true(slab_allocator_create(total_size, &memory_requirement, memory, &alloc));
+
+    // One allocation per class, each of which should take a page of its own.
+    const u64 sizes[] = {8, 24, 64, 100, 200, 512};
+    const u32 size_count = sizeof(sizes) / sizeof(u64);
+    void* blocks[sizeof(sizes) / sizeof(u64)];
+    u64 used = 0;
+    for (u32 i = 0; i < 4; ++i) {
+        blocks[i] = slab_allocator_allocate(&alloc, sizes[i]);
+        expect_should_not_be(0, blocks[i]);
+        expect_should_be(0, ((u64)blocks[i]) % SLAB_ALLOCATOR_MIN_BLOCK_SIZE);
+        expect_to_be_true(slab_allocator_owns_block(&alloc, blocks[i]));
+        expect_should_be(slab_allocator_class_size_get(sizes[i]), slab_allocator_block_size(&alloc, blocks[i]));
+        used += slab_allocator_class_size_get(sizes[i]);
+        expect_should_be(total_size - used, slab_allocator_free_space(&alloc));
+    }
+
+    // All pages are now assigned, so the remaining classes have nowhere to grow.
+    for (u32 i = 4; i < size_count; ++i) {
+        blocks[i] = slab_allocator_allocate(&alloc, sizes[i]);
+        expect_should_be(0, blocks[i]);
+    }
+
+    // Freed blocks should be handed out again for the same class.
+    expect_to_be_true(slab_allocator_free(&alloc, blocks[2]));
+    void* reused = slab_allocator_allocate(&alloc, 50);
+    expect_should_be(blocks[2], reused);
+
+    // Blocks outside the allocator are rejected.
+    u8 outside = 0;
+    expect_to_be_false(slab_allocator_owns_block(&alloc, &outside));
+    KDEBUG("The following warning is intentionally caused by this test.");
+    expect_to_be_false(slab_allocator_free(&alloc, &outside));
+
+    for (u32 i = 0; i < 4; ++i) {
+        expect_to_be_true(slab_allocator_free(&alloc, blocks[i]));
+    }
+    expect_should_be(total_size, slab_allocator_free_space(&alloc));
+
+    slab_allocator_destroy(&alloc);
+    kfree(memory, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+u8 slab_allocator_exhaust_class(void) {
+    slab_allocator alloc;
+    u64 memory_requirement = 0;
+    const u64 total_size = SLAB_ALLOCATOR_PAGE_SIZE * 2;
+    slab_allocator_create(total_size, &memory_requirement, 0, 0);
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_ENGINE);
+    expect_to_be_true(slab_allocator_create(total_size, &memory_requirement, memory, &alloc));
+
+    // Fill the entire allocator with a single class.
+    const u64 block_count = total_size / 256;
+    void** blocks = kallocate(sizeof(void*) * block_count, MEMORY_TAG_ARRAY);
+    for (u64 i = 0; i < block_count; ++i) {
+        blocks[i] = slab_allocator_allocate(&alloc, 256);
+        expect_should_not_be(0, blocks[i]);
+        // Write the whole block to catch any overlap.
+        kset_memory(blocks[i], (i32)(i & 0xFF), 256);
+    }
+    expect_should_be(0, slab_allocator_free_space(&alloc));
+    expect_should_be(0, slab_allocator_allocate(&alloc, 256));
+
+    for (u64 i = 0; i < block_count; ++i) {
+        u8* b = blocks[i];
+        expect_should_be((u8)(i & 0xFF), b[0]);
+        expect_should_be((u8)(i & 0xFF), b[255]);
+        slab_allocator_free(&alloc, blocks[i]);
+    }
+    expect_should_be(total_size, slab_allocator_free_space(&alloc));
+
+    kfree(blocks, sizeof(void*) * block_count, MEMORY_TAG_ARRAY);
+    slab_allocator_destroy(&alloc);
+    kfree(memory, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+static u64 benchmark_size_get(u32 i) {
+    // Mix of sizes across all classes.
+    return 8 + ((i * 2654435761u) % (SLAB_ALLOCATOR_MAX_BLOCK_SIZE - 8));
+}
+
+u8 slab_allocator_benchmark_against_dynamic_allocator(void) {
+    const u64 total_size = MEBIBYTES(4);
+    void* blocks[SLAB_BENCHMARK_LIVE_COUNT];
+
+    // Dynamic allocator.
+    dynamic_allocator dyn;
+    u64 dyn_requirement = 0;
+    dynamic_allocator_create(total_size, &dyn_requirement, 0, 0);
+    void* dyn_memory = kallocate(dyn_requirement, MEMORY_TAG_ENGINE);
+    expect_to_be_true(dynamic_allocator_create(total_size, &dyn_requirement, dyn_memory, &dyn));
+
+    f64 start = platform_get_absolute_time();
+    for (u32 iter = 0; iter < SLAB_BENCHMARK_ITERATIONS; ++iter) {
+        for (u32 i = 0; i < SLAB_BENCHMARK_LIVE_COUNT; ++i) {
+            blocks[i] = dynamic_allocator_allocate_aligned(&dyn, benchmark_size_get(i + iter), SLAB_ALLOCATOR_MIN_BLOCK_SIZE);
+        }
+        // Free every other block first to interleave free space, then the rest.
+        for (u32 i = 0; i < SLAB_BENCHMARK_LIVE_COUNT; i += 2) {
+            dynamic_allocator_free_aligned(&dyn, blocks[i]);
+        }
+        for (u32 i = 1; i < SLAB_BENCHMARK_LIVE_COUNT; i += 2) {
+            dynamic_allocator_free_aligned(&dyn, blocks[i]);
+        }
+    }
+    f64 dyn_time = platform_get_absolute_time() - start;
+    dynamic_allocator_destroy(&dyn);
+    kfree(dyn_memory, dyn_requirement, MEMORY_TAG_ENGINE);
+
+    // Slab allocator.
+    slab_allocator slab;
+    u64 slab_requirement = 0;
+    slab_allocator_create(total_size, &slab_requirement, 0, 0);
+    void* slab_memory = kallocate(slab_requirement, MEMORY_TAG_ENGINE);
+    expect_to_be_true(slab_allocator_create(total_size, &slab_requirement, slab_memory, &slab));
+
+    start = platform_get_absolute_time();
+    for (u32 iter = 0; iter < SLAB_BENCHMARK_ITERATIONS; ++iter) {
+        for (u32 i = 0; i < SLAB_BENCHMARK_LIVE_COUNT; ++i) {
+            blocks[i] = slab_allocator_allocate(&slab, benchmark_size_get(i + iter));
+        }
+        for (u32 i = 0; i < SLAB_BENCHMARK_LIVE_COUNT; i += 2) {
+            slab_allocator_free(&slab, blocks[i]);
+        }
+        for (u32 i = 1; i < SLAB_BENCHMARK_LIVE_COUNT; i += 2) {
+            slab_allocator_free(&slab, blocks[i]);
+        }
+    }
+    f64 slab_time = platform_get_absolute_time() - start;
+    expect_should_be(total_size, slab_allocator_free_space(&slab));
+    slab_allocator_destroy(&slab);
+    kfree(slab_memory, slab_requirement, MEMORY_TAG_ENGINE);
+
+    u64 op_count = (u64)SLAB_BENCHMARK_ITERATIONS * SLAB_BENCHMARK_LIVE_COUNT;
+    KINFO("Small alloc/free benchmark (%llu pairs): dynamic allocator %.3fms (%.1fns/pair), slab allocator %.3fms (%.1fns/pair)",
+          op_count, dyn_time * 1000.0, (dyn_time * 1e9) / op_count, slab_time * 1000.0, (slab_time * 1e9) / op_count);
+    return true;
+}
+
+void slab_allocator_register_tests(void) {
+    test_manager_register_test(slab_allocator_should_create_and_destroy, "Slab allocator should create and destroy");
+    test_manager_register_test(slab_allocator_should_reject_too_small, "Slab allocator should reject a size smaller than a page");
+    test_manager_register_test(slab_allocator_class_sizes, "Slab allocator class sizes");
+    test_manager_register_test(slab_allocator_allocate_and_free, "Slab allocator allocate and free one block per class");
+    test_manager_register_test(slab_allocator_exhaust_class, "Slab allocator fill entire allocator with one class");
+    test_manager_register_test(slab_allocator_benchmark_against_dynamic_allocator, "Slab allocator benchmark against dynamic allocator");
+}
@@ -0,0 +1,294 @@
+#include "async_io_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+#include <memory/kmemory.h>
+#include <platform/async_io.h>
+#include <platform/filesystem.h>
+#include <platform/platform.h>
+
+#include <stdio.h>
+
+#define ASYNC_IO_TEST_FILE "async_io_test.bin"
+#define ASYNC_IO_TEST_SIZE 3000000
+#define ASYNC_IO_TEST_MISSING_FILE "async_io_test_missing.bin"
+// How long to wait for reads before giving up, in milliseconds.
+#define ASYNC_IO_TEST_TIMEOUT 10000
+
+typedef struct read_record {
+    u32 completed;
+    async_io_result result;
+    u64 size;
+    // The data the read should have produced, not counting any terminator.
+    const u8* expected;
+    u64 expected_size;
+    b8 terminated;
+    u32 mismatches;
+    // The position of this read in the order callbacks were made.
+    u32 order;
+} read_record;
+
+static u64 async_io_memory_requirement = 0;
+static void* async_io_state = 0;
+static u8* test_content = 0;
+static u32 callback_count = 0;
+
+static b8 async_io_start(const async_io_config* config) {
+    async_io_config copy = *config;
+    async_io_system_initialize(&async_io_memory_requirement, 0, &copy);
+    async_io_state = kallocate(async_io_memory_requirement, MEMORY_TAG_PLATFORM);
+    callback_count = 0;
+    return async_io_system_initialize(&async_io_memory_requirement, async_io_state, &copy);
+}
+
+static void async_io_stop(void) {
+    async_io_system_shutdown(async_io_state);
+    kfree(async_io_state, async_io_memory_requirement, MEMORY_TAG_PLATFORM);
+    async_io_state = 0;
+}
+
+static b8 test_file_create(void) {
+    test_content = kallocate(ASYNC_IO_TEST_SIZE, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < ASYNC_IO_TEST_SIZE; ++i) {
+        test_content[i] = (u8)((i * 13) ^ (i >> 9));
+    }
+    return filesystem_write_entire_binary_file(ASYNC_IO_TEST_FILE, ASYNC_IO_TEST_SIZE, test_content);
+}
+
+static void test_file_destroy(void) {
+    remove(ASYNC_IO_TEST_FILE);
+    kfree(test_content, ASYNC_IO_TEST_SIZE, MEMORY_TAG_ARRAY);
+    test_content = 0;
+}
+
+static void on_read(async_io_completion* completion) {
+    read_record* record = completion->context;
+    record->completed++;
+    record->result = completion->result;
+    record->size = completion->size;
+    record->order = callback_count++;
+    if (completion->result == ASYNC_IO_RESULT_SUCCESS && completion->size >= record->expected_size) {
+        const u8* data = completion->data;
+        for (u64 i = 0; i < record->expected_size; ++i) {
+            if (data[i] != record->expected[i]) {
+                record->mismatches++;
+            }
+        }
+        if (record->terminated && data[completion->size - 1] != 0) {
+            record->mismatches++;
+        }
+    }
+}
+
+// Pumps callbacks until the given number have been made, or the timeout passes.
+static b8 callbacks_wait(u32 count) {
+    f64 start = platform_get_absolute_time();
+    while (callback_count < count) {
+        async_io_system_update(async_io_state, 0);
+        if (callback_count >= count) {
+            break;
+        }
+        if ((platform_get_absolute_time() - start) * 1000.0 > ASYNC_IO_TEST_TIMEOUT) {
+            return false;
+        }
+        platform_sleep(1);
+    }
+    return true;
+}
+
+static async_io_read_request read_request(read_record* record, u64 offset, u64 size, async_io_read_flags flags) {
+    async_io_read_request request = {0};
+    request.path = ASYNC_IO_TEST_FILE;
+    request.offset = offset;
+    request.size = size;
+    request.flags = flags;
+    request.callback = on_read;
+    request.context = record;
+    record->expected = test_content + offset;
+    record->expected_size = size ? size : ASYNC_IO_TEST_SIZE - offset;
+    record->terminated = FLAG_GET(flags, ASYNC_IO_READ_FLAG_ZERO_TERMINATE_BIT);
+    return request;
+}
+
+// Reads the test file whole and in part, and reads which should fail, with the given config.
+static b8 reads_should_complete(const async_io_config* config, async_io_backend expected_backend) {
+    expect_to_be_true(test_file_create());
+    expect_to_be_true(async_io_start(config));
+    if (expected_backend == ASYNC_IO_BACKEND_IO_URING && async_io_backend_get() != ASYNC_IO_BACKEND_IO_URING) {
+        KWARN("io_uring is not available here, so the thread pool was tested instead.");
+    } else {
+        expect_should_be(expected_backend, async_io_backend_get());
+    }
+
+    read_record records[5] = {0};
+    async_io_read_request requests[5] = {
+        read_request(&records[0], 0, 0, ASYNC_IO_READ_FLAG_NONE),
+        read_request(&records[1], 12345, 100000, ASYNC_IO_READ_FLAG_ZERO_TERMINATE_BIT),
+        read_request(&records[2], ASYNC_IO_TEST_SIZE - 10, 0, ASYNC_IO_READ_FLAG_ZERO_TERMINATE_BIT),
+        read_request(&records[3], ASYNC_IO_TEST_SIZE - 10, 11, ASYNC_IO_READ_FLAG_NONE),
+        read_request(&records[4], 0, 0, ASYNC_IO_READ_FLAG_NONE),
+    };
+    requests[4].path = ASYNC_IO_TEST_MISSING_FILE;
+    u64 ids[5] = {0};
+    expect_should_be(5, async_io_read_batch(5, requests, ids));
+    for (u32 i = 0; i < 5; ++i) {
+        expect_should_not_be(ASYNC_IO_INVALID_ID, ids[i]);
+    }
+
+    expect_to_be_true(callbacks_wait(5));
+
+    expect_should_be(ASYNC_IO_RESULT_SUCCESS, records[0].result);
+    expect_should_be(ASYNC_IO_TEST_SIZE, records[0].size);
+    expect_should_be(ASYNC_IO_RESULT_SUCCESS, records[1].result);
+    expect_should_be(100001, records[1].size);
+    expect_should_be(ASYNC_IO_RESULT_SUCCESS, records[2].result);
+    expect_should_be(11, records[2].size);
+    // Reads beyond the end of the file fail, rather than coming back short.
+    expect_should_be(ASYNC_IO_RESULT_READ_ERROR, records[3].result);
+    expect_should_be(ASYNC_IO_RESULT_FILE_NOT_FOUND, records[4].result);
+    for (u32 i = 0; i < 5; ++i) {
+        expect_should_be(1, records[i].completed);
+        expect_should_be(0, records[i].mismatches);
+    }
+
+    async_io_stop();
+    test_file_destroy();
+    return true;
+}
+
+u8 async_io_should_read_files_with_thread_pool(void) {
+    async_io_config config = {0};
+    config.disable_io_uring = true;
+    return reads_should_complete(&config, ASYNC_IO_BACKEND_THREAD_POOL);
+}
+
+u8 async_io_should_read_files_with_io_uring(void) {
+    async_io_config config = {0};
+#if KPLATFORM_LINUX
+    return reads_should_complete(&config, ASYNC_IO_BACKEND_IO_URING);
+#else
+    return reads_should_complete(&config, ASYNC_IO_BACKEND_THREAD_POOL);
+#endif
+}
+
+u8 async_io_should_start_reads_in_priority_order(void) {
+    // With one thread, reads are made one at a time, strictly in the order they are started.
+    async_io_config config = {0};
+    config.disable_io_uring = true;
+    config.thread_count = 1;
+    expect_to_be_true(test_file_create());
+    expect_to_be_true(async_io_start(&config));
+
+    // Queued in one batch, so all are waiting before the thread can take any.
+    read_record records[4] = {0};
+    async_io_read_request requests[4] = {
+        read_request(&records[0], 0, 1000, ASYNC_IO_READ_FLAG_NONE),
+        read_request(&records[1], 1000, 1000, ASYNC_IO_READ_FLAG_NONE),
+        read_request(&records[2], 2000, 1000, ASYNC_IO_READ_FLAG_NONE),
+        read_request(&records[3], 3000, 1000, ASYNC_IO_READ_FLAG_NONE),
+    };
+    requests[0].priority = ASYNC_IO_PRIORITY_PREFETCH;
+    requests[1].priority = ASYNC_IO_PRIORITY_NORMAL;
+    requests[2].priority = ASYNC_IO_PRIORITY_CRITICAL;
+    requests[3].priority = ASYNC_IO_PRIORITY_NORMAL;
+    expect_should_be(4, async_io_read_batch(4, requests, 0));
+    expect_to_be_true(callbacks_wait(4));
+
+    // Critical first, then normal in the order queued, then prefetch.
+    expect_should_be(0, records[2].order);
+    expect_should_be(1, records[1].order);
+    expect_should_be(2, records[3].order);
+    expect_should_be(3, records[0].order);
+    for (u32 i = 0; i < 4; ++i) {
+        expect_should_be(ASYNC_IO_RESULT_SUCCESS, records[i].result);
+        expect_should_be(0, records[i].mismatches);
+    }
+
+    async_io_stop();
+    test_file_destroy();
+    return true;
+}
+
+u8 async_io_should_cancel_reads(void) {
+    async_io_config config = {0};
+    config.disable_io_uring = true;
+    config.thread_count = 1;
+    expect_to_be_true(test_file_create());
+    expect_to_be_true(async_io_start(&config));
+
+    // The single thread is kept busy with whole-file reads, so most of these are still
+    // queued when cancelled. Whatever the timing, a read reported as cancelled must complete as such.
+#define CANCEL_READ_COUNT 16
+    read_record records[CANCEL_READ_COUNT] = {0};
+    async_io_read_request requests[CANCEL_READ_COUNT];
+    for (u32 i = 0; i < CANCEL_READ_COUNT; ++i) {
+        requests[i] = read_request(&records[i], 0, 0, ASYNC_IO_READ_FLAG_NONE);
+    }
+    u64 ids[CANCEL_READ_COUNT] = {0};
+    expect_should_be(CANCEL_READ_COUNT, async_io_read_batch(CANCEL_READ_COUNT, requests, ids));
+
+    b8 cancelled[CANCEL_READ_COUNT] = {0};
+    u32 cancelled_count = 0;
+    for (u32 i = 1; i < CANCEL_READ_COUNT; ++i) {
+        cancelled[i] = async_io_cancel(ids[i]);
+        cancelled_count += cancelled[i] ? 1 : 0;
+        // Once cancelled, there is nothing left to cancel.
+        expect_to_be_false(async_io_cancel(ids[i]));
+    }
+    expect_to_be_true((cancelled_count > 0));
+    expect_to_be_false(async_io_cancel(ASYNC_IO_INVALID_ID));
+
+    expect_to_be_true(callbacks_wait(CANCEL_READ_COUNT));
+    for (u32 i = 0; i < CANCEL_READ_COUNT; ++i) {
+        expect_should_be(1, records[i].completed);
+        async_io_result expected_result = cancelled[i] ? ASYNC_IO_RESULT_CANCELLED : ASYNC_IO_RESULT_SUCCESS;
+        expect_should_be(expected_result, records[i].result);
+        expect_should_be(0, records[i].mismatches);
+    }
+    // Completed reads can't be cancelled, and ids aren't reused once their callback is made.
+    expect_to_be_false(async_io_cancel(ids[0]));
+
+    async_io_stop();
+    test_file_destroy();
+    return true;
+}
+
+u8 async_io_shutdown_should_complete_outstanding_reads(void) {
+    async_io_config config = {0};
+    expect_to_be_true(test_file_create());
+    expect_to_be_true(async_io_start(&config));
+
+#define SHUTDOWN_READ_COUNT 32
+    read_record records[SHUTDOWN_READ_COUNT] = {0};
+    async_io_read_request requests[SHUTDOWN_READ_COUNT];
+    for (u32 i = 0; i < SHUTDOWN_READ_COUNT; ++i) {
+        requests[i] = read_request(&records[i], 0, 0, ASYNC_IO_READ_FLAG_NONE);
+    }
+    expect_should_be(SHUTDOWN_READ_COUNT, async_io_read_batch(SHUTDOWN_READ_COUNT, requests, 0));
+
+    // Every callback is made during shutdown, whether or not the read got to finish.
+    async_io_stop();
+    expect_should_be(SHUTDOWN_READ_COUNT, callback_count);
+    for (u32 i = 0; i < SHUTDOWN_READ_COUNT; ++i) {
+        expect_should_be(1, records[i].completed);
+        expect_to_be_true((records[i].result == ASYNC_IO_RESULT_SUCCESS || records[i].result == ASYNC_IO_RESULT_CANCELLED));
+        expect_should_be(0, records[i].mismatches);
+    }
+
+    // Nothing may be read once shut down.
+    read_record late = {0};
+    async_io_read_request late_request = read_request(&late, 0, 0, ASYNC_IO_READ_FLAG_NONE);
+    expect_should_be(ASYNC_IO_INVALID_ID, async_io_read(&late_request));
+
+    test_file_destroy();
+    return true;
+}
+
+void async_io_register_tests(void) {
+    test_manager_register_test(async_io_should_read_files_with_thread_pool, "async io should read files with thread pool");
+    test_manager_register_test(async_io_should_read_files_with_io_uring, "async io should read files with io_uring");
+    test_manager_register_test(async_io_should_start_reads_in_priority_order, "async io should start reads in priority order");
+    test_manager_register_test(async_io_should_cancel_reads, "async io should cancel reads");
+    test_manager_register_test(async_io_shutdown_should_complete_outstanding_reads, "async io shutdown should complete outstanding reads");
+}
@@ -0,0 +1,53 @@
+#include "filesystem_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+#include <platform/filesystem.h>
+
+#include <stdio.h>
+
+#define MAP_TEST_FILE "filesystem_map_test.bin"
+#define MAP_TEST_SIZE 100000
+
+u8 filesystem_map_should_view_file_contents(void) {
+    static u8 content[MAP_TEST_SIZE];
+    for (u32 i = 0; i < MAP_TEST_SIZE; ++i) {
+        content[i] = (u8)(i * 7);
+    }
+    expect_to_be_true(filesystem_write_entire_binary_file(MAP_TEST_FILE, MAP_TEST_SIZE, content));
+
+    file_mapping mapping = {0};
+    b8 mapped = filesystem_map(MAP_TEST_FILE, &mapping);
+    // Remove the file before checking, so it's cleaned up either way. The view stays valid.
+    remove(MAP_TEST_FILE);
+    expect_to_be_true(mapped);
+    expect_should_be(MAP_TEST_SIZE, mapping.size);
+
+    u32 mismatches = 0;
+    const u8* data = mapping.data;
+    for (u32 i = 0; i < MAP_TEST_SIZE; ++i) {
+        if (data[i] != content[i]) {
+            mismatches++;
+        }
+    }
+    expect_should_be(0, mismatches);
+
+    filesystem_unmap(&mapping);
+    expect_should_be(0, mapping.data);
+    expect_should_be(0, mapping.size);
+
+    return true;
+}
+
+u8 filesystem_map_should_fail_for_missing_file(void) {
+    file_mapping mapping = {0};
+    expect_to_be_false(filesystem_map("filesystem_map_test_missing.bin", &mapping));
+    expect_should_be(0, mapping.data);
+    return true;
+}
+
+void filesystem_register_tests(void) {
+    test_manager_register_test(filesystem_map_should_view_file_contents, "filesystem map should view file contents");
+    test_manager_register_test(filesystem_map_should_fail_for_missing_file, "filesystem map should fail for missing file");
+}
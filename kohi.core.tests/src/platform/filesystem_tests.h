@@ -0,0 +1,3 @@
+#pragma once
+
+void filesystem_register_tests(void);
@@ -0,0 +1,223 @@
+#include "kpackage_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+#include <memory/kmemory.h>
+#include <platform/filesystem.h>
+#include <platform/kpackage.h>
+#include <strings/kname.h>
+#include <strings/kstring.h>
+#include <utils/crc64.h>
+#include <utils/klz.h>
+
+#include <stddef.h>
+#include <stdio.h>
+
+#define LOCATION_TEST_FILE "kpackage_location_test.kpackage"
+
+// A binary package holding a single text asset, laid out as the tools write it.
+typedef struct test_package {
+    kpackage_binary_header header;
+    kpackage_binary_entry entry;
+    char strings[24];
+    _Alignas(KPACKAGE_BINARY_ALIGNMENT) char payload[KPACKAGE_BINARY_ALIGNMENT];
+} test_package;
+
+static void test_package_build(test_package* p) {
+    kzero_memory(p, sizeof(test_package));
+    string_ncopy(p->strings, "kpkg_test", 10);
+    string_ncopy(p->strings + 10, "kpkg_asset", 11);
+    string_ncopy(p->payload, "payload", 8);
+
+    p->entry.name = kname_create("kpkg_asset");
+    p->entry.offset = offsetof(test_package, payload);
+    p->entry.size = 7;
+    p->entry.stored_size = 7;
+    p->entry.content_hash = crc64(0, (const u8*)p->payload, 7);
+    p->entry.name_offset = 10;
+
+    p->header.magic = KPACKAGE_BINARY_MAGIC;
+    p->header.version = KPACKAGE_BINARY_VERSION;
+    p->header.name = kname_create("kpkg_test");
+    p->header.entry_count = 1;
+    p->header.toc_offset = offsetof(test_package, entry);
+    p->header.strings_offset = offsetof(test_package, strings);
+    p->header.strings_size = 21;
+    p->header.payload_offset = offsetof(test_package, payload);
+    p->header.file_size = sizeof(test_package);
+}
+
+u8 kpackage_binary_should_find_assets_in_place(void) {
+    static test_package p;
+    test_package_build(&p);
+
+    kpackage package = {0};
+    expect_to_be_true(kpackage_create_from_binary(sizeof(p), &p, &package));
+    expect_to_be_true(package.is_binary);
+    expect_should_be(kname_create("kpkg_test"), package.name);
+
+    // Binary assets are views into the package itself.
+    kpackage_asset_view view = {0};
+    expect_should_be(KPACKAGE_RESULT_SUCCESS, kpackage_asset_bytes_view_get(&package, kname_create("KPKG_ASSET"), &view));
+    expect_should_be(7, view.size);
+    expect_should_be((const void*)p.payload, view.data);
+    view.release(view.release_context, view.size, view.data);
+
+    // Text assets are copied, with a terminator.
+    u64 size = 0;
+    const char* text = 0;
+    expect_should_be(KPACKAGE_RESULT_SUCCESS, kpackage_asset_text_get(&package, kname_create("kpkg_asset"), &size, &text));
+    expect_should_be(8, size);
+    expect_to_be_true(strings_equal("payload", text));
+    kfree((void*)text, size, MEMORY_TAG_ASSET);
+
+    expect_should_be(KPACKAGE_RESULT_ASSET_GET_FAILURE, kpackage_asset_bytes_view_get(&package, kname_create("kpkg_missing"), &view));
+
+    kpackage_destroy(&package);
+    return true;
+}
+
+u8 kpackage_binary_should_reject_corrupt_data(void) {
+    static test_package p;
+    kpackage package = {0};
+
+    test_package_build(&p);
+    p.header.magic = 0;
+    expect_to_be_false(kpackage_create_from_binary(sizeof(p), &p, &package));
+
+    test_package_build(&p);
+    expect_to_be_false(kpackage_create_from_binary(sizeof(p) - 1, &p, &package));
+
+    test_package_build(&p);
+    p.entry.size = sizeof(p);
+    expect_to_be_false(kpackage_create_from_binary(sizeof(p), &p, &package));
+
+    // Offsets which would wrap around past the end of the package.
+    test_package_build(&p);
+    p.header.strings_offset = ~0ull - 4;
+    expect_to_be_false(kpackage_create_from_binary(sizeof(p), &p, &package));
+
+    test_package_build(&p);
+    p.entry.offset = ~0ull - 4;
+    expect_to_be_false(kpackage_create_from_binary(sizeof(p), &p, &package));
+
+    return true;
+}
+
+u8 kpackage_binary_should_locate_and_decode_assets(void) {
+    static test_package p;
+    test_package_build(&p);
+
+    // Packages not loaded from a file have nowhere to read assets from.
+    kpackage package = {0};
+    kpackage_asset_location location = {0};
+    expect_to_be_true(kpackage_create_from_binary(sizeof(p), &p, &package));
+    expect_should_be(KPACKAGE_RESULT_INTERNAL_FAILURE, kpackage_asset_location_get(&package, kname_create("kpkg_asset"), &location));
+    kpackage_destroy(&package);
+
+    expect_to_be_true(filesystem_write_entire_binary_file(LOCATION_TEST_FILE, sizeof(p), &p));
+    expect_to_be_true(kpackage_create_from_binary_file(LOCATION_TEST_FILE, &package));
+
+    expect_should_be(KPACKAGE_RESULT_SUCCESS, kpackage_asset_location_get(&package, kname_create("kpkg_asset"), &location));
+    expect_to_be_true(strings_equal(LOCATION_TEST_FILE, location.path));
+    expect_should_be(offsetof(test_package, payload), location.offset);
+    expect_should_be(7, location.stored_size);
+    expect_should_be(7, location.size);
+    expect_to_be_true(location.packed);
+    expect_to_be_false(location.compressed);
+    expect_should_be(KPACKAGE_RESULT_ASSET_GET_FAILURE, kpackage_asset_location_get(&package, kname_create("kpkg_missing"), &location));
+
+    // Data read from the location decodes as the asset itself would.
+    u64 size = 0;
+    const char* text = 0;
+    expect_should_be(KPACKAGE_RESULT_SUCCESS, kpackage_asset_decode(&package, kname_create("kpkg_asset"), false, 7, "payload", &size, (const void**)&text));
+    expect_should_be(8, size);
+    expect_to_be_true(strings_equal("payload", text));
+    kfree((void*)text, size, MEMORY_TAG_ASSET);
+    expect_should_be(KPACKAGE_RESULT_INTERNAL_FAILURE, kpackage_asset_decode(&package, kname_create("kpkg_asset"), false, 6, "payload", &size, (const void**)&text));
+    expect_to_be_true(kpackage_asset_verify(&package, kname_create("kpkg_asset"), 7, "payload"));
+    expect_to_be_false(kpackage_asset_verify(&package, kname_create("kpkg_asset"), 6, "payload"));
+
+    kpackage_destroy(&package);
+    remove(LOCATION_TEST_FILE);
+    return true;
+}
+
+#define COMPRESSED_TEST_SIZE (KPACKAGE_BINARY_BLOCK_SIZE * 2 + 1000)
+
+// A binary package holding a single asset compressed in three blocks, the last stored as-is.
+typedef struct compressed_test_package {
+    kpackage_binary_header header;
+    kpackage_binary_entry entry;
+    char strings[24];
+    _Alignas(KPACKAGE_BINARY_ALIGNMENT) u8 payload[COMPRESSED_TEST_SIZE + 64];
+} compressed_test_package;
+
+u8 kpackage_binary_should_decompress_assets(void) {
+    static compressed_test_package p;
+    static u8 content[COMPRESSED_TEST_SIZE];
+    kzero_memory(&p, sizeof(p));
+    for (u32 i = 0; i < COMPRESSED_TEST_SIZE; ++i) {
+        content[i] = (u8)((i / 3) % 11);
+    }
+
+    u32* block_sizes = (u32*)p.payload;
+    u64 offset = sizeof(u32) * 3;
+    for (u32 b = 0; b < 2; ++b) {
+        block_sizes[b] = (u32)klz_compress(content + KPACKAGE_BINARY_BLOCK_SIZE * b, KPACKAGE_BINARY_BLOCK_SIZE, p.payload + offset, sizeof(p.payload) - offset);
+        expect_to_be_true((block_sizes[b] > 0));
+        offset += block_sizes[b];
+    }
+    block_sizes[2] = 1000 | KPACKAGE_BINARY_BLOCK_STORED_BIT;
+    kcopy_memory(p.payload + offset, content + KPACKAGE_BINARY_BLOCK_SIZE * 2, 1000);
+    offset += 1000;
+
+    string_ncopy(p.strings, "kpkg_test", 10);
+    string_ncopy(p.strings + 10, "kpkg_asset", 11);
+    p.entry.name = kname_create("kpkg_asset");
+    p.entry.offset = offsetof(compressed_test_package, payload);
+    p.entry.size = COMPRESSED_TEST_SIZE;
+    p.entry.stored_size = offset;
+    p.entry.content_hash = crc64(0, content, COMPRESSED_TEST_SIZE);
+    p.entry.flags = KPACKAGE_BINARY_ENTRY_FLAG_COMPRESSED_BIT;
+    p.entry.name_offset = 10;
+    p.header.magic = KPACKAGE_BINARY_MAGIC;
+    p.header.version = KPACKAGE_BINARY_VERSION;
+    p.header.name = kname_create("kpkg_test");
+    p.header.entry_count = 1;
+    p.header.toc_offset = offsetof(compressed_test_package, entry);
+    p.header.strings_offset = offsetof(compressed_test_package, strings);
+    p.header.strings_size = 21;
+    p.header.payload_offset = offsetof(compressed_test_package, payload);
+    p.header.file_size = sizeof(compressed_test_package);
+
+    kpackage package = {0};
+    expect_to_be_true(kpackage_create_from_binary(sizeof(p), &p, &package));
+
+    kpackage_asset_view view = {0};
+    expect_should_be(KPACKAGE_RESULT_SUCCESS, kpackage_asset_bytes_view_get(&package, kname_create("kpkg_asset"), &view));
+    expect_should_be(COMPRESSED_TEST_SIZE, view.size);
+    expect_should_be(p.entry.content_hash, crc64(0, view.data, view.size));
+    view.release(view.release_context, view.size, view.data);
+
+    // Damage a block, which must be caught rather than decompressed.
+    p.payload[sizeof(u32) * 3 + 5] ^= 0xFF;
+    p.payload[sizeof(u32) * 3 + 6] ^= 0xFF;
+    kpackage_result result = kpackage_asset_bytes_view_get(&package, kname_create("kpkg_asset"), &view);
+    if (result == KPACKAGE_RESULT_SUCCESS) {
+        // The damage may happen to still decompress to the right size, but not to the right content.
+        expect_to_be_true((crc64(0, view.data, view.size) != p.entry.content_hash));
+        view.release(view.release_context, view.size, view.data);
+    }
+
+    kpackage_destroy(&package);
+    return true;
+}
+
+void kpackage_register_tests(void) {
+    test_manager_register_test(kpackage_binary_should_find_assets_in_place, "kpackage binary should find assets in place");
+    test_manager_register_test(kpackage_binary_should_reject_corrupt_data, "kpackage binary should reject corrupt data");
+    test_manager_register_test(kpackage_binary_should_locate_and_decode_assets, "kpackage binary should locate and decode assets");
+    test_manager_register_test(kpackage_binary_should_decompress_assets, "kpackage binary should decompress assets");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void kpackage_register_tests(void);
@@ -0,0 +1,110 @@
+#include "kname_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+#include <strings/kname.h>
+#include <strings/kstring.h>
+#include <threads/kthread.h>
+#include <utils/crc64.h>
+
+#include <stdio.h>
+
+u8 kname_should_be_case_insensitive(void) {
+    kname a = kname_create("Kname_Test_Mixed_Case");
+    kname b = kname_create("KNAME_TEST_MIXED_CASE");
+    kname c = kname_create("kname_test_mixed_case");
+    expect_should_not_be(INVALID_KNAME, a);
+    expect_should_be(a, b);
+    expect_should_be(a, c);
+
+    // The hash is the crc64 of the lowercased string.
+    const char* lower = "kname_test_mixed_case";
+    expect_should_be(crc64(0, (const u8*)lower, string_length(lower)), a);
+
+    // The string first used to create the name is the one kept.
+    expect_to_be_true(strings_equal("Kname_Test_Mixed_Case", kname_string_get(a)));
+
+    expect_should_be(INVALID_KNAME, kname_create(""));
+    expect_should_be(INVALID_KNAME, kname_create(0));
+    expect_should_be(0, kname_string_get(INVALID_KNAME));
+
+    return true;
+}
+
+u8 kname_should_handle_long_strings(void) {
+    // Longer than the buffer used to lowercase while hashing.
+    char upper[1000];
+    char lower[1000];
+    for (u32 i = 0; i < 999; ++i) {
+        upper[i] = 'A' + (i % 26);
+        lower[i] = 'a' + (i % 26);
+    }
+    upper[999] = 0;
+    lower[999] = 0;
+
+    kname a = kname_create(upper);
+    expect_should_be(a, kname_create(lower));
+    expect_should_be(crc64(0, (const u8*)lower, 999), a);
+    expect_to_be_true(strings_equal(upper, kname_string_get(a)));
+
+    return true;
+}
+
+#define KNAME_THREAD_COUNT 8
+// More than fit in the first table, so the tables must grow while threads are interning.
+#define KNAME_THREAD_NAME_COUNT 6000
+
+typedef struct kname_thread_params {
+    u32 thread_index;
+    kname* names;
+    b8 success;
+} kname_thread_params;
+
+static u32 kname_thread(void* params) {
+    kname_thread_params* p = params;
+    p->success = true;
+    char buffer[64];
+    for (u32 i = 0; i < KNAME_THREAD_NAME_COUNT; ++i) {
+        // Each thread visits the names in a different order and with different casing.
+        u32 n = (i + (p->thread_index * 997)) % KNAME_THREAD_NAME_COUNT;
+        snprintf(buffer, sizeof(buffer), (p->thread_index & 1) ? "KNAME_THREADED_%u" : "kname_threaded_%u", n);
+        p->names[n] = kname_create(buffer);
+        const char* str = kname_string_get(p->names[n]);
+        if (!str || !strings_equali(str, buffer)) {
+            p->success = false;
+        }
+    }
+    return 0;
+}
+
+u8 kname_should_intern_from_many_threads(void) {
+    static kname names[KNAME_THREAD_COUNT][KNAME_THREAD_NAME_COUNT];
+    kthread threads[KNAME_THREAD_COUNT];
+    kname_thread_params params[KNAME_THREAD_COUNT];
+    for (u32 i = 0; i < KNAME_THREAD_COUNT; ++i) {
+        params[i].thread_index = i;
+        params[i].names = names[i];
+        params[i].success = false;
+        expect_to_be_true(kthread_create(kname_thread, &params[i], false, &threads[i]));
+    }
+    for (u32 i = 0; i < KNAME_THREAD_COUNT; ++i) {
+        kthread_wait(&threads[i]);
+        expect_to_be_true(params[i].success);
+    }
+
+    // Every thread should have arrived at the same name for each string.
+    for (u32 n = 0; n < KNAME_THREAD_NAME_COUNT; ++n) {
+        for (u32 i = 1; i < KNAME_THREAD_COUNT; ++i) {
+            expect_should_be(names[0][n], names[i][n]);
+        }
+    }
+
+    return true;
+}
+
+void kname_register_tests(void) {
+    test_manager_register_test(kname_should_be_case_insensitive, "kname should be case-insensitive");
+    test_manager_register_test(kname_should_handle_long_strings, "kname should handle long strings");
+    test_manager_register_test(kname_should_intern_from_many_threads, "kname should intern from many threads");
+}
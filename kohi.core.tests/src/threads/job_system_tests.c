@@ -0,0 +1,158 @@
+#include "job_system_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+#include <memory/kmemory.h>
+#include <threads/katomic.h>
+#include <threads/job_system.h>
+
+#define JOB_TEST_THREAD_COUNT 3
+
+static u64 job_system_memory_requirement = 0;
+static void* job_system_state = 0;
+
+static b8 job_system_start(void) {
+    job_system_config config = {0};
+    config.max_job_thread_count = JOB_TEST_THREAD_COUNT;
+    job_system_initialize(&job_system_memory_requirement, 0, &config);
+    job_system_state = kallocate(job_system_memory_requirement, MEMORY_TAG_JOB);
+    return job_system_initialize(&job_system_memory_requirement, job_system_state, &config);
+}
+
+static void job_system_stop(void) {
+    job_system_shutdown(job_system_state);
+    kfree(job_system_state, job_system_memory_requirement, MEMORY_TAG_JOB);
+    job_system_state = 0;
+}
+
+#define PARALLEL_FOR_COUNT 100000
+
+static void parallel_for_mark(u32 start, u32 end, void* context) {
+    u32* hits = context;
+    for (u32 i = start; i < end; ++i) {
+        katomic_fetch_add_u32(&hits[i], 1);
+    }
+}
+
+static void parallel_reduce_sum(u32 start, u32 end, void* context, void* accumulator) {
+    for (u32 i = start; i < end; ++i) {
+        *(u64*)accumulator += i;
+    }
+}
+
+static void parallel_reduce_combine(void* accumulator, const void* partial, void* context) {
+    *(u64*)accumulator += *(const u64*)partial;
+}
+
+u8 job_system_parallel_for_should_cover_every_index_once(void) {
+    expect_to_be_true(job_system_start());
+
+    static u32 hits[PARALLEL_FOR_COUNT];
+    kzero_memory(hits, sizeof(hits));
+    job_system_parallel_for(PARALLEL_FOR_COUNT, 0, parallel_for_mark, hits);
+    u32 wrong = 0;
+    for (u32 i = 0; i < PARALLEL_FOR_COUNT; ++i) {
+        if (hits[i] != 1) {
+            wrong++;
+        }
+    }
+    expect_should_be(0, wrong);
+
+    u64 sum = 0;
+    u64 identity = 0;
+    job_system_parallel_reduce(PARALLEL_FOR_COUNT, 0, sizeof(u64), &identity, parallel_reduce_sum, parallel_reduce_combine, 0, &sum);
+    expect_should_be((u64)PARALLEL_FOR_COUNT * (PARALLEL_FOR_COUNT - 1) / 2, sum);
+
+    job_system_stop();
+    return true;
+}
+
+u8 job_system_should_start_with_default_config(void) {
+    // Without a config, every thread takes every type of job.
+    job_system_initialize(&job_system_memory_requirement, 0, 0);
+    job_system_state = kallocate(job_system_memory_requirement, MEMORY_TAG_JOB);
+    expect_to_be_true(job_system_initialize(&job_system_memory_requirement, job_system_state, 0));
+
+    static u32 hits[PARALLEL_FOR_COUNT];
+    kzero_memory(hits, sizeof(hits));
+    job_system_parallel_for(PARALLEL_FOR_COUNT, 0, parallel_for_mark, hits);
+    u32 wrong = 0;
+    for (u32 i = 0; i < PARALLEL_FOR_COUNT; ++i) {
+        if (hits[i] != 1) {
+            wrong++;
+        }
+    }
+    expect_should_be(0, wrong);
+
+    job_system_stop();
+    return true;
+}
+
+u8 job_system_parallel_for_should_run_without_job_system(void) {
+    // Code shared with tools may run before (or without) the job system, in which case
+    // the whole loop runs on the calling thread.
+    static u32 hits[PARALLEL_FOR_COUNT];
+    kzero_memory(hits, sizeof(hits));
+    job_system_parallel_for(PARALLEL_FOR_COUNT, 0, parallel_for_mark, hits);
+    u32 wrong = 0;
+    for (u32 i = 0; i < PARALLEL_FOR_COUNT; ++i) {
+        if (hits[i] != 1) {
+            wrong++;
+        }
+    }
+    expect_should_be(0, wrong);
+    return true;
+}
+
+typedef struct dependency_test_params {
+    u32* order;
+    u32* order_count;
+    u32 tag;
+} dependency_test_params;
+
+static b8 dependency_test_job(void* params, void* result_data) {
+    dependency_test_params* p = params;
+    u32 index = katomic_fetch_add_u32(p->order_count, 1);
+    p->order[index] = p->tag;
+    return true;
+}
+
+u8 job_system_should_run_dependents_after_dependencies(void) {
+    expect_to_be_true(job_system_start());
+
+    for (u32 round = 0; round < 100; ++round) {
+        u32 order[3] = {0};
+        u32 order_count = 0;
+
+        dependency_test_params first_params = {order, &order_count, 1};
+        job_info first = job_create(dependency_test_job, 0, 0, &first_params, sizeof(dependency_test_params), 0);
+        dependency_test_params second_params = {order, &order_count, 2};
+        job_info second = job_create_with_dependencies(dependency_test_job, 0, 0, &second_params, sizeof(dependency_test_params), 0, JOB_TYPE_GENERAL, JOB_PRIORITY_NORMAL, 1, &first.id);
+        khandle16 both[2] = {first.id, second.id};
+        dependency_test_params third_params = {order, &order_count, 3};
+        job_info third = job_create_with_dependencies(dependency_test_job, 0, 0, &third_params, sizeof(dependency_test_params), 0, JOB_TYPE_GENERAL, JOB_PRIORITY_HIGH, 2, both);
+
+        // Submitted in reverse, so the dependents are waiting before their dependencies exist.
+        khandle16 third_id = third.id;
+        job_system_submit(third);
+        job_system_submit(second);
+        job_system_submit(first);
+        expect_to_be_true(job_system_wait_for_jobs(1, &third_id));
+
+        expect_should_be(3, order_count);
+        expect_should_be(1, order[0]);
+        expect_should_be(2, order[1]);
+        expect_should_be(3, order[2]);
+    }
+
+    job_system_stop();
+    return true;
+}
+
+void job_system_register_tests(void) {
+    test_manager_register_test(job_system_parallel_for_should_cover_every_index_once, "job_system parallel for/reduce should cover every index once");
+    test_manager_register_test(job_system_should_start_with_default_config, "job_system should start with the default config");
+    test_manager_register_test(job_system_parallel_for_should_run_without_job_system, "job_system parallel for should run without the job system");
+    test_manager_register_test(job_system_should_run_dependents_after_dependencies, "job_system should run dependents after dependencies");
+}
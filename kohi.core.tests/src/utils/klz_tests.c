@@ -0,0 +1,171 @@
+#include "klz_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+#include <logger.h>
+#include <memory/kmemory.h>
+#include <platform/platform.h>
+#include <utils/klz.h>
+
+#define KLZ_TEST_SIZE 100000
+#define KLZ_BENCHMARK_SIZE MEBIBYTES(8)
+#define KLZ_BENCHMARK_BLOCK_SIZE KIBIBYTES(256)
+#define KLZ_BENCHMARK_ITERATIONS 4
+
+static u32 random_state = 0x12345678;
+
+static u32 random_next(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+// Fills data with something like asset content: runs of repeated words mixed with noise.
+static void asset_like_fill(u8* data, u64 size) {
+    static const char* words[] = {"vertex ", "normal ", "texcoord ", "0.000000 ", "1.000000 ", "-0.5 ", "material ", "\n"};
+    u64 i = 0;
+    while (i < size) {
+        u32 r = random_next();
+        if ((r & 7) == 0) {
+            data[i++] = (u8)(r >> 8);
+        } else {
+            const char* word = words[(r >> 3) % 8];
+            for (u32 j = 0; word[j] && i < size; ++j) {
+                data[i++] = (u8)word[j];
+            }
+        }
+    }
+}
+
+static b8 round_trip(const u8* data, u64 size) {
+    u64 bound = klz_compress_bound(size);
+    u8* compressed = kallocate(bound, MEMORY_TAG_ARRAY);
+    u8* decompressed = kallocate(size + 1, MEMORY_TAG_ARRAY);
+    u64 compressed_size = klz_compress(data, size, compressed, bound);
+    b8 result = compressed_size > 0 && klz_decompress(compressed, compressed_size, decompressed, size);
+    for (u64 i = 0; result && i < size; ++i) {
+        result = decompressed[i] == data[i];
+    }
+    kfree(compressed, bound, MEMORY_TAG_ARRAY);
+    kfree(decompressed, size + 1, MEMORY_TAG_ARRAY);
+    return result;
+}
+
+u8 klz_should_round_trip(void) {
+    static u8 data[KLZ_TEST_SIZE];
+
+    // Assorted sizes, including those too small to hold a match.
+    asset_like_fill(data, KLZ_TEST_SIZE);
+    u64 sizes[] = {0, 1, 5, 12, 13, 64, 1000, KLZ_TEST_SIZE};
+    for (u32 i = 0; i < sizeof(sizes) / sizeof(u64); ++i) {
+        expect_to_be_true(round_trip(data, sizes[i]));
+    }
+
+    // Noise, which doesn't compress.
+    for (u32 i = 0; i < KLZ_TEST_SIZE; ++i) {
+        data[i] = (u8)random_next();
+    }
+    expect_to_be_true(round_trip(data, KLZ_TEST_SIZE));
+
+    // A single repeated byte, where every match overlaps itself.
+    kset_memory(data, 0xAB, KLZ_TEST_SIZE);
+    expect_to_be_true(round_trip(data, KLZ_TEST_SIZE));
+
+    return true;
+}
+
+u8 klz_should_compress_repetitive_data(void) {
+    static u8 data[KLZ_TEST_SIZE];
+    static u8 compressed[KLZ_TEST_SIZE];
+    kset_memory(data, 0, KLZ_TEST_SIZE);
+    u64 compressed_size = klz_compress(data, KLZ_TEST_SIZE, compressed, KLZ_TEST_SIZE);
+    expect_to_be_true((compressed_size > 0 && compressed_size < KLZ_TEST_SIZE / 100));
+
+    // Data which doesn't fit the given capacity fails, rather than overrunning it.
+    for (u32 i = 0; i < KLZ_TEST_SIZE; ++i) {
+        data[i] = (u8)random_next();
+    }
+    expect_should_be(0, klz_compress(data, KLZ_TEST_SIZE, compressed, KLZ_TEST_SIZE));
+
+    return true;
+}
+
+u8 klz_should_reject_corrupt_data(void) {
+    static u8 data[KLZ_TEST_SIZE];
+    static u8 compressed[KLZ_TEST_SIZE * 2];
+    static u8 decompressed[KLZ_TEST_SIZE];
+    asset_like_fill(data, KLZ_TEST_SIZE);
+    u64 compressed_size = klz_compress(data, KLZ_TEST_SIZE, compressed, sizeof(compressed));
+    expect_to_be_true((compressed_size > 0));
+
+    // Truncated, or the wrong size.
+    expect_to_be_false(klz_decompress(compressed, compressed_size - 1, decompressed, KLZ_TEST_SIZE));
+    expect_to_be_false(klz_decompress(compressed, compressed_size, decompressed, KLZ_TEST_SIZE - 1));
+
+    // Damaged anywhere. Whatever the result, nothing is written out of bounds.
+    for (u32 i = 0; i < 1000; ++i) {
+        u32 position = random_next() % compressed_size;
+        u8 original = compressed[position];
+        compressed[position] ^= (u8)(random_next() | 1);
+        klz_decompress(compressed, compressed_size, decompressed, KLZ_TEST_SIZE);
+        compressed[position] = original;
+    }
+
+    return true;
+}
+
+u8 klz_benchmark(void) {
+    u64 block_count = KLZ_BENCHMARK_SIZE / KLZ_BENCHMARK_BLOCK_SIZE;
+    u64 bound = klz_compress_bound(KLZ_BENCHMARK_BLOCK_SIZE);
+    u8* data = kallocate(KLZ_BENCHMARK_SIZE, MEMORY_TAG_ARRAY);
+    u8* compressed = kallocate(bound * block_count, MEMORY_TAG_ARRAY);
+    u64* compressed_sizes = kallocate(sizeof(u64) * block_count, MEMORY_TAG_ARRAY);
+    u8* decompressed = kallocate(KLZ_BENCHMARK_SIZE, MEMORY_TAG_ARRAY);
+    asset_like_fill(data, KLZ_BENCHMARK_SIZE);
+
+    u64 total_compressed = 0;
+    f64 start = platform_get_absolute_time();
+    for (u32 iter = 0; iter < KLZ_BENCHMARK_ITERATIONS; ++iter) {
+        total_compressed = 0;
+        for (u64 b = 0; b < block_count; ++b) {
+            compressed_sizes[b] = klz_compress(data + b * KLZ_BENCHMARK_BLOCK_SIZE, KLZ_BENCHMARK_BLOCK_SIZE, compressed + b * bound, bound);
+            total_compressed += compressed_sizes[b];
+        }
+    }
+    f64 compress_time = platform_get_absolute_time() - start;
+
+    b8 result = true;
+    start = platform_get_absolute_time();
+    for (u32 iter = 0; iter < KLZ_BENCHMARK_ITERATIONS; ++iter) {
+        for (u64 b = 0; b < block_count; ++b) {
+            result = klz_decompress(compressed + b * bound, compressed_sizes[b], decompressed + b * KLZ_BENCHMARK_BLOCK_SIZE, KLZ_BENCHMARK_BLOCK_SIZE) && result;
+        }
+    }
+    f64 decompress_time = platform_get_absolute_time() - start;
+    expect_to_be_true(result);
+    u64 mismatches = 0;
+    for (u64 i = 0; i < KLZ_BENCHMARK_SIZE; ++i) {
+        mismatches += data[i] != decompressed[i];
+    }
+    expect_should_be(0, mismatches);
+
+    f64 megabytes = (f64)(KLZ_BENCHMARK_SIZE * KLZ_BENCHMARK_ITERATIONS) / (1024.0 * 1024.0);
+    KINFO("LZ benchmark (%.0f MiB in %llu KiB blocks, ratio %.3f): compress %.1f MB/s, decompress %.1f MB/s",
+          megabytes, KLZ_BENCHMARK_BLOCK_SIZE / 1024, (f64)total_compressed / KLZ_BENCHMARK_SIZE,
+          megabytes / compress_time, megabytes / decompress_time);
+
+    kfree(data, KLZ_BENCHMARK_SIZE, MEMORY_TAG_ARRAY);
+    kfree(compressed, bound * block_count, MEMORY_TAG_ARRAY);
+    kfree(compressed_sizes, sizeof(u64) * block_count, MEMORY_TAG_ARRAY);
+    kfree(decompressed, KLZ_BENCHMARK_SIZE, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+void klz_register_tests(void) {
+    test_manager_register_test(klz_should_round_trip, "klz should round trip");
+    test_manager_register_test(klz_should_compress_repetitive_data, "klz should compress repetitive data");
+    test_manager_register_test(klz_should_reject_corrupt_data, "klz should reject corrupt data");
+    test_manager_register_test(klz_benchmark, "klz compression/decompression benchmark");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void klz_register_tests(void);
@@ -0,0 +1,229 @@
+#include "ksort_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+#include <utils/ksort.h>
+
+#define SORT_TEST_COUNT 5000
+
+typedef struct sort_test_item {
+    u32 key;
+    u32 original_index;
+    u8 payload[24];
+} sort_test_item;
+
+// Sorts ascending by key.
+static i32 sort_test_item_compare(void* a, void* b) {
+    sort_test_item* a_typed = a;
+    sort_test_item* b_typed = b;
+    if (a_typed->key < b_typed->key) {
+        return 1;
+    } else if (a_typed->key > b_typed->key) {
+        return -1;
+    }
+    return 0;
+}
+
+static u64 sort_test_random_state = 0x9E3779B97F4A7C15ull;
+static u64 sort_test_random(void) {
+    // xorshift64
+    sort_test_random_state ^= sort_test_random_state << 13;
+    sort_test_random_state ^= sort_test_random_state >> 7;
+    sort_test_random_state ^= sort_test_random_state << 17;
+    return sort_test_random_state;
+}
+
+u8 kradix_sort_u32_should_sort_ascending(void) {
+    u32 keys[SORT_TEST_COUNT];
+    u32 scratch[SORT_TEST_COUNT];
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        keys[i] = (u32)sort_test_random();
+    }
+    kradix_sort_u32(keys, SORT_TEST_COUNT, scratch);
+    for (u32 i = 1; i < SORT_TEST_COUNT; ++i) {
+        b8 in_order = keys[i - 1] <= keys[i];
+        expect_to_be_true(in_order);
+    }
+
+    // Keys which only differ in one byte, using internally allocated scratch.
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        keys[i] = 0xAB00CD00u | ((SORT_TEST_COUNT - i) & 0xFF);
+    }
+    kradix_sort_u32(keys, SORT_TEST_COUNT, 0);
+    for (u32 i = 1; i < SORT_TEST_COUNT; ++i) {
+        b8 in_order = keys[i - 1] <= keys[i];
+        expect_to_be_true(in_order);
+    }
+
+    return true;
+}
+
+u8 kradix_sort_u64_should_sort_ascending(void) {
+    u64 keys[SORT_TEST_COUNT];
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        keys[i] = sort_test_random();
+    }
+    keys[7] = 0;
+    keys[8] = U64_MAX;
+    kradix_sort_u64(keys, SORT_TEST_COUNT, 0);
+    expect_should_be(0, keys[0]);
+    expect_should_be(U64_MAX, keys[SORT_TEST_COUNT - 1]);
+    for (u32 i = 1; i < SORT_TEST_COUNT; ++i) {
+        b8 in_order = keys[i - 1] <= keys[i];
+        expect_to_be_true(in_order);
+    }
+
+    return true;
+}
+
+u8 kradix_sort_indices_should_be_stable(void) {
+    u32 keys[SORT_TEST_COUNT];
+    u32 keys_copy[SORT_TEST_COUNT];
+    u32 indices[SORT_TEST_COUNT];
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        // Plenty of duplicates, spread across more than one byte.
+        keys[i] = (u32)(sort_test_random() % 700) * 1000;
+        keys_copy[i] = keys[i];
+    }
+    kradix_sort_u32_indices(keys, SORT_TEST_COUNT, indices, 0);
+
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        // The keys themselves must be untouched.
+        expect_should_be(keys_copy[i], keys[i]);
+    }
+    for (u32 i = 1; i < SORT_TEST_COUNT; ++i) {
+        b8 in_order = keys[indices[i - 1]] < keys[indices[i]] || (keys[indices[i - 1]] == keys[indices[i]] && indices[i - 1] < indices[i]);
+        expect_to_be_true(in_order);
+    }
+
+    // u64 keys with caller-provided scratch, gathered into a payload array.
+    static sort_test_item items[SORT_TEST_COUNT];
+    static sort_test_item sorted[SORT_TEST_COUNT];
+    u64 keys64[SORT_TEST_COUNT];
+    static u8 scratch[KRADIX_SORT_INDICES_SCRATCH_SIZE(u64, SORT_TEST_COUNT)];
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        items[i].key = (u32)(sort_test_random() % 50);
+        items[i].original_index = i;
+        keys64[i] = ((u64)items[i].key << 40) | 0xFFFF;
+    }
+    kradix_sort_u64_indices(keys64, SORT_TEST_COUNT, indices, scratch);
+    ksort_gather(sizeof(sort_test_item), items, indices, SORT_TEST_COUNT, sorted);
+    for (u32 i = 1; i < SORT_TEST_COUNT; ++i) {
+        b8 in_order = sorted[i - 1].key < sorted[i].key || (sorted[i - 1].key == sorted[i].key && sorted[i - 1].original_index < sorted[i].original_index);
+        expect_to_be_true(in_order);
+    }
+
+    // All keys equal means the identity permutation.
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        keys[i] = 42;
+    }
+    kradix_sort_u32_indices(keys, SORT_TEST_COUNT, indices, 0);
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        expect_should_be(i, indices[i]);
+    }
+
+    return true;
+}
+
+u8 kradix_key_from_f32_should_preserve_order(void) {
+    f32 values[] = {-1000.0f, -2.5f, -1.0f, -0.001f, 0.0f, 0.001f, 1.0f, 2.5f, 1000.0f};
+    u32 count = sizeof(values) / sizeof(f32);
+    for (u32 i = 1; i < count; ++i) {
+        b8 in_order = kradix_key_from_f32(values[i - 1]) < kradix_key_from_f32(values[i]);
+        expect_to_be_true(in_order);
+    }
+    return true;
+}
+
+static b8 items_sorted(sort_test_item* items, u32 count) {
+    for (u32 i = 1; i < count; ++i) {
+        if (items[i - 1].key > items[i].key) {
+            return false;
+        }
+    }
+    return true;
+}
+
+u8 kquick_sort_should_handle_adversarial_input(void) {
+    static sort_test_item items[SORT_TEST_COUNT];
+
+    // Already sorted.
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        items[i].key = i;
+    }
+    kquick_sort(sizeof(sort_test_item), items, 0, SORT_TEST_COUNT - 1, sort_test_item_compare);
+    expect_to_be_true(items_sorted(items, SORT_TEST_COUNT));
+
+    // Reversed.
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        items[i].key = SORT_TEST_COUNT - i;
+    }
+    kquick_sort(sizeof(sort_test_item), items, 0, SORT_TEST_COUNT - 1, sort_test_item_compare);
+    expect_to_be_true(items_sorted(items, SORT_TEST_COUNT));
+
+    // All equal.
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        items[i].key = 7;
+    }
+    kquick_sort(sizeof(sort_test_item), items, 0, SORT_TEST_COUNT - 1, sort_test_item_compare);
+    expect_to_be_true(items_sorted(items, SORT_TEST_COUNT));
+
+    // Organ pipe.
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        items[i].key = i < SORT_TEST_COUNT / 2 ? i : SORT_TEST_COUNT - i;
+    }
+    kquick_sort(sizeof(sort_test_item), items, 0, SORT_TEST_COUNT - 1, sort_test_item_compare);
+    expect_to_be_true(items_sorted(items, SORT_TEST_COUNT));
+
+    // Random, with a subrange sorted only.
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        items[i].key = (u32)(sort_test_random() % 1000);
+    }
+    u32 first_key = items[0].key;
+    u32 last_key = items[SORT_TEST_COUNT - 1].key;
+    kquick_sort(sizeof(sort_test_item), items, 1, SORT_TEST_COUNT - 2, sort_test_item_compare);
+    expect_to_be_true(items_sorted(items + 1, SORT_TEST_COUNT - 2));
+    expect_should_be(first_key, items[0].key);
+    expect_should_be(last_key, items[SORT_TEST_COUNT - 1].key);
+
+    return true;
+}
+
+u8 kquick_sort_should_respect_compare_direction(void) {
+    u32 values[SORT_TEST_COUNT];
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        values[i] = (u32)sort_test_random();
+    }
+    kquick_sort(sizeof(u32), values, 0, SORT_TEST_COUNT - 1, kquicksort_compare_u32_desc);
+    for (u32 i = 1; i < SORT_TEST_COUNT; ++i) {
+        b8 in_order = values[i - 1] >= values[i];
+        expect_to_be_true(in_order);
+    }
+
+    kquick_sort(sizeof(u32), values, 0, SORT_TEST_COUNT - 1, kquicksort_compare_u32);
+    for (u32 i = 1; i < SORT_TEST_COUNT; ++i) {
+        b8 in_order = values[i - 1] <= values[i];
+        expect_to_be_true(in_order);
+    }
+
+    // Small ranges are handled by insertion sort only.
+    u32 small[5] = {3, 1, 4, 1, 5};
+    kquick_sort(sizeof(u32), small, 0, 4, kquicksort_compare_u32);
+    expect_should_be(1, small[0]);
+    expect_should_be(1, small[1]);
+    expect_should_be(3, small[2]);
+    expect_should_be(4, small[3]);
+    expect_should_be(5, small[4]);
+
+    return true;
+}
+
+void ksort_register_tests(void) {
+    test_manager_register_test(kradix_sort_u32_should_sort_ascending, "kradix_sort_u32 should sort ascending");
+    test_manager_register_test(kradix_sort_u64_should_sort_ascending, "kradix_sort_u64 should sort ascending");
+    test_manager_register_test(kradix_sort_indices_should_be_stable, "kradix_sort indices should be a stable permutation");
+    test_manager_register_test(kradix_key_from_f32_should_preserve_order, "kradix_key_from_f32 should preserve float order");
+    test_manager_register_test(kquick_sort_should_handle_adversarial_input, "kquick_sort should handle adversarial input");
+    test_manager_register_test(kquick_sort_should_respect_compare_direction, "kquick_sort should respect compare direction");
+}
@@ -0,0 +1,142 @@
+#include "bitset.h"
+
+#include "logger.h"
+#include "memory/kmemory.h"
+
+static KINLINE u32 word_count_get(u32 bit_count) {
+    return (bit_count + BITSET_WORD_BITS - 1) / BITSET_WORD_BITS;
+}
+
+// The bits of the last word which are in use.
+static KINLINE u64 last_word_mask(const bitset* set) {
+    u32 used = set->bit_count % BITSET_WORD_BITS;
+    return used ? ((1ull << used) - 1) : ~0ull;
+}
+
+u64 bitset_memory_requirement(u32 bit_count) {
+    return sizeof(u64) * word_count_get(bit_count);
+}
+
+b8 bitset_create(u32 bit_count, void* memory, bitset* out_set) {
+    if (!out_set) {
+        KERROR("bitset_create requires a valid pointer to hold the bitset.");
+        return false;
+    }
+    if (!bit_count) {
+        KERROR("bitset_create requires a nonzero bit_count.");
+        return false;
+    }
+
+    kzero_memory(out_set, sizeof(bitset));
+    out_set->bit_count = bit_count;
+    out_set->word_count = word_count_get(bit_count);
+    if (memory) {
+        out_set->owns_memory = false;
+        out_set->words = memory;
+    } else {
+        out_set->owns_memory = true;
+        out_set->words = kallocate(bitset_memory_requirement(bit_count), MEMORY_TAG_ARRAY);
+    }
+    kzero_memory(out_set->words, bitset_memory_requirement(bit_count));
+
+    return true;
+}
+
+void bitset_destroy(bitset* set) {
+    if (set) {
+        if (set->owns_memory && set->words) {
+            kfree(set->words, bitset_memory_requirement(set->bit_count), MEMORY_TAG_ARRAY);
+        }
+        kzero_memory(set, sizeof(bitset));
+    }
+}
+
+void bitset_set_all(bitset* set) {
+    if (!set || !set->words) {
+        return;
+    }
+    for (u32 i = 0; i < set->word_count; ++i) {
+        set->words[i] = ~0ull;
+    }
+    set->words[set->word_count - 1] &= last_word_mask(set);
+}
+
+void bitset_clear_all(bitset* set) {
+    if (!set || !set->words) {
+        return;
+    }
+    kzero_memory(set->words, bitset_memory_requirement(set->bit_count));
+}
+
+u32 bitset_popcount(const bitset* set) {
+    if (!set || !set->words) {
+        return 0;
+    }
+    u32 count = 0;
+    for (u32 i = 0; i < set->word_count; ++i) {
+        count += kbit_popcount_u64(katomic_load_u64(&set->words[i]));
+    }
+    return count;
+}
+
+// Searches for a set bit in the words, optionally inverted, from start_index onward.
+// Words are loaded atomically, so this may be used alongside the atomic operations.
+static b8 find_first(const bitset* set, u32 start_index, u64 invert, u32* out_index) {
+    if (!set || !set->words || !out_index || start_index >= set->bit_count) {
+        return false;
+    }
+
+    u32 word_index = start_index / BITSET_WORD_BITS;
+    // Ignore bits before the start in the first word.
+    u64 word = (katomic_load_u64(&set->words[word_index]) ^ invert) & (~0ull << (start_index % BITSET_WORD_BITS));
+    for (;;) {
+        if (word_index == set->word_count - 1) {
+            // Ignore the unused bits of the last word.
+            word &= last_word_mask(set);
+        }
+        if (word) {
+            *out_index = (word_index * BITSET_WORD_BITS) + kbit_ctz_u64(word);
+            return true;
+        }
+        if (++word_index == set->word_count) {
+            return false;
+        }
+        word = katomic_load_u64(&set->words[word_index]) ^ invert;
+    }
+}
+
+b8 bitset_find_first_set(const bitset* set, u32 start_index, u32* out_index) {
+    return find_first(set, start_index, 0, out_index);
+}
+
+b8 bitset_find_first_clear(const bitset* set, u32 start_index, u32* out_index) {
+    return find_first(set, start_index, ~0ull, out_index);
+}
+
+bitset_iterator bitset_iterator_begin(const bitset* set) {
+    bitset_iterator it = {0};
+    it.set = set;
+    if (set && set->words) {
+        it.remaining = katomic_load_u64(&set->words[0]);
+    }
+    return it;
+}
+
+b8 bitset_iterator_next(bitset_iterator* it, u32* out_index) {
+    if (!it || !it->set || !it->set->words) {
+        return false;
+    }
+    while (!it->remaining) {
+        if (++it->word_index >= it->set->word_count) {
+            // Stay at the end so further calls also return false.
+            it->word_index = it->set->word_count;
+            return false;
+        }
+        it->remaining = katomic_load_u64(&it->set->words[it->word_index]);
+    }
+
+    *out_index = (it->word_index * BITSET_WORD_BITS) + kbit_ctz_u64(it->remaining);
+    // Drop the lowest set bit.
+    it->remaining &= it->remaining - 1;
+    return true;
+}
@@ -0,0 +1,179 @@
+/**
+ * @file bitset.h
+ * @author Travis Vroman (travis@kohiengine.com)
+ * @brief A fixed-size, packed array of bits.
+ * @details Bits are packed 64 to a word, so a bitset uses an eighth of the memory
+ * of an array of b8s and can be scanned a whole word at a time. Along with the
+ * usual set/clear/test operations, atomic versions are provided which may be used
+ * from any number of threads at once on the same bitset. The non-atomic versions
+ * must not be mixed with concurrent use from other threads.
+ *
+ * Counting and searching use compiler intrinsics (popcount and count-trailing-zeroes),
+ * which map to single instructions on modern CPUs.
+ * @version 1.0
+ * @date 2024-11-07
+ *
+ * @copyright Kohi Game Engine is Copyright (c) Travis Vroman 2021-2024
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "threads/katomic.h"
+
+/** @brief The number of bits held in each word of a bitset. */
+#define BITSET_WORD_BITS 64
+
+/**
+ * @brief A fixed-size array of bits. Members of this structure should not be
+ * modified outside the functions associated with it.
+ */
+typedef struct bitset {
+    /** @brief The number of bits held. */
+    u32 bit_count;
+    /** @brief The number of words used to hold the bits. */
+    u32 word_count;
+    /** @brief The words holding the bits. Bits past bit_count are always clear. */
+    u64* words;
+    /** @brief Indicates if the bitset owns its memory. */
+    b8 owns_memory;
+} bitset;
+
+/**
+ * @brief Walks the set bits of a bitset in ascending order, one word at a time.
+ * Obtain one with bitset_iterator_begin().
+ */
+typedef struct bitset_iterator {
+    /** @brief The bitset being iterated. */
+    const bitset* set;
+    /** @brief The index of the word currently being walked. */
+    u32 word_index;
+    /** @brief The bits of the current word which are yet to be returned. */
+    u64 remaining;
+} bitset_iterator;
+
+#if defined(__clang__) || defined(__gcc__) || defined(__GNUC__)
+
+/** @brief Obtains the number of set bits in the given value. */
+KINLINE u32 kbit_popcount_u64(u64 value) {
+    return (u32)__builtin_popcountll(value);
+}
+
+/** @brief Obtains the index of the lowest set bit in the given value. value must not be 0. */
+KINLINE u32 kbit_ctz_u64(u64 value) {
+    return (u32)__builtin_ctzll(value);
+}
+
+#else
+#    error "bitset.h - Unsupported compiler - don't know how to define bit intrinsics!"
+#endif
+
+/**
+ * @brief Obtains the amount of memory needed by a bitset with the given number of bits.
+ *
+ * @param bit_count The number of bits.
+ * @returns The size in bytes of the memory block the bitset requires.
+ */
+KAPI u64 bitset_memory_requirement(u32 bit_count);
+
+/**
+ * @brief Creates a new bitset with every bit clear.
+ *
+ * @param bit_count The number of bits. Must be nonzero.
+ * @param memory The memory block used to hold the bits. Should be the size given by
+ * bitset_memory_requirement() and aligned to 8 bytes. If 0 is passed, a block is
+ * automatically allocated and freed upon creation/destruction.
+ * @param out_set A pointer to hold the newly created bitset.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 bitset_create(u32 bit_count, void* memory, bitset* out_set);
+
+/**
+ * @brief Destroys the given bitset. If memory was not passed in during creation, it is freed here.
+ *
+ * @param set A pointer to the bitset to destroy.
+ */
+KAPI void bitset_destroy(bitset* set);
+
+/** @brief Sets the bit at the given index. Not thread-safe. */
+KINLINE void bitset_set(bitset* set, u32 index) {
+    set->words[index / BITSET_WORD_BITS] |= (1ull << (index % BITSET_WORD_BITS));
+}
+
+/** @brief Clears the bit at the given index. Not thread-safe. */
+KINLINE void bitset_clear(bitset* set, u32 index) {
+    set->words[index / BITSET_WORD_BITS] &= ~(1ull << (index % BITSET_WORD_BITS));
+}
+
+/** @brief Indicates if the bit at the given index is set. Not thread-safe. */
+KINLINE b8 bitset_test(const bitset* set, u32 index) {
+    return (set->words[index / BITSET_WORD_BITS] >> (index % BITSET_WORD_BITS)) & 1;
+}
+
+/** @brief Atomically sets the bit at the given index. Returns true if it was already set. */
+KINLINE b8 bitset_set_atomic(bitset* set, u32 index) {
+    u64 mask = 1ull << (index % BITSET_WORD_BITS);
+    return (katomic_fetch_or_u64(&set->words[index / BITSET_WORD_BITS], mask) & mask) != 0;
+}
+
+/** @brief Atomically clears the bit at the given index. Returns true if it was previously set. */
+KINLINE b8 bitset_clear_atomic(bitset* set, u32 index) {
+    u64 mask = 1ull << (index % BITSET_WORD_BITS);
+    return (katomic_fetch_and_u64(&set->words[index / BITSET_WORD_BITS], ~mask) & mask) != 0;
+}
+
+/** @brief Atomically tests the bit at the given index. */
+KINLINE b8 bitset_test_atomic(const bitset* set, u32 index) {
+    return (katomic_load_u64(&set->words[index / BITSET_WORD_BITS]) >> (index % BITSET_WORD_BITS)) & 1;
+}
+
+/** @brief Sets every bit. Not thread-safe. */
+KAPI void bitset_set_all(bitset* set);
+
+/** @brief Clears every bit. Not thread-safe. */
+KAPI void bitset_clear_all(bitset* set);
+
+/** @brief Obtains the number of set bits. Safe alongside the atomic operations, but only a snapshot if the bitset is changing. */
+KAPI u32 bitset_popcount(const bitset* set);
+
+/**
+ * @brief Finds the first set bit at or after the given index. Safe alongside the atomic
+ * operations, but the bit found may have changed by the time this returns.
+ *
+ * @param set A pointer to the bitset.
+ * @param start_index The index to begin searching from.
+ * @param out_index A pointer to hold the index of the bit found.
+ * @returns True if a set bit was found; otherwise false.
+ */
+KAPI b8 bitset_find_first_set(const bitset* set, u32 start_index, u32* out_index);
+
+/**
+ * @brief Finds the first clear bit at or after the given index. Safe alongside the atomic
+ * operations, but the bit found may have changed by the time this returns.
+ *
+ * @param set A pointer to the bitset.
+ * @param start_index The index to begin searching from.
+ * @param out_index A pointer to hold the index of the bit found.
+ * @returns True if a clear bit was found; otherwise false.
+ */
+KAPI b8 bitset_find_first_clear(const bitset* set, u32 start_index, u32* out_index);
+
+/**
+ * @brief Creates an iterator over the set bits of the given bitset. Each word is read
+ * once, and words with no set bits are skipped in a single comparison. Changes made to
+ * a word after the iterator has moved on to it are not seen.
+ *
+ * @param set A pointer to the bitset to iterate.
+ * @returns The iterator.
+ */
+KAPI bitset_iterator bitset_iterator_begin(const bitset* set);
+
+/**
+ * @brief Moves the iterator to the next set bit.
+ *
+ * @param it A pointer to the iterator.
+ * @param out_index A pointer to hold the index of the next set bit.
+ * @returns True if a set bit was found; false once there are none left.
+ */
+KAPI b8 bitset_iterator_next(bitset_iterator* it, u32* out_index);
@@ -3,31 +3,64 @@
 #include "memory/kmemory.h"
 #include "logger.h"
 
+/*
+ * Free ranges are kept in a pool of nodes, each of which sits in two AVL trees at once:
+ * one ordered by offset (used to find neighbours to coalesce with on free), and one ordered
+ * by size, then offset (used to find the best fit on allocation). Both allocation and free
+ * are O(log n) in the number of free ranges. Returned nodes are kept on a stack so that
+ * obtaining one is O(1). Nodes which have never been used are handed out in order and are
+ * never touched beforehand, so that a list over reserved (but not yet resident) memory
+ * only makes resident the nodes it actually needs.
+ */
+
+// Indicates the absence of a node. Nodes are referred to by index so the pool can be copied on resize.
+#define NODE_NONE INVALID_ID_U32
+
+typedef enum freelist_tree {
+    FREELIST_TREE_OFFSET = 0,
+    FREELIST_TREE_SIZE = 1,
+    FREELIST_TREE_COUNT
+} freelist_tree;
+
+typedef struct freelist_link {
+    u32 left;
+    u32 right;
+    u32 height;
+} freelist_link;
+
 typedef struct freelist_node {
     u64 offset;
     u64 size;
-    struct freelist_node* next;
+    // Links for each tree. When the node is unused, links[FREELIST_TREE_OFFSET].left points to the next unused node.
+    freelist_link links[FREELIST_TREE_COUNT];
 } freelist_node;
 
 typedef struct internal_state {
     u64 total_size;
     u64 max_entries;
-    freelist_node* head;
+    // Running total of free space.
+    u64 free_space;
+    // The number of free ranges.
+    u64 free_block_count;
+    u32 roots[FREELIST_TREE_COUNT];
+    // The top of the stack of returned nodes.
+    u32 unused_head;
+    // The first node which has never been used. All nodes from here on are available.
+    u32 next_untouched;
     freelist_node* nodes;
 } internal_state;
 
-static freelist_node* get_node(freelist* list);
-static void return_node(freelist_node* node);
+static u64 max_entries_get(u64 total_size);
+static u32 get_node(internal_state* state);
+static void return_node(internal_state* state, u32 index);
+static u32 tree_insert(internal_state* state, freelist_tree tree, u32 root, u32 index);
+static u32 tree_remove(internal_state* state, freelist_tree tree, u32 root, u32 index);
+static u32 size_lower_bound(internal_state* state, u64 size);
+static void free_range_insert(internal_state* state, u32 index, u64 offset, u64 size);
 
 void freelist_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list) {
     // Enough space to hold state, plus array for all nodes.
-    u64 max_entries = (total_size / (sizeof(void*) * sizeof(freelist_node))); // NOTE: This might have a remainder, but that's ok.
-
-    // Catch an edge case of having a really small amount of memory to manage, and only having a
-    // super small number of entries. Always make sure we have at least a decent amount, like 20 or so.
-    if (max_entries < 20) {
-        max_entries = 20;
-    }
+    u64 max_entries = max_entries_get(total_size);
 
     *memory_requirement = sizeof(internal_state) + (sizeof(freelist_node) * max_entries);
     if (!memory) {
@@ -45,69 +78,87 @@ void freelist_create(u64 total_size, u64* memory_requirement, void* memory, free
 
     out_list->memory = memory;
 
-    // The block's layout is head* first, then array of available nodes.
-    kzero_memory(out_list->memory, *memory_requirement);
+    // The block's layout is state first, then array of available nodes.
+    kzero_memory(out_list->memory, sizeof(internal_state));
     internal_state* state = out_list->memory;
     state->nodes = (void*)(out_list->memory + sizeof(internal_state));
     state->max_entries = max_entries;
     state->total_size = total_size;
 
-    kzero_memory(state->nodes, sizeof(freelist_node) * state->max_entries);
-
-    state->head = &state->nodes[0];
-    state->head->offset = 0;
-    state->head->size = total_size;
-    state->head->next = 0;
+    freelist_clear(out_list);
 }
 
 void freelist_destroy(freelist* list) {
     if (list && list->memory) {
         // Just zero out the memory before giving it back.
-        internal_state* state = list->memory;
-        kzero_memory(list->memory, sizeof(internal_state) + sizeof(freelist_node) * state->max_entries);
+        kzero_memory(list->memory, sizeof(internal_state));
         list->memory = 0;
     }
 }
 
 b8 freelist_allocate_block(freelist* list, u64 size, u64* out_offset) {
-    if (!list || !out_offset || !list->memory) {
+    return freelist_allocate_block_aligned(list, size, 1, out_offset);
+}
+
+b8 freelist_allocate_block_aligned(freelist* list, u64 size, u64 alignment, u64* out_offset) {
+    if (!list || !out_offset || !list->memory || !size || !alignment) {
+        return false;
+    }
+    if (alignment & (alignment - 1)) {
+        KERROR("freelist_allocate_block_aligned requires a power-of-two alignment (got %llu).", alignment);
         return false;
     }
     internal_state* state = list->memory;
-    freelist_node* node = state->head;
-    freelist_node* previous = 0;
-    while (node) {
-        if (node->size == size) {
-            // Exact match. Just return the node.
-            *out_offset = node->offset;
-            freelist_node* node_to_return = 0;
-            if (previous) {
-                previous->next = node->next;
-                node_to_return = node;
-            } else {
-                // This node is the head of the list. Reassign the head
-                // and return the previous head node.
-                node_to_return = state->head;
-                state->head = node->next;
-            }
-            return_node(node_to_return);
-            return true;
-        } else if (node->size > size) {
-            // Node is larger. Deduct the memory from it and move the offset
-            // by that amount.
-            *out_offset = node->offset;
-            node->size -= size;
-            node->offset += size;
-            return true;
+
+    // Take the smallest range that fits. If that range can't also satisfy the alignment, take the
+    // smallest one which is guaranteed to, regardless of where it starts.
+    u32 index = size_lower_bound(state, size);
+    if (index != NODE_NONE && alignment > 1) {
+        freelist_node* node = &state->nodes[index];
+        if (get_aligned(node->offset, alignment) + size > node->offset + node->size) {
+            index = size_lower_bound(state, size + alignment - 1);
+        }
+    }
+
+    if (index == NODE_NONE) {
+        KWARN("freelist_find_block, no block with enough free space found (requested: %lluB, available: %lluB).", size, state->free_space);
+        return false;
+    }
+
+    freelist_node* node = &state->nodes[index];
+    u64 node_end = node->offset + node->size;
+    u64 offset = get_aligned(node->offset, alignment);
+    u64 prefix = offset - node->offset;
+    u64 suffix = node_end - (offset + size);
+
+    // Space before and after the block means the range is split in two, which requires another node.
+    u32 suffix_index = NODE_NONE;
+    if (prefix && suffix) {
+        suffix_index = get_node(state);
+        if (suffix_index == NODE_NONE) {
+            KWARN("freelist_allocate_block_aligned has run out of nodes to track free ranges with.");
+            return false;
         }
+    }
+
+    state->roots[FREELIST_TREE_OFFSET] = tree_remove(state, FREELIST_TREE_OFFSET, state->roots[FREELIST_TREE_OFFSET], index);
+    state->roots[FREELIST_TREE_SIZE] = tree_remove(state, FREELIST_TREE_SIZE, state->roots[FREELIST_TREE_SIZE], index);
+    state->free_block_count--;
 
-        previous = node;
-        node = node->next;
+    if (prefix) {
+        free_range_insert(state, index, node->offset, prefix);
+        if (suffix) {
+            free_range_insert(state, suffix_index, offset + size, suffix);
+        }
+    } else if (suffix) {
+        free_range_insert(state, index, offset + size, suffix);
+    } else {
+        return_node(state, index);
     }
 
-    u64 free_space = freelist_free_space(list);
-    KWARN("freelist_find_block, no block with enough free space found (requested: %lluB, available: %lluB).", size, free_space);
-    return false;
+    state->free_space -= size;
+    *out_offset = offset;
+    return true;
 }
 
 b8 freelist_free_block(freelist* list, u64 size, u64 offset) {
@@ -115,105 +166,87 @@ b8 freelist_free_block(freelist* list, u64 size, u64 offset) {
         return false;
     }
     internal_state* state = list->memory;
-    freelist_node* node = state->head;
-    freelist_node* previous = 0;
-    if (!node) {
-        // Check for the case where the entire thing is allocated.
-        // In this case a new node is needed at the head.
-        freelist_node* new_node = get_node(list);
-        new_node->offset = offset;
-        new_node->size = size;
-        new_node->next = 0;
-        state->head = new_node;
-        return true;
+    if (offset + size > state->total_size) {
+        KWARN("freelist_free_block trying to free range (offset=%llu, size=%llu) outside of list (size=%llu).", offset, size, state->total_size);
+        return false;
+    }
+
+    // Find the free ranges immediately before and after the one being freed.
+    u32 prev = NODE_NONE;
+    u32 next = NODE_NONE;
+    u32 i = state->roots[FREELIST_TREE_OFFSET];
+    while (i != NODE_NONE) {
+        freelist_node* node = &state->nodes[i];
+        if (node->offset == offset) {
+            // If there is an exact match, this means the exact block of memory
+            // that is already free is being freed again.
+            KFATAL("Attempting to free already-freed block of memory at offset %llu", node->offset);
+            return false;
+        } else if (node->offset < offset) {
+            prev = i;
+            i = node->links[FREELIST_TREE_OFFSET].right;
+        } else {
+            next = i;
+            i = node->links[FREELIST_TREE_OFFSET].left;
+        }
+    }
+
+    freelist_node* prev_node = prev != NODE_NONE ? &state->nodes[prev] : 0;
+    freelist_node* next_node = next != NODE_NONE ? &state->nodes[next] : 0;
+    if ((prev_node && prev_node->offset + prev_node->size > offset) || (next_node && offset + size > next_node->offset)) {
+        KFATAL("Attempting to free block of memory (offset=%llu, size=%llu) which overlaps free space.", offset, size);
+        return false;
+    }
+
+    b8 join_prev = prev_node && prev_node->offset + prev_node->size == offset;
+    b8 join_next = next_node && offset + size == next_node->offset;
+
+    if (join_prev && join_next) {
+        // Bridges the gap between both neighbours. Fold everything into the previous range.
+        state->roots[FREELIST_TREE_OFFSET] = tree_remove(state, FREELIST_TREE_OFFSET, state->roots[FREELIST_TREE_OFFSET], next);
+        state->roots[FREELIST_TREE_SIZE] = tree_remove(state, FREELIST_TREE_SIZE, state->roots[FREELIST_TREE_SIZE], next);
+        state->roots[FREELIST_TREE_SIZE] = tree_remove(state, FREELIST_TREE_SIZE, state->roots[FREELIST_TREE_SIZE], prev);
+        prev_node->size += size + next_node->size;
+        state->roots[FREELIST_TREE_SIZE] = tree_insert(state, FREELIST_TREE_SIZE, state->roots[FREELIST_TREE_SIZE], prev);
+        return_node(state, next);
+        state->free_block_count--;
+    } else if (join_prev) {
+        // Growing the previous range doesn't change its position by offset, only by size.
+        state->roots[FREELIST_TREE_SIZE] = tree_remove(state, FREELIST_TREE_SIZE, state->roots[FREELIST_TREE_SIZE], prev);
+        prev_node->size += size;
+        state->roots[FREELIST_TREE_SIZE] = tree_insert(state, FREELIST_TREE_SIZE, state->roots[FREELIST_TREE_SIZE], prev);
+    } else if (join_next) {
+        // Nothing lies between the previous range and here, so moving the next range's
+        // offset back doesn't change its position by offset either.
+        state->roots[FREELIST_TREE_SIZE] = tree_remove(state, FREELIST_TREE_SIZE, state->roots[FREELIST_TREE_SIZE], next);
+        next_node->offset = offset;
+        next_node->size += size;
+        state->roots[FREELIST_TREE_SIZE] = tree_insert(state, FREELIST_TREE_SIZE, state->roots[FREELIST_TREE_SIZE], next);
     } else {
-        while (node) {
-            if (node->offset + node->size == offset) {
-                // Can be appended to the right of this node.
-                node->size += size;
-
-                // Check if this then connects the range between this and the next
-                // node, and if so, combine them and return the second node..
-                if (node->next && node->next->offset == node->offset + node->size) {
-                    node->size += node->next->size;
-                    freelist_node* next = node->next;
-                    node->next = node->next->next;
-                    return_node(next);
-                }
-                return true;
-            } else if (node->offset == offset) {
-                // If there is an exact match, this means the exact block of memory
-                // that is already free is being freed again.
-                KFATAL("Attempting to free already-freed block of memory at offset %llu", node->offset);
-                return false;
-            } else if (node->offset > offset) {
-                // Iterated beyond the space to be freed. Need a new node.
-                freelist_node* new_node = get_node(list);
-                new_node->offset = offset;
-                new_node->size = size;
-
-                // If there is a previous node, the new node should be inserted between this and it.
-                if (previous) {
-                    previous->next = new_node;
-                    new_node->next = node;
-                } else {
-                    // Otherwise, the new node becomes the head.
-                    new_node->next = node;
-                    state->head = new_node;
-                }
-
-                // Double-check next node to see if it can be joined.
-                if (new_node->next && new_node->offset + new_node->size == new_node->next->offset) {
-                    new_node->size += new_node->next->size;
-                    freelist_node* rubbish = new_node->next;
-                    new_node->next = rubbish->next;
-                    return_node(rubbish);
-                }
-
-                // Double-check previous node to see if the new_node can be joined to it.
-                if (previous && previous->offset + previous->size == new_node->offset) {
-                    previous->size += new_node->size;
-                    freelist_node* rubbish = new_node;
-                    previous->next = rubbish->next;
-                    return_node(rubbish);
-                }
-
-                return true;
-            }
-
-            // If on the last node and the last node's offset + size < the free offset,
-            // a new node is required.
-            if (!node->next && node->offset + node->size < offset) {
-                freelist_node* new_node = get_node(list);
-                new_node->offset = offset;
-                new_node->size = size;
-                new_node->next = 0;
-                node->next = new_node;
-
-                return true;
-            }
-
-            previous = node;
-            node = node->next;
+        u32 index = get_node(state);
+        if (index == NODE_NONE) {
+            KERROR("freelist_free_block has run out of nodes to track free ranges with. Memory is being leaked.");
+            return false;
         }
+        free_range_insert(state, index, offset, size);
     }
 
-    KWARN("Unable to find block to be freed. Corruption possible?");
-    return false;
+    state->free_space += size;
+    return true;
 }
 
 b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memory, u64 new_size, void** out_old_memory) {
-    if (!list || !memory_requirement || ((internal_state*)list->memory)->total_size > new_size) {
+    if (!list || !memory_requirement || !list->memory || ((internal_state*)list->memory)->total_size > new_size) {
         return false;
     }
 
     // Enough space to hold state, plus array for all nodes.
-    u64 max_entries = (new_size / sizeof(void*)); // NOTE: This might have a remainder, but that's ok.
+    u64 max_entries = max_entries_get(new_size);
 
-    // Catch an edge case of having a really small amount of memory to manage, and only having a
-    // super small number of entries. Always make sure we have at least a decent amount, like 20 or so.
-    if (max_entries < 20) {
-        max_entries = 20;
+    internal_state* old_state = (internal_state*)list->memory;
+    // Never shrink the node pool, since every node in use has to be carried over.
+    if (max_entries < old_state->max_entries) {
+        max_entries = old_state->max_entries;
     }
 
     *memory_requirement = sizeof(internal_state) + (sizeof(freelist_node) * max_entries);
@@ -224,70 +257,22 @@ b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memory, u6
     // Assign the old memory pointer so it can be freed.
     *out_old_memory = list->memory;
 
-    // Copy over the old state to the new.
-    internal_state* old_state = (internal_state*)list->memory;
-    u64 size_diff = new_size - old_state->total_size;
-
     // Setup the new memory
     list->memory = new_memory;
 
-    // The block's layout is head* first, then array of available nodes.
-    kzero_memory(list->memory, *memory_requirement);
-
-    // Setup the new state.
+    // Copy over the old state and nodes to the new. Since nodes refer to each other by index,
+    // the trees remain intact.
     internal_state* state = (internal_state*)list->memory;
+    kcopy_memory(state, old_state, sizeof(internal_state));
     state->nodes = (void*)(list->memory + sizeof(internal_state));
+    // Only nodes which have been used need to be copied.
+    kcopy_memory(state->nodes, old_state->nodes, sizeof(freelist_node) * old_state->next_untouched);
     state->max_entries = max_entries;
     state->total_size = new_size;
 
-    // Invalidate the offset for all but the first node. The invalid
-    // value will be checked for when seeking a new node from the list.
-    kzero_memory(state->nodes, sizeof(freelist_node) * state->max_entries);
-
-    state->head = &state->nodes[0];
-
-    // Copy over the nodes.
-    freelist_node* new_list_node = state->head;
-    freelist_node* old_node = old_state->head;
-    if (!old_node) {
-        // If there is no head, then the entire list is allocated. In this case,
-        // the head should be set to the difference of the space now available, and
-        // at the end of the list.
-        state->head->offset = old_state->total_size;
-        state->head->size = size_diff;
-        state->head->next = 0;
-    } else {
-        // Iterate the old nodes.
-        while (old_node) {
-            // Get a new node, copy the offset/size, and set next to it.
-            freelist_node* new_node = get_node(list);
-            new_node->offset = old_node->offset;
-            new_node->size = old_node->size;
-            new_node->next = 0;
-            new_list_node->next = new_node;
-            // Move to the next entry.
-            new_list_node = new_list_node->next;
-
-            if (old_node->next) {
-                // If there is another node, move on.
-                old_node = old_node->next;
-            } else {
-                // Reached the end of the list.
-                // Check if it extends to the end of the block. If so,
-                // just append to the size. Otherwise, create a new node and
-                // attach to it.
-                if (old_node->offset + old_node->size == old_state->total_size) {
-                    new_node->size += size_diff;
-                } else {
-                    freelist_node* new_node_end = get_node(list);
-                    new_node_end->offset = old_state->total_size;
-                    new_node_end->size = size_diff;
-                    new_node_end->next = 0;
-                    new_node->next = new_node_end;
-                }
-                break;
-            }
-        }
+    // Free the newly-added space at the end, which joins it to the last range if that reached the old end.
+    if (new_size > old_state->total_size) {
+        return freelist_free_block(list, new_size - old_state->total_size, old_state->total_size);
     }
 
     return true;
@@ -299,14 +284,18 @@ void freelist_clear(freelist* list) {
     }
 
     internal_state* state = list->memory;
-    // Invalidate the offset for all but the first node. The invalid
-    // value will be checked for when seeking a new node from the list.
-    kzero_memory(state->nodes, sizeof(freelist_node) * state->max_entries);
-
-    // Reset the head to occupy the entire thing.
-    state->head->offset = 0;
-    state->head->size = state->total_size;
-    state->head->next = 0;
+    state->unused_head = NODE_NONE;
+    state->next_untouched = 0;
+    state->roots[FREELIST_TREE_OFFSET] = NODE_NONE;
+    state->roots[FREELIST_TREE_SIZE] = NODE_NONE;
+    state->free_space = 0;
+    state->free_block_count = 0;
+
+    // Reset to a single range occupying the entire thing.
+    if (state->total_size) {
+        free_range_insert(state, get_node(state), 0, state->total_size);
+        state->free_space = state->total_size;
+    }
 }
 
 u64 freelist_free_space(freelist* list) {
@@ -314,33 +303,237 @@ u64 freelist_free_space(freelist* list) {
         return 0;
     }
 
-    u64 running_total = 0;
     internal_state* state = list->memory;
-    freelist_node* node = state->head;
-    while (node) {
-        running_total += node->size;
-        node = node->next;
+    return state->free_space;
+}
+
+u64 freelist_largest_free_block(freelist* list) {
+    if (!list || !list->memory) {
+        return 0;
     }
 
-    return running_total;
+    // The largest range is the rightmost in the size tree.
+    internal_state* state = list->memory;
+    u32 i = state->roots[FREELIST_TREE_SIZE];
+    if (i == NODE_NONE) {
+        return 0;
+    }
+    while (state->nodes[i].links[FREELIST_TREE_SIZE].right != NODE_NONE) {
+        i = state->nodes[i].links[FREELIST_TREE_SIZE].right;
+    }
+    return state->nodes[i].size;
 }
 
-static freelist_node* get_node(freelist* list) {
+u64 freelist_trailing_free_offset(freelist* list) {
+    if (!list || !list->memory) {
+        return 0;
+    }
+
+    // The last range by offset, if it reaches the end of the list.
     internal_state* state = list->memory;
-    for (u64 i = 1; i < state->max_entries; ++i) {
-        if (state->nodes[i].size == 0) {
-            state->nodes[i].next = 0;
-            state->nodes[i].offset = 0;
-            return &state->nodes[i];
-        }
+    u32 i = state->roots[FREELIST_TREE_OFFSET];
+    if (i == NODE_NONE) {
+        return state->total_size;
     }
+    while (state->nodes[i].links[FREELIST_TREE_OFFSET].right != NODE_NONE) {
+        i = state->nodes[i].links[FREELIST_TREE_OFFSET].right;
+    }
+    freelist_node* node = &state->nodes[i];
+    return node->offset + node->size == state->total_size ? node->offset : state->total_size;
+}
 
-    // Return nothing if no nodes are available.
-    return 0;
+u64 freelist_free_block_count(freelist* list) {
+    if (!list || !list->memory) {
+        return 0;
+    }
+
+    internal_state* state = list->memory;
+    return state->free_block_count;
+}
+
+static u64 max_entries_get(u64 total_size) {
+    u64 max_entries = (total_size / (sizeof(void*) * sizeof(freelist_node))); // NOTE: This might have a remainder, but that's ok.
+
+    // Catch an edge case of having a really small amount of memory to manage, and only having a
+    // super small number of entries. Always make sure we have at least a decent amount, like 20 or so.
+    if (max_entries < 20) {
+        max_entries = 20;
+    }
+    // Nodes are referred to by u32 index.
+    if (max_entries >= NODE_NONE) {
+        max_entries = NODE_NONE - 1;
+    }
+    return max_entries;
+}
+
+static u32 get_node(internal_state* state) {
+    u32 index = state->unused_head;
+    if (index != NODE_NONE) {
+        state->unused_head = state->nodes[index].links[FREELIST_TREE_OFFSET].left;
+    } else if (state->next_untouched < state->max_entries) {
+        index = state->next_untouched++;
+    }
+
+    // Returns NODE_NONE if no nodes are available.
+    return index;
 }
 
-static void return_node(freelist_node* node) {
+static void return_node(internal_state* state, u32 index) {
+    freelist_node* node = &state->nodes[index];
     node->offset = 0;
     node->size = 0;
-    node->next = 0;
+    node->links[FREELIST_TREE_OFFSET].left = state->unused_head;
+    state->unused_head = index;
+}
+
+static void free_range_insert(internal_state* state, u32 index, u64 offset, u64 size) {
+    state->nodes[index].offset = offset;
+    state->nodes[index].size = size;
+    state->roots[FREELIST_TREE_OFFSET] = tree_insert(state, FREELIST_TREE_OFFSET, state->roots[FREELIST_TREE_OFFSET], index);
+    state->roots[FREELIST_TREE_SIZE] = tree_insert(state, FREELIST_TREE_SIZE, state->roots[FREELIST_TREE_SIZE], index);
+    state->free_block_count++;
+}
+
+static u32 size_lower_bound(internal_state* state, u64 size) {
+    // Find the smallest range at least as large as size. Among equally-sized ranges, the lowest offset wins.
+    u32 best = NODE_NONE;
+    u32 i = state->roots[FREELIST_TREE_SIZE];
+    while (i != NODE_NONE) {
+        if (state->nodes[i].size >= size) {
+            best = i;
+            i = state->nodes[i].links[FREELIST_TREE_SIZE].left;
+        } else {
+            i = state->nodes[i].links[FREELIST_TREE_SIZE].right;
+        }
+    }
+    return best;
+}
+
+// AVL tree operations. Each takes the index of a subtree root and returns the new root of that subtree.
+
+static i32 node_compare(internal_state* state, freelist_tree tree, u32 a, u32 b) {
+    freelist_node* na = &state->nodes[a];
+    freelist_node* nb = &state->nodes[b];
+    if (tree == FREELIST_TREE_SIZE && na->size != nb->size) {
+        return na->size < nb->size ? -1 : 1;
+    }
+    if (na->offset != nb->offset) {
+        return na->offset < nb->offset ? -1 : 1;
+    }
+    return 0;
+}
+
+static KINLINE freelist_link* link_get(internal_state* state, freelist_tree tree, u32 index) {
+    return &state->nodes[index].links[tree];
+}
+
+static KINLINE u32 height_get(internal_state* state, freelist_tree tree, u32 index) {
+    return index == NODE_NONE ? 0 : state->nodes[index].links[tree].height;
+}
+
+static void height_update(internal_state* state, freelist_tree tree, u32 index) {
+    freelist_link* link = link_get(state, tree, index);
+    u32 lh = height_get(state, tree, link->left);
+    u32 rh = height_get(state, tree, link->right);
+    link->height = 1 + (lh > rh ? lh : rh);
+}
+
+static u32 rotate_right(internal_state* state, freelist_tree tree, u32 index) {
+    freelist_link* link = link_get(state, tree, index);
+    u32 left = link->left;
+    freelist_link* left_link = link_get(state, tree, left);
+    link->left = left_link->right;
+    left_link->right = index;
+    height_update(state, tree, index);
+    height_update(state, tree, left);
+    return left;
+}
+
+static u32 rotate_left(internal_state* state, freelist_tree tree, u32 index) {
+    freelist_link* link = link_get(state, tree, index);
+    u32 right = link->right;
+    freelist_link* right_link = link_get(state, tree, right);
+    link->right = right_link->left;
+    right_link->left = index;
+    height_update(state, tree, index);
+    height_update(state, tree, right);
+    return right;
+}
+
+static u32 rebalance(internal_state* state, freelist_tree tree, u32 index) {
+    height_update(state, tree, index);
+    freelist_link* link = link_get(state, tree, index);
+    i32 balance = (i32)height_get(state, tree, link->left) - (i32)height_get(state, tree, link->right);
+    if (balance > 1) {
+        freelist_link* left_link = link_get(state, tree, link->left);
+        if (height_get(state, tree, left_link->left) < height_get(state, tree, left_link->right)) {
+            link->left = rotate_left(state, tree, link->left);
+        }
+        return rotate_right(state, tree, index);
+    } else if (balance < -1) {
+        freelist_link* right_link = link_get(state, tree, link->right);
+        if (height_get(state, tree, right_link->right) < height_get(state, tree, right_link->left)) {
+            link->right = rotate_right(state, tree, link->right);
+        }
+        return rotate_left(state, tree, index);
+    }
+    return index;
+}
+
+static u32 tree_insert(internal_state* state, freelist_tree tree, u32 root, u32 index) {
+    if (root == NODE_NONE) {
+        freelist_link* link = link_get(state, tree, index);
+        link->left = NODE_NONE;
+        link->right = NODE_NONE;
+        link->height = 1;
+        return index;
+    }
+
+    freelist_link* root_link = link_get(state, tree, root);
+    if (node_compare(state, tree, index, root) < 0) {
+        root_link->left = tree_insert(state, tree, root_link->left, index);
+    } else {
+        root_link->right = tree_insert(state, tree, root_link->right, index);
+    }
+    return rebalance(state, tree, root);
+}
+
+static u32 tree_remove_min(internal_state* state, freelist_tree tree, u32 root, u32* out_min) {
+    freelist_link* root_link = link_get(state, tree, root);
+    if (root_link->left == NODE_NONE) {
+        *out_min = root;
+        return root_link->right;
+    }
+    root_link->left = tree_remove_min(state, tree, root_link->left, out_min);
+    return rebalance(state, tree, root);
+}
+
+static u32 tree_remove(internal_state* state, freelist_tree tree, u32 root, u32 index) {
+    if (root == NODE_NONE) {
+        KERROR("freelist tree_remove could not find node %u. Corruption possible?", index);
+        return NODE_NONE;
+    }
+
+    freelist_link* root_link = link_get(state, tree, root);
+    i32 cmp = node_compare(state, tree, index, root);
+    if (cmp < 0) {
+        root_link->left = tree_remove(state, tree, root_link->left, index);
+    } else if (cmp > 0) {
+        root_link->right = tree_remove(state, tree, root_link->right, index);
+    } else {
+        if (root_link->left == NODE_NONE) {
+            return root_link->right;
+        }
+        if (root_link->right == NODE_NONE) {
+            return root_link->left;
+        }
+        // Replace with the smallest node from the right subtree.
+        u32 min = NODE_NONE;
+        u32 right = tree_remove_min(state, tree, root_link->right, &min);
+        freelist_link* min_link = link_get(state, tree, min);
+        min_link->left = root_link->left;
+        min_link->right = right;
+        return rebalance(state, tree, min);
+    }
+    return rebalance(state, tree, root);
 }
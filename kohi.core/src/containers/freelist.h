@@ -15,7 +15,8 @@
 
 /**
  * @brief A data structure to be used alongside an allocator for dynamic memory
- * allocation. Tracks free ranges of memory.
+ * allocation. Tracks free ranges of memory. Allocations are best-fit, and both
+ * allocation and free are O(log n) in the number of free ranges.
  */
 typedef struct freelist {
     /** @brief The internal state of the freelist. */
@@ -51,6 +52,19 @@ KAPI void freelist_destroy(freelist* list);
  */
 KAPI b8 freelist_allocate_block(freelist* list, u64 size, u64* out_offset);
 
+/**
+ * @brief Attempts to find a free block of memory of the given size, whose offset
+ * is a multiple of the given alignment. Any space skipped to satisfy alignment
+ * remains free.
+ *
+ * @param list A pointer to the list to search.
+ * @param size The size to allocate.
+ * @param alignment The alignment of the offset. Must be a power of two.
+ * @param out_offset A pointer to hold the offset to the allocated memory.
+ * @return b8 True if a block of memory was found and allocated; otherwise false.
+ */
+KAPI b8 freelist_allocate_block_aligned(freelist* list, u64 size, u64 alignment, u64* out_offset);
+
 /**
  * @brief Attempts to free a block of memory at the given offset, and of the given
  * size. Can fail if invalid data is passed.
@@ -86,11 +100,37 @@ KAPI b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memor
 KAPI void freelist_clear(freelist* list);
 
 /**
- * @brief Returns the amount of free space in this list. NOTE: Since this has
- * to iterate the entire internal list, this can be an expensive operation.
- * Use sparingly.
+ * @brief Returns the amount of free space in this list.
  * 
  * @param list A pointer to the list to obtain from.
  * @return The amount of free space in bytes.
  */
 KAPI u64 freelist_free_space(freelist* list);
+
+/**
+ * @brief Returns the size of the largest contiguous free range in this list,
+ * which is the largest allocation that can currently succeed.
+ *
+ * @param list A pointer to the list to obtain from.
+ * @return The size of the largest free range in bytes.
+ */
+KAPI u64 freelist_largest_free_block(freelist* list);
+
+/**
+ * @brief Returns the number of separate free ranges in this list. Along with
+ * freelist_largest_free_block, this gives an indication of fragmentation.
+ *
+ * @param list A pointer to the list to obtain from.
+ * @return The number of free ranges.
+ */
+KAPI u64 freelist_free_block_count(freelist* list);
+
+/**
+ * @brief Returns the offset at which the run of free space reaching the end of the
+ * list begins. Everything from this offset onward is free. Useful for allocators
+ * which need to know how much of their memory is actually in use.
+ *
+ * @param list A pointer to the list to obtain from.
+ * @return The offset of the trailing free space, or the total size of the list if the end is in use.
+ */
+KAPI u64 freelist_trailing_free_offset(freelist* list);
@@ -0,0 +1,138 @@
+#include "mpmc_queue.h"
+
+#include "logger.h"
+#include "memory/kmemory.h"
+#include "threads/katomic.h"
+
+// Each cell is a sequence number followed by the element.
+static KINLINE u64 cell_size_get(u32 stride) {
+    return get_aligned(sizeof(u64) + stride, sizeof(u64));
+}
+
+static KINLINE u64* cell_sequence(const mpmc_queue* queue, u64 position) {
+    return (u64*)((u8*)queue->block + (queue->cell_size * (position & (queue->capacity - 1))));
+}
+
+static KINLINE void* cell_data(u64* sequence) {
+    return (u8*)sequence + sizeof(u64);
+}
+
+u64 mpmc_queue_memory_requirement(u32 stride, u32 capacity) {
+    return cell_size_get(stride) * capacity;
+}
+
+b8 mpmc_queue_create(u32 stride, u32 capacity, void* memory, mpmc_queue* out_queue) {
+    if (!out_queue) {
+        KERROR("mpmc_queue_create requires a valid pointer to hold the queue.");
+        return false;
+    }
+    if (!stride || capacity < 2 || (capacity & (capacity - 1))) {
+        KERROR("mpmc_queue_create requires a nonzero stride and a capacity which is a power of two of at least 2.");
+        return false;
+    }
+
+    kzero_memory(out_queue, sizeof(mpmc_queue));
+    out_queue->stride = stride;
+    out_queue->capacity = capacity;
+    out_queue->cell_size = cell_size_get(stride);
+    if (memory) {
+        out_queue->owns_memory = false;
+        out_queue->block = memory;
+    } else {
+        out_queue->owns_memory = true;
+        out_queue->block = kallocate(mpmc_queue_memory_requirement(stride, capacity), MEMORY_TAG_RING_QUEUE);
+    }
+
+    // Each cell starts out ready to be written at its own position during the first lap.
+    for (u64 i = 0; i < capacity; ++i) {
+        *cell_sequence(out_queue, i) = i;
+    }
+    katomic_thread_fence();
+
+    return true;
+}
+
+void mpmc_queue_destroy(mpmc_queue* queue) {
+    if (queue) {
+        if (queue->owns_memory && queue->block) {
+            kfree(queue->block, mpmc_queue_memory_requirement(queue->stride, queue->capacity), MEMORY_TAG_RING_QUEUE);
+        }
+        kzero_memory(queue, sizeof(mpmc_queue));
+    }
+}
+
+b8 mpmc_queue_enqueue(mpmc_queue* queue, const void* value) {
+    if (!queue || !value) {
+        KERROR("mpmc_queue_enqueue requires valid pointers to queue and value.");
+        return false;
+    }
+
+    u64 position = katomic_load_u64(&queue->enqueue_position);
+    u64* sequence;
+    for (;;) {
+        sequence = cell_sequence(queue, position);
+        i64 difference = (i64)katomic_load_u64(sequence) - (i64)position;
+        if (difference == 0) {
+            // The cell is free for this lap. Try to claim the position.
+            if (katomic_compare_exchange_u64(&queue->enqueue_position, &position, position + 1)) {
+                break;
+            }
+            // Another producer claimed it. position now holds the current one.
+        } else if (difference < 0) {
+            // The cell still holds an element from the previous lap, so the queue is full.
+            return false;
+        } else {
+            // Another producer claimed this position and moved on. Catch up.
+            position = katomic_load_u64(&queue->enqueue_position);
+        }
+    }
+
+    kcopy_memory(cell_data(sequence), value, queue->stride);
+    // Publish the element to consumers.
+    katomic_store_u64(sequence, position + 1);
+    return true;
+}
+
+b8 mpmc_queue_dequeue(mpmc_queue* queue, void* out_value) {
+    if (!queue || !out_value) {
+        KERROR("mpmc_queue_dequeue requires valid pointers to queue and out_value.");
+        return false;
+    }
+
+    u64 position = katomic_load_u64(&queue->dequeue_position);
+    u64* sequence;
+    for (;;) {
+        sequence = cell_sequence(queue, position);
+        i64 difference = (i64)katomic_load_u64(sequence) - (i64)(position + 1);
+        if (difference == 0) {
+            // The cell has been published for this lap. Try to claim the position.
+            if (katomic_compare_exchange_u64(&queue->dequeue_position, &position, position + 1)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // Nothing has been published here yet, so the queue is empty.
+            return false;
+        } else {
+            // Another consumer claimed this position and moved on. Catch up.
+            position = katomic_load_u64(&queue->dequeue_position);
+        }
+    }
+
+    kcopy_memory(out_value, cell_data(sequence), queue->stride);
+    // Mark the cell as free for the next lap.
+    katomic_store_u64(sequence, position + queue->capacity);
+    return true;
+}
+
+u32 mpmc_queue_length(const mpmc_queue* queue) {
+    if (!queue) {
+        return 0;
+    }
+    u64 dequeue_position = katomic_load_u64(&queue->dequeue_position);
+    u64 enqueue_position = katomic_load_u64(&queue->enqueue_position);
+    // The two are read separately, so the dequeue position can appear to be ahead.
+    if (enqueue_position <= dequeue_position) {
+        return 0;
+    }
+    return (u32)KMIN(enqueue_position - dequeue_position, (u64)queue->capacity);
+}
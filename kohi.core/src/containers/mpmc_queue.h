@@ -0,0 +1,104 @@
+/**
+ * @file mpmc_queue.h
+ * @author Travis Vroman (travis@kohiengine.com)
+ * @brief A bounded, lock-free, multi-producer/multi-consumer queue.
+ * @details Based on Dmitry Vyukov's bounded MPMC queue. Each cell carries a
+ * sequence number which tells producers and consumers whether it is ready to be
+ * written to or read from for the current lap around the ring. Producers and
+ * consumers each claim a position with a single compare-exchange, so any number
+ * of threads may enqueue and dequeue at once without locks. The queue does not
+ * resize; enqueueing fails when it is full.
+ * @version 1.0
+ * @date 2024-11-06
+ *
+ * @copyright Kohi Game Engine is Copyright (c) Travis Vroman 2021-2024
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A bounded lock-free queue which may be used from any number of threads
+ * at once. Members of this structure should not be modified outside the functions
+ * associated with it.
+ */
+typedef struct mpmc_queue {
+    /** @brief The size of each element in bytes. */
+    u32 stride;
+    /** @brief The total number of elements available. Always a power of two. */
+    u32 capacity;
+    /** @brief The size of each cell (sequence number plus element) in bytes. */
+    u64 cell_size;
+    /** @brief The block of memory holding the cells. */
+    void* block;
+    /** @brief Indicates if the queue owns its memory block. */
+    b8 owns_memory;
+
+    u8 padding0[KCACHE_LINE_SIZE];
+    /** @brief The next position to be written to. Written by producers only. */
+    u64 enqueue_position;
+    u8 padding1[KCACHE_LINE_SIZE - sizeof(u64)];
+    /** @brief The next position to be read from. Written by consumers only. */
+    u64 dequeue_position;
+    u8 padding2[KCACHE_LINE_SIZE - sizeof(u64)];
+} mpmc_queue;
+
+/**
+ * @brief Obtains the amount of memory needed by a queue of the given stride and capacity.
+ *
+ * @param stride The size of each element in bytes.
+ * @param capacity The total number of elements to be available in the queue.
+ * @returns The size in bytes of the memory block the queue requires.
+ */
+KAPI u64 mpmc_queue_memory_requirement(u32 stride, u32 capacity);
+
+/**
+ * @brief Creates a new queue of the given capacity and stride. Must not be called
+ * while other threads may be using the queue.
+ *
+ * @param stride The size of each element in bytes.
+ * @param capacity The total number of elements to be available in the queue. Must be a power of two, and at least 2.
+ * @param memory The memory block used to hold the data. Should be the size given by
+ * mpmc_queue_memory_requirement(). If 0 is passed, a block is automatically allocated and
+ * freed upon creation/destruction.
+ * @param out_queue A pointer to hold the newly created queue.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 mpmc_queue_create(u32 stride, u32 capacity, void* memory, mpmc_queue* out_queue);
+
+/**
+ * @brief Destroys the given queue. If memory was not passed in during creation,
+ * it is freed here. Must not be called while other threads may be using the queue.
+ *
+ * @param queue A pointer to the queue to destroy.
+ */
+KAPI void mpmc_queue_destroy(mpmc_queue* queue);
+
+/**
+ * @brief Adds a copy of value to the queue, if space is available. Safe to call from any thread.
+ *
+ * @param queue A pointer to the queue to add data to.
+ * @param value A pointer to the value to be added.
+ * @return True if success; false if the queue is full.
+ */
+KAPI b8 mpmc_queue_enqueue(mpmc_queue* queue, const void* value);
+
+/**
+ * @brief Attempts to retrieve the next value from the queue. Safe to call from any thread.
+ *
+ * @param queue A pointer to the queue to retrieve data from.
+ * @param out_value A pointer to hold the retrieved value.
+ * @return True if success; false if the queue is empty.
+ */
+KAPI b8 mpmc_queue_dequeue(mpmc_queue* queue, void* out_value);
+
+/**
+ * @brief Obtains the number of elements in the queue. If other threads are using the
+ * queue, this is only a snapshot and may be stale as soon as it returns.
+ *
+ * @param queue A pointer to the queue.
+ * @return The number of elements in the queue.
+ */
+KAPI u32 mpmc_queue_length(const mpmc_queue* queue);
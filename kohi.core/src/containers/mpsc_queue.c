@@ -0,0 +1,32 @@
+#include "mpsc_queue.h"
+
+#include "threads/katomic.h"
+
+void mpsc_queue_push(mpsc_queue* queue, mpsc_queue_node* node) {
+    void* head = katomic_load_ptr((void**)&queue->head);
+    do {
+        node->next = head;
+    } while (!katomic_compare_exchange_ptr((void**)&queue->head, &head, node));
+}
+
+mpsc_queue_node* mpsc_queue_take_all(mpsc_queue* queue) {
+    // Skip the exchange when there is nothing to take, so idle polling stays read-only.
+    if (!katomic_load_ptr((void**)&queue->head)) {
+        return 0;
+    }
+
+    // Nodes are pushed onto the front, so the list comes out newest first. Reverse it.
+    mpsc_queue_node* node = katomic_exchange_ptr((void**)&queue->head, 0);
+    mpsc_queue_node* oldest = 0;
+    while (node) {
+        mpsc_queue_node* next = node->next;
+        node->next = oldest;
+        oldest = node;
+        node = next;
+    }
+    return oldest;
+}
+
+b8 mpsc_queue_is_empty(const mpsc_queue* queue) {
+    return katomic_load_ptr((void* const*)&queue->head) == 0;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file mpsc_queue.h
+ * @author Travis Vroman (travis@kohiengine.com)
+ * @brief An unbounded, lock-free, intrusive multi-producer/single-consumer queue.
+ * @details Items are nodes embedded in structures owned by the caller, so the queue
+ * itself never allocates and can never be full. Any number of threads may push at
+ * once, each with a single compare-exchange. One consumer thread takes everything
+ * pushed so far in one exchange, then walks it at leisure without touching shared
+ * memory again. Checking an empty queue is a single atomic load.
+ *
+ * Suited to handing results from worker threads back to one thread, such as job
+ * completions being processed on the main thread once a frame.
+ * @version 1.0
+ * @date 2024-11-09
+ *
+ * @copyright Kohi Game Engine is Copyright (c) Travis Vroman 2021-2024
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A link in an mpsc_queue. Embed one in the structure being queued, and
+ * recover the structure from the node once taken (placing it first makes this a cast).
+ */
+typedef struct mpsc_queue_node {
+    /** @brief The next node. Owned by the queue while the node is in it. */
+    struct mpsc_queue_node* next;
+} mpsc_queue_node;
+
+/**
+ * @brief An unbounded lock-free queue for any number of producer threads and one
+ * consumer thread. A zeroed structure is an empty queue. Members of this structure
+ * should not be modified outside the functions associated with it.
+ */
+typedef struct mpsc_queue {
+    /** @brief The most recently pushed node, which links to the one before it. */
+    mpsc_queue_node* head;
+} mpsc_queue;
+
+/**
+ * @brief Adds the given node to the queue. Safe to call from any thread. The node must
+ * not be modified (or freed) until it has been taken by the consumer.
+ *
+ * @param queue A pointer to the queue.
+ * @param node A pointer to the node to be added.
+ */
+KAPI void mpsc_queue_push(mpsc_queue* queue, mpsc_queue_node* node);
+
+/**
+ * @brief Takes every node in the queue, leaving it empty. Must only be called from
+ * the consumer thread. The nodes are linked through next, oldest first, and the last
+ * has a next of 0. Ownership of the nodes returns to the caller.
+ *
+ * @param queue A pointer to the queue.
+ * @returns The oldest node taken, or 0 if the queue was empty.
+ */
+KAPI mpsc_queue_node* mpsc_queue_take_all(mpsc_queue* queue);
+
+/**
+ * @brief Indicates if the queue is empty. If other threads are pushing, this is only
+ * a snapshot and may be stale as soon as it returns.
+ *
+ * @param queue A pointer to the queue.
+ * @returns True if empty; otherwise false.
+ */
+KAPI b8 mpsc_queue_is_empty(const mpsc_queue* queue);
@@ -0,0 +1,155 @@
+#include "slot_map.h"
+
+#include "identifiers/khandle.h"
+#include "logger.h"
+#include "memory/kmemory.h"
+
+static KINLINE void* element_at(const slot_map* map, u32 index) {
+    return (u8*)map->elements + (map->element_size * index);
+}
+
+// Obtains the slot the handle refers to, if it is live and of the same generation.
+static slot_map_slot* slot_get(const slot_map* map, khandle handle) {
+    if (!map || !map->slots || khandle_is_invalid(handle) || handle.handle_index >= map->slot_count) {
+        return 0;
+    }
+    slot_map_slot* slot = &map->slots[handle.handle_index];
+    if (slot->generation != handle.unique_id.uniqueid || slot->index >= map->count || map->element_slots[slot->index] != handle.handle_index) {
+        return 0;
+    }
+    return slot;
+}
+
+static void grow(slot_map* map, u32 new_capacity) {
+    u32 old_capacity = map->capacity;
+    map->elements = kreallocate(map->elements, map->element_size * old_capacity, map->element_size * new_capacity, MEMORY_TAG_ARRAY);
+    map->element_slots = kreallocate(map->element_slots, sizeof(u32) * old_capacity, sizeof(u32) * new_capacity, MEMORY_TAG_ARRAY);
+    map->slots = kreallocate(map->slots, sizeof(slot_map_slot) * old_capacity, sizeof(slot_map_slot) * new_capacity, MEMORY_TAG_ARRAY);
+    map->capacity = new_capacity;
+}
+
+b8 slot_map_create(u64 element_size, u32 initial_capacity, slot_map* out_map) {
+    if (!out_map) {
+        KERROR("slot_map_create requires a pointer to hold the map.");
+        return false;
+    }
+    if (!element_size) {
+        KERROR("slot_map_create requires a nonzero element_size.");
+        return false;
+    }
+
+    kzero_memory(out_map, sizeof(slot_map));
+    out_map->element_size = element_size;
+    out_map->free_head = INVALID_ID;
+    out_map->capacity = KMAX(initial_capacity, SLOT_MAP_MIN_CAPACITY);
+    out_map->elements = kallocate(element_size * out_map->capacity, MEMORY_TAG_ARRAY);
+    out_map->element_slots = kallocate(sizeof(u32) * out_map->capacity, MEMORY_TAG_ARRAY);
+    out_map->slots = kallocate(sizeof(slot_map_slot) * out_map->capacity, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+void slot_map_destroy(slot_map* map) {
+    if (map && map->slots) {
+        kfree(map->elements, map->element_size * map->capacity, MEMORY_TAG_ARRAY);
+        kfree(map->element_slots, sizeof(u32) * map->capacity, MEMORY_TAG_ARRAY);
+        kfree(map->slots, sizeof(slot_map_slot) * map->capacity, MEMORY_TAG_ARRAY);
+        kzero_memory(map, sizeof(slot_map));
+    }
+}
+
+void* slot_map_acquire(slot_map* map, khandle* out_handle) {
+    if (!map || !map->slots || !out_handle) {
+        KERROR("slot_map_acquire requires a valid map and a pointer to hold the handle.");
+        return 0;
+    }
+
+    u32 slot_index;
+    if (map->free_head != INVALID_ID) {
+        // Reuse the most recently released slot.
+        slot_index = map->free_head;
+        map->free_head = map->slots[slot_index].index;
+    } else {
+        // There are as many slots in use as live elements, so both arrays fill up together.
+        if (map->slot_count == map->capacity) {
+            grow(map, map->capacity * 2);
+        }
+        slot_index = map->slot_count++;
+        map->slots[slot_index].generation = 0;
+    }
+
+    u32 dense_index = map->count++;
+    map->slots[slot_index].index = dense_index;
+    map->element_slots[dense_index] = slot_index;
+
+    *out_handle = khandle_create_with_u64_identifier(slot_index, map->slots[slot_index].generation);
+
+    void* element = element_at(map, dense_index);
+    kzero_memory(element, map->element_size);
+    return element;
+}
+
+b8 slot_map_release(slot_map* map, khandle handle) {
+    slot_map_slot* slot = slot_get(map, handle);
+    if (!slot) {
+        return false;
+    }
+
+    // Fill the hole with the last element to keep the array dense.
+    u32 dense_index = slot->index;
+    u32 last_index = map->count - 1;
+    if (dense_index != last_index) {
+        kcopy_memory(element_at(map, dense_index), element_at(map, last_index), map->element_size);
+        u32 moved_slot = map->element_slots[last_index];
+        map->element_slots[dense_index] = moved_slot;
+        map->slots[moved_slot].index = dense_index;
+    }
+    map->count--;
+
+    // Outstanding handles to this slot become stale, and it goes onto the free list.
+    slot->generation++;
+    slot->index = map->free_head;
+    map->free_head = handle.handle_index;
+    return true;
+}
+
+void* slot_map_get(const slot_map* map, khandle handle) {
+    slot_map_slot* slot = slot_get(map, handle);
+    return slot ? element_at(map, slot->index) : 0;
+}
+
+b8 slot_map_contains(const slot_map* map, khandle handle) {
+    return slot_get(map, handle) != 0;
+}
+
+void slot_map_clear(slot_map* map) {
+    if (!map || !map->slots) {
+        return;
+    }
+    // Release in reverse so the lowest slots are reused first.
+    map->free_head = INVALID_ID;
+    for (u32 i = map->slot_count; i > 0; --i) {
+        slot_map_slot* slot = &map->slots[i - 1];
+        if (slot->index < map->count && map->element_slots[slot->index] == i - 1) {
+            slot->generation++;
+        }
+        slot->index = map->free_head;
+        map->free_head = i - 1;
+    }
+    map->count = 0;
+}
+
+u32 slot_map_count(const slot_map* map) {
+    return map ? map->count : 0;
+}
+
+void* slot_map_elements(const slot_map* map) {
+    return (map && map->count) ? map->elements : 0;
+}
+
+khandle slot_map_handle_at(const slot_map* map, u32 dense_index) {
+    if (!map || dense_index >= map->count) {
+        return khandle_invalid();
+    }
+    u32 slot_index = map->element_slots[dense_index];
+    return khandle_create_with_u64_identifier(slot_index, map->slots[slot_index].generation);
+}
@@ -0,0 +1,147 @@
+/**
+ * @file slot_map.h
+ * @author Travis Vroman (travis@kohiengine.com)
+ * @brief A generational slot map, which hands out khandles to elements it owns.
+ * @details Elements are kept densely packed in a single array, so iterating over
+ * every live element touches only live data, contiguously. Handles refer to a slot
+ * rather than directly to an element; each slot records where its element currently
+ * lives in the dense array, along with a generation which is bumped each time the
+ * slot is released. A handle holds the generation of its slot at the time it was
+ * acquired (in its unique_id), so handles to released elements are detected as stale
+ * even after their slot has been reused.
+ *
+ * Free slots are chained into a list through the slots themselves, so acquiring and
+ * releasing are both O(1). Releasing moves the last element into the hole left behind,
+ * so the order of elements in the dense array is not stable.
+ * @version 1.0
+ * @date 2024-11-07
+ *
+ * @copyright Kohi Game Engine is Copyright (c) Travis Vroman 2021-2024
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "identifiers/khandle.h"
+
+/** @brief The smallest capacity a slot_map will have. */
+#define SLOT_MAP_MIN_CAPACITY 8
+
+/** @brief A single slot of a slot_map. */
+typedef struct slot_map_slot {
+    /** @brief If occupied, the index of the element in the dense array. Otherwise the next free slot, or INVALID_ID. */
+    u32 index;
+    /** @brief Incremented each time the slot is released. */
+    u32 generation;
+} slot_map_slot;
+
+/**
+ * @brief A generational slot map. Members of this structure should not be modified
+ * outside the functions associated with it.
+ *
+ * Pointers to elements are only valid until the next acquire or release.
+ */
+typedef struct slot_map {
+    /** @brief The size of each element in bytes. */
+    u64 element_size;
+    /** @brief The number of live elements. */
+    u32 count;
+    /** @brief The number of elements/slots memory is allocated for. */
+    u32 capacity;
+    /** @brief The number of slots which have ever been used. */
+    u32 slot_count;
+    /** @brief The first free slot, or INVALID_ID if there are none below slot_count. */
+    u32 free_head;
+    /** @brief The live elements, densely packed. */
+    void* elements;
+    /** @brief The slot each element in the dense array belongs to. */
+    u32* element_slots;
+    /** @brief The slots handles refer to. */
+    slot_map_slot* slots;
+} slot_map;
+
+/**
+ * @brief Creates a new slot map.
+ *
+ * @param element_size The size of each element in bytes. Must be nonzero.
+ * @param initial_capacity The number of elements the map should be able to hold before it needs to grow. May be 0.
+ * @param out_map A pointer to hold the created map.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 slot_map_create(u64 element_size, u32 initial_capacity, slot_map* out_map);
+
+/**
+ * @brief Destroys the given map and frees its memory. All handles to it become invalid.
+ *
+ * @param map A pointer to the map to be destroyed.
+ */
+KAPI void slot_map_destroy(slot_map* map);
+
+/**
+ * @brief Acquires a new, zeroed element. O(1), save for when the map must grow.
+ *
+ * @param map A pointer to the map.
+ * @param out_handle A pointer to hold the handle to the new element.
+ * @return A pointer to the new element, or 0 on failure.
+ */
+KAPI void* slot_map_acquire(slot_map* map, khandle* out_handle);
+
+/**
+ * @brief Releases the element the given handle refers to, which makes the handle
+ * (and all copies of it) stale. The last element in the dense array is moved into
+ * its place. Stale or invalid handles are ignored.
+ *
+ * @param map A pointer to the map.
+ * @param handle The handle of the element to release.
+ * @return True if an element was released; otherwise false.
+ */
+KAPI b8 slot_map_release(slot_map* map, khandle handle);
+
+/**
+ * @brief Obtains a pointer to the element the given handle refers to.
+ *
+ * @param map A pointer to the map.
+ * @param handle The handle of the element.
+ * @return A pointer to the element, or 0 if the handle is invalid or stale.
+ */
+KAPI void* slot_map_get(const slot_map* map, khandle handle);
+
+/**
+ * @brief Indicates if the given handle refers to a live element of the map.
+ *
+ * @param map A pointer to the map.
+ * @param handle The handle to check.
+ * @return True if the handle is neither invalid nor stale; otherwise false.
+ */
+KAPI b8 slot_map_contains(const slot_map* map, khandle handle);
+
+/**
+ * @brief Releases every element, making all outstanding handles stale. Memory is kept.
+ *
+ * @param map A pointer to the map.
+ */
+KAPI void slot_map_clear(slot_map* map);
+
+/**
+ * @brief Obtains the number of live elements.
+ */
+KAPI u32 slot_map_count(const slot_map* map);
+
+/**
+ * @brief Obtains the dense array of live elements, which holds slot_map_count() of them.
+ * Intended for iterating over every element; the order is not meaningful.
+ *
+ * @param map A pointer to the map.
+ * @return A pointer to the first element, or 0 if the map is empty.
+ */
+KAPI void* slot_map_elements(const slot_map* map);
+
+/**
+ * @brief Obtains the handle of the element at the given position of the dense array.
+ *
+ * @param map A pointer to the map.
+ * @param dense_index The position in the dense array. Must be less than slot_map_count().
+ * @return The handle of the element, or an invalid handle if dense_index is out of range.
+ */
+KAPI khandle slot_map_handle_at(const slot_map* map, u32 dense_index);
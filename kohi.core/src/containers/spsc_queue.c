@@ -0,0 +1,99 @@
+#include "spsc_queue.h"
+
+#include "logger.h"
+#include "memory/kmemory.h"
+#include "threads/katomic.h"
+
+static KINLINE void* element_at(const spsc_queue* queue, u64 position) {
+    return (u8*)queue->block + ((u64)queue->stride * (position & (queue->capacity - 1)));
+}
+
+b8 spsc_queue_create(u32 stride, u32 capacity, void* memory, spsc_queue* out_queue) {
+    if (!out_queue) {
+        KERROR("spsc_queue_create requires a valid pointer to hold the queue.");
+        return false;
+    }
+    if (!stride || !capacity || (capacity & (capacity - 1))) {
+        KERROR("spsc_queue_create requires a nonzero stride and a capacity which is a power of two.");
+        return false;
+    }
+
+    kzero_memory(out_queue, sizeof(spsc_queue));
+    out_queue->stride = stride;
+    out_queue->capacity = capacity;
+    if (memory) {
+        out_queue->owns_memory = false;
+        out_queue->block = memory;
+    } else {
+        out_queue->owns_memory = true;
+        out_queue->block = kallocate((u64)capacity * stride, MEMORY_TAG_RING_QUEUE);
+    }
+    katomic_thread_fence();
+
+    return true;
+}
+
+void spsc_queue_destroy(spsc_queue* queue) {
+    if (queue) {
+        if (queue->owns_memory && queue->block) {
+            kfree(queue->block, (u64)queue->capacity * queue->stride, MEMORY_TAG_RING_QUEUE);
+        }
+        kzero_memory(queue, sizeof(spsc_queue));
+    }
+}
+
+b8 spsc_queue_enqueue(spsc_queue* queue, const void* value) {
+    if (!queue || !value) {
+        KERROR("spsc_queue_enqueue requires valid pointers to queue and value.");
+        return false;
+    }
+
+    // Only this thread writes write_position, so it can be read directly.
+    u64 position = queue->write_position;
+    if (position - queue->cached_read_position == queue->capacity) {
+        // Looks full, but the consumer may have moved on since last checked.
+        queue->cached_read_position = katomic_load_u64(&queue->read_position);
+        if (position - queue->cached_read_position == queue->capacity) {
+            return false;
+        }
+    }
+
+    kcopy_memory(element_at(queue, position), value, queue->stride);
+    // Publish the element to the consumer.
+    katomic_store_u64(&queue->write_position, position + 1);
+    return true;
+}
+
+b8 spsc_queue_dequeue(spsc_queue* queue, void* out_value) {
+    if (!queue || !out_value) {
+        KERROR("spsc_queue_dequeue requires valid pointers to queue and out_value.");
+        return false;
+    }
+
+    // Only this thread writes read_position, so it can be read directly.
+    u64 position = queue->read_position;
+    if (position == queue->cached_write_position) {
+        // Looks empty, but the producer may have added more since last checked.
+        queue->cached_write_position = katomic_load_u64(&queue->write_position);
+        if (position == queue->cached_write_position) {
+            return false;
+        }
+    }
+
+    kcopy_memory(out_value, element_at(queue, position), queue->stride);
+    // Hand the slot back to the producer.
+    katomic_store_u64(&queue->read_position, position + 1);
+    return true;
+}
+
+u32 spsc_queue_length(const spsc_queue* queue) {
+    if (!queue) {
+        return 0;
+    }
+    u64 read_position = katomic_load_u64(&queue->read_position);
+    u64 write_position = katomic_load_u64(&queue->write_position);
+    if (write_position <= read_position) {
+        return 0;
+    }
+    return (u32)KMIN(write_position - read_position, (u64)queue->capacity);
+}
@@ -0,0 +1,97 @@
+/**
+ * @file spsc_queue.h
+ * @author Travis Vroman (travis@kohiengine.com)
+ * @brief A bounded, lock-free, single-producer/single-consumer queue.
+ * @details Suited to a fixed pair of threads handing data in one direction,
+ * such as a streaming thread feeding an audio mixer. Exactly one thread may
+ * enqueue and exactly one (other) thread may dequeue at any one time. Each side
+ * only writes its own position and keeps a cached copy of the other's, so in the
+ * common case neither side touches memory the other is writing to. The queue does
+ * not resize; enqueueing fails when it is full.
+ * @version 1.0
+ * @date 2024-11-06
+ *
+ * @copyright Kohi Game Engine is Copyright (c) Travis Vroman 2021-2024
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A bounded lock-free queue for one producer thread and one consumer thread.
+ * Members of this structure should not be modified outside the functions associated with it.
+ */
+typedef struct spsc_queue {
+    /** @brief The size of each element in bytes. */
+    u32 stride;
+    /** @brief The total number of elements available. Always a power of two. */
+    u32 capacity;
+    /** @brief The block of memory to hold the data. */
+    void* block;
+    /** @brief Indicates if the queue owns its memory block. */
+    b8 owns_memory;
+
+    u8 padding0[KCACHE_LINE_SIZE];
+    /** @brief The next position to be written to. Written by the producer only. */
+    u64 write_position;
+    /** @brief The producer's last view of read_position. */
+    u64 cached_read_position;
+    u8 padding1[KCACHE_LINE_SIZE - (sizeof(u64) * 2)];
+    /** @brief The next position to be read from. Written by the consumer only. */
+    u64 read_position;
+    /** @brief The consumer's last view of write_position. */
+    u64 cached_write_position;
+    u8 padding2[KCACHE_LINE_SIZE - (sizeof(u64) * 2)];
+} spsc_queue;
+
+/**
+ * @brief Creates a new queue of the given capacity and stride.
+ *
+ * @param stride The size of each element in bytes.
+ * @param capacity The total number of elements to be available in the queue. Must be a power of two.
+ * @param memory The memory block used to hold the data. Should be the size of
+ * stride * capacity. If 0 is passed, a block is automatically allocated and
+ * freed upon creation/destruction.
+ * @param out_queue A pointer to hold the newly created queue.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 spsc_queue_create(u32 stride, u32 capacity, void* memory, spsc_queue* out_queue);
+
+/**
+ * @brief Destroys the given queue. If memory was not passed in during creation,
+ * it is freed here. Must not be called while either thread may be using the queue.
+ *
+ * @param queue A pointer to the queue to destroy.
+ */
+KAPI void spsc_queue_destroy(spsc_queue* queue);
+
+/**
+ * @brief Adds a copy of value to the queue, if space is available. Must only be
+ * called from the producer thread.
+ *
+ * @param queue A pointer to the queue to add data to.
+ * @param value A pointer to the value to be added.
+ * @return True if success; false if the queue is full.
+ */
+KAPI b8 spsc_queue_enqueue(spsc_queue* queue, const void* value);
+
+/**
+ * @brief Attempts to retrieve the next value from the queue. Must only be called
+ * from the consumer thread.
+ *
+ * @param queue A pointer to the queue to retrieve data from.
+ * @param out_value A pointer to hold the retrieved value.
+ * @return True if success; false if the queue is empty.
+ */
+KAPI b8 spsc_queue_dequeue(spsc_queue* queue, void* out_value);
+
+/**
+ * @brief Obtains the number of elements in the queue. If the other thread is using
+ * the queue, this is only a snapshot and may be stale as soon as it returns.
+ *
+ * @param queue A pointer to the queue.
+ * @return The number of elements in the queue.
+ */
+KAPI u32 spsc_queue_length(const spsc_queue* queue);
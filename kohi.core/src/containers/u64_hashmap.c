@@ -0,0 +1,315 @@
+#include "u64_hashmap.h"
+
+#include "logger.h"
+#include "memory/kmemory.h"
+
+// The largest value a slot's distance may hold. Distances are stored plus one, so
+// an entry can be at most this minus one slots from its home.
+#define MAX_DISTANCE 255
+
+// Scratch slots, each element_size bytes.
+#define SCRATCH_CARRY 0
+#define SCRATCH_SWAP 1
+#define SCRATCH_PENDING 2
+#define SCRATCH_SLOT_COUNT 3
+
+// Spreads the key's bits across the whole word (the splitmix64 finalizer), so
+// that keys which only differ in their upper bits do not share a home slot.
+static KINLINE u64 hash_key(u64 key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+}
+
+static KINLINE void* value_at(void* values, u64 element_size, u32 index) {
+    return (u8*)values + (element_size * index);
+}
+
+static KINLINE void* scratch_at(const u64_hashmap* map, u32 slot) {
+    return (u8*)map->scratch + (map->element_size * slot);
+}
+
+static u32 capacity_for(u32 entry_count) {
+    u64 capacity = U64_HASHMAP_MIN_CAPACITY;
+    while ((f32)entry_count > (f32)capacity * U64_HASHMAP_MAX_LOAD_FACTOR) {
+        capacity <<= 1;
+    }
+    return (u32)capacity;
+}
+
+static void slots_allocate(u64 element_size, u32 capacity, u8** out_distances, u64** out_keys, void** out_values) {
+    *out_distances = kallocate(sizeof(u8) * capacity, MEMORY_TAG_HASHTABLE);
+    *out_keys = kallocate(sizeof(u64) * capacity, MEMORY_TAG_HASHTABLE);
+    *out_values = kallocate(element_size * capacity, MEMORY_TAG_HASHTABLE);
+}
+
+static void slots_free(u64 element_size, u32 capacity, u8* distances, u64* keys, void* values) {
+    kfree(distances, sizeof(u8) * capacity, MEMORY_TAG_HASHTABLE);
+    kfree(keys, sizeof(u64) * capacity, MEMORY_TAG_HASHTABLE);
+    kfree(values, element_size * capacity, MEMORY_TAG_HASHTABLE);
+}
+
+/**
+ * Places the key given and the value in the carry scratch slot into the given slot
+ * arrays. Any entry closer to its home than the one being carried is displaced and
+ * carried on in its place. Returns false if an entry would end up too far from its
+ * home, in which case the carry key and slot hold the entry still needing a home.
+ */
+static b8 place(u64 element_size, u32 capacity, u8* distances, u64* keys, void* values, void* carry, void* swap, u64* carry_key) {
+    u32 mask = capacity - 1;
+    u32 index = (u32)hash_key(*carry_key) & mask;
+    u8 distance = 1;
+    for (;;) {
+        u8 existing = distances[index];
+        if (existing == 0) {
+            distances[index] = distance;
+            keys[index] = *carry_key;
+            kcopy_memory(value_at(values, element_size, index), carry, element_size);
+            return true;
+        }
+        if (existing < distance) {
+            // Take from the rich, give to the poor.
+            distances[index] = distance;
+            u64 displaced_key = keys[index];
+            keys[index] = *carry_key;
+            *carry_key = displaced_key;
+            void* slot = value_at(values, element_size, index);
+            kcopy_memory(swap, slot, element_size);
+            kcopy_memory(slot, carry, element_size);
+            kcopy_memory(carry, swap, element_size);
+            distance = existing;
+        }
+        if (distance == MAX_DISTANCE) {
+            return false;
+        }
+        distance++;
+        index = (index + 1) & mask;
+    }
+}
+
+// Moves all entries into new slot arrays of at least the given capacity.
+static void rehash(u64_hashmap* map, u32 new_capacity) {
+    void* carry = scratch_at(map, SCRATCH_CARRY);
+    void* swap = scratch_at(map, SCRATCH_SWAP);
+    for (;;) {
+        u8* distances;
+        u64* keys;
+        void* values;
+        slots_allocate(map->element_size, new_capacity, &distances, &keys, &values);
+
+        b8 success = true;
+        for (u32 i = 0; i < map->capacity && success; ++i) {
+            if (map->distances[i]) {
+                u64 key = map->keys[i];
+                kcopy_memory(carry, value_at(map->values, map->element_size, i), map->element_size);
+                success = place(map->element_size, new_capacity, distances, keys, values, carry, swap, &key);
+            }
+        }
+
+        if (success) {
+            slots_free(map->element_size, map->capacity, map->distances, map->keys, map->values);
+            map->capacity = new_capacity;
+            map->distances = distances;
+            map->keys = keys;
+            map->values = values;
+            return;
+        }
+
+        // Some run of keys is still too long to fit. Try again with more room.
+        slots_free(map->element_size, new_capacity, distances, keys, values);
+        new_capacity <<= 1;
+    }
+}
+
+static b8 find(const u64_hashmap* map, u64 key, u32* out_index) {
+    if (!map->count) {
+        return false;
+    }
+    u32 mask = map->capacity - 1;
+    u32 index = (u32)hash_key(key) & mask;
+    for (u32 distance = 1; distance <= MAX_DISTANCE; ++distance) {
+        u8 existing = map->distances[index];
+        // An entry closer to its home than we are to ours means the key would
+        // have been placed before it, so it is not here. This also covers empty slots.
+        if (existing < distance) {
+            return false;
+        }
+        if (existing == distance && map->keys[index] == key) {
+            *out_index = index;
+            return true;
+        }
+        index = (index + 1) & mask;
+    }
+    return false;
+}
+
+b8 u64_hashmap_create(u64 element_size, u32 initial_capacity, u64_hashmap* out_map) {
+    if (!out_map) {
+        KERROR("u64_hashmap_create requires a pointer to hold the map.");
+        return false;
+    }
+    if (!element_size) {
+        KERROR("u64_hashmap_create requires a nonzero element_size.");
+        return false;
+    }
+
+    kzero_memory(out_map, sizeof(u64_hashmap));
+    out_map->element_size = element_size;
+    out_map->capacity = capacity_for(initial_capacity);
+    slots_allocate(element_size, out_map->capacity, &out_map->distances, &out_map->keys, &out_map->values);
+    out_map->scratch = kallocate(element_size * SCRATCH_SLOT_COUNT, MEMORY_TAG_HASHTABLE);
+    return true;
+}
+
+void u64_hashmap_destroy(u64_hashmap* map) {
+    if (map && map->distances) {
+        slots_free(map->element_size, map->capacity, map->distances, map->keys, map->values);
+        kfree(map->scratch, map->element_size * SCRATCH_SLOT_COUNT, MEMORY_TAG_HASHTABLE);
+        kzero_memory(map, sizeof(u64_hashmap));
+    }
+}
+
+b8 u64_hashmap_set(u64_hashmap* map, u64 key, const void* value) {
+    if (!map || !map->distances || !value) {
+        KERROR("u64_hashmap_set requires a valid map and value.");
+        return false;
+    }
+
+    u32 index;
+    if (find(map, key, &index)) {
+        kcopy_memory(value_at(map->values, map->element_size, index), value, map->element_size);
+        return true;
+    }
+
+    if ((f32)(map->count + 1) > (f32)map->capacity * U64_HASHMAP_MAX_LOAD_FACTOR) {
+        rehash(map, map->capacity << 1);
+    }
+
+    void* carry = scratch_at(map, SCRATCH_CARRY);
+    void* pending = scratch_at(map, SCRATCH_PENDING);
+    kcopy_memory(carry, value, map->element_size);
+    while (!place(map->element_size, map->capacity, map->distances, map->keys, map->values, carry, scratch_at(map, SCRATCH_SWAP), &key)) {
+        // Whatever was left without a home must be held aside while the map grows,
+        // since growing uses the carry slot itself.
+        kcopy_memory(pending, carry, map->element_size);
+        rehash(map, map->capacity << 1);
+        kcopy_memory(carry, pending, map->element_size);
+    }
+    map->count++;
+    return true;
+}
+
+b8 u64_hashmap_get(const u64_hashmap* map, u64 key, void* out_value) {
+    if (!map || !map->distances || !out_value) {
+        KERROR("u64_hashmap_get requires a valid map and out_value.");
+        return false;
+    }
+    u32 index;
+    if (!find(map, key, &index)) {
+        return false;
+    }
+    kcopy_memory(out_value, value_at(map->values, map->element_size, index), map->element_size);
+    return true;
+}
+
+void* u64_hashmap_get_ptr(const u64_hashmap* map, u64 key) {
+    if (!map || !map->distances) {
+        KERROR("u64_hashmap_get_ptr requires a valid map.");
+        return 0;
+    }
+    u32 index;
+    if (!find(map, key, &index)) {
+        return 0;
+    }
+    return value_at(map->values, map->element_size, index);
+}
+
+b8 u64_hashmap_contains(const u64_hashmap* map, u64 key) {
+    if (!map || !map->distances) {
+        return false;
+    }
+    u32 index;
+    return find(map, key, &index);
+}
+
+b8 u64_hashmap_remove(u64_hashmap* map, u64 key, void* out_value) {
+    if (!map || !map->distances) {
+        KERROR("u64_hashmap_remove requires a valid map.");
+        return false;
+    }
+    u32 index;
+    if (!find(map, key, &index)) {
+        return false;
+    }
+    if (out_value) {
+        kcopy_memory(out_value, value_at(map->values, map->element_size, index), map->element_size);
+    }
+
+    // Shift each following entry which is away from its home back by one, until
+    // reaching an empty slot or one already at home.
+    u32 mask = map->capacity - 1;
+    u32 next = (index + 1) & mask;
+    while (map->distances[next] > 1) {
+        map->distances[index] = map->distances[next] - 1;
+        map->keys[index] = map->keys[next];
+        kcopy_memory(value_at(map->values, map->element_size, index), value_at(map->values, map->element_size, next), map->element_size);
+        index = next;
+        next = (next + 1) & mask;
+    }
+    map->distances[index] = 0;
+    map->count--;
+    return true;
+}
+
+void u64_hashmap_clear(u64_hashmap* map) {
+    if (map && map->distances) {
+        kzero_memory(map->distances, sizeof(u8) * map->capacity);
+        map->count = 0;
+    }
+}
+
+b8 u64_hashmap_iterate(const u64_hashmap* map, u32* iterator, u64* out_key, void** out_value) {
+    if (!map || !map->distances || !iterator) {
+        return false;
+    }
+    while (*iterator < map->capacity) {
+        u32 index = (*iterator)++;
+        if (map->distances[index]) {
+            if (out_key) {
+                *out_key = map->keys[index];
+            }
+            if (out_value) {
+                *out_value = value_at(map->values, map->element_size, index);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void u64_hashmap_stats_get(const u64_hashmap* map, u64_hashmap_stats* out_stats) {
+    if (!map || !out_stats) {
+        return;
+    }
+    kzero_memory(out_stats, sizeof(u64_hashmap_stats));
+    out_stats->count = map->count;
+    out_stats->capacity = map->capacity;
+    if (!map->capacity) {
+        return;
+    }
+    out_stats->load_factor = (f32)map->count / (f32)map->capacity;
+
+    // A slot's stored distance is the number of slots examined to reach it.
+    u64 total_probe_length = 0;
+    for (u32 i = 0; i < map->capacity; ++i) {
+        u8 distance = map->distances[i];
+        total_probe_length += distance;
+        out_stats->max_probe_length = KMAX(out_stats->max_probe_length, (u32)distance);
+    }
+    if (map->count) {
+        out_stats->average_probe_length = (f32)total_probe_length / (f32)map->count;
+    }
+}
@@ -0,0 +1,164 @@
+/**
+ * @file u64_hashmap.h
+ * @author Travis Vroman (travis@kohiengine.com)
+ * @brief An open-addressing hashmap keyed by u64 values, such as knames.
+ * @details Entries are stored inline in flat arrays and placed using Robin Hood
+ * linear probing: on insertion, an entry which is further from its home slot
+ * takes the place of one which is closer to its own. This keeps probe lengths
+ * short and even, and lets lookups stop early on a miss. Removal shifts the
+ * following entries back rather than leaving tombstones. The map owns its
+ * memory and grows automatically (doubling) when its load factor would exceed
+ * U64_HASHMAP_MAX_LOAD_FACTOR.
+ *
+ * Unlike hashtable, keys are never reduced modulo the capacity before being
+ * compared, so distinct keys never overwrite each other.
+ * @version 1.0
+ * @date 2024-11-05
+ *
+ * @copyright Kohi Game Engine is Copyright (c) Travis Vroman 2021-2024
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The load factor (count / capacity) above which a u64_hashmap grows. */
+#define U64_HASHMAP_MAX_LOAD_FACTOR 0.875f
+
+/** @brief The smallest capacity a u64_hashmap will have. */
+#define U64_HASHMAP_MIN_CAPACITY 8
+
+/**
+ * @brief An open-addressing hashmap keyed by u64. Members of this structure
+ * should not be modified outside the functions associated with it.
+ *
+ * The map retains a copy of each value. Pointers to values obtained from
+ * u64_hashmap_get_ptr() are only valid until the next set or remove.
+ */
+typedef struct u64_hashmap {
+    /** @brief The size of each value in bytes. */
+    u64 element_size;
+    /** @brief The number of slots. Always a power of two. */
+    u32 capacity;
+    /** @brief The number of entries currently held. */
+    u32 count;
+    /** @brief Per-slot probe distance plus one. 0 indicates an empty slot. */
+    u8* distances;
+    /** @brief The key of each slot. */
+    u64* keys;
+    /** @brief The value of each slot, element_size bytes apiece. */
+    void* values;
+    /** @brief Room for entries being moved during insertion. */
+    void* scratch;
+} u64_hashmap;
+
+/** @brief Statistics describing the current state of a u64_hashmap. */
+typedef struct u64_hashmap_stats {
+    /** @brief The number of entries currently held. */
+    u32 count;
+    /** @brief The number of slots. */
+    u32 capacity;
+    /** @brief count / capacity. */
+    f32 load_factor;
+    /** @brief The most slots which must be examined to find any one entry. */
+    u32 max_probe_length;
+    /** @brief The average number of slots examined to find an entry. */
+    f32 average_probe_length;
+} u64_hashmap_stats;
+
+/**
+ * @brief Creates a new hashmap.
+ *
+ * @param element_size The size of each value in bytes. Must be nonzero.
+ * @param initial_capacity The number of entries the map should be able to hold before it needs to grow. May be 0.
+ * @param out_map A pointer to hold the created map.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 u64_hashmap_create(u64 element_size, u32 initial_capacity, u64_hashmap* out_map);
+
+/**
+ * @brief Destroys the given map, releasing its memory.
+ *
+ * @param map A pointer to the map to be destroyed.
+ */
+KAPI void u64_hashmap_destroy(u64_hashmap* map);
+
+/**
+ * @brief Stores a copy of the given value under the given key, replacing any
+ * value already stored under it. Grows the map if required.
+ *
+ * @param map A pointer to the map. Required.
+ * @param key The key to store the value under.
+ * @param value A pointer to the value to be copied in. Required.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 u64_hashmap_set(u64_hashmap* map, u64 key, const void* value);
+
+/**
+ * @brief Obtains a copy of the value stored under the given key.
+ *
+ * @param map A pointer to the map. Required.
+ * @param key The key to look up.
+ * @param out_value A pointer to hold a copy of the value. Required.
+ * @return True if the key was found; otherwise false.
+ */
+KAPI b8 u64_hashmap_get(const u64_hashmap* map, u64 key, void* out_value);
+
+/**
+ * @brief Obtains a pointer to the value stored under the given key. The pointer
+ * is only valid until the map is next modified.
+ *
+ * @param map A pointer to the map. Required.
+ * @param key The key to look up.
+ * @return A pointer to the value if found; otherwise 0.
+ */
+KAPI void* u64_hashmap_get_ptr(const u64_hashmap* map, u64 key);
+
+/**
+ * @brief Indicates if the map contains the given key.
+ *
+ * @param map A pointer to the map. Required.
+ * @param key The key to look up.
+ * @return True if the key was found; otherwise false.
+ */
+KAPI b8 u64_hashmap_contains(const u64_hashmap* map, u64 key);
+
+/**
+ * @brief Removes the entry stored under the given key, if there is one.
+ *
+ * @param map A pointer to the map. Required.
+ * @param key The key to be removed.
+ * @param out_value A pointer to hold a copy of the removed value. Optional.
+ * @return True if an entry was removed; otherwise false.
+ */
+KAPI b8 u64_hashmap_remove(u64_hashmap* map, u64 key, void* out_value);
+
+/**
+ * @brief Removes all entries from the map without changing its capacity.
+ *
+ * @param map A pointer to the map. Required.
+ */
+KAPI void u64_hashmap_clear(u64_hashmap* map);
+
+/**
+ * @brief Iterates the entries of the map in no particular order. The iterator
+ * should be set to 0 before the first call. The map must not be modified while
+ * being iterated.
+ *
+ * @param map A pointer to the map. Required.
+ * @param iterator A pointer to the iterator state. Required.
+ * @param out_key A pointer to hold the key of the next entry. Optional.
+ * @param out_value A pointer to hold a pointer to the value of the next entry. Optional.
+ * @return True if an entry was obtained; false once all entries have been visited.
+ */
+KAPI b8 u64_hashmap_iterate(const u64_hashmap* map, u32* iterator, u64* out_key, void** out_value);
+
+/**
+ * @brief Obtains statistics about the given map. Probe lengths are calculated
+ * by walking the map, so this is O(capacity).
+ *
+ * @param map A pointer to the map. Required.
+ * @param out_stats A pointer to hold the statistics. Required.
+ */
+KAPI void u64_hashmap_stats_get(const u64_hashmap* map, u64_hashmap_stats* out_stats);
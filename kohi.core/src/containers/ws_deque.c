@@ -0,0 +1,131 @@
+#include "ws_deque.h"
+
+#include "logger.h"
+#include "memory/kmemory.h"
+#include "threads/katomic.h"
+
+static KINLINE u64* item_at(const ws_deque* deque, u64 position) {
+    return &deque->items[position & (deque->capacity - 1)];
+}
+
+u64 ws_deque_memory_requirement(u32 capacity) {
+    return sizeof(u64) * capacity;
+}
+
+b8 ws_deque_create(u32 capacity, void* memory, ws_deque* out_deque) {
+    if (!out_deque) {
+        KERROR("ws_deque_create requires a valid pointer to hold the deque.");
+        return false;
+    }
+    if (!capacity || (capacity & (capacity - 1))) {
+        KERROR("ws_deque_create requires a capacity which is a power of two.");
+        return false;
+    }
+
+    kzero_memory(out_deque, sizeof(ws_deque));
+    out_deque->capacity = capacity;
+    if (memory) {
+        out_deque->owns_memory = false;
+        out_deque->items = memory;
+    } else {
+        out_deque->owns_memory = true;
+        out_deque->items = kallocate(ws_deque_memory_requirement(capacity), MEMORY_TAG_RING_QUEUE);
+    }
+    katomic_thread_fence();
+
+    return true;
+}
+
+void ws_deque_destroy(ws_deque* deque) {
+    if (deque) {
+        if (deque->owns_memory && deque->items) {
+            kfree(deque->items, ws_deque_memory_requirement(deque->capacity), MEMORY_TAG_RING_QUEUE);
+        }
+        kzero_memory(deque, sizeof(ws_deque));
+    }
+}
+
+b8 ws_deque_push(ws_deque* deque, u64 value) {
+    if (!deque || !deque->items) {
+        KERROR("ws_deque_push requires a valid deque.");
+        return false;
+    }
+
+    // Only this thread writes bottom, so it can be read directly.
+    u64 bottom = deque->bottom;
+    u64 top = katomic_load_u64(&deque->top);
+    if (bottom - top >= deque->capacity) {
+        return false;
+    }
+
+    katomic_store_u64(item_at(deque, bottom), value);
+    // Publish the value to thieves.
+    katomic_store_u64(&deque->bottom, bottom + 1);
+    return true;
+}
+
+b8 ws_deque_pop(ws_deque* deque, u64* out_value) {
+    if (!deque || !deque->items || !out_value) {
+        KERROR("ws_deque_pop requires valid pointers to deque and out_value.");
+        return false;
+    }
+
+    // Claim the bottom value before looking at top, so a thief either sees the claim or
+    // has already moved top past it. The full fence keeps the two from being reordered.
+    u64 bottom = deque->bottom - 1;
+    katomic_store_u64(&deque->bottom, bottom);
+    katomic_thread_fence();
+    u64 top = katomic_load_u64(&deque->top);
+
+    if ((i64)(bottom - top) < 0) {
+        // Empty. Put bottom back where it was.
+        katomic_store_u64(&deque->bottom, bottom + 1);
+        return false;
+    }
+
+    *out_value = katomic_load_u64(item_at(deque, bottom));
+    if (bottom != top) {
+        // More than one value remained, so no thief can be after this one.
+        return true;
+    }
+
+    // This is the last value, so race any thieves for it by moving top instead.
+    b8 won = katomic_compare_exchange_u64(&deque->top, &top, top + 1);
+    katomic_store_u64(&deque->bottom, bottom + 1);
+    return won;
+}
+
+b8 ws_deque_steal(ws_deque* deque, u64* out_value) {
+    if (!deque || !deque->items || !out_value) {
+        KERROR("ws_deque_steal requires valid pointers to deque and out_value.");
+        return false;
+    }
+
+    u64 top = katomic_load_u64(&deque->top);
+    katomic_thread_fence();
+    u64 bottom = katomic_load_u64(&deque->bottom);
+    if ((i64)(bottom - top) <= 0) {
+        return false;
+    }
+
+    // Read the value before claiming it, as the owner may reuse the slot once top moves.
+    u64 value = katomic_load_u64(item_at(deque, top));
+    if (!katomic_compare_exchange_u64(&deque->top, &top, top + 1)) {
+        // Another thief, or the owner, got there first.
+        return false;
+    }
+    *out_value = value;
+    return true;
+}
+
+u32 ws_deque_length(const ws_deque* deque) {
+    if (!deque) {
+        return 0;
+    }
+    u64 top = katomic_load_u64(&deque->top);
+    u64 bottom = katomic_load_u64(&deque->bottom);
+    if ((i64)(bottom - top) <= 0) {
+        return 0;
+    }
+    return (u32)KMIN(bottom - top, (u64)deque->capacity);
+}
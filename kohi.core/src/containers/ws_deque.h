@@ -0,0 +1,113 @@
+/**
+ * @file ws_deque.h
+ * @author Travis Vroman (travis@kohiengine.com)
+ * @brief A bounded, lock-free work-stealing deque of u64 values.
+ * @details Based on the Chase-Lev deque. The deque has a single owner thread,
+ * which pushes and pops values at the bottom (last in, first out). Any other
+ * thread may steal values from the top (first in, first out). The owner only
+ * contends with thieves when taking the very last value, so in the common case
+ * pushing and popping are as cheap as working with a plain array.
+ *
+ * Typically each worker thread owns one of these. Work it creates goes onto its
+ * own deque, and workers which run out of work steal from the others. Values are
+ * u64 so they may hold indices, handles or pointers. The deque does not resize;
+ * pushing fails when it is full.
+ * @version 1.0
+ * @date 2024-11-08
+ *
+ * @copyright Kohi Game Engine is Copyright (c) Travis Vroman 2021-2024
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A bounded lock-free work-stealing deque. Members of this structure should
+ * not be modified outside the functions associated with it.
+ */
+typedef struct ws_deque {
+    /** @brief The total number of values available. Always a power of two. */
+    u32 capacity;
+    /** @brief The block of memory holding the values. */
+    u64* items;
+    /** @brief Indicates if the deque owns its memory block. */
+    b8 owns_memory;
+
+    u8 padding0[KCACHE_LINE_SIZE];
+    /** @brief The position thieves steal from. */
+    u64 top;
+    u8 padding1[KCACHE_LINE_SIZE - sizeof(u64)];
+    /** @brief The position the owner pushes to. Written by the owner only. */
+    u64 bottom;
+    u8 padding2[KCACHE_LINE_SIZE - sizeof(u64)];
+} ws_deque;
+
+/**
+ * @brief Obtains the amount of memory needed by a deque of the given capacity.
+ *
+ * @param capacity The total number of values to be available in the deque.
+ * @returns The size in bytes of the memory block the deque requires.
+ */
+KAPI u64 ws_deque_memory_requirement(u32 capacity);
+
+/**
+ * @brief Creates a new deque of the given capacity. Must not be called while other
+ * threads may be using the deque.
+ *
+ * @param capacity The total number of values to be available in the deque. Must be a power of two.
+ * @param memory The memory block used to hold the values. Should be the size given by
+ * ws_deque_memory_requirement(). If 0 is passed, a block is automatically allocated and
+ * freed upon creation/destruction.
+ * @param out_deque A pointer to hold the newly created deque.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 ws_deque_create(u32 capacity, void* memory, ws_deque* out_deque);
+
+/**
+ * @brief Destroys the given deque. If memory was not passed in during creation,
+ * it is freed here. Must not be called while other threads may be using the deque.
+ *
+ * @param deque A pointer to the deque to destroy.
+ */
+KAPI void ws_deque_destroy(ws_deque* deque);
+
+/**
+ * @brief Adds a value to the bottom of the deque, if space is available. Must only
+ * be called from the owner thread.
+ *
+ * @param deque A pointer to the deque.
+ * @param value The value to be added.
+ * @return True if success; false if the deque is full.
+ */
+KAPI b8 ws_deque_push(ws_deque* deque, u64 value);
+
+/**
+ * @brief Takes the most recently pushed value from the bottom of the deque. Must only
+ * be called from the owner thread.
+ *
+ * @param deque A pointer to the deque.
+ * @param out_value A pointer to hold the value.
+ * @return True if success; false if the deque is empty.
+ */
+KAPI b8 ws_deque_pop(ws_deque* deque, u64* out_value);
+
+/**
+ * @brief Attempts to take the oldest value from the top of the deque. Safe to call
+ * from any thread.
+ *
+ * @param deque A pointer to the deque.
+ * @param out_value A pointer to hold the value.
+ * @return True if success; false if the deque is empty or another thread took the value first.
+ */
+KAPI b8 ws_deque_steal(ws_deque* deque, u64* out_value);
+
+/**
+ * @brief Obtains the number of values in the deque. If other threads are using the
+ * deque, this is only a snapshot and may be stale as soon as it returns.
+ *
+ * @param deque A pointer to the deque.
+ * @return The number of values in the deque.
+ */
+KAPI u32 ws_deque_length(const ws_deque* deque);
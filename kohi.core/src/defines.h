@@ -255,6 +255,18 @@ STATIC_ASSERT(sizeof(f64) == 8, "Expected f64 to be 8 bytes.");
 #    define KNOINLINE
 #endif
 
+// Thread-local storage
+#if defined(__clang__) || defined(__gcc__)
+/** @brief Thread-local storage qualifier. Each thread gets its own copy of the variable. */
+#    define KTHREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+/** @brief Thread-local storage qualifier. Each thread gets its own copy of the variable. */
+#    define KTHREAD_LOCAL __declspec(thread)
+#else
+/** @brief Thread-local storage qualifier. Each thread gets its own copy of the variable. */
+#    define KTHREAD_LOCAL _Thread_local
+#endif
+
 // Deprecation
 #if defined(__clang__) || defined(__gcc__)
 /** @brief Mark something (i.e. a function) as deprecated. */
@@ -266,6 +278,9 @@ STATIC_ASSERT(sizeof(f64) == 8, "Expected f64 to be 8 bytes.");
 #    error "Unsupported compiler - don't know how to define deprecations!"
 #endif
 
+/** @brief The assumed size of a CPU cache line. Data written by different threads should be kept at least this far apart. */
+#define KCACHE_LINE_SIZE 64
+
 /** @brief Gets the number of bytes from amount of gibibytes (GiB) (1024*1024*1024) */
 #define GIBIBYTES(amount) ((amount) * 1024ULL * 1024ULL * 1024ULL)
 /** @brief Gets the number of bytes from amount of mebibytes (MiB) (1024*1024) */
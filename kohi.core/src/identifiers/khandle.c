@@ -77,11 +77,11 @@ khandle16 khandle16_invalid(void) {
 }
 
 b8 khandle16_is_valid(khandle16 handle) {
-    return handle.handle_index == INVALID_ID_U16 || handle.generation == INVALID_ID_U16;
+    return handle.handle_index != INVALID_ID_U16 && handle.generation != INVALID_ID_U16;
 }
 
 b8 khandle16_is_invalid(khandle16 handle) {
-    return handle.handle_index != INVALID_ID_U16 && handle.generation != INVALID_ID_U16;
+    return handle.handle_index == INVALID_ID_U16 || handle.generation == INVALID_ID_U16;
 }
 
 void khandle16_update(khandle16* handle) {
@@ -101,9 +101,9 @@ void khandle16_invalidate(khandle16* handle) {
 }
 
 b8 khandle16_is_stale(khandle16 handle, u16 generation) {
-    return handle.generation == generation;
+    return handle.generation != generation;
 }
 
 b8 khandle16_is_pristine(khandle16 handle, u16 generation) {
-    return handle.generation != generation;
+    return handle.generation == generation;
 }
@@ -10,16 +10,37 @@ typedef struct dynamic_allocator_state {
     freelist list;
     void* freelist_block;
     void* memory_block;
+    // The start of the memory which is committed on demand. memory_block lies a little way into it.
+    void* commit_block;
+    // The amount of commit_block which may be committed.
+    u64 reserved_size;
+    // The amount of commit_block which is committed. Always reserved_size if not created over reserved memory.
+    u64 committed_size;
+    u64 commit_granularity;
+    PFN_dynamic_allocator_commit commit;
+    PFN_dynamic_allocator_commit decommit;
 } dynamic_allocator_state;
 
 typedef struct alloc_header {
+    // The start of the block taken from the freelist.
     void* start;
+    // The size of the block taken from the freelist.
+    u32 block_size;
     u16 alignment;
 } alloc_header;
 
 // The storage size in bytes of a node's user memory block size
 #define KSIZE_STORAGE sizeof(u32)
 
+// The memory block is placed so that the size storage of a block starting on an aligned offset
+// ends on an address with this alignment. User blocks of up to this alignment then need no padding.
+#define BASE_ALIGNMENT 256
+
+// Places the memory block at or just after the given address. See BASE_ALIGNMENT.
+static void* memory_block_place(void* address) {
+    return (void*)(get_aligned((u64)address + KSIZE_STORAGE, BASE_ALIGNMENT) - KSIZE_STORAGE);
+}
+
 b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator) {
     if (total_size < 1) {
         KERROR("dynamic_allocator_create cannot have a total_size of 0. Create failed.");
@@ -33,7 +54,7 @@ b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memor
     // Grab the memory requirement for the free list first.
     freelist_create(total_size, &freelist_requirement, 0, 0);
 
-    *memory_requirement = freelist_requirement + sizeof(dynamic_allocator_state) + total_size;
+    *memory_requirement = freelist_requirement + sizeof(dynamic_allocator_state) + BASE_ALIGNMENT + total_size;
 
     // If only obtaining requirement, boot out.
     if (!memory) {
@@ -43,17 +64,74 @@ b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memor
     // Memory layout:
     // state
     // freelist block
+    // padding
     // memory block
     out_allocator->memory = memory;
     dynamic_allocator_state* state = out_allocator->memory;
     state->total_size = total_size;
     state->freelist_block = (void*)(out_allocator->memory + sizeof(dynamic_allocator_state));
-    state->memory_block = (void*)(state->freelist_block + freelist_requirement);
+    state->memory_block = memory_block_place(state->freelist_block + freelist_requirement);
+    state->commit_block = state->memory_block;
+    state->reserved_size = total_size;
+    state->committed_size = total_size;
+    state->commit_granularity = 0;
+    state->commit = 0;
+    state->decommit = 0;
 
     // Actually create the freelist
     freelist_create(total_size, &freelist_requirement, state->freelist_block, &state->list);
 
-    kzero_memory(state->memory_block, total_size);
+    // NOTE: The memory block itself isn't zeroed here, since allocations are zeroed when handed out
+    // anyway, and touching all of it up front would make all of it resident.
+    return true;
+}
+
+b8 dynamic_allocator_create_reserved(u64 total_size, u64 commit_granularity, PFN_dynamic_allocator_commit commit, PFN_dynamic_allocator_commit decommit, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator) {
+    if (total_size < 1) {
+        KERROR("dynamic_allocator_create_reserved cannot have a total_size of 0. Create failed.");
+        return false;
+    }
+    if (!memory_requirement || !commit || !decommit || !commit_granularity || (commit_granularity & (commit_granularity - 1))) {
+        KERROR("dynamic_allocator_create_reserved requires memory_requirement, commit/decommit functions and a power-of-two commit_granularity. Create failed.");
+        return false;
+    }
+    total_size = get_aligned(total_size, commit_granularity);
+
+    u64 freelist_requirement = 0;
+    // Grab the memory requirement for the free list first.
+    freelist_create(total_size, &freelist_requirement, 0, 0);
+
+    // The memory block starts on a commit boundary so it can be committed independently of the header.
+    u64 header_size = get_aligned(sizeof(dynamic_allocator_state) + freelist_requirement, commit_granularity);
+    u64 reserved_size = get_aligned(BASE_ALIGNMENT + total_size, commit_granularity);
+    *memory_requirement = header_size + reserved_size;
+
+    // If only obtaining requirement, boot out.
+    if (!memory) {
+        return true;
+    }
+
+    // Memory layout is the same as a regular dynamic allocator. The padding between the freelist and memory blocks
+    // also takes the commit block to a commit boundary.
+    // The header is committed up front. Pages of the freelist only become resident as nodes are used.
+    if (!commit(memory, header_size)) {
+        KERROR("dynamic_allocator_create_reserved failed to commit memory for internal state. Create failed.");
+        return false;
+    }
+    out_allocator->memory = memory;
+    dynamic_allocator_state* state = out_allocator->memory;
+    state->total_size = total_size;
+    state->freelist_block = (void*)(out_allocator->memory + sizeof(dynamic_allocator_state));
+    state->commit_block = (void*)(out_allocator->memory + header_size);
+    state->memory_block = memory_block_place(state->commit_block);
+    state->reserved_size = reserved_size;
+    state->committed_size = 0;
+    state->commit_granularity = commit_granularity;
+    state->commit = commit;
+    state->decommit = decommit;
+
+    // Actually create the freelist
+    freelist_create(total_size, &freelist_requirement, state->freelist_block, &state->list);
     return true;
 }
 
@@ -61,8 +139,8 @@ b8 dynamic_allocator_destroy(dynamic_allocator* allocator) {
     if (allocator) {
         dynamic_allocator_state* state = allocator->memory;
         freelist_destroy(&state->list);
-        kzero_memory(state->memory_block, state->total_size);
         state->total_size = 0;
+        state->committed_size = 0;
         allocator->memory = 0;
         return true;
     }
@@ -79,29 +157,49 @@ void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size,
     if (allocator && size && alignment) {
         dynamic_allocator_state* state = allocator->memory;
 
-        // The size required is based on the requested size, plus the alignment, header and a u32 to hold
+        // Blocks start on an offset aligned to the requested alignment, so the user block following the
+        // size storage is aligned as well, unless the alignment is larger than the memory block guarantees.
+        // Only then is padding needed in front of the size storage.
+        u64 misalignment = ((u64)state->memory_block + KSIZE_STORAGE) & (alignment - 1);
+        u64 padding = misalignment ? alignment - misalignment : 0;
+
+        // The size required is based on the requested size, plus any padding, the header and a u32 to hold
         // the size for quick/easy lookups.
         u64 header_size = sizeof(alloc_header);
         u64 storage_size = KSIZE_STORAGE;
-        u64 required_size = alignment + header_size + storage_size + size;
+        u64 required_size = padding + header_size + storage_size + size;
         // NOTE: This cast will really only be an issue on allocations over ~4GiB, so... don't do that.
         KASSERT_MSG(required_size < 4294967295U, "dynamic_allocator_allocate_aligned called with required size > 4 GiB. Don't do that.");
 
+        // If over reserved memory, make sure enough is committed. A block will either fit within a gap
+        // below the trailing free space (already committed), or at the first aligned offset of the trailing free space.
+        if (state->committed_size < state->reserved_size) {
+            u64 block_start = (u64)state->memory_block - (u64)state->commit_block;
+            u64 required_end = block_start + get_aligned(freelist_trailing_free_offset(&state->list), alignment) + required_size;
+            if (required_end > state->committed_size) {
+                u64 new_committed_size = KMIN(get_aligned(required_end, state->commit_granularity), state->reserved_size);
+                if (!state->commit((void*)((u64)state->commit_block + state->committed_size), new_committed_size - state->committed_size)) {
+                    KERROR("dynamic_allocator_allocate_aligned failed to commit memory (requested size: %llu).", size);
+                    return 0;
+                }
+                state->committed_size = new_committed_size;
+            }
+        }
+
         u64 base_offset = 0;
-        if (freelist_allocate_block(&state->list, required_size, &base_offset)) {
+        if (freelist_allocate_block_aligned(&state->list, required_size, alignment, &base_offset)) {
             /*
             Memory layout:
-            x bytes/void padding
+            x bytes/void padding (only for alignments over BASE_ALIGNMENT)
             4 bytes/u32 user block size
             x bytes/void user memory block
             alloc_header
 
             */
-            // Get the base pointer, or the unaligned memory block.
+            // Get the base pointer, or the start of the block.
             void* ptr = (void*)((u64)state->memory_block + base_offset);
-            // Start the alignment after enough space to hold a u32. This allows for the u32 to be stored
-            // immediately before the user block, while maintaining alignment on said user block.
-            u64 aligned_block_offset = get_aligned((u64)ptr + KSIZE_STORAGE, alignment);
+            // The u32 is stored immediately before the user block, which is aligned.
+            u64 aligned_block_offset = (u64)ptr + padding + KSIZE_STORAGE;
             // Store the size just before the user data block
             u32* block_size = (u32*)(aligned_block_offset - KSIZE_STORAGE);
             *block_size = (u32)size;
@@ -110,6 +208,7 @@ void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size,
             alloc_header* header = (alloc_header*)(aligned_block_offset + size);
             header->start = ptr;
             KASSERT_MSG(header->start, "dynamic_allocator_allocate_aligned got a null pointer (0x0). Memory corruption likely as this should always be nonzero.");
+            header->block_size = (u32)required_size;
             header->alignment = alignment;
             KASSERT_MSG(header->alignment, "dynamic_allocator_allocate_aligned got an alignment of 0. Memory corruption likely as this should always be nonzero.");
 
@@ -118,7 +217,7 @@ void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size,
             KERROR("dynamic_allocator_allocate_aligned no blocks of memory large enough to allocate from.");
             u64 available = freelist_free_space(&state->list);
             KERROR("Requested size: %llu, total space available: %llu", size, available);
-            // TODO: Report fragmentation?
+            KERROR("Largest free block: %llu, free block count: %llu", freelist_largest_free_block(&state->list), freelist_free_block_count(&state->list));
             return 0;
         }
     }
@@ -146,9 +245,8 @@ b8 dynamic_allocator_free_aligned(dynamic_allocator* allocator, void* block) {
 
     u32* block_size = (u32*)((u64)block - KSIZE_STORAGE);
     alloc_header* header = (alloc_header*)((u64)block + *block_size);
-    u64 required_size = header->alignment + sizeof(alloc_header) + KSIZE_STORAGE + *block_size;
     u64 offset = (u64)header->start - (u64)state->memory_block;
-    if (!freelist_free_block(&state->list, required_size, offset)) {
+    if (!freelist_free_block(&state->list, header->block_size, offset)) {
         KERROR("dynamic_allocator_free_aligned failed.");
         return false;
     }
@@ -173,6 +271,14 @@ b8 dynamic_allocator_get_size_alignment(dynamic_allocator* allocator, void* bloc
     return true;
 }
 
+b8 dynamic_allocator_owns_block(dynamic_allocator* allocator, const void* block) {
+    if (!allocator || !allocator->memory) {
+        return false;
+    }
+    dynamic_allocator_state* state = allocator->memory;
+    return block >= state->memory_block && block < (void*)((u8*)state->memory_block + state->total_size);
+}
+
 u64 dynamic_allocator_free_space(dynamic_allocator* allocator) {
     dynamic_allocator_state* state = allocator->memory;
     return freelist_free_space(&state->list);
@@ -183,6 +289,44 @@ u64 dynamic_allocator_total_space(dynamic_allocator* allocator) {
     return state->total_size;
 }
 
+u64 dynamic_allocator_largest_free_block(dynamic_allocator* allocator) {
+    dynamic_allocator_state* state = allocator->memory;
+    return freelist_largest_free_block(&state->list);
+}
+
+u64 dynamic_allocator_free_block_count(dynamic_allocator* allocator) {
+    dynamic_allocator_state* state = allocator->memory;
+    return freelist_free_block_count(&state->list);
+}
+
+u64 dynamic_allocator_committed_space(dynamic_allocator* allocator) {
+    dynamic_allocator_state* state = allocator->memory;
+    return state->committed_size;
+}
+
+u64 dynamic_allocator_trim(dynamic_allocator* allocator) {
+    dynamic_allocator_state* state = allocator->memory;
+    if (!state->decommit) {
+        return 0;
+    }
+
+    // Keep everything up to the end of the last allocation. That lies past the start of the memory block, unless there are none.
+    u64 trailing_free_offset = freelist_trailing_free_offset(&state->list);
+    u64 block_start = (u64)state->memory_block - (u64)state->commit_block;
+    u64 keep_size = trailing_free_offset ? get_aligned(block_start + trailing_free_offset, state->commit_granularity) : 0;
+    if (keep_size >= state->committed_size) {
+        return 0;
+    }
+
+    u64 trim_size = state->committed_size - keep_size;
+    if (!state->decommit((void*)((u64)state->commit_block + keep_size), trim_size)) {
+        KWARN("dynamic_allocator_trim failed to decommit memory.");
+        return 0;
+    }
+    state->committed_size = keep_size;
+    return trim_size;
+}
+
 u64 dynamic_allocator_header_size(void) {
     // Enough space for a header and size storage.
     return sizeof(alloc_header) + KSIZE_STORAGE;
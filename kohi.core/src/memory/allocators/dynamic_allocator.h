@@ -13,6 +13,15 @@
 
 #include "defines.h"
 
+/**
+ * @brief A function which makes a range of reserved memory usable (commit), or gives
+ * it back to the OS while keeping it reserved (decommit).
+ * @param block The start of the range. Always page-aligned, provided the allocator's memory is.
+ * @param size The size of the range in bytes.
+ * @return True on success; otherwise false.
+ */
+typedef b8 (*PFN_dynamic_allocator_commit)(void* block, u64 size);
+
 /** @brief The dynamic allocator structure. */
 typedef struct dynamic_allocator {
     /** @brief The allocated memory block for this allocator to use. */
@@ -31,6 +40,23 @@ typedef struct dynamic_allocator {
  */
 KAPI b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator);
 
+/**
+ * @brief Creates a new dynamic allocator over reserved (but not committed) memory. Memory is
+ * committed as the allocator grows into it, and memory beyond the last allocation can be given
+ * back via dynamic_allocator_trim(). Should be called twice; once to obtain the memory amount
+ * required (passing memory=0), and a second time with memory being set to a reserved block.
+ *
+ * @param total_size The total size in bytes the allocator should hold. Rounded up to a multiple of commit_granularity.
+ * @param commit_granularity The size in bytes memory is committed in. Must be a multiple of the platform page size.
+ * @param commit A function which commits a range of the reserved block.
+ * @param decommit A function which decommits a range of the reserved block.
+ * @param memory_requirement A pointer to hold the required memory for the internal state _plus_ total_size.
+ * @param memory A reserved block of memory aligned to the platform page size, or 0 if just obtaining the requirement.
+ * @param out_allocator A pointer to hold the allocator.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 dynamic_allocator_create_reserved(u64 total_size, u64 commit_granularity, PFN_dynamic_allocator_commit commit, PFN_dynamic_allocator_commit decommit, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator);
+
 /**
  * @brief Destroys the given allocator.
  *
@@ -90,6 +116,16 @@ KAPI b8 dynamic_allocator_free_aligned(dynamic_allocator* allocator, void* block
  */
 KAPI b8 dynamic_allocator_get_size_alignment(dynamic_allocator* allocator, void* block, u64* out_size, u16* out_alignment);
 
+/**
+ * @brief Indicates if the given block of memory lies within the range managed by the
+ * provided allocator. Does not read from the block itself.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param block The block of memory.
+ * @return True if the block is within the allocator's range; otherwise false.
+ */
+KAPI b8 dynamic_allocator_owns_block(dynamic_allocator* allocator, const void* block);
+
 /**
  * @brief Obtains the amount of free space left in the provided allocator.
  *
@@ -106,5 +142,40 @@ KAPI u64 dynamic_allocator_free_space(dynamic_allocator* allocator);
  */
 KAPI u64 dynamic_allocator_total_space(dynamic_allocator* allocator);
 
+/**
+ * @brief Obtains the size of the largest contiguous free range in the provided allocator.
+ * Note that allocation headers and alignment padding also come out of this space.
+ *
+ * @param allocator A pointer to the allocator to be examined.
+ * @return The size of the largest free range in bytes.
+ */
+KAPI u64 dynamic_allocator_largest_free_block(dynamic_allocator* allocator);
+
+/**
+ * @brief Obtains the number of separate free ranges in the provided allocator.
+ *
+ * @param allocator A pointer to the allocator to be examined.
+ * @return The number of free ranges.
+ */
+KAPI u64 dynamic_allocator_free_block_count(dynamic_allocator* allocator);
+
+/**
+ * @brief Obtains the amount of space currently committed in the provided allocator. For
+ * allocators not created over reserved memory, this is always the total space.
+ *
+ * @param allocator A pointer to the allocator to be examined.
+ * @return The amount of committed space in bytes.
+ */
+KAPI u64 dynamic_allocator_committed_space(dynamic_allocator* allocator);
+
+/**
+ * @brief Decommits the memory following the last allocation in the provided allocator, giving
+ * it back to the OS. Does nothing for allocators not created over reserved memory.
+ *
+ * @param allocator A pointer to the allocator to be trimmed.
+ * @return The amount of memory decommitted in bytes.
+ */
+KAPI u64 dynamic_allocator_trim(dynamic_allocator* allocator);
+
 /** Obtains the size of the internal allocation header. This is really only used for unit testing purposes. */
 KAPI u64 dynamic_allocator_header_size(void);
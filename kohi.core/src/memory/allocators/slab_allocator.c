@@ -0,0 +1,189 @@
+#include "memory/allocators/slab_allocator.h"
+
+#include "debug/kassert.h"
+#include "logger.h"
+#include "memory/kmemory.h"
+
+typedef struct slab_free_block {
+    struct slab_free_block* next;
+} slab_free_block;
+
+typedef struct slab_class {
+    // The size of each block in this class.
+    u64 block_size;
+    // Blocks which have been freed and are available for reuse.
+    slab_free_block* free_list;
+    // The next never-used block in the page most recently assigned to this class.
+    u8* cursor;
+    // The end of the page most recently assigned to this class.
+    u8* cursor_end;
+} slab_class;
+
+typedef struct slab_allocator_state {
+    u64 total_size;
+    u64 allocated_size;
+    u32 page_count;
+    // The next page which has never been assigned to a class.
+    u32 next_free_page;
+    slab_class classes[SLAB_ALLOCATOR_CLASS_COUNT];
+    // The class index each page belongs to, indexed by page.
+    u8* page_classes;
+    u8* memory_block;
+} slab_allocator_state;
+
+static u32 class_index_get(u64 size) {
+    u32 index = 0;
+    u64 class_size = SLAB_ALLOCATOR_MIN_BLOCK_SIZE;
+    while (class_size < size) {
+        class_size <<= 1;
+        index++;
+    }
+    return index;
+}
+
+b8 slab_allocator_create(u64 total_size, u64* memory_requirement, void* memory, slab_allocator* out_allocator) {
+    if (!memory_requirement) {
+        KERROR("slab_allocator_create requires memory_requirement to exist. Create failed.");
+        return false;
+    }
+    u64 page_count = total_size / SLAB_ALLOCATOR_PAGE_SIZE;
+    if (page_count < 1) {
+        KERROR("slab_allocator_create requires a total_size of at least %llu. Create failed.", SLAB_ALLOCATOR_PAGE_SIZE);
+        return false;
+    }
+    total_size = page_count * SLAB_ALLOCATOR_PAGE_SIZE;
+
+    // Memory layout:
+    // state
+    // page class table
+    // padding to align the memory block
+    // memory block
+    u64 header_size = get_aligned(sizeof(slab_allocator_state) + page_count, SLAB_ALLOCATOR_MIN_BLOCK_SIZE);
+    // Extra room so the memory block can be aligned regardless of where the block given to us starts.
+    *memory_requirement = header_size + SLAB_ALLOCATOR_MIN_BLOCK_SIZE + total_size;
+
+    // If only obtaining requirement, boot out.
+    if (!memory) {
+        return true;
+    }
+
+    out_allocator->memory = memory;
+    slab_allocator_state* state = out_allocator->memory;
+    kzero_memory(state, sizeof(slab_allocator_state));
+    state->total_size = total_size;
+    state->page_count = (u32)page_count;
+    state->page_classes = (u8*)memory + sizeof(slab_allocator_state);
+    kzero_memory(state->page_classes, page_count);
+    state->memory_block = (u8*)get_aligned((u64)memory + header_size, SLAB_ALLOCATOR_MIN_BLOCK_SIZE);
+
+    u64 block_size = SLAB_ALLOCATOR_MIN_BLOCK_SIZE;
+    for (u32 i = 0; i < SLAB_ALLOCATOR_CLASS_COUNT; ++i) {
+        state->classes[i].block_size = block_size;
+        block_size <<= 1;
+    }
+
+    return true;
+}
+
+b8 slab_allocator_destroy(slab_allocator* allocator) {
+    if (allocator && allocator->memory) {
+        slab_allocator_state* state = allocator->memory;
+        kzero_memory(state, sizeof(slab_allocator_state));
+        allocator->memory = 0;
+        return true;
+    }
+
+    KWARN("slab_allocator_destroy requires a pointer to an allocator. Destroy failed.");
+    return false;
+}
+
+void* slab_allocator_allocate(slab_allocator* allocator, u64 size) {
+    if (!allocator || !allocator->memory || !size || size > SLAB_ALLOCATOR_MAX_BLOCK_SIZE) {
+        KERROR("slab_allocator_allocate requires a valid allocator and a size between 1 and %u.", SLAB_ALLOCATOR_MAX_BLOCK_SIZE);
+        return 0;
+    }
+
+    slab_allocator_state* state = allocator->memory;
+    u32 index = class_index_get(size);
+    slab_class* c = &state->classes[index];
+
+    void* block = 0;
+    if (c->free_list) {
+        // Reuse a freed block first.
+        block = c->free_list;
+        c->free_list = c->free_list->next;
+    } else {
+        if (c->cursor == c->cursor_end) {
+            // The current page is used up, so take a new one for this class.
+            if (state->next_free_page == state->page_count) {
+                return 0;
+            }
+            u32 page = state->next_free_page++;
+            state->page_classes[page] = (u8)index;
+            c->cursor = state->memory_block + ((u64)page * SLAB_ALLOCATOR_PAGE_SIZE);
+            c->cursor_end = c->cursor + SLAB_ALLOCATOR_PAGE_SIZE;
+        }
+        block = c->cursor;
+        c->cursor += c->block_size;
+    }
+
+    state->allocated_size += c->block_size;
+    return block;
+}
+
+b8 slab_allocator_free(slab_allocator* allocator, void* block) {
+    if (!allocator || !allocator->memory || !block) {
+        KERROR("slab_allocator_free requires both a valid allocator (0x%p) and a block (0x%p) to be freed.", allocator, block);
+        return false;
+    }
+
+    if (!slab_allocator_owns_block(allocator, block)) {
+        KWARN("slab_allocator_free trying to release block (0x%p) outside of allocator range.", block);
+        return false;
+    }
+
+    slab_allocator_state* state = allocator->memory;
+    u64 page = ((u8*)block - state->memory_block) / SLAB_ALLOCATOR_PAGE_SIZE;
+    KASSERT_MSG(page < state->next_free_page, "slab_allocator_free was given a block in a page which was never assigned. Memory corruption likely.");
+    slab_class* c = &state->classes[state->page_classes[page]];
+
+    slab_free_block* free_block = block;
+    free_block->next = c->free_list;
+    c->free_list = free_block;
+    state->allocated_size -= c->block_size;
+    return true;
+}
+
+b8 slab_allocator_owns_block(slab_allocator* allocator, const void* block) {
+    if (!allocator || !allocator->memory) {
+        return false;
+    }
+    slab_allocator_state* state = allocator->memory;
+    return (const u8*)block >= state->memory_block && (const u8*)block < state->memory_block + state->total_size;
+}
+
+u64 slab_allocator_block_size(slab_allocator* allocator, const void* block) {
+    if (!slab_allocator_owns_block(allocator, block)) {
+        return 0;
+    }
+    slab_allocator_state* state = allocator->memory;
+    u64 page = ((const u8*)block - state->memory_block) / SLAB_ALLOCATOR_PAGE_SIZE;
+    return state->classes[state->page_classes[page]].block_size;
+}
+
+u64 slab_allocator_class_size_get(u64 size) {
+    if (!size || size > SLAB_ALLOCATOR_MAX_BLOCK_SIZE) {
+        return 0;
+    }
+    return (u64)SLAB_ALLOCATOR_MIN_BLOCK_SIZE << class_index_get(size);
+}
+
+u64 slab_allocator_free_space(slab_allocator* allocator) {
+    slab_allocator_state* state = allocator->memory;
+    return state->total_size - state->allocated_size;
+}
+
+u64 slab_allocator_total_space(slab_allocator* allocator) {
+    slab_allocator_state* state = allocator->memory;
+    return state->total_size;
+}
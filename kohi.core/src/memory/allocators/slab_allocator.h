@@ -0,0 +1,118 @@
+/**
+ * @file slab_allocator.h
+ * @author Travis Vroman (travis@kohiengine.com)
+ * @brief Contains the implementation of the slab allocator.
+ * @details A slab allocator serves small allocations from a set of fixed size classes
+ * (powers of two from SLAB_ALLOCATOR_MIN_BLOCK_SIZE to SLAB_ALLOCATOR_MAX_BLOCK_SIZE).
+ * Its memory is divided into pages of SLAB_ALLOCATOR_PAGE_SIZE bytes, each of which is
+ * handed to a single size class the first time that class needs more room. Within a
+ * class, freed blocks are kept in an intrusive free list, so both allocation and free
+ * are O(1). Pages are never returned from a class once assigned to it.
+ * @version 1.0
+ * @date 2024-11-03
+ *
+ * @copyright Kohi Game Engine is Copyright (c) Travis Vroman 2021-2024
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The smallest block size handed out by a slab allocator. Also the alignment of all blocks. */
+#define SLAB_ALLOCATOR_MIN_BLOCK_SIZE 16
+/** @brief The largest block size handed out by a slab allocator. */
+#define SLAB_ALLOCATOR_MAX_BLOCK_SIZE 512
+/** @brief The number of size classes in a slab allocator (16, 32, 64, 128, 256, 512). */
+#define SLAB_ALLOCATOR_CLASS_COUNT 6
+/** @brief The size of each page a size class grows by. */
+#define SLAB_ALLOCATOR_PAGE_SIZE KIBIBYTES(64)
+
+/** @brief The slab allocator structure. */
+typedef struct slab_allocator {
+    /** @brief The allocated memory block for this allocator to use. */
+    void* memory;
+} slab_allocator;
+
+/**
+ * @brief Creates a new slab allocator. Should be called twice; once to obtain the memory
+ * amount required (passing memory=0), and a second time with memory being set to an allocated block.
+ *
+ * @param total_size The total size in bytes the allocator should hold. Rounded down to a multiple of SLAB_ALLOCATOR_PAGE_SIZE, and must be at least one page.
+ * @param memory_requirement A pointer to hold the required memory for the internal state _plus_ total_size.
+ * @param memory An allocated block of memory, or 0 if just obtaining the requirement.
+ * @param out_allocator A pointer to hold the allocator.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 slab_allocator_create(u64 total_size, u64* memory_requirement, void* memory, slab_allocator* out_allocator);
+
+/**
+ * @brief Destroys the given allocator.
+ *
+ * @param allocator A pointer to the allocator to be destroyed.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 slab_allocator_destroy(slab_allocator* allocator);
+
+/**
+ * @brief Allocates a block from the size class which fits the given size. The returned
+ * block is aligned to SLAB_ALLOCATOR_MIN_BLOCK_SIZE and is _not_ zeroed.
+ *
+ * @param allocator A pointer to the allocator to allocate from.
+ * @param size The amount in bytes to be allocated. Must be nonzero and no larger than SLAB_ALLOCATOR_MAX_BLOCK_SIZE.
+ * @return The allocated block of memory, or 0 if the size is unsupported or no space remains.
+ */
+KAPI void* slab_allocator_allocate(slab_allocator* allocator, u64 size);
+
+/**
+ * @brief Frees the given block of memory back to its size class.
+ *
+ * @param allocator A pointer to the allocator to free from.
+ * @param block The block to be freed. Must have been allocated by the provided allocator.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 slab_allocator_free(slab_allocator* allocator, void* block);
+
+/**
+ * @brief Indicates if the given block of memory lies within the range managed by the
+ * provided allocator. Does not read from the block itself.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param block The block of memory.
+ * @return True if the block is within the allocator's range; otherwise false.
+ */
+KAPI b8 slab_allocator_owns_block(slab_allocator* allocator, const void* block);
+
+/**
+ * @brief Obtains the size of the class the given block belongs to.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param block The block of memory.
+ * @return The block size in bytes, or 0 if the block is not owned by the allocator.
+ */
+KAPI u64 slab_allocator_block_size(slab_allocator* allocator, const void* block);
+
+/**
+ * @brief Obtains the block size of the size class that a request of the given size would be served from.
+ *
+ * @param size The requested size in bytes.
+ * @return The size of the class in bytes, or 0 if the size is too large for a slab allocator.
+ */
+KAPI u64 slab_allocator_class_size_get(u64 size);
+
+/**
+ * @brief Obtains the amount of free space left in the provided allocator. This includes
+ * both unassigned pages and free blocks within each size class.
+ *
+ * @param allocator A pointer to the allocator to be examined.
+ * @return The amount of free space in bytes.
+ */
+KAPI u64 slab_allocator_free_space(slab_allocator* allocator);
+
+/**
+ * @brief Obtains the amount of total space originally available in the provided allocator.
+ *
+ * @param allocator A pointer to the allocator to be examined.
+ * @return The total amount of space originally available in bytes.
+ */
+KAPI u64 slab_allocator_total_space(slab_allocator* allocator);
@@ -4,8 +4,10 @@
 #include "defines.h"
 #include "logger.h"
 #include "memory/allocators/dynamic_allocator.h"
+#include "memory/allocators/slab_allocator.h"
 #include "platform/platform.h"
 #include "strings/kstring.h"
+#include "threads/katomic.h"
 #include "threads/kmutex.h"
 
 // TODO: Custom string lib
@@ -25,6 +27,43 @@
 #        define kaligned_free free
 #    endif
 #endif
+
+/*
+ * Small allocations (up to K_MEMORY_SMALL_MAX_SIZE bytes with an alignment of no more than
+ * K_MEMORY_SMALL_ALIGNMENT) are rounded up to a size class and served from a per-thread cache
+ * of blocks for that class. Caches are refilled from, and flushed back to, the shared allocator
+ * in batches, so a mutex is only taken once per K_MEMORY_CACHE_BATCH_SIZE allocations/frees
+ * instead of on every call.
+ *
+ * If the system is configured with a small allocation pool, the shared side of this is a slab
+ * allocator, which hands out and takes back blocks in constant time and keeps small, short-lived
+ * allocations from fragmenting the dynamic allocator. Once the pool is exhausted, small
+ * allocations fall back to the dynamic allocator.
+ */
+#define K_MEMORY_SIZE_CLASS_COUNT SLAB_ALLOCATOR_CLASS_COUNT
+#define K_MEMORY_SMALL_MIN_SIZE SLAB_ALLOCATOR_MIN_BLOCK_SIZE
+#define K_MEMORY_SMALL_MAX_SIZE SLAB_ALLOCATOR_MAX_BLOCK_SIZE
+#define K_MEMORY_SMALL_ALIGNMENT SLAB_ALLOCATOR_MIN_BLOCK_SIZE
+#define K_MEMORY_CACHE_BATCH_SIZE 16
+#define K_MEMORY_CACHE_BIN_CAPACITY (K_MEMORY_CACHE_BATCH_SIZE * 2)
+
+// The amount of memory committed at a time when using virtual memory, unless huge pages are used.
+#define K_MEMORY_COMMIT_GRANULARITY KIBIBYTES(64)
+// The amount of memory committed at a time when using virtual memory with huge pages.
+#define K_MEMORY_HUGE_COMMIT_GRANULARITY MEBIBYTES(2)
+
+typedef struct memory_cache_bin {
+    u32 count;
+    void* blocks[K_MEMORY_CACHE_BIN_CAPACITY];
+} memory_cache_bin;
+
+typedef struct memory_thread_cache {
+    // The epoch of the memory system the cached blocks belong to. Blocks from a
+    // previous initialization of the memory system are simply dropped.
+    u32 epoch;
+    memory_cache_bin bins[K_MEMORY_SIZE_CLASS_COUNT];
+} memory_thread_cache;
+
 struct memory_stats {
     u64 total_allocated;
     u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
@@ -76,13 +115,37 @@ typedef struct memory_system_state {
     u64 allocator_memory_requirement;
     dynamic_allocator allocator;
     void* allocator_block;
+    u64 slab_memory_requirement;
+    // The size of the reserved address range holding everything. Only nonzero if config.use_virtual_memory is set.
+    u64 reserved_size;
+    // The small allocation pool. Only valid if config.small_alloc_pool_size is nonzero.
+    slab_allocator slab;
+    void* slab_block;
     // A mutex for allocations/frees
     kmutex allocation_mutex;
+    // A mutex for allocations/frees against the small allocation pool.
+    kmutex small_alloc_mutex;
+    // The epoch of this initialization of the memory system, used to invalidate thread caches.
+    u32 epoch;
 } memory_system_state;
 
 // Pointer to system state.
 static memory_system_state* state_ptr;
 
+// Incremented each time the memory system is initialized.
+static u32 memory_epoch = 0;
+
+#if K_USE_CUSTOM_MEMORY_ALLOCATOR
+// The small allocation cache for the calling thread.
+static KTHREAD_LOCAL memory_thread_cache thread_cache;
+
+static b8 small_alloc_class_get(u64 size, u16 alignment, u32* out_class_index, u64* out_class_size);
+static memory_cache_bin* thread_cache_bin_get(u32 class_index);
+static void* small_alloc_allocate(u32 class_index, u64 class_size);
+static void small_alloc_free(u32 class_index, void* block);
+static void thread_cache_bin_flush(memory_cache_bin* bin, u32 count);
+#endif
+
 b8 memory_system_initialize(memory_system_configuration config) {
 #if K_USE_CUSTOM_MEMORY_ALLOCATOR
     // The amount needed by the system state.
@@ -90,11 +153,49 @@ b8 memory_system_initialize(memory_system_configuration config) {
 
     // Figure out how much space the dynamic allocator needs.
     u64 alloc_requirement = 0;
-    dynamic_allocator_create(config.total_alloc_size, &alloc_requirement, 0, 0);
+    u64 commit_granularity = 0;
+    if (config.use_virtual_memory) {
+        commit_granularity = config.use_huge_pages ? K_MEMORY_HUGE_COMMIT_GRANULARITY : K_MEMORY_COMMIT_GRANULARITY;
+        commit_granularity = KMAX(commit_granularity, platform_memory_page_size());
+        // The allocator needs to start on a commit boundary.
+        state_memory_requirement = get_aligned(state_memory_requirement, commit_granularity);
+        if (!dynamic_allocator_create_reserved(config.total_alloc_size, commit_granularity, platform_memory_commit, platform_memory_decommit, &alloc_requirement, 0, 0)) {
+            KFATAL("Memory system is unable to determine internal allocator requirements. Application cannot continue.");
+            return false;
+        }
+    } else {
+        dynamic_allocator_create(config.total_alloc_size, &alloc_requirement, 0, 0);
+    }
+
+    // Figure out how much space the small allocation pool needs, if one is used.
+    u64 slab_requirement = 0;
+    if (config.small_alloc_pool_size) {
+        if (!slab_allocator_create(config.small_alloc_pool_size, &slab_requirement, 0, 0)) {
+            KFATAL("Memory system is unable to determine small allocation pool requirements. Application cannot continue.");
+            return false;
+        }
+    }
 
-    // Call the platform allocator to get the memory for the whole system, including the state.
-    // TODO: memory alignment
-    void* block = platform_allocate(state_memory_requirement + alloc_requirement, true);
+    // Get the memory for the whole system, including the state.
+    u64 total_requirement = state_memory_requirement + alloc_requirement + slab_requirement;
+    u64 reserved_size = 0;
+    void* block = 0;
+    if (config.use_virtual_memory) {
+        // Reserve address space for everything, but only commit the state and the small allocation pool
+        // up front. The internal allocator commits the rest as it is used.
+        reserved_size = get_aligned(total_requirement, commit_granularity);
+        block = platform_memory_reserve(reserved_size, config.use_huge_pages);
+        if (block) {
+            void* slab_start = (void*)((u64)block + state_memory_requirement + alloc_requirement);
+            if (!platform_memory_commit(block, state_memory_requirement) || (slab_requirement && !platform_memory_commit(slab_start, slab_requirement))) {
+                platform_memory_release(block, reserved_size);
+                block = 0;
+            }
+        }
+    } else {
+        // TODO: memory alignment
+        block = platform_allocate(total_requirement, true);
+    }
     if (!block) {
         KFATAL("Memory system allocation failed and the system cannot continue.");
         return false;
@@ -105,18 +206,45 @@ b8 memory_system_initialize(memory_system_configuration config) {
     state_ptr->config = config;
     state_ptr->alloc_count = 0;
     state_ptr->allocator_memory_requirement = alloc_requirement;
+    state_ptr->slab_memory_requirement = slab_requirement;
+    state_ptr->reserved_size = reserved_size;
+    state_ptr->slab.memory = 0;
+    state_ptr->slab_block = 0;
+    state_ptr->epoch = ++memory_epoch;
     platform_zero_memory(&state_ptr->stats, sizeof(state_ptr->stats));
     // The allocator block is in the same block of memory, but after the state.
     state_ptr->allocator_block = ((void*)block + state_memory_requirement);
 
-    if (!dynamic_allocator_create(
+    b8 allocator_result = false;
+    if (config.use_virtual_memory) {
+        allocator_result = dynamic_allocator_create_reserved(
             config.total_alloc_size,
+            commit_granularity,
+            platform_memory_commit,
+            platform_memory_decommit,
             &state_ptr->allocator_memory_requirement,
             state_ptr->allocator_block,
-            &state_ptr->allocator)) {
+            &state_ptr->allocator);
+    } else {
+        allocator_result = dynamic_allocator_create(
+            config.total_alloc_size,
+            &state_ptr->allocator_memory_requirement,
+            state_ptr->allocator_block,
+            &state_ptr->allocator);
+    }
+    if (!allocator_result) {
         KFATAL("Memory system is unable to setup internal allocator. Application cannot continue.");
         return false;
     }
+
+    // The small allocation pool comes after the dynamic allocator's block.
+    if (slab_requirement) {
+        state_ptr->slab_block = ((void*)state_ptr->allocator_block + alloc_requirement);
+        if (!slab_allocator_create(config.small_alloc_pool_size, &state_ptr->slab_memory_requirement, state_ptr->slab_block, &state_ptr->slab)) {
+            KFATAL("Memory system is unable to setup small allocation pool. Application cannot continue.");
+            return false;
+        }
+    }
 #else
     state_ptr = kaligned_alloc(sizeof(memory_system_state), 16);
     kzero_memory(state_ptr, sizeof(memory_system_state));
@@ -130,8 +258,16 @@ b8 memory_system_initialize(memory_system_configuration config) {
         KFATAL("Unable to create allocation mutex!");
         return false;
     }
+    if (!kmutex_create(&state_ptr->small_alloc_mutex)) {
+        KFATAL("Unable to create small allocation mutex!");
+        return false;
+    }
 
-    KDEBUG("Memory system successfully allocated %llu bytes.", config.total_alloc_size);
+    if (config.use_virtual_memory) {
+        KDEBUG("Memory system successfully reserved %llu bytes.", config.total_alloc_size);
+    } else {
+        KDEBUG("Memory system successfully allocated %llu bytes.", config.total_alloc_size);
+    }
     return true;
 }
 
@@ -139,11 +275,19 @@ void memory_system_shutdown(void) {
     if (state_ptr) {
         // Destroy allocation mutex
         kmutex_destroy(&state_ptr->allocation_mutex);
+        kmutex_destroy(&state_ptr->small_alloc_mutex);
 
 #if K_USE_CUSTOM_MEMORY_ALLOCATOR
+        if (state_ptr->slab.memory) {
+            slab_allocator_destroy(&state_ptr->slab);
+        }
         dynamic_allocator_destroy(&state_ptr->allocator);
         // Free the entire block.
-        platform_free(state_ptr, state_ptr->allocator_memory_requirement + sizeof(memory_system_state));
+        if (state_ptr->reserved_size) {
+            platform_memory_release(state_ptr, state_ptr->reserved_size);
+        } else {
+            platform_free(state_ptr, state_ptr->allocator_memory_requirement + state_ptr->slab_memory_requirement + sizeof(memory_system_state));
+        }
 #else
         kaligned_free(state_ptr);
 #endif
@@ -167,6 +311,28 @@ void* kallocate_aligned(u64 size, u16 alignment, memory_tag tag) {
     // really happen.
     void* block = 0;
     if (state_ptr) {
+#if K_USE_CUSTOM_MEMORY_ALLOCATOR
+        // Small allocations are served from the calling thread's cache and never touch the mutex
+        // unless the cache needs to be refilled. These are tracked by their size class so that
+        // frees (which may pass either size) keep the stats consistent.
+        u32 class_index;
+        u64 class_size;
+        if (small_alloc_class_get(size, alignment, &class_index, &class_size)) {
+            block = small_alloc_allocate(class_index, class_size);
+            if (block) {
+                katomic_add_u64_relaxed(&state_ptr->stats.total_allocated, class_size);
+                katomic_add_u64_relaxed(&state_ptr->stats.tagged_allocations[tag], class_size);
+                katomic_add_u64_relaxed(&state_ptr->stats.new_tagged_allocations[tag], class_size);
+                katomic_add_u64_relaxed(&state_ptr->alloc_count, 1);
+                platform_zero_memory(block, class_size);
+                return block;
+            }
+
+            KFATAL("kallocate_aligned failed to allocate successfully.");
+            return 0;
+        }
+#endif
+
         // Make sure multithreaded requests don't trample each other.
         if (!kmutex_lock(&state_ptr->allocation_mutex)) {
             KFATAL("Error obtaining mutex lock during allocation.");
@@ -174,10 +340,10 @@ void* kallocate_aligned(u64 size, u16 alignment, memory_tag tag) {
         }
 
         // FIXME: Track aligned alloc offset as part of size.
-        state_ptr->stats.total_allocated += size;
-        state_ptr->stats.tagged_allocations[tag] += size;
-        state_ptr->stats.new_tagged_allocations[tag] += size;
-        state_ptr->alloc_count++;
+        katomic_add_u64_relaxed(&state_ptr->stats.total_allocated, size);
+        katomic_add_u64_relaxed(&state_ptr->stats.tagged_allocations[tag], size);
+        katomic_add_u64_relaxed(&state_ptr->stats.new_tagged_allocations[tag], size);
+        katomic_add_u64_relaxed(&state_ptr->alloc_count, 1);
 
 #if K_USE_CUSTOM_MEMORY_ALLOCATOR
         block = dynamic_allocator_allocate_aligned(&state_ptr->allocator, size, alignment);
@@ -202,16 +368,10 @@ void* kallocate_aligned(u64 size, u16 alignment, memory_tag tag) {
 }
 
 void kallocate_report(u64 size, memory_tag tag) {
-    // Make sure multithreaded requests don't trample each other.
-    if (!kmutex_lock(&state_ptr->allocation_mutex)) {
-        KFATAL("Error obtaining mutex lock during allocation reporting.");
-        return;
-    }
-    state_ptr->stats.total_allocated += size;
-    state_ptr->stats.tagged_allocations[tag] += size;
-    state_ptr->stats.new_tagged_allocations[tag] += size;
-    state_ptr->alloc_count++;
-    kmutex_unlock(&state_ptr->allocation_mutex);
+    katomic_add_u64_relaxed(&state_ptr->stats.total_allocated, size);
+    katomic_add_u64_relaxed(&state_ptr->stats.tagged_allocations[tag], size);
+    katomic_add_u64_relaxed(&state_ptr->stats.new_tagged_allocations[tag], size);
+    katomic_add_u64_relaxed(&state_ptr->alloc_count, 1);
 }
 
 void* kreallocate(void* block, u64 old_size, u64 new_size, memory_tag tag) {
@@ -245,6 +405,25 @@ void kfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag) {
         KWARN("kfree_aligned called using MEMORY_TAG_UNKNOWN. Re-class this allocation.");
     }
     if (state_ptr) {
+#if K_USE_CUSTOM_MEMORY_ALLOCATOR
+        // Small allocations go back to the calling thread's cache. Blocks not owned by the
+        // allocator were made before the system was started, and are given back to the OS.
+        u32 class_index;
+        u64 class_size;
+        if (small_alloc_class_get(size, alignment, &class_index, &class_size)) {
+            if (!slab_allocator_owns_block(&state_ptr->slab, block) && !dynamic_allocator_owns_block(&state_ptr->allocator, block)) {
+                platform_free(block, false);
+                return;
+            }
+            katomic_sub_u64_relaxed(&state_ptr->stats.total_allocated, class_size);
+            katomic_sub_u64_relaxed(&state_ptr->stats.tagged_allocations[tag], class_size);
+            katomic_add_u64_relaxed(&state_ptr->stats.new_tagged_deallocations[tag], class_size);
+            katomic_sub_u64_relaxed(&state_ptr->alloc_count, 1);
+            small_alloc_free(class_index, block);
+            return;
+        }
+#endif
+
         // Make sure multithreaded requests don't trample each other.
         if (!kmutex_lock(&state_ptr->allocation_mutex)) {
             KFATAL("Unable to obtain mutex lock for free operation. Heap corruption is likely.");
@@ -265,10 +444,10 @@ void kfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag) {
         }
 #endif
 
-        state_ptr->stats.total_allocated -= size;
-        state_ptr->stats.tagged_allocations[tag] -= size;
-        state_ptr->stats.new_tagged_deallocations[tag] += size;
-        state_ptr->alloc_count--;
+        katomic_sub_u64_relaxed(&state_ptr->stats.total_allocated, size);
+        katomic_sub_u64_relaxed(&state_ptr->stats.tagged_allocations[tag], size);
+        katomic_add_u64_relaxed(&state_ptr->stats.new_tagged_deallocations[tag], size);
+        katomic_sub_u64_relaxed(&state_ptr->alloc_count, 1);
 #if K_USE_CUSTOM_MEMORY_ALLOCATOR
         b8 result = dynamic_allocator_free_aligned(&state_ptr->allocator, block);
 #else
@@ -293,19 +472,21 @@ void kfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag) {
 }
 
 void kfree_report(u64 size, memory_tag tag) {
-    // Make sure multithreaded requests don't trample each other.
-    if (!kmutex_lock(&state_ptr->allocation_mutex)) {
-        KFATAL("Error obtaining mutex lock during allocation reporting.");
-        return;
-    }
-    state_ptr->stats.total_allocated -= size;
-    state_ptr->stats.tagged_allocations[tag] -= size;
-    state_ptr->stats.new_tagged_deallocations[tag] += size;
-    state_ptr->alloc_count--;
-    kmutex_unlock(&state_ptr->allocation_mutex);
+    katomic_sub_u64_relaxed(&state_ptr->stats.total_allocated, size);
+    katomic_sub_u64_relaxed(&state_ptr->stats.tagged_allocations[tag], size);
+    katomic_add_u64_relaxed(&state_ptr->stats.new_tagged_deallocations[tag], size);
+    katomic_sub_u64_relaxed(&state_ptr->alloc_count, 1);
 }
 
 b8 kmemory_get_size_alignment(void* block, u64* out_size, u16* out_alignment) {
+#if K_USE_CUSTOM_MEMORY_ALLOCATOR
+    // Blocks from the small allocation pool carry no header, so report their class instead.
+    if (slab_allocator_owns_block(&state_ptr->slab, block)) {
+        *out_size = slab_allocator_block_size(&state_ptr->slab, block);
+        *out_alignment = K_MEMORY_SMALL_ALIGNMENT;
+        return true;
+    }
+#endif
     if (!kmutex_lock(&state_ptr->allocation_mutex)) {
         KFATAL("Error obtaining mutex lock during kmemory_get_size_alignment.");
         return false;
@@ -321,6 +502,42 @@ b8 kmemory_get_size_alignment(void* block, u64* out_size, u16* out_alignment) {
     return result;
 }
 
+void kmemory_thread_cache_flush(void) {
+#if K_USE_CUSTOM_MEMORY_ALLOCATOR
+    if (!state_ptr || thread_cache.epoch != state_ptr->epoch) {
+        return;
+    }
+
+    for (u32 i = 0; i < K_MEMORY_SIZE_CLASS_COUNT; ++i) {
+        memory_cache_bin* bin = &thread_cache.bins[i];
+        if (bin->count) {
+            thread_cache_bin_flush(bin, bin->count);
+        }
+    }
+#endif
+}
+
+u64 kmemory_trim(void) {
+#if K_USE_CUSTOM_MEMORY_ALLOCATOR
+    if (!state_ptr || !state_ptr->reserved_size) {
+        return 0;
+    }
+
+    // Cached blocks on this thread could be holding up the end of the allocator.
+    kmemory_thread_cache_flush();
+
+    if (!kmutex_lock(&state_ptr->allocation_mutex)) {
+        KERROR("Unable to obtain mutex lock for kmemory_trim.");
+        return 0;
+    }
+    u64 trimmed = dynamic_allocator_trim(&state_ptr->allocator);
+    kmutex_unlock(&state_ptr->allocation_mutex);
+    return trimmed;
+#else
+    return 0;
+#endif
+}
+
 void* kzero_memory(void* block, u64 size) {
     return platform_zero_memory(block, size);
 }
@@ -384,11 +601,57 @@ char* get_memory_usage_str(void) {
         f32 total_amount = 1.0f;
         const char* total_unit = get_unit_for_size(total_space, &total_amount);
 
-        f64 percent_used = (f64)(used_space) / total_space;
+        f64 percent_used = (f64)(used_space) / total_space * 100.0;
+
+        i32 length = snprintf(buffer + offset, 8000 - offset, "Total memory usage: %.2f%s of %.2f%s (%.2f%%)\n", used_amount, used_unit, total_amount, total_unit, percent_used);
+        offset += length;
+    }
+#if K_USE_CUSTOM_MEMORY_ALLOCATOR
+    {
+        // Fragmentation of the internal allocator. This walks the allocator's internal structures, so take the lock.
+        u64 largest_free = 0;
+        u64 free_block_count = 0;
+        if (kmutex_lock(&state_ptr->allocation_mutex)) {
+            largest_free = dynamic_allocator_largest_free_block(&state_ptr->allocator);
+            free_block_count = dynamic_allocator_free_block_count(&state_ptr->allocator);
+            kmutex_unlock(&state_ptr->allocation_mutex);
+        }
+
+        f32 largest_amount = 1.0f;
+        const char* largest_unit = get_unit_for_size(largest_free, &largest_amount);
+
+        i32 length = snprintf(buffer + offset, 8000 - offset, "Free blocks: %llu (largest: %.2f%s)\n", free_block_count, largest_amount, largest_unit);
+        offset += length;
+    }
+    if (state_ptr->reserved_size) {
+        u64 committed = dynamic_allocator_committed_space(&state_ptr->allocator);
+        f32 committed_amount = 1.0f;
+        const char* committed_unit = get_unit_for_size(committed, &committed_amount);
+
+        f32 reserved_amount = 1.0f;
+        const char* reserved_unit = get_unit_for_size(state_ptr->reserved_size, &reserved_amount);
+
+        i32 length = snprintf(buffer + offset, 8000 - offset, "Committed: %.2f%s of %.2f%s reserved\n", committed_amount, committed_unit, reserved_amount, reserved_unit);
+        offset += length;
+    }
+#endif
+#if K_USE_CUSTOM_MEMORY_ALLOCATOR
+    if (state_ptr->slab.memory) {
+        u64 total_space = slab_allocator_total_space(&state_ptr->slab);
+        u64 used_space = total_space - slab_allocator_free_space(&state_ptr->slab);
+
+        f32 used_amount = 1.0f;
+        const char* used_unit = get_unit_for_size(used_space, &used_amount);
+
+        f32 total_amount = 1.0f;
+        const char* total_unit = get_unit_for_size(total_space, &total_amount);
+
+        f64 percent_used = (f64)(used_space) / total_space * 100.0;
 
-        i32 length = snprintf(buffer + offset, 8000, "Total memory usage: %.2f%s of %.2f%s (%.2f%%)\n", used_amount, used_unit, total_amount, total_unit, percent_used);
+        i32 length = snprintf(buffer + offset, 8000 - offset, "Small allocation pool usage: %.2f%s of %.2f%s (%.2f%%)\n", used_amount, used_unit, total_amount, total_unit, percent_used);
         offset += length;
     }
+#endif
 
     char* out_string = string_duplicate(buffer);
     return out_string;
@@ -396,7 +659,7 @@ char* get_memory_usage_str(void) {
 
 u64 get_memory_alloc_count(void) {
     if (state_ptr) {
-        return state_ptr->alloc_count;
+        return katomic_load_u64(&state_ptr->alloc_count);
     }
     return 0;
 }
@@ -417,3 +680,106 @@ b8 unpack_u8_from_u32(u32 n, u8* x, u8* y, u8* z, u8* w) {
 
     return true;
 }
+
+#if K_USE_CUSTOM_MEMORY_ALLOCATOR
+static b8 small_alloc_class_get(u64 size, u16 alignment, u32* out_class_index, u64* out_class_size) {
+    if (size > K_MEMORY_SMALL_MAX_SIZE || alignment > K_MEMORY_SMALL_ALIGNMENT) {
+        return false;
+    }
+
+    u32 index = 0;
+    u64 class_size = K_MEMORY_SMALL_MIN_SIZE;
+    while (class_size < size) {
+        class_size <<= 1;
+        index++;
+    }
+
+    *out_class_index = index;
+    *out_class_size = class_size;
+    return true;
+}
+
+static memory_cache_bin* thread_cache_bin_get(u32 class_index) {
+    // Blocks left over from a previous initialization of the memory system are invalid.
+    if (thread_cache.epoch != state_ptr->epoch) {
+        platform_zero_memory(&thread_cache, sizeof(memory_thread_cache));
+        thread_cache.epoch = state_ptr->epoch;
+    }
+    return &thread_cache.bins[class_index];
+}
+
+static void* small_alloc_allocate(u32 class_index, u64 class_size) {
+    memory_cache_bin* bin = thread_cache_bin_get(class_index);
+    if (bin->count == 0) {
+        // Refill the cache with a batch of blocks in a single trip through the mutex,
+        // preferring the small allocation pool if there is one.
+        if (state_ptr->slab.memory) {
+            if (!kmutex_lock(&state_ptr->small_alloc_mutex)) {
+                KFATAL("Error obtaining mutex lock during allocation.");
+                return 0;
+            }
+            for (u32 i = 0; i < K_MEMORY_CACHE_BATCH_SIZE; ++i) {
+                void* block = slab_allocator_allocate(&state_ptr->slab, class_size);
+                if (!block) {
+                    break;
+                }
+                bin->blocks[bin->count++] = block;
+            }
+            kmutex_unlock(&state_ptr->small_alloc_mutex);
+        }
+
+        if (bin->count == 0) {
+            if (!kmutex_lock(&state_ptr->allocation_mutex)) {
+                KFATAL("Error obtaining mutex lock during allocation.");
+                return 0;
+            }
+            for (u32 i = 0; i < K_MEMORY_CACHE_BATCH_SIZE; ++i) {
+                void* block = dynamic_allocator_allocate_aligned(&state_ptr->allocator, class_size, K_MEMORY_SMALL_ALIGNMENT);
+                if (!block) {
+                    break;
+                }
+                bin->blocks[bin->count++] = block;
+            }
+            kmutex_unlock(&state_ptr->allocation_mutex);
+        }
+
+        if (bin->count == 0) {
+            return 0;
+        }
+    }
+
+    return bin->blocks[--bin->count];
+}
+
+static void small_alloc_free(u32 class_index, void* block) {
+    memory_cache_bin* bin = thread_cache_bin_get(class_index);
+    if (bin->count == K_MEMORY_CACHE_BIN_CAPACITY) {
+        // Give half of the cache back so that a thread which only frees doesn't hoard memory.
+        thread_cache_bin_flush(bin, K_MEMORY_CACHE_BATCH_SIZE);
+    }
+    bin->blocks[bin->count++] = block;
+}
+
+static void thread_cache_bin_flush(memory_cache_bin* bin, u32 count) {
+    // NOTE: The small allocation mutex may be held while taking the allocation mutex, never the other way around.
+    if (!kmutex_lock(&state_ptr->small_alloc_mutex)) {
+        KFATAL("Unable to obtain mutex lock for free operation. Heap corruption is likely.");
+        return;
+    }
+    for (u32 i = 0; i < count; ++i) {
+        void* block = bin->blocks[--bin->count];
+        if (slab_allocator_owns_block(&state_ptr->slab, block)) {
+            slab_allocator_free(&state_ptr->slab, block);
+        } else {
+            // Only happens once the small allocation pool has been exhausted, so take the lock per block.
+            if (!kmutex_lock(&state_ptr->allocation_mutex)) {
+                KFATAL("Unable to obtain mutex lock for free operation. Heap corruption is likely.");
+                break;
+            }
+            dynamic_allocator_free_aligned(&state_ptr->allocator, block);
+            kmutex_unlock(&state_ptr->allocation_mutex);
+        }
+    }
+    kmutex_unlock(&state_ptr->small_alloc_mutex);
+}
+#endif
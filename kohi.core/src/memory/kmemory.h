@@ -72,6 +72,21 @@ typedef enum memory_tag {
 typedef struct memory_system_configuration {
     /** @brief The total memory size in byes used by the internal allocator for this system. */
     u64 total_alloc_size;
+    /**
+     * @brief The size in bytes of the pool small allocations (up to SLAB_ALLOCATOR_MAX_BLOCK_SIZE)
+     * are served from. This is in addition to total_alloc_size. If 0, small allocations are
+     * served from the internal allocator instead.
+     */
+    u64 small_alloc_pool_size;
+    /**
+     * @brief If true, address space for total_alloc_size is only reserved up front, and memory is
+     * committed as the internal allocator grows into it. Memory following the last allocation can
+     * later be given back to the OS via kmemory_trim(). This allows total_alloc_size to be far larger
+     * than the expected working set.
+     */
+    b8 use_virtual_memory;
+    /** @brief If using virtual memory, requests that memory be backed by huge pages where supported. */
+    b8 use_huge_pages;
 } memory_system_configuration;
 
 /**
@@ -251,6 +266,23 @@ KAPI void kfree_report(u64 size, memory_tag tag);
  */
 KAPI b8 kmemory_get_size_alignment(void* block, u64* out_size, u16* out_alignment);
 
+/**
+ * @brief Returns all small blocks held in the calling thread's allocation cache to the
+ * shared allocator. Small allocations are served from a per-thread cache which is refilled
+ * and flushed in batches; threads which exit before the memory system is shut down should
+ * call this just before exiting so that their cached blocks are not lost.
+ */
+KAPI void kmemory_thread_cache_flush(void);
+
+/**
+ * @brief Gives memory following the last live allocation back to the OS. Only has an effect when
+ * the memory system is configured to use virtual memory. Intended to be called at points where
+ * a lot of memory has just been freed, such as after unloading a level.
+ *
+ * @return The number of bytes given back to the OS.
+ */
+KAPI u64 kmemory_trim(void);
+
 /**
  * @brief Zeroes out the provided memory block.
  * @param block A pointer to the block of memory to be zeroed out.
@@ -0,0 +1,899 @@
+// NOTE: Linux needs this for pread. Must come before any system header.
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#    define _GNU_SOURCE
+#endif
+
+#include "async_io.h"
+
+#include "containers/mpsc_queue.h"
+#include "logger.h"
+#include "memory/kmemory.h"
+#include "strings/kstring.h"
+#include "threads/katomic.h"
+#include "threads/kmutex.h"
+#include "threads/ksemaphore.h"
+#include "threads/kthread.h"
+
+#if KPLATFORM_WINDOWS
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+#else
+#    include <errno.h>
+#    include <fcntl.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+// io_uring is only used where the kernel headers describing it are available at build time.
+#if KPLATFORM_LINUX && defined(__has_include)
+#    if __has_include(<linux/io_uring.h>)
+#        define ASYNC_IO_URING 1
+#        include <linux/io_uring.h>
+#        include <sys/eventfd.h>
+#        include <sys/mman.h>
+#        include <sys/syscall.h>
+#    endif
+#endif
+
+// The number of reading threads used by the thread pool backend if not configured.
+#define ASYNC_IO_DEFAULT_THREAD_COUNT 2
+// The max number of reads in flight at once with io_uring if not configured.
+#define ASYNC_IO_DEFAULT_QUEUE_DEPTH 64
+// Files are read in pieces of up to this size, so a cancelled read stops part way through
+// a large file, and large reads don't hold up others for long.
+#define ASYNC_IO_PIECE_SIZE MEBIBYTES(1)
+
+typedef enum io_request_state {
+    IO_REQUEST_STATE_FREE = 0,
+    // Waiting in one of the priority queues to be started.
+    IO_REQUEST_STATE_QUEUED,
+    // Taken by a reader.
+    IO_REQUEST_STATE_READING,
+    // Waiting for its callback to be made on the main thread.
+    IO_REQUEST_STATE_COMPLETE
+} io_request_state;
+
+#if KPLATFORM_WINDOWS
+typedef HANDLE io_file;
+#    define IO_FILE_INVALID INVALID_HANDLE_VALUE
+#else
+typedef int io_file;
+#    define IO_FILE_INVALID -1
+#endif
+
+typedef struct io_request {
+    // Links the request into the completed queue. Must be first.
+    mpsc_queue_node node;
+    // Link the request into its priority queue while queued, and the free list (next only) while free.
+    u32 prev;
+    u32 next;
+    // Combined with the index to form the id. Changed each time the request is reused, so stale ids are ignored.
+    u32 generation;
+    // Protected by the lock.
+    io_request_state state;
+    // Set when cancelled while being read. Checked by the reader between pieces.
+    u32 cancel_requested;
+
+    async_io_priority priority;
+    async_io_read_flags flags;
+    const char* path;
+    u64 offset;
+    // The number of bytes to read. Known once the file is opened, if reading to the end.
+    u64 size;
+    // The number of bytes read so far.
+    u64 read_size;
+    u8* data;
+    // The size of data, including any terminator.
+    u64 data_size;
+    io_file file;
+    async_io_result result;
+    PFN_async_io_callback callback;
+    void* context;
+} io_request;
+
+#if ASYNC_IO_URING
+// The user data marking completions of the read on the wake eventfd, rather than of a request.
+#    define RING_WAKE_USER_DATA U64_MAX
+
+typedef struct io_ring {
+    i32 fd;
+    // Written to by other threads to wake the ring thread while it waits for completions.
+    // A read of it is always in flight.
+    i32 wake_fd;
+    u64 wake_value;
+
+    void* sq_ptr;
+    u64 sq_map_size;
+    u32* sq_head;
+    u32* sq_tail;
+    u32 sq_mask;
+    u32 sq_entries;
+    struct io_uring_sqe* sqes;
+    u64 sqes_map_size;
+
+    void* cq_ptr;
+    u64 cq_map_size;
+    u32* cq_head;
+    u32* cq_tail;
+    u32 cq_mask;
+    struct io_uring_cqe* cqes;
+
+    // Prepared, but not yet handed to the kernel.
+    u32 unsubmitted_count;
+    // Reads of requests handed to the kernel and not yet completed.
+    u32 read_count;
+
+    kthread thread;
+} io_ring;
+#endif
+
+typedef struct async_io_state {
+    async_io_backend backend;
+    u32 running;
+
+    // Protects everything below, other than completed.
+    kmutex lock;
+    io_request* requests;
+    u32 free_head;
+    // The oldest and newest queued request of each priority.
+    u32 queue_heads[ASYNC_IO_PRIORITY_COUNT];
+    u32 queue_tails[ASYNC_IO_PRIORITY_COUNT];
+    // The number of requests being read, and how many of those are prefetches.
+    u32 reading_count;
+    u32 prefetch_reading_count;
+    // The max number of requests which may be read at once.
+    u32 reading_capacity;
+
+    // Requests whose callbacks are waiting to be made on the main thread.
+    mpsc_queue completed;
+
+    // Thread pool backend.
+    u8 thread_count;
+    kthread threads[ASYNC_IO_MAX_THREAD_COUNT];
+    ksemaphore semaphore;
+
+#if ASYNC_IO_URING
+    // io_uring backend.
+    io_ring ring;
+#endif
+} async_io_state;
+
+static async_io_state* state_ptr;
+
+// Opens the given file for reading, obtaining its size.
+static b8 io_file_open(const char* path, io_file* out_file, u64* out_size) {
+#if KPLATFORM_WINDOWS
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    *out_file = file;
+    *out_size = (u64)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    *out_file = fd;
+    *out_size = (u64)info.st_size;
+#endif
+    return true;
+}
+
+static void io_file_close(io_file file) {
+    if (file != IO_FILE_INVALID) {
+#if KPLATFORM_WINDOWS
+        CloseHandle(file);
+#else
+        close(file);
+#endif
+    }
+}
+
+// Reads up to size bytes from the given offset of the file, without moving a shared
+// file position, so any thread may read from anywhere. Returns the number of bytes read,
+// which is 0 at the end of the file, or -1 on error.
+static i64 io_file_read_at(io_file file, u64 offset, u64 size, void* dest) {
+#if KPLATFORM_WINDOWS
+    // On a handle opened without FILE_FLAG_OVERLAPPED, this reads synchronously at the given offset.
+    OVERLAPPED overlapped = {0};
+    overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+    overlapped.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD read = 0;
+    if (!ReadFile(file, dest, (DWORD)size, &read, &overlapped)) {
+        return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+    }
+    return (i64)read;
+#else
+    while (true) {
+        ssize_t read = pread(file, dest, (size_t)size, (off_t)offset);
+        if (read >= 0 || errno != EINTR) {
+            return (i64)read;
+        }
+    }
+#endif
+}
+
+// Links the given request onto the end of the queue of its priority. Lock must be held.
+static void priority_queue_push(io_request* request) {
+    u32 index = (u32)(request - state_ptr->requests);
+    u32 tail = state_ptr->queue_tails[request->priority];
+    request->prev = tail;
+    request->next = INVALID_ID;
+    if (tail == INVALID_ID) {
+        state_ptr->queue_heads[request->priority] = index;
+    } else {
+        state_ptr->requests[tail].next = index;
+    }
+    state_ptr->queue_tails[request->priority] = index;
+}
+
+// Unlinks the given request from the queue of its priority. Lock must be held.
+static void priority_queue_remove(io_request* request) {
+    if (request->prev == INVALID_ID) {
+        state_ptr->queue_heads[request->priority] = request->next;
+    } else {
+        state_ptr->requests[request->prev].next = request->next;
+    }
+    if (request->next == INVALID_ID) {
+        state_ptr->queue_tails[request->priority] = request->prev;
+    } else {
+        state_ptr->requests[request->next].prev = request->prev;
+    }
+    request->prev = INVALID_ID;
+    request->next = INVALID_ID;
+}
+
+// Marks the given request complete with the given result, and hands it to the main thread. Lock must be held.
+static void request_complete(io_request* request, async_io_result result) {
+    if (result != ASYNC_IO_RESULT_SUCCESS && request->data) {
+        kfree(request->data, request->data_size, MEMORY_TAG_ASSET);
+        request->data = 0;
+        request->data_size = 0;
+    }
+    request->result = result;
+    request->state = IO_REQUEST_STATE_COMPLETE;
+    mpsc_queue_push(&state_ptr->completed, &request->node);
+}
+
+// Takes the next queued request to be read, in priority order, or returns 0 if there is nothing
+// to read or no room to read it. Prefetches are held back once they take up half the room.
+static io_request* request_next(void) {
+    static const async_io_priority order[ASYNC_IO_PRIORITY_COUNT] = {ASYNC_IO_PRIORITY_CRITICAL, ASYNC_IO_PRIORITY_NORMAL, ASYNC_IO_PRIORITY_PREFETCH};
+    io_request* request = 0;
+
+    kmutex_lock(&state_ptr->lock);
+    if (katomic_load_u32(&state_ptr->running) && state_ptr->reading_count < state_ptr->reading_capacity) {
+        for (u32 i = 0; i < ASYNC_IO_PRIORITY_COUNT; ++i) {
+            async_io_priority priority = order[i];
+            if (priority == ASYNC_IO_PRIORITY_PREFETCH && state_ptr->prefetch_reading_count >= KMAX(state_ptr->reading_capacity / 2, 1U)) {
+                break;
+            }
+            u32 head = state_ptr->queue_heads[priority];
+            if (head != INVALID_ID) {
+                request = &state_ptr->requests[head];
+                priority_queue_remove(request);
+                request->state = IO_REQUEST_STATE_READING;
+                state_ptr->reading_count++;
+                if (priority == ASYNC_IO_PRIORITY_PREFETCH) {
+                    state_ptr->prefetch_reading_count++;
+                }
+                break;
+            }
+        }
+    }
+    kmutex_unlock(&state_ptr->lock);
+
+    return request;
+}
+
+// Opens the file of the given request, which is being read, and allocates room for its data now the size is known.
+static async_io_result request_open(io_request* request) {
+    u64 file_size = 0;
+    if (!io_file_open(request->path, &request->file, &file_size)) {
+        request->file = IO_FILE_INVALID;
+        return ASYNC_IO_RESULT_FILE_NOT_FOUND;
+    }
+    if (request->offset > file_size || request->size > file_size - request->offset) {
+        KERROR("async_io - Read of %llu bytes at offset %llu is beyond the end of '%s' (%llu bytes).", request->size, request->offset, request->path, file_size);
+        return ASYNC_IO_RESULT_READ_ERROR;
+    }
+    if (!request->size) {
+        request->size = file_size - request->offset;
+    }
+
+    request->data_size = request->size + (FLAG_GET(request->flags, ASYNC_IO_READ_FLAG_ZERO_TERMINATE_BIT) ? 1 : 0);
+    if (request->data_size) {
+        request->data = kallocate(request->data_size, MEMORY_TAG_ASSET);
+        if (request->data_size > request->size) {
+            request->data[request->size] = 0;
+        }
+    }
+    return ASYNC_IO_RESULT_SUCCESS;
+}
+
+// Closes the file of the given request, which is being read, and completes it.
+static void request_finish(io_request* request, async_io_result result) {
+    io_file_close(request->file);
+    request->file = IO_FILE_INVALID;
+
+    kmutex_lock(&state_ptr->lock);
+    // Checked under the lock, so a read reported as cancelled by async_io_cancel() always completes as such.
+    if (katomic_load_u32(&request->cancel_requested)) {
+        result = ASYNC_IO_RESULT_CANCELLED;
+    }
+    state_ptr->reading_count--;
+    if (request->priority == ASYNC_IO_PRIORITY_PREFETCH) {
+        state_ptr->prefetch_reading_count--;
+    }
+    request_complete(request, result);
+    kmutex_unlock(&state_ptr->lock);
+}
+
+// Makes the callbacks of all completed requests, then frees them. If cancel is set, reads which
+// succeeded are reported as cancelled instead, so nothing new is started with their data.
+static void completions_process(b8 cancel) {
+    mpsc_queue_node* node = mpsc_queue_take_all(&state_ptr->completed);
+    while (node) {
+        io_request* request = (io_request*)node;
+        node = node->next;
+
+        if (cancel && request->result == ASYNC_IO_RESULT_SUCCESS) {
+            if (request->data) {
+                kfree(request->data, request->data_size, MEMORY_TAG_ASSET);
+                request->data = 0;
+                request->data_size = 0;
+            }
+            request->result = ASYNC_IO_RESULT_CANCELLED;
+        }
+
+        async_io_completion completion = {0};
+        completion.id = ((u64)request->generation << 32) | (u64)(request - state_ptr->requests);
+        completion.result = request->result;
+        completion.data = request->data;
+        completion.size = request->data_size;
+        completion.context = request->context;
+        request->callback(&completion);
+
+        // Free the data unless the callback took it.
+        if (completion.data) {
+            kfree(request->data, request->data_size, MEMORY_TAG_ASSET);
+        }
+
+        kmutex_lock(&state_ptr->lock);
+        string_free(request->path);
+        u32 generation = request->generation + 1;
+        kzero_memory(request, sizeof(io_request));
+        // Zero is never used, so an id is never ASYNC_IO_INVALID_ID.
+        request->generation = generation ? generation : 1;
+        request->file = IO_FILE_INVALID;
+        request->next = state_ptr->free_head;
+        state_ptr->free_head = (u32)(request - state_ptr->requests);
+        kmutex_unlock(&state_ptr->lock);
+    }
+}
+
+static u32 pool_thread_run(void* params) {
+    while (katomic_load_u32(&state_ptr->running)) {
+        io_request* request = request_next();
+        if (!request) {
+            ksemaphore_wait(&state_ptr->semaphore, U32_MAX);
+            continue;
+        }
+
+        async_io_result result = request_open(request);
+        while (result == ASYNC_IO_RESULT_SUCCESS && request->read_size < request->size) {
+            if (katomic_load_u32(&request->cancel_requested)) {
+                result = ASYNC_IO_RESULT_CANCELLED;
+                break;
+            }
+            u64 piece_size = KMIN(request->size - request->read_size, (u64)ASYNC_IO_PIECE_SIZE);
+            i64 read = io_file_read_at(request->file, request->offset + request->read_size, piece_size, request->data + request->read_size);
+            if (read <= 0) {
+                // The file was cut short since it was opened, or could not be read.
+                result = ASYNC_IO_RESULT_READ_ERROR;
+                break;
+            }
+            request->read_size += (u64)read;
+        }
+        request_finish(request, result);
+    }
+
+    // Hand any cached small allocations back before the thread goes away.
+    kmemory_thread_cache_flush();
+    return 0;
+}
+
+static void pool_wake(u32 count) {
+    // Each thread keeps reading until nothing is left, so there is no need to wake more than all of them.
+    count = KMIN(count, (u32)state_ptr->thread_count);
+    for (u32 i = 0; i < count; ++i) {
+        ksemaphore_signal(&state_ptr->semaphore);
+    }
+}
+
+static b8 pool_create(u8 thread_count) {
+    if (!ksemaphore_create(&state_ptr->semaphore, ASYNC_IO_MAX_REQUESTS, 0)) {
+        KERROR("Failed to create async I/O semaphore.");
+        return false;
+    }
+
+    state_ptr->thread_count = KCLAMP(thread_count, 1, ASYNC_IO_MAX_THREAD_COUNT);
+    state_ptr->reading_capacity = state_ptr->thread_count;
+    for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+        kthread_options options = {0};
+        options.name = string_format("kohi_read_%u", i);
+        b8 created = kthread_create_with_options(pool_thread_run, 0, &options, false, &state_ptr->threads[i]);
+        string_free(options.name);
+        if (!created) {
+            KERROR("Failed to create async I/O thread.");
+            state_ptr->thread_count = i;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void pool_destroy(void) {
+    for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+        ksemaphore_signal(&state_ptr->semaphore);
+    }
+    for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+        kthread_wait(&state_ptr->threads[i]);
+        kthread_destroy(&state_ptr->threads[i]);
+    }
+    state_ptr->thread_count = 0;
+    ksemaphore_destroy(&state_ptr->semaphore);
+}
+
+#if ASYNC_IO_URING
+static i32 ring_enter(i32 fd, u32 to_submit, u32 min_complete, u32 flags) {
+    return (i32)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, 0, 0);
+}
+
+// Obtains a zeroed submission queue entry. The caller makes sure there is room.
+static struct io_uring_sqe* ring_sqe_get(io_ring* ring) {
+    u32 tail = *ring->sq_tail;
+    struct io_uring_sqe* sqe = &ring->sqes[tail & ring->sq_mask];
+    kzero_memory(sqe, sizeof(struct io_uring_sqe));
+    return sqe;
+}
+
+// Makes the entry obtained from ring_sqe_get() visible to the kernel, to be handed over on the next enter.
+static void ring_sqe_push(io_ring* ring) {
+    katomic_store_u32(ring->sq_tail, *ring->sq_tail + 1);
+    ring->unsubmitted_count++;
+}
+
+static void ring_wake_arm(io_ring* ring) {
+    struct io_uring_sqe* sqe = ring_sqe_get(ring);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = ring->wake_fd;
+    sqe->addr = (u64)&ring->wake_value;
+    sqe->len = sizeof(u64);
+    sqe->user_data = RING_WAKE_USER_DATA;
+    ring_sqe_push(ring);
+}
+
+// Queues a read of the next piece of the given request.
+static void ring_read_piece(io_ring* ring, io_request* request) {
+    struct io_uring_sqe* sqe = ring_sqe_get(ring);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = request->file;
+    sqe->off = request->offset + request->read_size;
+    sqe->addr = (u64)(request->data + request->read_size);
+    sqe->len = (u32)KMIN(request->size - request->read_size, (u64)ASYNC_IO_PIECE_SIZE);
+    sqe->user_data = (u64)(request - state_ptr->requests);
+    ring_sqe_push(ring);
+    ring->read_count++;
+}
+
+static void ring_completions_process(io_ring* ring) {
+    u32 head = *ring->cq_head;
+    u32 tail = katomic_load_u32(ring->cq_tail);
+    while (head != tail) {
+        struct io_uring_cqe* cqe = &ring->cqes[head & ring->cq_mask];
+        u64 user_data = cqe->user_data;
+        i32 res = cqe->res;
+        head++;
+
+        if (user_data == RING_WAKE_USER_DATA) {
+            // Something was queued (or the system is shutting down). Keep listening while running.
+            if (katomic_load_u32(&state_ptr->running)) {
+                ring_wake_arm(ring);
+            }
+            continue;
+        }
+
+        io_request* request = &state_ptr->requests[user_data];
+        ring->read_count--;
+        if (res == -EINTR || res == -EAGAIN) {
+            ring_read_piece(ring, request);
+        } else if (res <= 0) {
+            // The file was cut short since it was opened, or could not be read.
+            request_finish(request, ASYNC_IO_RESULT_READ_ERROR);
+        } else {
+            request->read_size += (u64)res;
+            if (request->read_size == request->size) {
+                request_finish(request, ASYNC_IO_RESULT_SUCCESS);
+            } else if (katomic_load_u32(&request->cancel_requested)) {
+                request_finish(request, ASYNC_IO_RESULT_CANCELLED);
+            } else {
+                ring_read_piece(ring, request);
+            }
+        }
+    }
+    katomic_store_u32(ring->cq_head, head);
+}
+
+static u32 ring_thread_run(void* params) {
+    io_ring* ring = &state_ptr->ring;
+    ring_wake_arm(ring);
+
+    while (katomic_load_u32(&state_ptr->running) || ring->read_count) {
+        // Start as many queued reads as there is room for. They are all handed to the kernel at once.
+        // NOTE: Files are opened here rather than through the ring, which costs little next to reading them.
+        io_request* request;
+        while ((request = request_next())) {
+            async_io_result result = request_open(request);
+            if (result != ASYNC_IO_RESULT_SUCCESS) {
+                request_finish(request, result);
+            } else if (!request->size) {
+                request_finish(request, ASYNC_IO_RESULT_SUCCESS);
+            } else {
+                ring_read_piece(ring, request);
+            }
+        }
+
+        // Submit, then wait for something to complete. There is always at least the wake read in flight.
+        i32 submitted = ring_enter(ring->fd, ring->unsubmitted_count, 1, IORING_ENTER_GETEVENTS);
+        if (submitted < 0) {
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                KERROR("async_io - io_uring_enter failed (errno=%i). Reads can no longer be made.", errno);
+                break;
+            }
+        } else {
+            ring->unsubmitted_count -= (u32)submitted;
+        }
+
+        ring_completions_process(ring);
+    }
+
+    kmemory_thread_cache_flush();
+    return 0;
+}
+
+static void ring_wake(void) {
+    eventfd_write(state_ptr->ring.wake_fd, 1);
+}
+
+static void ring_destroy(io_ring* ring);
+
+static b8 ring_create(u32 queue_depth, io_ring* ring) {
+    kzero_memory(ring, sizeof(io_ring));
+    ring->wake_fd = -1;
+
+    struct io_uring_params params = {0};
+    ring->fd = (i32)syscall(__NR_io_uring_setup, queue_depth, &params);
+    if (ring->fd < 0) {
+        KDEBUG("async_io - io_uring is not available (errno=%i).", errno);
+        return false;
+    }
+
+    // Reads with a plain buffer and offset need a kernel which knows IORING_OP_READ (5.6+).
+    u64 probe_size = sizeof(struct io_uring_probe) + sizeof(struct io_uring_probe_op) * 256;
+    struct io_uring_probe* probe = kallocate(probe_size, MEMORY_TAG_PLATFORM);
+    b8 supported = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, 256) == 0 &&
+                   probe->last_op >= IORING_OP_READ &&
+                   (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+    kfree(probe, probe_size, MEMORY_TAG_PLATFORM);
+    if (!supported) {
+        KDEBUG("async_io - io_uring does not support plain reads on this kernel.");
+        close(ring->fd);
+        return false;
+    }
+
+    ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+    ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    b8 single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_map) {
+        ring->sq_map_size = ring->cq_map_size = KMAX(ring->sq_map_size, ring->cq_map_size);
+    }
+    ring->sq_ptr = mmap(0, ring->sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        ring->sq_ptr = 0;
+        ring_destroy(ring);
+        return false;
+    }
+    if (single_map) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr = mmap(0, ring->cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) {
+            ring->cq_ptr = 0;
+            ring_destroy(ring);
+            return false;
+        }
+    }
+    ring->sqes_map_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(0, ring->sqes_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = 0;
+        ring_destroy(ring);
+        return false;
+    }
+
+    u8* sq = ring->sq_ptr;
+    ring->sq_head = (u32*)(sq + params.sq_off.head);
+    ring->sq_tail = (u32*)(sq + params.sq_off.tail);
+    ring->sq_mask = *(u32*)(sq + params.sq_off.ring_mask);
+    ring->sq_entries = params.sq_entries;
+    // Entries are always used in order, so each slot of the index array just points at its own entry.
+    u32* sq_array = (u32*)(sq + params.sq_off.array);
+    for (u32 i = 0; i < params.sq_entries; ++i) {
+        sq_array[i] = i;
+    }
+    u8* cq = ring->cq_ptr;
+    ring->cq_head = (u32*)(cq + params.cq_off.head);
+    ring->cq_tail = (u32*)(cq + params.cq_off.tail);
+    ring->cq_mask = *(u32*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    ring->wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (ring->wake_fd < 0) {
+        ring_destroy(ring);
+        return false;
+    }
+
+    // One entry is kept for the wake read. The completion queue is larger than the submission
+    // queue, so it can't overflow with no more than this many reads in flight.
+    state_ptr->reading_capacity = params.sq_entries - 1;
+    return true;
+}
+
+static void ring_destroy(io_ring* ring) {
+    if (ring->sqes) {
+        munmap(ring->sqes, ring->sqes_map_size);
+    }
+    if (ring->cq_ptr && ring->cq_ptr != ring->sq_ptr) {
+        munmap(ring->cq_ptr, ring->cq_map_size);
+    }
+    if (ring->sq_ptr) {
+        munmap(ring->sq_ptr, ring->sq_map_size);
+    }
+    if (ring->wake_fd >= 0) {
+        close(ring->wake_fd);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+    kzero_memory(ring, sizeof(io_ring));
+    ring->fd = -1;
+    ring->wake_fd = -1;
+}
+#endif
+
+static void wake(u32 count) {
+#if ASYNC_IO_URING
+    if (state_ptr->backend == ASYNC_IO_BACKEND_IO_URING) {
+        ring_wake();
+        return;
+    }
+#endif
+    pool_wake(count);
+}
+
+b8 async_io_system_initialize(u64* memory_requirement, void* state, void* config) {
+    if (!memory_requirement) {
+        KERROR("async_io_system_initialize requires a valid pointer to memory_requirement.");
+        return false;
+    }
+    *memory_requirement = sizeof(async_io_state) + sizeof(io_request) * ASYNC_IO_MAX_REQUESTS;
+    if (!state) {
+        return true;
+    }
+
+    async_io_config default_config = {0};
+    async_io_config* typed_config = config ? config : &default_config;
+
+    kzero_memory(state, *memory_requirement);
+    state_ptr = state;
+    state_ptr->requests = (io_request*)((u8*)state + sizeof(async_io_state));
+    if (!kmutex_create(&state_ptr->lock)) {
+        KERROR("Failed to create async I/O mutex.");
+        state_ptr = 0;
+        return false;
+    }
+
+    // Every request starts out free, linked in order.
+    for (u32 i = 0; i < ASYNC_IO_MAX_REQUESTS; ++i) {
+        state_ptr->requests[i].generation = 1;
+        state_ptr->requests[i].file = IO_FILE_INVALID;
+        state_ptr->requests[i].next = i + 1 < ASYNC_IO_MAX_REQUESTS ? i + 1 : INVALID_ID;
+    }
+    state_ptr->free_head = 0;
+    for (u32 i = 0; i < ASYNC_IO_PRIORITY_COUNT; ++i) {
+        state_ptr->queue_heads[i] = INVALID_ID;
+        state_ptr->queue_tails[i] = INVALID_ID;
+    }
+    katomic_store_u32(&state_ptr->running, true);
+
+#if ASYNC_IO_URING
+    state_ptr->ring.fd = -1;
+    state_ptr->ring.wake_fd = -1;
+    if (!typed_config->disable_io_uring) {
+        u32 queue_depth = typed_config->queue_depth ? typed_config->queue_depth : ASYNC_IO_DEFAULT_QUEUE_DEPTH;
+        if (ring_create(KCLAMP(queue_depth, 2, ASYNC_IO_MAX_REQUESTS), &state_ptr->ring)) {
+            kthread_options options = {0};
+            options.name = "kohi_uring";
+            if (kthread_create_with_options(ring_thread_run, 0, &options, false, &state_ptr->ring.thread)) {
+                state_ptr->backend = ASYNC_IO_BACKEND_IO_URING;
+                KINFO("Async I/O is using io_uring, with up to %u reads in flight.", state_ptr->reading_capacity);
+                return true;
+            }
+            KWARN("Failed to create async I/O ring thread. Falling back to a thread pool.");
+            ring_destroy(&state_ptr->ring);
+        }
+    }
+#endif
+
+    if (!pool_create(typed_config->thread_count ? typed_config->thread_count : ASYNC_IO_DEFAULT_THREAD_COUNT)) {
+        async_io_system_shutdown(state);
+        return false;
+    }
+    state_ptr->backend = ASYNC_IO_BACKEND_THREAD_POOL;
+    KINFO("Async I/O is using a pool of %u reading threads.", state_ptr->thread_count);
+    return true;
+}
+
+void async_io_system_shutdown(void* state) {
+    if (!state_ptr) {
+        return;
+    }
+
+    // Queued reads are never started, and those underway stop after the piece in flight.
+    kmutex_lock(&state_ptr->lock);
+    katomic_store_u32(&state_ptr->running, false);
+    for (u32 p = 0; p < ASYNC_IO_PRIORITY_COUNT; ++p) {
+        while (state_ptr->queue_heads[p] != INVALID_ID) {
+            io_request* request = &state_ptr->requests[state_ptr->queue_heads[p]];
+            priority_queue_remove(request);
+            request_complete(request, ASYNC_IO_RESULT_CANCELLED);
+        }
+    }
+    for (u32 i = 0; i < ASYNC_IO_MAX_REQUESTS; ++i) {
+        if (state_ptr->requests[i].state == IO_REQUEST_STATE_READING) {
+            katomic_store_u32(&state_ptr->requests[i].cancel_requested, true);
+        }
+    }
+    kmutex_unlock(&state_ptr->lock);
+
+#if ASYNC_IO_URING
+    if (state_ptr->backend == ASYNC_IO_BACKEND_IO_URING) {
+        ring_wake();
+        kthread_wait(&state_ptr->ring.thread);
+        kthread_destroy(&state_ptr->ring.thread);
+        ring_destroy(&state_ptr->ring);
+    }
+#endif
+    if (state_ptr->backend == ASYNC_IO_BACKEND_THREAD_POOL || state_ptr->thread_count) {
+        pool_destroy();
+    }
+
+    // Everything has now completed, so make the remaining callbacks, letting owners release what they hold.
+    completions_process(true);
+
+    kmutex_destroy(&state_ptr->lock);
+    state_ptr->backend = ASYNC_IO_BACKEND_NONE;
+    state_ptr = 0;
+}
+
+b8 async_io_system_update(void* state, struct frame_data* p_frame_data) {
+    if (!state_ptr) {
+        return false;
+    }
+
+    completions_process(false);
+    return true;
+}
+
+async_io_backend async_io_backend_get(void) {
+    return state_ptr ? state_ptr->backend : ASYNC_IO_BACKEND_NONE;
+}
+
+u64 async_io_read(const async_io_read_request* request) {
+    u64 id = ASYNC_IO_INVALID_ID;
+    async_io_read_batch(1, request, &id);
+    return id;
+}
+
+u32 async_io_read_batch(u32 count, const async_io_read_request* requests, u64* out_ids) {
+    if (!requests) {
+        KERROR("async_io_read_batch requires a valid pointer to requests.");
+        return 0;
+    }
+    if (!state_ptr || !katomic_load_u32(&state_ptr->running)) {
+        KERROR("async_io_read_batch called before the async I/O system was initialized (or after shutdown). Nothing will be read.");
+        if (out_ids) {
+            kzero_memory(out_ids, sizeof(u64) * count);
+        }
+        return 0;
+    }
+
+    u32 queued_count = 0;
+    kmutex_lock(&state_ptr->lock);
+    for (u32 i = 0; i < count; ++i) {
+        const async_io_read_request* info = &requests[i];
+        u64 id = ASYNC_IO_INVALID_ID;
+        if (!info->path || !info->callback) {
+            KERROR("async_io_read_batch - read %u requires a path and callback. It will not be queued.", i);
+        } else if (state_ptr->free_head == INVALID_ID) {
+            KERROR("Too many reads are waiting to complete (max %u). '%s' will not be read.", ASYNC_IO_MAX_REQUESTS, info->path);
+        } else {
+            u32 index = state_ptr->free_head;
+            io_request* request = &state_ptr->requests[index];
+            state_ptr->free_head = request->next;
+
+            request->state = IO_REQUEST_STATE_QUEUED;
+            request->priority = info->priority < ASYNC_IO_PRIORITY_COUNT ? info->priority : ASYNC_IO_PRIORITY_NORMAL;
+            request->flags = info->flags;
+            request->path = string_duplicate(info->path);
+            request->offset = info->offset;
+            request->size = info->size;
+            request->callback = info->callback;
+            request->context = info->context;
+            priority_queue_push(request);
+
+            id = ((u64)request->generation << 32) | (u64)index;
+            queued_count++;
+        }
+        if (out_ids) {
+            out_ids[i] = id;
+        }
+    }
+    kmutex_unlock(&state_ptr->lock);
+
+    if (queued_count) {
+        wake(queued_count);
+    }
+    return queued_count;
+}
+
+b8 async_io_cancel(u64 id) {
+    if (!state_ptr || id == ASYNC_IO_INVALID_ID) {
+        return false;
+    }
+    u32 index = (u32)(id & 0xFFFFFFFF);
+    u32 generation = (u32)(id >> 32);
+    if (index >= ASYNC_IO_MAX_REQUESTS) {
+        return false;
+    }
+
+    b8 cancelled = false;
+    kmutex_lock(&state_ptr->lock);
+    io_request* request = &state_ptr->requests[index];
+    if (request->generation == generation) {
+        if (request->state == IO_REQUEST_STATE_QUEUED) {
+            priority_queue_remove(request);
+            request_complete(request, ASYNC_IO_RESULT_CANCELLED);
+            cancelled = true;
+        } else if (request->state == IO_REQUEST_STATE_READING && !katomic_load_u32(&request->cancel_requested)) {
+            // The reader notices between pieces, and completes the read as cancelled either way.
+            katomic_store_u32(&request->cancel_requested, true);
+            cancelled = true;
+        }
+    }
+    kmutex_unlock(&state_ptr->lock);
+
+    return cancelled;
+}
@@ -0,0 +1,204 @@
+/**
+ * @file async_io.h
+ * @author Travis Vroman (travis@kohiengine.com)
+ * @brief An asynchronous file reading engine with request priorities.
+ * @details Reads are queued from any thread and carried out on dedicated I/O threads, so
+ * job threads (and the main thread) never block on disk. On Linux, reads are batched into
+ * an io_uring where the kernel supports it, with many in flight at once from a single
+ * thread. Elsewhere, or if io_uring is unavailable or disabled, a small pool of threads
+ * each perform positional reads (pread or the platform equivalent).
+ *
+ * Pending reads are started in priority order: critical reads first, then normal, then
+ * prefetch. Prefetch reads are never allowed to take up more than half of the reads in
+ * flight, so critical work arriving later always finds room.
+ *
+ * Completion callbacks are made on the main thread from async_io_system_update(), in the
+ * same way as job completion callbacks.
+ * @version 1.0
+ * @date 2024-11-22
+ *
+ * @copyright Kohi Game Engine is Copyright (c) Travis Vroman 2021-2024
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+struct frame_data;
+
+/** @brief Identifies no read. Returned when a read could not be queued. */
+#define ASYNC_IO_INVALID_ID 0
+
+/** @brief The max number of reads which may be queued or in flight at once. */
+#define ASYNC_IO_MAX_REQUESTS 4096
+
+/** @brief The max number of reading threads used by the thread pool backend. */
+#define ASYNC_IO_MAX_THREAD_COUNT 16
+
+/**
+ * @brief The order in which pending reads are started. A zeroed request is normal priority.
+ */
+typedef enum async_io_priority {
+    /** @brief Needed soon, but not holding anything up. */
+    ASYNC_IO_PRIORITY_NORMAL = 0,
+    /** @brief Needed as soon as possible (i.e. something is waiting on it). Started before all others. */
+    ASYNC_IO_PRIORITY_CRITICAL,
+    /** @brief Speculative reads of data which may be needed later. Started only once nothing else is waiting. */
+    ASYNC_IO_PRIORITY_PREFETCH,
+    ASYNC_IO_PRIORITY_COUNT
+} async_io_priority;
+
+/** @brief The means by which the engine reads files. */
+typedef enum async_io_backend {
+    /** @brief The engine is not running. */
+    ASYNC_IO_BACKEND_NONE = 0,
+    /** @brief A pool of threads, each performing positional reads. */
+    ASYNC_IO_BACKEND_THREAD_POOL,
+    /** @brief Reads are batched into an io_uring (Linux only). */
+    ASYNC_IO_BACKEND_IO_URING
+} async_io_backend;
+
+/** @brief The outcome of a read. */
+typedef enum async_io_result {
+    /** @brief The data was read in full. */
+    ASYNC_IO_RESULT_SUCCESS = 0,
+    /** @brief The file could not be opened. */
+    ASYNC_IO_RESULT_FILE_NOT_FOUND,
+    /** @brief The file was opened, but the requested range could not be read. */
+    ASYNC_IO_RESULT_READ_ERROR,
+    /** @brief The read was cancelled, or the engine was shut down before it completed. */
+    ASYNC_IO_RESULT_CANCELLED
+} async_io_result;
+
+typedef enum async_io_read_flag_bits {
+    ASYNC_IO_READ_FLAG_NONE = 0,
+    /** @brief A zero byte is appended to the data (and counted in its size), so text may be used as a string. */
+    ASYNC_IO_READ_FLAG_ZERO_TERMINATE_BIT = 0x01,
+} async_io_read_flag_bits;
+
+typedef u32 async_io_read_flags;
+
+/**
+ * @brief Describes a completed read, as handed to its callback.
+ */
+typedef struct async_io_completion {
+    /** @brief The id the read was given when queued. */
+    u64 id;
+    /** @brief The outcome of the read. */
+    async_io_result result;
+    /**
+     * @brief The data read, allocated with MEMORY_TAG_ASSET. 0 unless the read succeeded. Freed
+     * once the callback returns, unless the callback takes ownership by setting this to 0, in
+     * which case it must be freed later with kfree(data, size, MEMORY_TAG_ASSET).
+     */
+    void* data;
+    /** @brief The size of data in bytes, including the terminator if one was requested. */
+    u64 size;
+    /** @brief The context given with the request. */
+    void* context;
+} async_io_completion;
+
+/**
+ * @brief Invoked on the main thread when a read completes, fails or is cancelled.
+ *
+ * @param completion A pointer to the completed read. Only valid during the call.
+ */
+typedef void (*PFN_async_io_callback)(async_io_completion* completion);
+
+/**
+ * @brief Describes a read to be made.
+ */
+typedef struct async_io_read_request {
+    /** @brief The path of the file to read. Copied, so its lifetime isn't important. Required. */
+    const char* path;
+    /** @brief The offset within the file to start reading from. */
+    u64 offset;
+    /** @brief The number of bytes to read. 0 reads everything from offset to the end of the file. */
+    u64 size;
+    /** @brief The priority of the read. */
+    async_io_priority priority;
+    /** @brief Flags controlling the read. */
+    async_io_read_flags flags;
+    /** @brief Invoked when the read completes. Required. */
+    PFN_async_io_callback callback;
+    /** @brief Passed through to the callback. Not copied, so must remain valid until then. */
+    void* context;
+} async_io_read_request;
+
+typedef struct async_io_config {
+    /** @brief The number of reading threads to use for the thread pool backend. Pass 0 for the default. */
+    u8 thread_count;
+    /** @brief The max number of reads in flight at once with io_uring. Pass 0 for the default. */
+    u32 queue_depth;
+    /** @brief Uses the thread pool backend even where io_uring is available. */
+    b8 disable_io_uring;
+} async_io_config;
+
+/**
+ * @brief Initializes the async I/O system, starting its threads. Call once to retrieve
+ * memory_requirement, passing 0 to state. Then call a second time with allocated state memory block.
+ *
+ * @param memory_requirement A pointer to hold the memory required for the system state in bytes.
+ * @param state A block of memory to hold the state of the system.
+ * @param config A pointer to the configuration (async_io_config) of this system. Optional.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 async_io_system_initialize(u64* memory_requirement, void* state, void* config);
+
+/**
+ * @brief Shuts the async I/O system down. Reads still queued are not started, and the callbacks
+ * of all reads not yet delivered are made with ASYNC_IO_RESULT_CANCELLED, so anything they hold
+ * can be released.
+ *
+ * @param state A pointer to the system state.
+ */
+KAPI void async_io_system_shutdown(void* state);
+
+/**
+ * @brief Makes the callbacks of all reads completed since the last update. Must be called
+ * from the main thread, once an update cycle.
+ *
+ * @param state A pointer to the system state.
+ * @param p_frame_data A pointer to the current frame's data. Not used.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 async_io_system_update(void* state, struct frame_data* p_frame_data);
+
+/**
+ * @brief Obtains the means by which the system is reading files.
+ *
+ * @returns The backend in use, or ASYNC_IO_BACKEND_NONE if the system is not running.
+ */
+KAPI async_io_backend async_io_backend_get(void);
+
+/**
+ * @brief Queues a file to be read. Safe to call from any thread.
+ *
+ * @param request A constant pointer to the description of the read. Required.
+ * @returns The id of the read, which may be used to cancel it. ASYNC_IO_INVALID_ID if the
+ * read could not be queued, in which case the callback is never made.
+ */
+KAPI u64 async_io_read(const async_io_read_request* request);
+
+/**
+ * @brief Queues a batch of files to be read at once, which is cheaper than queuing each on its
+ * own. Safe to call from any thread.
+ *
+ * @param count The number of reads.
+ * @param requests An array of count read descriptions. Required.
+ * @param out_ids An array to hold the id of each read, or ASYNC_IO_INVALID_ID for any which
+ * could not be queued. Optional.
+ * @returns The number of reads queued.
+ */
+KAPI u32 async_io_read_batch(u32 count, const async_io_read_request* requests, u64* out_ids);
+
+/**
+ * @brief Cancels the given read. Safe to call from any thread. A read which has not started yet is
+ * never started. A read which is already underway stops as soon as the piece in flight finishes,
+ * and its data is dropped. Either way, its callback is made with ASYNC_IO_RESULT_CANCELLED.
+ *
+ * @param id The id of the read to cancel.
+ * @returns True if the read was cancelled; false if it had already completed (or the id is invalid).
+ */
+KAPI b8 async_io_cancel(u64 id);
@@ -8,6 +8,15 @@
 #include <string.h>
 #include <sys/stat.h>
 
+#if KPLATFORM_WINDOWS
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
 b8 filesystem_exists(const char* path) {
 #ifdef _MSC_VER
     struct _stat buffer;
@@ -184,6 +193,77 @@ const void* filesystem_read_entire_binary_file(const char* filepath, u64* out_si
     return buf;
 }
 
+b8 filesystem_map(const char* filepath, file_mapping* out_mapping) {
+    if (!filepath || !out_mapping) {
+        KERROR("filesystem_map requires valid pointers to filepath and out_mapping.");
+        return false;
+    }
+    out_mapping->data = 0;
+    out_mapping->size = 0;
+
+#if KPLATFORM_WINDOWS
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if (file == INVALID_HANDLE_VALUE) {
+        KERROR("%s: Error opening file: '%s'", __FUNCTION__, filepath);
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+    // The view keeps the file mapped, so the handles aren't needed past this point.
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    if (!data) {
+        KERROR("%s: Error mapping file: '%s'", __FUNCTION__, filepath);
+        return false;
+    }
+    out_mapping->data = data;
+    out_mapping->size = (u64)size.QuadPart;
+#else
+    int fd = open(filepath, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        KERROR("%s: Error opening file: '%s'", __FUNCTION__, filepath);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file referenced, so the descriptor isn't needed past this point.
+    close(fd);
+    if (data == MAP_FAILED) {
+        KERROR("%s: Error mapping file: '%s'", __FUNCTION__, filepath);
+        return false;
+    }
+    // Assets are usually parsed front to back, so have the OS read ahead.
+    madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+    out_mapping->data = data;
+    out_mapping->size = (u64)info.st_size;
+#endif
+
+    return true;
+}
+
+void filesystem_unmap(file_mapping* mapping) {
+    if (mapping && mapping->data) {
+#if KPLATFORM_WINDOWS
+        UnmapViewOfFile(mapping->data);
+#else
+        munmap((void*)mapping->data, (size_t)mapping->size);
+#endif
+        mapping->data = 0;
+        mapping->size = 0;
+    }
+}
+
 b8 filesystem_write_entire_text_file(const char* filepath, const char* content) {
     file_handle f;
     if (!filesystem_open(filepath, FILE_MODE_WRITE, false, &f)) {
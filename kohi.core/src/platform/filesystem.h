@@ -22,6 +22,18 @@ typedef struct file_handle {
     b8 is_valid;
 } file_handle;
 
+/**
+ * @brief A read-only view of the contents of a file, mapped into memory.
+ * Pages are read in from disk (or straight out of the OS page cache) as they are
+ * first touched, so no copy of the file is made on the heap.
+ */
+typedef struct file_mapping {
+    /** @brief The contents of the file. Read-only; writing to it will fault. */
+    const void* data;
+    /** @brief The size of the view in bytes. */
+    u64 size;
+} file_mapping;
+
 /** @brief File open modes. Can be combined. */
 typedef enum file_modes {
     /** Read mode */
@@ -156,6 +168,25 @@ KAPI const char* filesystem_read_entire_text_file(const char* filepath);
  */
 KAPI const void* filesystem_read_entire_binary_file(const char* filepath, u64* out_size);
 
+/**
+ * @brief Maps the entire file at the provided path into memory as a read-only view.
+ * No file handle required, and the file need not remain open. The view must be
+ * released with filesystem_unmap() once no longer needed.
+ * NOTE: Empty files cannot be mapped.
+ *
+ * @param filepath The path to the file to map.
+ * @param out_mapping A pointer to hold the mapped view.
+ * @returns True if successful; otherwise false.
+ */
+KAPI b8 filesystem_map(const char* filepath, file_mapping* out_mapping);
+
+/**
+ * @brief Releases a view obtained from filesystem_map(). The data must not be accessed afterward.
+ *
+ * @param mapping A pointer to the view to release.
+ */
+KAPI void filesystem_unmap(file_mapping* mapping);
+
 KAPI b8 filesystem_write_entire_text_file(const char* filepath, const char* content);
 
 KAPI b8 filesystem_write_entire_binary_file(const char* filepath, u64 size, const void* content);
@@ -1,6 +1,7 @@
 #include "kpackage.h"
 
 #include "containers/darray.h"
+#include "containers/u64_hashmap.h"
 #include "debug/kassert.h"
 #include "defines.h"
 #include "logger.h"
@@ -9,6 +10,10 @@
 #include "platform/filesystem.h"
 #include "strings/kname.h"
 #include "strings/kstring.h"
+#include "threads/job_system.h"
+#include "threads/katomic.h"
+#include "utils/crc64.h"
+#include "utils/klz.h"
 
 typedef struct asset_entry {
     kname name;
@@ -20,11 +25,24 @@ typedef struct asset_entry {
     // If loaded from binary, these define where the asset is in the blob.
     u64 offset;
     u64 size;
+    u64 stored_size;
+    u64 content_hash;
+    kpackage_binary_entry_flags flags;
 } asset_entry;
 
 typedef struct kpackage_internal {
     // darray of all asset entries.
     asset_entry* entries;
+    // Maps the name of each asset to its index in entries.
+    u64_hashmap entry_lookup;
+
+    // If loaded from binary, the contents of the binary package.
+    const u8* blob;
+    u64 blob_size;
+    // If loaded from a binary package file, the mapping holding blob. Released when the package is destroyed.
+    file_mapping mapping;
+    // If loaded from a binary package file, the path of that file.
+    const char* file_path;
 } kpackage_internal;
 
 b8 kpackage_create_from_manifest(const asset_manifest* manifest, kpackage* out_package) {
@@ -48,6 +66,7 @@ b8 kpackage_create_from_manifest(const asset_manifest* manifest, kpackage* out_p
 
     // Process manifest
     u32 asset_count = darray_length(manifest->assets);
+    u64_hashmap_create(sizeof(u32), asset_count, &out_package->internal_data->entry_lookup);
     for (u32 i = 0; i < asset_count; ++i) {
         asset_manifest_asset* asset = &manifest->assets[i];
 
@@ -64,7 +83,9 @@ b8 kpackage_create_from_manifest(const asset_manifest* manifest, kpackage* out_p
             out_package->internal_data->entries = darray_create(asset_entry);
         }
         // Push the asset to it.
+        u32 index = darray_length(out_package->internal_data->entries);
         darray_push(out_package->internal_data->entries, new_entry);
+        u64_hashmap_set(&out_package->internal_data->entry_lookup, new_entry.name, &index);
     }
 
     return true;
@@ -76,16 +97,98 @@ b8 kpackage_create_from_binary(u64 size, void* bytes, kpackage* out_package) {
         return false;
     }
 
-    out_package->is_binary = false;
+    kzero_memory(out_package, sizeof(kpackage));
 
-    // Process manifest
-    // TODO: the thing.
-    KERROR("kpackage_create_from_binary not yet supported.");
-    return false;
+    // Validate the header.
+    const u8* blob = bytes;
+    const kpackage_binary_header* header = bytes;
+    if (size < sizeof(kpackage_binary_header) || header->magic != KPACKAGE_BINARY_MAGIC) {
+        KERROR("kpackage_create_from_binary - data is not a binary package.");
+        return false;
+    }
+    if (header->version != KPACKAGE_BINARY_VERSION) {
+        KERROR("kpackage_create_from_binary - unsupported binary package version %u (expected %u). Rebuild the package.", header->version, KPACKAGE_BINARY_VERSION);
+        return false;
+    }
+    u64 toc_size = (u64)header->entry_count * sizeof(kpackage_binary_entry);
+    // NOTE: Bounds are checked by subtraction, so corrupt offsets can't overflow past them.
+    if (header->file_size != size ||
+        toc_size > size || header->toc_offset > size - toc_size ||
+        header->strings_size > size || header->strings_offset > size - header->strings_size ||
+        header->payload_offset > size ||
+        header->name_offset >= header->strings_size) {
+        KERROR("kpackage_create_from_binary - binary package is truncated or corrupt.");
+        return false;
+    }
+    // The string table must end with a terminator, so names can't run off the end of it.
+    const char* strings = (const char*)(blob + header->strings_offset);
+    if (strings[header->strings_size - 1] != 0) {
+        KERROR("kpackage_create_from_binary - binary package string table is corrupt.");
+        return false;
+    }
+
+    // Registering the name string means it can be looked up as usual. It hashes to the stored name.
+    out_package->name = kname_create(strings + header->name_offset);
+    out_package->is_binary = true;
+    out_package->internal_data = kallocate(sizeof(kpackage_internal), MEMORY_TAG_RESOURCE);
+    out_package->internal_data->blob = blob;
+    out_package->internal_data->blob_size = size;
+    out_package->internal_data->entries = darray_reserve(asset_entry, header->entry_count);
+    u64_hashmap_create(sizeof(u32), header->entry_count, &out_package->internal_data->entry_lookup);
+
+    // Process the table of contents.
+    const kpackage_binary_entry* toc = (const kpackage_binary_entry*)(blob + header->toc_offset);
+    for (u32 i = 0; i < header->entry_count; ++i) {
+        const kpackage_binary_entry* e = &toc[i];
+        b8 compressed = FLAG_GET(e->flags, KPACKAGE_BINARY_ENTRY_FLAG_COMPRESSED_BIT);
+        if (e->stored_size > size || e->offset > size - e->stored_size || e->name_offset >= header->strings_size || (!compressed && e->stored_size != e->size)) {
+            KERROR("kpackage_create_from_binary - entry %u of binary package '%s' is out of bounds.", i, strings + header->name_offset);
+            kpackage_destroy(out_package);
+            return false;
+        }
+
+        asset_entry new_entry = {0};
+        new_entry.name = kname_create(strings + e->name_offset);
+        new_entry.offset = e->offset;
+        new_entry.size = e->size;
+        new_entry.stored_size = e->stored_size;
+        new_entry.content_hash = e->content_hash;
+        new_entry.flags = e->flags;
+
+        u32 index = darray_length(out_package->internal_data->entries);
+        darray_push(out_package->internal_data->entries, new_entry);
+        u64_hashmap_set(&out_package->internal_data->entry_lookup, new_entry.name, &index);
+    }
+
+    return true;
+}
+
+b8 kpackage_create_from_binary_file(const char* path, kpackage* out_package) {
+    if (!path || !out_package) {
+        KERROR("kpackage_create_from_binary_file requires valid pointers to path and out_package.");
+        return false;
+    }
+
+    file_mapping mapping = {0};
+    if (!filesystem_map(path, &mapping)) {
+        KERROR("Failed to map binary package file '%s'.", path);
+        return false;
+    }
+
+    if (!kpackage_create_from_binary(mapping.size, (void*)mapping.data, out_package)) {
+        KERROR("Failed to create package from binary package file '%s'.", path);
+        filesystem_unmap(&mapping);
+        return false;
+    }
+
+    // The package now owns the mapping.
+    out_package->internal_data->mapping = mapping;
+    out_package->internal_data->file_path = string_duplicate(path);
+    return true;
 }
 
 void kpackage_destroy(kpackage* package) {
-    if (package) {
+    if (package && package->internal_data) {
         if (package->internal_data->entries) {
             u32 entry_count = darray_length(package->internal_data->entries);
             for (u32 j = 0; j < entry_count; ++j) {
@@ -93,32 +196,191 @@ void kpackage_destroy(kpackage* package) {
                 if (entry->path) {
                     string_free(entry->path);
                 }
+                if (entry->source_path) {
+                    string_free(entry->source_path);
+                }
             }
             darray_destroy(package->internal_data->entries);
         }
+        u64_hashmap_destroy(&package->internal_data->entry_lookup);
 
-        if (package->internal_data) {
-            kfree(package->internal_data, sizeof(kpackage_internal), MEMORY_TAG_RESOURCE);
+        filesystem_unmap(&package->internal_data->mapping);
+        if (package->internal_data->file_path) {
+            string_free(package->internal_data->file_path);
         }
 
-        kzero_memory(package, sizeof(kpackage_internal));
+        kfree(package->internal_data, sizeof(kpackage_internal), MEMORY_TAG_RESOURCE);
+
+        kzero_memory(package, sizeof(kpackage));
     }
 }
 
+static asset_entry* asset_entry_find(const kpackage* package, kname name) {
+    u32 index;
+    if (u64_hashmap_get(&package->internal_data->entry_lookup, name, &index)) {
+        return &package->internal_data->entries[index];
+    }
+    return 0;
+}
+
 static asset_entry* asset_entry_get(const kpackage* package, kname name) {
-    // Search the type lookup's entries for the matching name.
-    u32 entry_count = darray_length(package->internal_data->entries);
-    for (u32 j = 0; j < entry_count; ++j) {
-        asset_entry* entry = &package->internal_data->entries[j];
-        if (entry->name == name) {
-            return entry;
-        }
+    asset_entry* entry = asset_entry_find(package, name);
+    if (entry) {
+        return entry;
     }
 
     KTRACE("Package '%s': No entry called '%s' exists.", kname_string_get(package->name), kname_string_get(name));
     return 0;
 }
 
+typedef struct asset_decompress_context {
+    const u8* blocks;
+    // The offset of each block from blocks, with an extra entry for the end of the last.
+    u64* block_offsets;
+    const u32* block_sizes;
+    u64 size;
+    u8* dest;
+    u32 failure_count;
+} asset_decompress_context;
+
+static void asset_decompress_blocks(u32 start, u32 end, void* context) {
+    asset_decompress_context* ctx = context;
+    for (u32 i = start; i < end; ++i) {
+        const u8* source = ctx->blocks + ctx->block_offsets[i];
+        u64 stored_size = ctx->block_offsets[i + 1] - ctx->block_offsets[i];
+        u64 offset = (u64)i * KPACKAGE_BINARY_BLOCK_SIZE;
+        u64 size = KMIN(ctx->size - offset, (u64)KPACKAGE_BINARY_BLOCK_SIZE);
+        b8 result;
+        if (ctx->block_sizes[i] & KPACKAGE_BINARY_BLOCK_STORED_BIT) {
+            result = stored_size == size;
+            if (result) {
+                kcopy_memory(ctx->dest + offset, source, size);
+            }
+        } else {
+            result = klz_decompress(source, stored_size, ctx->dest + offset, size);
+        }
+        if (!result) {
+            katomic_fetch_add_u32(&ctx->failure_count, 1);
+        }
+    }
+}
+
+// Decompresses the given compressed asset from its stored data into dest, which must hold entry->size bytes.
+// Blocks are spread across the job system, so large assets decompress in parallel.
+static b8 asset_decompress(const asset_entry* entry, const u8* stored, u8* dest) {
+    u32 block_count = (u32)((entry->size + KPACKAGE_BINARY_BLOCK_SIZE - 1) / KPACKAGE_BINARY_BLOCK_SIZE);
+    u64 table_size = sizeof(u32) * block_count;
+    if (table_size > entry->stored_size) {
+        return false;
+    }
+
+    asset_decompress_context context = {0};
+    context.block_sizes = (const u32*)stored;
+    context.blocks = stored + table_size;
+    context.size = entry->size;
+    context.dest = dest;
+
+    // Find where each block starts, making sure they all lie within the asset.
+    u64 offsets_size = sizeof(u64) * (block_count + 1);
+    context.block_offsets = kallocate(offsets_size, MEMORY_TAG_ARRAY);
+    u64 offset = 0;
+    for (u32 i = 0; i < block_count; ++i) {
+        context.block_offsets[i] = offset;
+        offset += context.block_sizes[i] & ~KPACKAGE_BINARY_BLOCK_STORED_BIT;
+    }
+    context.block_offsets[block_count] = offset;
+
+    b8 result = table_size + offset == entry->stored_size;
+    if (result) {
+        job_system_parallel_for(block_count, 1, asset_decompress_blocks, &context);
+        result = context.failure_count == 0;
+    }
+
+    kfree(context.block_offsets, offsets_size, MEMORY_TAG_ARRAY);
+    return result;
+}
+
+// Checks the decompressed data of an asset in a binary package against its content hash. Debug builds only.
+static b8 asset_verify(const kpackage* package, const asset_entry* entry, const void* data) {
+#ifdef KOHI_DEBUG
+    if (crc64(0, data, entry->size) != entry->content_hash) {
+        KERROR("Package '%s': asset '%s' failed its content hash check. The package is corrupt.", kname_string_get(package->name), kname_string_get(entry->name));
+        return false;
+    }
+#endif
+    return true;
+}
+
+static void asset_view_release_allocation(void* release_context, u64 size, const void* data) {
+    kfree((void*)data, size, MEMORY_TAG_ASSET);
+}
+
+static void asset_view_release_none(void* release_context, u64 size, const void* data) {
+    // Views into a binary package remain valid for as long as the package itself, so there is nothing to do.
+}
+
+static void asset_view_release_mapping(void* release_context, u64 size, const void* data) {
+    file_mapping mapping = {.data = data, .size = size};
+    filesystem_unmap(&mapping);
+}
+
+// Hands over the data of a view as an allocation owned by the caller, copying it if the view doesn't already own one.
+static void asset_view_take(kpackage_asset_view* view, u64* out_size, const void** out_data) {
+    if (view->release != asset_view_release_allocation) {
+        void* data = kallocate(view->size, MEMORY_TAG_ASSET);
+        kcopy_memory(data, view->data, view->size);
+        view->release(view->release_context, view->size, view->data);
+        view->data = data;
+    }
+    *out_data = view->data;
+    *out_size = view->size;
+}
+
+// Decodes the stored data of an asset in a binary package. Stored binary assets are used in place, so the view
+// points into stored. Compressed assets are decompressed, and text is given a null terminator, into an allocation.
+static kpackage_result asset_decode(const kpackage* package, const asset_entry* entry, b8 is_binary, const u8* stored, kpackage_asset_view* out_view) {
+    const char* package_name = kname_string_get(package->name);
+    const char* name_str = kname_string_get(entry->name);
+
+    b8 compressed = FLAG_GET(entry->flags, KPACKAGE_BINARY_ENTRY_FLAG_COMPRESSED_BIT);
+    if (is_binary && !compressed) {
+        if (!asset_verify(package, entry, stored)) {
+            return KPACKAGE_RESULT_INTERNAL_FAILURE;
+        }
+        out_view->size = entry->size;
+        out_view->data = stored;
+        out_view->release = asset_view_release_none;
+        return KPACKAGE_RESULT_SUCCESS;
+    }
+
+    u64 size = entry->size + (is_binary ? 0 : 1);
+    if (!size) {
+        KERROR("Package '%s': asset '%s' is empty.", package_name, name_str);
+        return KPACKAGE_RESULT_ASSET_GET_FAILURE;
+    }
+    u8* data = kallocate(size, MEMORY_TAG_ASSET);
+    if (compressed) {
+        if (!asset_decompress(entry, stored, data)) {
+            KERROR("Package '%s': failed to decompress asset '%s'. The package is corrupt.", package_name, name_str);
+            kfree(data, size, MEMORY_TAG_ASSET);
+            return KPACKAGE_RESULT_INTERNAL_FAILURE;
+        }
+    } else {
+        kcopy_memory(data, stored, entry->size);
+    }
+    if (!asset_verify(package, entry, data)) {
+        kfree(data, size, MEMORY_TAG_ASSET);
+        return KPACKAGE_RESULT_INTERNAL_FAILURE;
+    }
+    if (!is_binary) {
+        data[size - 1] = 0;
+    }
+    out_view->size = size;
+    out_view->data = data;
+    out_view->release = asset_view_release_allocation;
+    return KPACKAGE_RESULT_SUCCESS;
+}
+
 static kpackage_result asset_get_data(const kpackage* package, b8 is_binary, kname name, u64* out_size, const void** out_data) {
 
     const char* package_name = kname_string_get(package->name);
@@ -129,8 +391,13 @@ static kpackage_result asset_get_data(const kpackage* package, b8 is_binary, kna
     }
 
     if (package->is_binary) {
-        KERROR("binary packages not yet supported.");
-        return KPACKAGE_RESULT_INTERNAL_FAILURE;
+        // The caller owns the returned data, so assets used in place are copied. kpackage_asset_bytes_view_get() avoids that.
+        kpackage_asset_view view = {0};
+        kpackage_result result = asset_decode(package, entry, is_binary, package->internal_data->blob + entry->offset, &view);
+        if (result == KPACKAGE_RESULT_SUCCESS) {
+            asset_view_take(&view, out_size, out_data);
+        }
+        return result;
     } else {
         kpackage_result result = KPACKAGE_RESULT_INTERNAL_FAILURE;
 
@@ -246,36 +513,141 @@ kpackage_result kpackage_asset_text_get(const kpackage* package, kname name, u64
     return asset_get_data(package, false, name, out_size, (const void**)out_text);
 }
 
+kpackage_result kpackage_asset_bytes_view_get(const kpackage* package, kname name, kpackage_asset_view* out_view) {
+    if (!package || !name || !out_view) {
+        KERROR("kpackage_asset_bytes_view_get requires valid pointers to package, name, and out_view.");
+        return KPACKAGE_RESULT_INTERNAL_FAILURE;
+    }
+    kzero_memory(out_view, sizeof(kpackage_asset_view));
+
+    asset_entry* entry = asset_entry_get(package, name);
+    if (!entry) {
+        return KPACKAGE_RESULT_ASSET_GET_FAILURE;
+    }
+
+    if (package->is_binary) {
+        // The asset is used in place, straight out of the package, unless it has to be decompressed.
+        return asset_decode(package, entry, true, package->internal_data->blob + entry->offset, out_view);
+    }
+
+    if (entry->path) {
+        file_mapping mapping = {0};
+        if (filesystem_map(entry->path, &mapping)) {
+            out_view->size = mapping.size;
+            out_view->data = mapping.data;
+            out_view->release = asset_view_release_mapping;
+            return KPACKAGE_RESULT_SUCCESS;
+        }
+    }
+
+    // Fall back to reading the asset if it could not be mapped.
+    kpackage_result result = asset_get_data(package, true, name, &out_view->size, &out_view->data);
+    if (result == KPACKAGE_RESULT_SUCCESS) {
+        out_view->release = asset_view_release_allocation;
+    }
+    return result;
+}
+
+kpackage_result kpackage_asset_location_get(const kpackage* package, kname name, kpackage_asset_location* out_location) {
+    if (!package || !name || !out_location) {
+        KERROR("kpackage_asset_location_get requires valid pointers to package, name, and out_location.");
+        return KPACKAGE_RESULT_INTERNAL_FAILURE;
+    }
+    kzero_memory(out_location, sizeof(kpackage_asset_location));
+
+    asset_entry* entry = asset_entry_get(package, name);
+    if (!entry) {
+        return KPACKAGE_RESULT_ASSET_GET_FAILURE;
+    }
+
+    if (package->is_binary) {
+        if (!package->internal_data->file_path) {
+            KERROR("Package '%s' was not loaded from a file, so asset '%s' has no location on disk.", kname_string_get(package->name), kname_string_get(name));
+            return KPACKAGE_RESULT_INTERNAL_FAILURE;
+        }
+        out_location->path = package->internal_data->file_path;
+        out_location->offset = entry->offset;
+        out_location->stored_size = entry->stored_size;
+        out_location->size = entry->size;
+        out_location->packed = true;
+        out_location->compressed = FLAG_GET(entry->flags, KPACKAGE_BINARY_ENTRY_FLAG_COMPRESSED_BIT);
+        return KPACKAGE_RESULT_SUCCESS;
+    }
+
+    if (!entry->path) {
+        KTRACE("Package '%s': No path exists for asset '%s'.", kname_string_get(package->name), kname_string_get(name));
+        return KPACKAGE_RESULT_ASSET_GET_FAILURE;
+    }
+    out_location->path = entry->path;
+    return KPACKAGE_RESULT_SUCCESS;
+}
+
+kpackage_result kpackage_asset_decode(const kpackage* package, kname name, b8 is_binary, u64 stored_size, const void* stored, u64* out_size, const void** out_data) {
+    if (!package || !name || !out_size || !out_data) {
+        KERROR("kpackage_asset_decode requires valid pointers to package, name, out_size, and out_data.");
+        return KPACKAGE_RESULT_INTERNAL_FAILURE;
+    }
+
+    asset_entry* entry = asset_entry_get(package, name);
+    if (!entry) {
+        return KPACKAGE_RESULT_ASSET_GET_FAILURE;
+    }
+    if (!package->is_binary || stored_size != entry->stored_size || (stored_size && !stored)) {
+        KERROR("kpackage_asset_decode - the data given is not the stored data of asset '%s' in binary package '%s'.", kname_string_get(name), kname_string_get(package->name));
+        return KPACKAGE_RESULT_INTERNAL_FAILURE;
+    }
+
+    // The caller owns the returned data, and stored may not outlive this call, so assets used in place are copied.
+    kpackage_asset_view view = {0};
+    kpackage_result result = asset_decode(package, entry, is_binary, stored, &view);
+    if (result == KPACKAGE_RESULT_SUCCESS) {
+        asset_view_take(&view, out_size, out_data);
+    }
+    return result;
+}
+
+b8 kpackage_asset_verify(const kpackage* package, kname name, u64 size, const void* data) {
+    if (!package || !name || !data) {
+        KERROR("kpackage_asset_verify requires valid pointers to package, name, and data.");
+        return false;
+    }
+
+    asset_entry* entry = asset_entry_get(package, name);
+    if (!entry || !package->is_binary) {
+        // Only assets in binary packages carry a content hash.
+        return entry != 0;
+    }
+    if (size < entry->size) {
+        KERROR("Package '%s': asset '%s' is truncated (%llu of %llu bytes).", kname_string_get(package->name), kname_string_get(name), size, entry->size);
+        return false;
+    }
+    return asset_verify(package, entry, data);
+}
+
 const char* kpackage_path_for_asset(const kpackage* package, kname name) {
-    u32 entry_count = darray_length(package->internal_data->entries);
-    for (u32 j = 0; j < entry_count; ++j) {
-        asset_entry* entry = &package->internal_data->entries[j];
-        if (entry->name == name) {
-            if (package->is_binary) {
-                KERROR("binary packages not yet supported.");
-                return 0;
-            } else {
-                return string_duplicate(entry->path);
-            }
+    asset_entry* entry = asset_entry_find(package, name);
+    if (entry) {
+        if (package->is_binary) {
+            // Assets in binary packages don't have paths of their own.
+            return 0;
+        } else {
+            return string_duplicate(entry->path);
         }
     }
     return 0;
 }
 
 const char* kpackage_source_path_for_asset(const kpackage* package, kname name) {
-    u32 entry_count = darray_length(package->internal_data->entries);
-    for (u32 j = 0; j < entry_count; ++j) {
-        asset_entry* entry = &package->internal_data->entries[j];
-        if (entry->name == name) {
-            if (package->is_binary) {
-                KERROR("binary packages not yet supported.");
-                return 0;
-            } else {
-                if (entry->source_path) {
-                    return string_duplicate(entry->source_path);
-                }
-                return 0;
+    asset_entry* entry = asset_entry_find(package, name);
+    if (entry) {
+        if (package->is_binary) {
+            // Assets in binary packages don't have source paths.
+            return 0;
+        } else {
+            if (entry->source_path) {
+                return string_duplicate(entry->source_path);
             }
+            return 0;
         }
     }
     return 0;
@@ -284,32 +656,28 @@ const char* kpackage_source_path_for_asset(const kpackage* package, kname name)
 // Writes file to disk for packages using the asset manifest, not binary packages.
 static b8 kpackage_asset_write_file_internal(kpackage* package, kname name, u64 size, const void* bytes, b8 is_binary) {
     file_handle f = {0};
-    // FIXME: Brute-force lookup, add a hash table or something better...
-    u32 entry_count = darray_length(package->internal_data->entries);
-    for (u32 i = 0; i < entry_count; ++i) {
-        asset_entry* entry = &package->internal_data->entries[i];
-        if (entry->name == name) {
-            // Found a match.
-            if (!filesystem_open(entry->path, FILE_MODE_WRITE, is_binary, &f)) {
-                KERROR("Unable to open asset file for writing: '%s'", entry->path);
-                return false;
-            }
-
-            u64 bytes_written = 0;
-            if (!filesystem_write(&f, size, bytes, &bytes_written)) {
-                KERROR("Unable to write to asset file: '%s'", entry->path);
-                filesystem_close(&f);
-                return false;
-            }
-
-            if (bytes_written != size) {
-                KWARN("Asset bytes written/size mismatch: %llu/%llu", bytes_written, size);
-            }
+    asset_entry* entry = asset_entry_find(package, name);
+    if (entry) {
+        // Found a match.
+        if (!filesystem_open(entry->path, FILE_MODE_WRITE, is_binary, &f)) {
+            KERROR("Unable to open asset file for writing: '%s'", entry->path);
+            return false;
+        }
 
+        u64 bytes_written = 0;
+        if (!filesystem_write(&f, size, bytes, &bytes_written)) {
+            KERROR("Unable to write to asset file: '%s'", entry->path);
             filesystem_close(&f);
+            return false;
+        }
 
-            return true;
+        if (bytes_written != size) {
+            KWARN("Asset bytes written/size mismatch: %llu/%llu", bytes_written, size);
         }
+
+        filesystem_close(&f);
+
+        return true;
     }
 
     // New asset file, write out.
@@ -324,8 +692,7 @@ b8 kpackage_asset_bytes_write(kpackage* package, kname name, u64 size, const voi
     }
 
     if (package->is_binary) {
-        // FIXME: do the thing.
-        KASSERT_MSG(false, "not yet supported");
+        KERROR("Package '%s' is a binary package, which is read-only. Write to the asset's source package and rebuild it instead.", kname_string_get(package->name));
         return false;
     }
 
@@ -344,8 +711,7 @@ b8 kpackage_asset_text_write(kpackage* package, kname name, u64 size, const char
     }
 
     if (package->is_binary) {
-        // FIXME: do the thing.
-        KASSERT_MSG(false, "not yet supported");
+        KERROR("Package '%s' is a binary package, which is read-only. Write to the asset's source package and rebuild it instead.", kname_string_get(package->name));
         return false;
     }
 
@@ -32,6 +32,83 @@ typedef struct asset_manifest {
     asset_manifest_reference* references;
 } asset_manifest;
 
+/** @brief Identifies a binary package file. "KPKG" when read as bytes. */
+#define KPACKAGE_BINARY_MAGIC 0x474B504BU
+/** @brief The current version of the binary package format. */
+#define KPACKAGE_BINARY_VERSION 2
+/** @brief The alignment of each asset within a binary package, so mapped assets may be used in place. */
+#define KPACKAGE_BINARY_ALIGNMENT 64
+/** @brief The uncompressed size of each block of a compressed asset. Blocks are independent, so may be decompressed in parallel. */
+#define KPACKAGE_BINARY_BLOCK_SIZE (256 * 1024)
+/** @brief Set on the size of a block in a compressed asset when the block is stored uncompressed. */
+#define KPACKAGE_BINARY_BLOCK_STORED_BIT 0x80000000U
+
+/**
+ * @brief The header at the start of a binary package file.
+ *
+ * A binary package holds every asset of a package in a single file, laid out as:
+ * - This header.
+ * - The table of contents: one kpackage_binary_entry per asset, sorted by name.
+ * - The string table: the null-terminated names of the package and its assets.
+ * - The payload: the data of each asset, each starting at a multiple of KPACKAGE_BINARY_ALIGNMENT.
+ *
+ * A compressed asset is split into blocks of KPACKAGE_BINARY_BLOCK_SIZE bytes (the last may be
+ * smaller), each compressed on its own with klz. Its data starts with a u32 per block holding the
+ * block's compressed size, with KPACKAGE_BINARY_BLOCK_STORED_BIT set if the block didn't compress
+ * and is stored as-is, followed by the blocks themselves.
+ *
+ * All offsets are from the start of the file, and all values are little-endian.
+ */
+typedef struct kpackage_binary_header {
+    /** @brief Always KPACKAGE_BINARY_MAGIC. */
+    u32 magic;
+    /** @brief The format version. Always KPACKAGE_BINARY_VERSION when written. */
+    u32 version;
+    /** @brief The name of the package. */
+    kname name;
+    /** @brief The number of entries in the table of contents. */
+    u32 entry_count;
+    /** @brief The offset of the package name in the string table. */
+    u32 name_offset;
+    /** @brief The offset of the table of contents. */
+    u64 toc_offset;
+    /** @brief The offset of the string table. */
+    u64 strings_offset;
+    /** @brief The size of the string table in bytes. */
+    u64 strings_size;
+    /** @brief The offset of the payload. Aligned to KPACKAGE_BINARY_ALIGNMENT. */
+    u64 payload_offset;
+    /** @brief The total size of the file in bytes. */
+    u64 file_size;
+} kpackage_binary_header;
+
+/** @brief Flags on an entry in a binary package. */
+typedef enum kpackage_binary_entry_flag_bits {
+    KPACKAGE_BINARY_ENTRY_FLAG_NONE = 0,
+    /** @brief The asset is stored as compressed blocks. */
+    KPACKAGE_BINARY_ENTRY_FLAG_COMPRESSED_BIT = 0x01
+} kpackage_binary_entry_flag_bits;
+
+typedef u32 kpackage_binary_entry_flags;
+
+/** @brief An entry in the table of contents of a binary package, describing one asset. */
+typedef struct kpackage_binary_entry {
+    /** @brief The name of the asset. Entries are sorted by this. */
+    kname name;
+    /** @brief The offset of the asset data. Aligned to KPACKAGE_BINARY_ALIGNMENT. */
+    u64 offset;
+    /** @brief The size of the asset data in bytes, once decompressed. */
+    u64 size;
+    /** @brief The size of the asset data as stored in the package, in bytes. Equal to size unless compressed. */
+    u64 stored_size;
+    /** @brief A crc64 of the asset data, once decompressed. */
+    u64 content_hash;
+    /** @brief Flags for the asset. See kpackage_binary_entry_flag_bits. */
+    kpackage_binary_entry_flags flags;
+    /** @brief The offset of the asset name in the string table. */
+    u32 name_offset;
+} kpackage_binary_entry;
+
 struct kpackage_internal;
 
 typedef struct kpackage {
@@ -46,13 +123,130 @@ typedef enum kpackage_result {
     KPACKAGE_RESULT_INTERNAL_FAILURE
 } kpackage_result;
 
+/**
+ * @brief Releases the data of an asset view once it is no longer needed.
+ *
+ * @param release_context The release_context of the view.
+ * @param size The size of the view's data in bytes.
+ * @param data The view's data.
+ */
+typedef void (*PFN_kpackage_asset_view_release)(void* release_context, u64 size, const void* data);
+
+/**
+ * @brief A read-only view of the binary data of an asset. Depending on the asset, this
+ * is either mapped straight from the file on disk or read into a heap allocation. Either
+ * way, it must be released through its release function when no longer needed.
+ */
+typedef struct kpackage_asset_view {
+    /** @brief The size of the data in bytes. */
+    u64 size;
+    /** @brief The asset data. Read-only. */
+    const void* data;
+    /** @brief Releases the data. Always set on success. */
+    PFN_kpackage_asset_view_release release;
+    /** @brief Passed through to release. */
+    void* release_context;
+} kpackage_asset_view;
+
+/**
+ * @brief Describes where the data of an asset lives on disk, so it may be read without the package
+ * (i.e. asynchronously, away from the thread using the package).
+ */
+typedef struct kpackage_asset_location {
+    /** @brief The path of the file holding the asset. Owned by the package, so valid for as long as it is. */
+    const char* path;
+    /** @brief The offset of the asset's data within the file. */
+    u64 offset;
+    /** @brief The size of the asset's data as stored in the file, in bytes. 0 if the asset is the whole file. */
+    u64 stored_size;
+    /** @brief The size of the asset once decompressed, in bytes. 0 if the asset is the whole file. */
+    u64 size;
+    /** @brief Indicates the asset lives in a binary package, so must be passed through kpackage_asset_verify() or kpackage_asset_decode() once read. */
+    b8 packed;
+    /** @brief Indicates the stored data is compressed, so must be passed through kpackage_asset_decode() once read. */
+    b8 compressed;
+} kpackage_asset_location;
+
 KAPI b8 kpackage_create_from_manifest(const asset_manifest* manifest, kpackage* out_package);
+/**
+ * @brief Creates a package from the contents of a binary package. Assets are used in place,
+ * so the bytes must remain valid until the package is destroyed.
+ *
+ * @param size The size of the binary package in bytes.
+ * @param bytes The contents of the binary package. Should be aligned to KPACKAGE_BINARY_ALIGNMENT.
+ * @param out_package A pointer to hold the created package.
+ * @returns True on success; otherwise false.
+ */
 KAPI b8 kpackage_create_from_binary(u64 size, void* bytes, kpackage* out_package);
+
+/**
+ * @brief Creates a package from the binary package file at the given path. The file is
+ * mapped into memory for as long as the package exists, so no asset is read until used.
+ *
+ * @param path The path to the binary package file.
+ * @param out_package A pointer to hold the created package.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 kpackage_create_from_binary_file(const char* path, kpackage* out_package);
 KAPI void kpackage_destroy(kpackage* package);
 
 KAPI kpackage_result kpackage_asset_bytes_get(const kpackage* package, kname name, u64* out_size, const void** out_data);
 KAPI kpackage_result kpackage_asset_text_get(const kpackage* package, kname name, u64* out_size, const char** out_text);
 
+/**
+ * Obtains a read-only view of the given binary asset. Where possible, the asset is mapped
+ * into memory instead of being read, so it is parsed straight out of the OS page cache
+ * without first being copied to the heap. Compressed assets in binary packages are
+ * decompressed into a heap allocation, with large ones spread across the job system.
+ *
+ * @param package A constant pointer to the package to search.
+ * @param name The name of the asset to obtain.
+ * @param out_view A pointer to hold the view. Must be released via its release function.
+ * @returns KPACKAGE_RESULT_SUCCESS if the view was obtained; otherwise an error result.
+ */
+KAPI kpackage_result kpackage_asset_bytes_view_get(const kpackage* package, kname name, kpackage_asset_view* out_view);
+
+/**
+ * Obtains where the data of the given asset lives on disk, so it may be read by other means
+ * (i.e. the async I/O system) rather than by the package itself.
+ *
+ * @param package A constant pointer to the package to search.
+ * @param name The name of the asset to locate.
+ * @param out_location A pointer to hold the location.
+ * @returns KPACKAGE_RESULT_SUCCESS if the asset was located; otherwise an error result.
+ */
+KAPI kpackage_result kpackage_asset_location_get(const kpackage* package, kname name, kpackage_asset_location* out_location);
+
+/**
+ * Decodes the stored data of an asset in a binary package, read from its location, into a new
+ * allocation (MEMORY_TAG_ASSET) owned by the caller. Compressed assets are decompressed, with large
+ * ones spread across the job system. Text is given a null terminator, which is counted in out_size.
+ * Stored (uncompressed) binary assets need no decoding, so are better used where they were read after
+ * kpackage_asset_verify(). Given one, this takes a copy.
+ *
+ * @param package A constant pointer to the binary package holding the asset.
+ * @param name The name of the asset.
+ * @param is_binary Indicates if the asset is binary. If not, it is decoded as text.
+ * @param stored_size The size of the stored data in bytes. Must match the location's stored_size.
+ * @param stored The stored data, as read from the asset's location.
+ * @param out_size A pointer to hold the size of the decoded data in bytes.
+ * @param out_data A pointer to hold the decoded data.
+ * @returns KPACKAGE_RESULT_SUCCESS if the asset was decoded; otherwise an error result.
+ */
+KAPI kpackage_result kpackage_asset_decode(const kpackage* package, kname name, b8 is_binary, u64 stored_size, const void* stored, u64* out_size, const void** out_data);
+
+/**
+ * Checks the uncompressed data of an asset, read from its location, against the content hash
+ * stored in its binary package. This is only done in debug builds; otherwise the data is assumed good.
+ *
+ * @param package A constant pointer to the package holding the asset.
+ * @param name The name of the asset.
+ * @param size The size of the data in bytes.
+ * @param data The data to check.
+ * @returns True if the data is good; otherwise false.
+ */
+KAPI b8 kpackage_asset_verify(const kpackage* package, kname name, u64 size, const void* data);
+
 /**
  * Attempts to retrieve the path string for the given asset within the provided package.
  * NOTE: If found, returns a _copy_ of the string (dynamically allocated) which must be freed by the caller.
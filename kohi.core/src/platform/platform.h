@@ -200,6 +200,52 @@ KAPI void* platform_allocate(u64 size, b8 aligned);
  */
 KAPI void platform_free(void* block, b8 aligned);
 
+/**
+ * @brief Obtains the size of a page of virtual memory on this platform.
+ *
+ * @return The page size in bytes.
+ */
+KAPI u64 platform_memory_page_size(void);
+
+/**
+ * @brief Reserves a range of virtual address space without committing any memory to it.
+ * The range must be committed via platform_memory_commit() before it is used.
+ *
+ * @param size The size of the range in bytes. Should be a multiple of the page size.
+ * @param huge_pages Requests that committed memory in this range be backed by huge pages where supported. On Linux,
+ * this uses transparent huge pages and aligns the range to 2MiB. Ignored elsewhere.
+ * @return A pointer to the start of the reserved range, or 0 on failure.
+ */
+KAPI void* platform_memory_reserve(u64 size, b8 huge_pages);
+
+/**
+ * @brief Commits a range of previously-reserved memory, making it usable. Committed memory
+ * reads as zero until written to.
+ *
+ * @param block The start of the range. Must be page-aligned.
+ * @param size The size of the range in bytes.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 platform_memory_commit(void* block, u64 size);
+
+/**
+ * @brief Decommits a range of committed memory, returning it to the OS. The range remains
+ * reserved and may be committed again later.
+ *
+ * @param block The start of the range. Must be page-aligned.
+ * @param size The size of the range in bytes.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 platform_memory_decommit(void* block, u64 size);
+
+/**
+ * @brief Releases a range of reserved memory entirely.
+ *
+ * @param block The start of the range, as returned by platform_memory_reserve().
+ * @param size The size of the range in bytes, as passed to platform_memory_reserve().
+ */
+KAPI void platform_memory_release(void* block, u64 size);
+
 /**
  * @brief Performs platform-specific zeroing out of the given block of memory.
  *
@@ -262,6 +308,18 @@ KAPI void platform_sleep(u64 ms);
  */
 KAPI i32 platform_get_processor_count(void);
 
+/**
+ * @brief Obtains the physical processor cores, each as a mask of the logical processors
+ * (i.e. hyperthreads) belonging to it, suitable for kthread_options.affinity_mask. Call
+ * twice, once with out_masks=0 to obtain the count, then a second time where out_masks
+ * holds at least that many. Only the first 64 logical processors are represented. The
+ * count is 0 where the topology cannot be determined, or threads cannot be pinned.
+ *
+ * @param out_count A pointer to hold the number of physical cores.
+ * @param out_masks An array to hold the mask of each physical core. Optional.
+ */
+KAPI void platform_get_physical_core_affinity_masks(u32* out_count, u64* out_masks);
+
 /**
  * @brief Obtains the required memory amount for platform-specific handle data,
  * and optionally obtains a copy of that data. Call twice, once with memory=0
@@ -42,6 +42,7 @@
 #    include <stdio.h>
 #    include <stdlib.h>
 #    include <string.h>
+#    include <sys/inotify.h>
 #    include <sys/sendfile.h>
 #    include <sys/stat.h>
 #    include <sys/sysinfo.h> // Processor info
@@ -55,7 +56,13 @@ typedef struct linux_handle_info {
 typedef struct linux_file_watch {
     u32 id;
     const char* file_path;
+    // The name of the file within its directory. Points into file_path.
+    const char* file_name;
+    // The inotify watch descriptor of the directory holding the file.
+    i32 directory_wd;
     b8 is_binary;
+    // Set when events for the file arrive, until they have been handled.
+    b8 changed;
     platform_filewatcher_file_written_callback watcher_written_callback;
     void* watcher_written_context;
     platform_filewatcher_file_deleted_callback watcher_deleted_callback;
@@ -63,6 +70,15 @@ typedef struct linux_file_watch {
     long last_write_time;
 } linux_file_watch;
 
+// A directory holding watched files. Directories are watched rather than the files themselves,
+// as editors often save by writing a new file and renaming it over the old one, which a watch
+// on the old file would never see.
+typedef struct linux_directory_watch {
+    i32 wd;
+    // The number of file watches in this directory.
+    u32 file_count;
+} linux_directory_watch;
+
 typedef struct kwindow_platform_state {
     xcb_window_t window;
     f32 device_pixel_ratio;
@@ -78,6 +94,10 @@ typedef struct platform_state {
     i32 screen_count;
     // darray
     linux_file_watch* watches;
+    // darray
+    linux_directory_watch* directory_watches;
+    // The inotify instance, created along with the first watch. -1 if not yet created.
+    i32 inotify_fd;
 
     // darray of pointers to created windows (owned by the application);
     kwindow** windows;
@@ -103,6 +123,7 @@ b8 platform_system_startup(u64* memory_requirement, struct platform_state* state
     }
 
     state_ptr = state;
+    state_ptr->inotify_fd = -1;
 
     // Connect to X
     state_ptr->display = XOpenDisplay(NULL);
@@ -158,6 +179,25 @@ void platform_system_shutdown(struct platform_state* state) {
             free(state->handle.connection);
             state->handle.connection = 0;
         }
+        if (state->watches) {
+            u32 count = darray_length(state->watches);
+            for (u32 i = 0; i < count; ++i) {
+                if (state->watches[i].id != INVALID_ID) {
+                    string_free(state->watches[i].file_path);
+                }
+            }
+            darray_destroy(state->watches);
+            state->watches = 0;
+        }
+        if (state->directory_watches) {
+            darray_destroy(state->directory_watches);
+            state->directory_watches = 0;
+        }
+        if (state->inotify_fd != -1) {
+            // Closing the instance removes all of its watches.
+            close(state->inotify_fd);
+            state->inotify_fd = -1;
+        }
     }
 }
 
@@ -626,6 +666,78 @@ i32 platform_get_processor_count(void) {
     return processors_available;
 }
 
+// Parses a sysfs cpu list (i.e. "0-3,8,10-11") into a mask. Processors beyond 63 are left out.
+static u64 cpu_list_parse(const char* list) {
+    u64 mask = 0;
+    const char* c = list;
+    while (*c >= '0' && *c <= '9') {
+        u32 first = (u32)strtoul(c, (char**)&c, 10);
+        u32 last = first;
+        if (*c == '-') {
+            last = (u32)strtoul(c + 1, (char**)&c, 10);
+        }
+        for (u32 i = first; i <= last && i < 64; ++i) {
+            mask |= 1ull << i;
+        }
+        if (*c != ',') {
+            break;
+        }
+        c++;
+    }
+    return mask;
+}
+
+// Reads the first line of a small sysfs file. Returns false if it can't be read.
+static b8 sysfs_line_read(const char* path, char* out_line, u32 max_length) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    b8 result = fgets(out_line, max_length, f) != 0;
+    fclose(f);
+    return result;
+}
+
+void platform_get_physical_core_affinity_masks(u32* out_count, u64* out_masks) {
+    if (!out_count) {
+        return;
+    }
+
+    // Each online processor lists the processors sharing its core, including itself. Every
+    // processor of a core lists the same set, so each distinct set is one physical core.
+    u64 seen = 0;
+    u32 count = 0;
+    i32 processor_count = KMIN(get_nprocs_conf(), 64);
+    char path[128];
+    char line[256];
+    for (i32 i = 0; i < processor_count; ++i) {
+        if (seen & (1ull << i)) {
+            continue;
+        }
+
+        // cpu0 usually can't be taken offline, so has no "online" file.
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%i/online", i);
+        if (sysfs_line_read(path, line, sizeof(line)) && line[0] == '0') {
+            continue;
+        }
+
+        u64 mask = 0;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%i/topology/thread_siblings_list", i);
+        if (sysfs_line_read(path, line, sizeof(line))) {
+            mask = cpu_list_parse(line);
+        }
+        // Treat the processor as its own core if the topology isn't available.
+        mask |= 1ull << i;
+
+        seen |= mask;
+        if (out_masks) {
+            out_masks[count] = mask;
+        }
+        count++;
+    }
+    *out_count = count;
+}
+
 void platform_get_handle_info(u64* out_size, void* memory) {
     *out_size = sizeof(linux_handle_info);
     if (!memory) {
@@ -772,6 +884,49 @@ close_handles:
     return ret_code;
 }
 
+// Adds a reference to the watch on the given directory, watching it if need be. Returns the watch descriptor, or -1 on failure.
+static i32 directory_watch_acquire(const char* directory_path) {
+    // Only the events which mean a file was completely written, replaced or removed. Writes in
+    // progress (IN_MODIFY) are ignored, so a file is never reloaded part way through being saved.
+    u32 mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM | IN_ONLYDIR;
+    // Watching an already-watched directory gives back the same descriptor.
+    i32 wd = inotify_add_watch(state_ptr->inotify_fd, directory_path, mask);
+    if (wd == -1) {
+        KERROR("Failed to watch directory '%s': %s", directory_path, strerror(errno));
+        return -1;
+    }
+
+    u32 count = darray_length(state_ptr->directory_watches);
+    for (u32 i = 0; i < count; ++i) {
+        if (state_ptr->directory_watches[i].wd == wd) {
+            state_ptr->directory_watches[i].file_count++;
+            return wd;
+        }
+    }
+
+    linux_directory_watch d = {0};
+    d.wd = wd;
+    d.file_count = 1;
+    darray_push(state_ptr->directory_watches, d);
+    return wd;
+}
+
+// Removes a reference to the watch on a directory, no longer watching it once there are none.
+static void directory_watch_release(i32 wd) {
+    u32 count = darray_length(state_ptr->directory_watches);
+    for (u32 i = 0; i < count; ++i) {
+        linux_directory_watch* d = &state_ptr->directory_watches[i];
+        if (d->wd == wd) {
+            d->file_count--;
+            if (d->file_count == 0) {
+                inotify_rm_watch(state_ptr->inotify_fd, wd);
+                darray_pop_at(state_ptr->directory_watches, i, 0);
+            }
+            return;
+        }
+    }
+}
+
 static b8 register_watch(
     const char* file_path,
     b8 is_binary,
@@ -791,6 +946,15 @@ static b8 register_watch(
 
     if (!state_ptr->watches) {
         state_ptr->watches = darray_create(linux_file_watch);
+        state_ptr->directory_watches = darray_create(linux_directory_watch);
+    }
+    if (state_ptr->inotify_fd == -1) {
+        // Non-blocking, so checking for changes returns straight away when there are none.
+        state_ptr->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (state_ptr->inotify_fd == -1) {
+            KERROR("Failed to create inotify instance, so files cannot be watched: %s", strerror(errno));
+            return false;
+        }
     }
 
     struct stat info;
@@ -802,28 +966,45 @@ static b8 register_watch(
         return false;
     }
 
+    linux_file_watch w = {0};
+    w.file_path = string_duplicate(file_path);
+    const char* separator = strrchr(w.file_path, '/');
+    if (separator) {
+        w.file_name = separator + 1;
+        // Temporarily cut the path off at the separator to get the directory ("/" for the root).
+        char* directory_end = (char*)(separator == w.file_path ? separator + 1 : separator);
+        char c = *directory_end;
+        *directory_end = 0;
+        w.directory_wd = directory_watch_acquire(w.file_path);
+        *directory_end = c;
+    } else {
+        w.file_name = w.file_path;
+        w.directory_wd = directory_watch_acquire(".");
+    }
+    if (w.directory_wd == -1) {
+        string_free(w.file_path);
+        return false;
+    }
+    w.is_binary = is_binary;
+    w.last_write_time = info.st_mtime;
+    w.watcher_written_callback = watcher_written_callback;
+    w.watcher_written_context = watcher_written_context;
+    w.watcher_deleted_callback = watcher_deleted_callback;
+    w.watcher_deleted_context = watcher_deleted_context;
+
     u32 count = darray_length(state_ptr->watches);
     for (u32 i = 0; i < count; ++i) {
-        linux_file_watch* w = &state_ptr->watches[i];
-        if (w->id == INVALID_ID) {
+        if (state_ptr->watches[i].id == INVALID_ID) {
             // Found a free slot to use.
-            w->id = i;
-            w->file_path = string_duplicate(file_path);
-            w->last_write_time = info.st_mtime;
+            w.id = i;
+            state_ptr->watches[i] = w;
             *out_watch_id = i;
             return true;
         }
     }
 
     // If no empty slot is available, create and push a new entry.
-    linux_file_watch w = {0};
     w.id = count;
-    w.file_path = string_duplicate(file_path);
-    w.last_write_time = info.st_mtime;
-    w.watcher_written_callback = watcher_written_callback;
-    w.watcher_written_context = watcher_written_context;
-    w.watcher_deleted_callback = watcher_deleted_callback;
-    w.watcher_deleted_context = watcher_deleted_context;
     *out_watch_id = count;
     darray_push(state_ptr->watches, w);
 
@@ -841,11 +1022,13 @@ static b8 unregister_watch(u32 watch_id) {
     }
 
     linux_file_watch* w = &state_ptr->watches[watch_id];
+    if (w->id == INVALID_ID) {
+        return false;
+    }
+    directory_watch_release(w->directory_wd);
+    string_free(w->file_path);
+    kzero_memory(w, sizeof(linux_file_watch));
     w->id = INVALID_ID;
-    u32 len = string_length(w->file_path);
-    kfree((void*)w->file_path, sizeof(char) * (len + 1), MEMORY_TAG_STRING);
-    w->file_path = 0;
-    kzero_memory(&w->last_write_time, sizeof(long));
 
     return true;
 }
@@ -872,48 +1055,95 @@ b8 platform_unwatch_file(u32 watch_id) {
     return unregister_watch(watch_id);
 }
 
+// Marks the watches of the named file (or every file, if name is 0) in the given directory as changed.
+static void watches_mark_changed(i32 directory_wd, const char* name) {
+    u32 count = darray_length(state_ptr->watches);
+    for (u32 i = 0; i < count; ++i) {
+        linux_file_watch* f = &state_ptr->watches[i];
+        if (f->id != INVALID_ID && f->directory_wd == directory_wd && (!name || strings_equal(f->file_name, name))) {
+            f->changed = true;
+        }
+    }
+}
+
 static void platform_update_watches(void) {
-    if (!state_ptr || !state_ptr->watches) {
+    if (!state_ptr || !state_ptr->watches || state_ptr->inotify_fd == -1) {
+        return;
+    }
+
+    // Drain every pending event first, only noting which files changed. A save usually raises
+    // several events (i.e. delete, then move, then close), which are coalesced into one
+    // notification per file per update. With no changes, this is a single read which returns
+    // immediately.
+    b8 any_changed = false;
+    _Alignas(struct inotify_event) char buffer[4096];
+    while (true) {
+        ssize_t length = read(state_ptr->inotify_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            if (length == -1 && errno != EAGAIN && errno != EINTR) {
+                KWARN("Failed to read file watch events: %s", strerror(errno));
+            }
+            break;
+        }
+
+        for (char* ptr = buffer; ptr < buffer + length;) {
+            const struct inotify_event* event = (const struct inotify_event*)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost, so anything may have changed. Check every file.
+                u32 count = darray_length(state_ptr->watches);
+                for (u32 i = 0; i < count; ++i) {
+                    state_ptr->watches[i].changed = state_ptr->watches[i].id != INVALID_ID;
+                }
+            } else if (event->mask & IN_IGNORED) {
+                // The directory itself is gone, and with it every file in it.
+                watches_mark_changed(event->wd, 0);
+            } else if (event->len) {
+                watches_mark_changed(event->wd, event->name);
+            }
+            any_changed = true;
+        }
+    }
+    if (!any_changed) {
         return;
     }
 
+    // Only now look at the changed files, to find out what they ended up as.
     u32 count = darray_length(state_ptr->watches);
     for (u32 i = 0; i < count; ++i) {
         linux_file_watch* f = &state_ptr->watches[i];
-        if (f->id != INVALID_ID) {
-            struct stat info;
-            int result = stat(f->file_path, &info);
-            if (result != 0) {
-                if (errno == ENOENT) {
-                    // File doesn't exist. Which means it was deleted. Remove the watch.
-                    if (f->watcher_deleted_callback) {
-                        f->watcher_deleted_callback(f->id, f->watcher_written_context);
-                    } else {
-                        KWARN("Watcher file was deleted but no handler callback was set. Make sure to call platform_register_watcher_deleted_callback()");
-                    }
-                    /* event_context context = {0};
-                    context.data.u32[0] = f->id;
-                    event_fire(EVENT_CODE_WATCHED_FILE_DELETED, 0, context); */
-                    KINFO("File watch id %d has been removed.", f->id);
-                    unregister_watch(f->id);
-                    continue;
-                } else {
-                    KWARN("Some other error occurred on file watch id %d", f->id);
-                }
-                // NOTE: some other error has occurred. TODO: Handle?
-                continue;
-            }
+        if (f->id == INVALID_ID || !f->changed) {
+            continue;
+        }
+        f->changed = false;
 
-            // Check the file time to see if it has been changed and update/notify if so.
-            if (info.st_mtime - f->last_write_time != 0) {
-                KTRACE("File update found.");
-                f->last_write_time = info.st_mtime;
-                if (f->watcher_written_callback) {
-                    f->watcher_written_callback(f->id, f->file_path, f->is_binary, f->watcher_written_context);
+        struct stat info;
+        int result = stat(f->file_path, &info);
+        if (result != 0) {
+            if (errno == ENOENT) {
+                // File doesn't exist. Which means it was deleted. Remove the watch.
+                if (f->watcher_deleted_callback) {
+                    f->watcher_deleted_callback(f->id, f->watcher_deleted_context);
                 } else {
-                    KWARN("Watcher file was deleted but no handler callback was set. Make sure to call platform_register_watcher_written_callback()");
+                    KWARN("Watcher file was deleted but no handler callback was set. Make sure to call platform_register_watcher_deleted_callback()");
                 }
+                KINFO("File watch id %d has been removed.", f->id);
+                unregister_watch(f->id);
+            } else {
+                KWARN("Some other error occurred on file watch id %d", f->id);
             }
+            continue;
+        }
+
+        // Events are also raised for writes which leave the file as it was (i.e. saving without
+        // changes). Those are still reported, as the content may differ even if the time does not.
+        KTRACE("File update found.");
+        f->last_write_time = info.st_mtime;
+        if (f->watcher_written_callback) {
+            f->watcher_written_callback(f->id, f->file_path, f->is_binary, f->watcher_written_context);
+        } else {
+            KWARN("Watcher file was written but no handler callback was set. Make sure to call platform_register_watcher_written_callback()");
         }
     }
 }
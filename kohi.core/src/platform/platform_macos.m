@@ -738,6 +738,13 @@ i32 platform_get_processor_count(void) {
     return [[NSProcessInfo processInfo] processorCount];
 }
 
+void platform_get_physical_core_affinity_masks(u32* out_count, u64* out_masks) {
+    // NOTE: macOS offers no way to pin threads to processors, so there is nothing to report.
+    if (out_count) {
+        *out_count = 0;
+    }
+}
+
 void platform_get_handle_info(u64* out_size, void* memory) {
 
     *out_size = sizeof(macos_handle_info);
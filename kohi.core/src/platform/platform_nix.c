@@ -9,6 +9,11 @@
  *
  */
 
+// NOTE: Linux needs this for pthread_setname_np and pthread_setaffinity_np. Must come before any system header.
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#    define _GNU_SOURCE
+#endif
+
 #include "platform.h"
 
 #if defined(KPLATFORM_LINUX) || defined(KPLATFORM_APPLE)
@@ -19,24 +24,39 @@
 
 // NOTE: Apple's include is on a different path.
 #    if defined(KPLATFORM_APPLE)
+#        include <pthread/qos.h>
 #        include <sys/semaphore.h>
 #    endif
 
 // NOTE: Linux has its own path, plus needs a few more headers.
 #    if defined(KPLATFORM_LINUX)
 #        include <semaphore.h> // sudo apt install linux-headers
+#        include <sys/resource.h>
+#        include <sys/syscall.h>
 /* #include <sys/stat.h>   // For mode constants */
 #    endif
 
 #    include <errno.h> // For error reporting
+#    include <string.h>
 #    include <pthread.h>
+#    include <sched.h>
+#    include <sys/mman.h>
 #    include <sys/shm.h>
+#    include <unistd.h>
+
+// NOTE: Apple only declares the (deprecated, but still working) ucontext routines when asked to.
+#    if defined(KPLATFORM_APPLE) && !defined(_XOPEN_SOURCE)
+#        define _XOPEN_SOURCE 600
+#    endif
+#    include <ucontext.h>
 
 #    include "containers/darray.h"
 #    include "logger.h"
 #    include "memory/kmemory.h"
 #    include "strings/kstring.h"
+#    include "threads/katomic.h"
 #    include "threads/kmutex.h"
+#    include "threads/kfiber.h"
 #    include "threads/kthread.h"
 
 typedef struct nix_semaphore_internal {
@@ -46,17 +66,198 @@ typedef struct nix_semaphore_internal {
 
 static u32 semaphore_id = 0;
 
+// NOTE: Begin virtual memory.
+
+#    define NIX_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+u64 platform_memory_page_size(void) {
+    return (u64)sysconf(_SC_PAGESIZE);
+}
+
+void* platform_memory_reserve(u64 size, b8 huge_pages) {
+    // Reserve by mapping with no access. MAP_NORESERVE keeps the range from counting against
+    // the commit limit until it is actually committed.
+    size = get_aligned(size, platform_memory_page_size());
+    u64 map_size = size;
+#    if defined(KPLATFORM_LINUX) && defined(MADV_HUGEPAGE)
+    if (huge_pages) {
+        // Over-reserve so the range can be aligned to a huge page boundary.
+        map_size += NIX_HUGE_PAGE_SIZE;
+    }
+#    endif
+    void* block = mmap(0, map_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (block == MAP_FAILED) {
+        KERROR("platform_memory_reserve failed to reserve %llu bytes: %s", size, strerror(errno));
+        return 0;
+    }
+
+#    if defined(KPLATFORM_LINUX) && defined(MADV_HUGEPAGE)
+    if (huge_pages) {
+        // Trim the excess from either side of the aligned range.
+        u64 start = (u64)block;
+        u64 aligned_start = get_aligned(start, NIX_HUGE_PAGE_SIZE);
+        if (aligned_start > start) {
+            munmap(block, aligned_start - start);
+        }
+        u64 tail = (start + map_size) - (aligned_start + size);
+        if (tail) {
+            munmap((void*)(aligned_start + size), tail);
+        }
+        block = (void*)aligned_start;
+        // Only a hint; if THP is disabled this simply does nothing.
+        if (madvise(block, size, MADV_HUGEPAGE) != 0) {
+            KWARN("platform_memory_reserve could not enable transparent huge pages: %s", strerror(errno));
+        }
+    }
+#    else
+    (void)huge_pages;
+#    endif
+    return block;
+}
+
+b8 platform_memory_commit(void* block, u64 size) {
+    // Pages only become resident once touched.
+    if (mprotect(block, size, PROT_READ | PROT_WRITE) != 0) {
+        KERROR("platform_memory_commit failed to commit %llu bytes at 0x%p: %s", size, block, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+b8 platform_memory_decommit(void* block, u64 size) {
+    // Mapping fresh, inaccessible pages over the range drops the old ones and their commit charge.
+    void* result = mmap(block, size, PROT_NONE, MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (result == MAP_FAILED) {
+        KERROR("platform_memory_decommit failed to decommit %llu bytes at 0x%p: %s", size, block, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void platform_memory_release(void* block, u64 size) {
+    if (block && munmap(block, size) != 0) {
+        KERROR("platform_memory_release failed to release %llu bytes at 0x%p: %s", size, block, strerror(errno));
+    }
+}
+
 // NOTE: Begin threads.
 
 typedef void *(*kthread_work_callback)(void *);
 
+// Everything a thread created with options needs to get started. Owned by the new thread.
+typedef struct nix_thread_start {
+    pfn_thread_start start_function_ptr;
+    void* params;
+    char name[KTHREAD_NAME_MAX_LENGTH];
+    u64 affinity_mask;
+    kthread_priority priority;
+} nix_thread_start;
+
+#    if defined(KPLATFORM_LINUX)
+// Set once a thread has been refused a raised priority, so that is only logged once.
+static u32 priority_raise_refused = 0;
+#    endif
+
+// Applies the options to the calling thread. Failures are not fatal; the thread just runs without them.
+static void nix_thread_options_apply(const nix_thread_start* start) {
+    if (start->name[0]) {
+#    if defined(KPLATFORM_APPLE)
+        // Apple can only name the calling thread.
+        pthread_setname_np(start->name);
+#    else
+        pthread_setname_np(pthread_self(), start->name);
+#    endif
+    }
+
+#    if defined(KPLATFORM_LINUX)
+    if (start->affinity_mask) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (u32 i = 0; i < 64; ++i) {
+            if (start->affinity_mask & (1ull << i)) {
+                CPU_SET(i, &set);
+            }
+        }
+        i32 result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+        if (result != 0) {
+            KWARN("Failed to set affinity of thread '%s' to %#llx: %s", start->name, start->affinity_mask, strerror(result));
+        }
+    }
+
+    // Linux scheduling is per thread, so the nice value of just this thread can be changed.
+    if (start->priority != KTHREAD_PRIORITY_NORMAL) {
+        id_t tid = (id_t)syscall(SYS_gettid);
+        i32 nice_value = start->priority == KTHREAD_PRIORITY_HIGH ? -10 : 10;
+        i32 error = setpriority(PRIO_PROCESS, tid, nice_value) == 0 ? 0 : errno;
+        if (error == EPERM && nice_value < 0) {
+            // Raising priority requires CAP_SYS_NICE, which most processes don't have. RLIMIT_NICE may still
+            // allow some of it (down to a nice value of 20 - limit), so raise it as far as that allows instead.
+            struct rlimit nice_limit;
+            if (getrlimit(RLIMIT_NICE, &nice_limit) == 0 && nice_limit.rlim_cur != RLIM_INFINITY && nice_limit.rlim_cur > 20) {
+                nice_value = KMAX(nice_value, 20 - (i32)nice_limit.rlim_cur);
+                error = setpriority(PRIO_PROCESS, tid, nice_value) == 0 ? 0 : errno;
+            }
+            // This is the expected outcome for an unprivileged process, so only mention it once.
+            if (error == EPERM) {
+                if (!katomic_exchange_u32(&priority_raise_refused, 1)) {
+                    KDEBUG("Thread priorities can't be raised without CAP_SYS_NICE or a higher RLIMIT_NICE. High priority threads will run at normal priority.");
+                }
+                error = 0;
+            }
+        }
+        if (error) {
+            KWARN("Failed to set nice value of thread '%s' to %i: %s", start->name, nice_value, strerror(error));
+        }
+    }
+#    elif defined(KPLATFORM_APPLE)
+    // NOTE: macOS offers no way to pin threads, so the affinity mask is ignored. Priority maps to QoS classes.
+    if (start->priority != KTHREAD_PRIORITY_NORMAL) {
+        qos_class_t qos_class = start->priority == KTHREAD_PRIORITY_HIGH ? QOS_CLASS_USER_INTERACTIVE : QOS_CLASS_UTILITY;
+        i32 result = pthread_set_qos_class_self_np(qos_class, 0);
+        if (result != 0) {
+            KWARN("Failed to set QoS class of thread '%s': %s", start->name, strerror(result));
+        }
+    }
+#    endif
+}
+
+static void* nix_thread_start_run(void* params) {
+    nix_thread_start start = *(nix_thread_start*)params;
+    platform_free(params, false);
+
+    nix_thread_options_apply(&start);
+    return (void*)(u64)start.start_function_ptr(start.params);
+}
+
 b8 kthread_create(pfn_thread_start start_function_ptr, void* params, b8 auto_detach, kthread* out_thread) {
+    return kthread_create_with_options(start_function_ptr, params, 0, auto_detach, out_thread);
+}
+
+b8 kthread_create_with_options(pfn_thread_start start_function_ptr, void* params, const kthread_options* options, b8 auto_detach, kthread* out_thread) {
     if (!start_function_ptr) {
         return false;
     }
 
-    // pthread_create uses a function pointer that returns void*, so cold-cast to this type.
-    i32 result = pthread_create((pthread_t*)&out_thread->thread_id, 0, (kthread_work_callback)start_function_ptr, params);
+    i32 result;
+    if (options) {
+        // Options are applied by the new thread itself, which is the only way to name a thread on Apple.
+        nix_thread_start* start = platform_allocate(sizeof(nix_thread_start), false);
+        kzero_memory(start, sizeof(nix_thread_start));
+        start->start_function_ptr = start_function_ptr;
+        start->params = params;
+        if (options->name) {
+            string_ncopy(start->name, options->name, KTHREAD_NAME_MAX_LENGTH - 1);
+        }
+        start->affinity_mask = options->affinity_mask;
+        start->priority = options->priority;
+        result = pthread_create((pthread_t*)&out_thread->thread_id, 0, nix_thread_start_run, start);
+        if (result != 0) {
+            platform_free(start, false);
+        }
+    } else {
+        // pthread_create uses a function pointer that returns void*, so cold-cast to this type.
+        result = pthread_create((pthread_t*)&out_thread->thread_id, 0, (kthread_work_callback)start_function_ptr, params);
+    }
     if (result != 0) {
         switch (result) {
         case EAGAIN:
@@ -153,6 +354,10 @@ void kthread_sleep(kthread* thread, u64 ms) {
     platform_sleep(ms);
 }
 
+void kthread_yield(void) {
+    sched_yield();
+}
+
 b8 kthread_wait(kthread* thread) {
     if (thread && thread->internal_data) {
         i32 result = pthread_join(*(pthread_t*)thread->internal_data, 0);
@@ -188,6 +393,98 @@ u64 platform_current_thread_id(void) {
 }
 // NOTE: End threads.
 
+// NOTE: Begin fibers.
+
+typedef struct nix_fiber_internal {
+    ucontext_t context;
+    // The reserved stack range, including a guard page at the bottom. 0 for a converted thread.
+    void* stack;
+    u64 stack_size;
+    pfn_fiber_start start_function_ptr;
+    void* params;
+} nix_fiber_internal;
+
+// makecontext() only passes int arguments, so the pointer to the fiber arrives in two halves.
+static void fiber_entry(u32 high, u32 low) {
+    nix_fiber_internal* internal = (nix_fiber_internal*)(((u64)high << 32) | (u64)low);
+    internal->start_function_ptr(internal->params);
+    KFATAL("A fiber returned from its start function. Fibers must switch to another fiber instead.");
+}
+
+b8 kfiber_thread_convert(kfiber* out_fiber) {
+    if (!out_fiber) {
+        return false;
+    }
+    // Nothing to do here beyond having somewhere to save the thread's context when it switches away.
+    out_fiber->internal_data = kallocate(sizeof(nix_fiber_internal), MEMORY_TAG_ENGINE);
+    return true;
+}
+
+void kfiber_thread_revert(kfiber* fiber) {
+    if (fiber && fiber->internal_data) {
+        kfree(fiber->internal_data, sizeof(nix_fiber_internal), MEMORY_TAG_ENGINE);
+        fiber->internal_data = 0;
+    }
+}
+
+b8 kfiber_create(u64 stack_size, pfn_fiber_start start_function_ptr, void* params, kfiber* out_fiber) {
+    if (!start_function_ptr || !out_fiber || !stack_size) {
+        return false;
+    }
+
+    // Leave the lowest page uncommitted, so overflowing the stack faults rather than
+    // silently trampling whatever lies below it.
+    u64 page_size = platform_memory_page_size();
+    u64 total_size = get_aligned(stack_size, page_size) + page_size;
+    void* stack = platform_memory_reserve(total_size, false);
+    if (!stack) {
+        return false;
+    }
+    if (!platform_memory_commit((u8*)stack + page_size, total_size - page_size)) {
+        platform_memory_release(stack, total_size);
+        return false;
+    }
+
+    nix_fiber_internal* internal = kallocate(sizeof(nix_fiber_internal), MEMORY_TAG_ENGINE);
+    internal->stack = stack;
+    internal->stack_size = total_size;
+    internal->start_function_ptr = start_function_ptr;
+    internal->params = params;
+    if (getcontext(&internal->context) != 0) {
+        KERROR("kfiber_create failed to get context: %s", strerror(errno));
+        platform_memory_release(stack, total_size);
+        kfree(internal, sizeof(nix_fiber_internal), MEMORY_TAG_ENGINE);
+        return false;
+    }
+    internal->context.uc_stack.ss_sp = (u8*)stack + page_size;
+    internal->context.uc_stack.ss_size = total_size - page_size;
+    internal->context.uc_link = 0;
+    u64 address = (u64)internal;
+    makecontext(&internal->context, (void (*)(void))fiber_entry, 2, (u32)(address >> 32), (u32)address);
+
+    out_fiber->internal_data = internal;
+    return true;
+}
+
+void kfiber_destroy(kfiber* fiber) {
+    if (fiber && fiber->internal_data) {
+        nix_fiber_internal* internal = fiber->internal_data;
+        platform_memory_release(internal->stack, internal->stack_size);
+        kfree(internal, sizeof(nix_fiber_internal), MEMORY_TAG_ENGINE);
+        fiber->internal_data = 0;
+    }
+}
+
+void kfiber_switch(kfiber* from, kfiber* to) {
+    nix_fiber_internal* from_internal = from->internal_data;
+    nix_fiber_internal* to_internal = to->internal_data;
+    if (swapcontext(&from_internal->context, &to_internal->context) != 0) {
+        KERROR("kfiber_switch failed to switch context: %s", strerror(errno));
+    }
+}
+
+// NOTE: End fibers.
+
 // NOTE: Begin mutexes
 b8 kmutex_create(kmutex* out_mutex) {
     if (!out_mutex) {
@@ -7,6 +7,7 @@
 #    include "logger.h"
 #    include "memory/kmemory.h"
 #    include "strings/kstring.h"
+#    include "threads/kfiber.h"
 #    include "threads/kmutex.h"
 #    include "threads/ksemaphore.h"
 #    include "threads/kthread.h"
@@ -358,6 +359,44 @@ void platform_free(void* block, b8 aligned) {
     HeapFree(GetProcessHeap(), 0, block);
 }
 
+u64 platform_memory_page_size(void) {
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo(&sysinfo);
+    return (u64)sysinfo.dwPageSize;
+}
+
+void* platform_memory_reserve(u64 size, b8 huge_pages) {
+    // NOTE: Large pages on Windows require a privilege and must be committed up front, so huge_pages is ignored.
+    void* block = VirtualAlloc(0, size, MEM_RESERVE, PAGE_NOACCESS);
+    if (!block) {
+        KERROR("platform_memory_reserve failed to reserve %llu bytes (error %lu).", size, GetLastError());
+    }
+    return block;
+}
+
+b8 platform_memory_commit(void* block, u64 size) {
+    if (!VirtualAlloc(block, size, MEM_COMMIT, PAGE_READWRITE)) {
+        KERROR("platform_memory_commit failed to commit %llu bytes at 0x%p (error %lu).", size, block, GetLastError());
+        return false;
+    }
+    return true;
+}
+
+b8 platform_memory_decommit(void* block, u64 size) {
+    if (!VirtualFree(block, size, MEM_DECOMMIT)) {
+        KERROR("platform_memory_decommit failed to decommit %llu bytes at 0x%p (error %lu).", size, block, GetLastError());
+        return false;
+    }
+    return true;
+}
+
+void platform_memory_release(void* block, u64 size) {
+    // NOTE: MEM_RELEASE requires a size of 0, and releases the entire reservation.
+    if (block && !VirtualFree(block, 0, MEM_RELEASE)) {
+        KERROR("platform_memory_release failed to release memory at 0x%p (error %lu).", block, GetLastError());
+    }
+}
+
 void* platform_zero_memory(void* block, u64 size) {
     return memset(block, 0, size);
 }
@@ -430,6 +469,35 @@ i32 platform_get_processor_count(void) {
     return sysinfo.dwNumberOfProcessors;
 }
 
+void platform_get_physical_core_affinity_masks(u32* out_count, u64* out_masks) {
+    if (!out_count) {
+        return;
+    }
+    *out_count = 0;
+
+    DWORD size = 0;
+    GetLogicalProcessorInformation(0, &size);
+    if (!size) {
+        KWARN("Unable to obtain processor topology.");
+        return;
+    }
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION* infos = kallocate(size, MEMORY_TAG_PLATFORM);
+    if (GetLogicalProcessorInformation(infos, &size)) {
+        u32 info_count = size / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION);
+        for (u32 i = 0; i < info_count; ++i) {
+            if (infos[i].Relationship == RelationProcessorCore && infos[i].ProcessorMask) {
+                if (out_masks) {
+                    out_masks[*out_count] = (u64)infos[i].ProcessorMask;
+                }
+                (*out_count)++;
+            }
+        }
+    } else {
+        KWARN("Unable to obtain processor topology.");
+    }
+    kfree(infos, size, MEMORY_TAG_PLATFORM);
+}
+
 void platform_get_handle_info(u64* out_size, void* memory) {
     *out_size = sizeof(win32_handle_info);
     if (!memory) {
@@ -444,18 +512,82 @@ f32 platform_device_pixel_ratio(const struct kwindow* window) {
 }
 
 // NOTE: Begin threads
+
+// Everything a thread created with options needs to get started. Owned by the new thread.
+typedef struct win32_thread_start {
+    pfn_thread_start start_function_ptr;
+    void* params;
+    char name[KTHREAD_NAME_MAX_LENGTH];
+    u64 affinity_mask;
+    kthread_priority priority;
+} win32_thread_start;
+
+// Only available from Windows 10 1607 onwards, so looked up rather than linked.
+typedef HRESULT(WINAPI* PFN_SetThreadDescription)(HANDLE thread, PCWSTR description);
+
+// Applies the options to the calling thread. Failures are not fatal; the thread just runs without them.
+static void win32_thread_options_apply(const win32_thread_start* start) {
+    HANDLE thread = GetCurrentThread();
+    if (start->name[0]) {
+        PFN_SetThreadDescription set_description = (PFN_SetThreadDescription)(void*)GetProcAddress(GetModuleHandleA("kernel32.dll"), "SetThreadDescription");
+        if (set_description) {
+            WCHAR wname[KTHREAD_NAME_MAX_LENGTH];
+            if (MultiByteToWideChar(CP_UTF8, 0, start->name, -1, wname, KTHREAD_NAME_MAX_LENGTH)) {
+                set_description(thread, wname);
+            }
+        }
+    }
+    if (start->affinity_mask && !SetThreadAffinityMask(thread, (DWORD_PTR)start->affinity_mask)) {
+        KWARN("Failed to set affinity of thread '%s' to %#llx. Error: %u", start->name, start->affinity_mask, GetLastError());
+    }
+    if (start->priority != KTHREAD_PRIORITY_NORMAL) {
+        i32 priority = start->priority == KTHREAD_PRIORITY_HIGH ? THREAD_PRIORITY_HIGHEST : THREAD_PRIORITY_BELOW_NORMAL;
+        if (!SetThreadPriority(thread, priority)) {
+            KWARN("Failed to set priority of thread '%s'. Error: %u", start->name, GetLastError());
+        }
+    }
+}
+
+static DWORD WINAPI win32_thread_start_run(LPVOID params) {
+    win32_thread_start start = *(win32_thread_start*)params;
+    kfree(params, sizeof(win32_thread_start), MEMORY_TAG_PLATFORM);
+
+    win32_thread_options_apply(&start);
+    return start.start_function_ptr(start.params);
+}
+
 b8 kthread_create(pfn_thread_start start_function_ptr, void* params, b8 auto_detach, kthread* out_thread) {
+    return kthread_create_with_options(start_function_ptr, params, 0, auto_detach, out_thread);
+}
+
+b8 kthread_create_with_options(pfn_thread_start start_function_ptr, void* params, const kthread_options* options, b8 auto_detach, kthread* out_thread) {
     if (!start_function_ptr) {
         return false;
     }
 
-    out_thread->internal_data = CreateThread(
-        0,
-        0,                                          // Default stack size
-        (LPTHREAD_START_ROUTINE)start_function_ptr, // function ptr
-        params,                                     // param to pass to thread
-        0,
-        (DWORD*)&out_thread->thread_id);
+    if (options) {
+        // Options are applied by the new thread itself, before it starts work.
+        win32_thread_start* start = kallocate(sizeof(win32_thread_start), MEMORY_TAG_PLATFORM);
+        start->start_function_ptr = start_function_ptr;
+        start->params = params;
+        if (options->name) {
+            string_ncopy(start->name, options->name, KTHREAD_NAME_MAX_LENGTH - 1);
+        }
+        start->affinity_mask = options->affinity_mask;
+        start->priority = options->priority;
+        out_thread->internal_data = CreateThread(0, 0, win32_thread_start_run, start, 0, (DWORD*)&out_thread->thread_id);
+        if (!out_thread->internal_data) {
+            kfree(start, sizeof(win32_thread_start), MEMORY_TAG_PLATFORM);
+        }
+    } else {
+        out_thread->internal_data = CreateThread(
+            0,
+            0,                                          // Default stack size
+            (LPTHREAD_START_ROUTINE)start_function_ptr, // function ptr
+            params,                                     // param to pass to thread
+            0,
+            (DWORD*)&out_thread->thread_id);
+    }
     KDEBUG("Starting process on thread id: %#x", out_thread->thread_id);
     if (!out_thread->internal_data) {
         return false;
@@ -529,12 +661,89 @@ void kthread_sleep(kthread* thread, u64 ms) {
     platform_sleep(ms);
 }
 
+void kthread_yield(void) {
+    SwitchToThread();
+}
+
 u64 platform_current_thread_id(void) {
     return (u64)GetCurrentThreadId();
 }
 
 // NOTE: End threads.
 
+// NOTE: Begin fibers
+
+typedef struct win32_fiber_internal {
+    LPVOID fiber;
+    // Created fibers only. Kept here so they live as long as the fiber.
+    pfn_fiber_start start_function_ptr;
+    void* params;
+} win32_fiber_internal;
+
+static void WINAPI win32_fiber_entry(LPVOID parameter) {
+    win32_fiber_internal* internal = parameter;
+    internal->start_function_ptr(internal->params);
+    KFATAL("A fiber returned from its start function. Fibers must switch to another fiber instead.");
+}
+
+b8 kfiber_thread_convert(kfiber* out_fiber) {
+    if (!out_fiber) {
+        return false;
+    }
+    LPVOID fiber = ConvertThreadToFiber(0);
+    if (!fiber) {
+        KERROR("kfiber_thread_convert failed to convert thread to fiber. Error: %u", GetLastError());
+        return false;
+    }
+    win32_fiber_internal* internal = kallocate(sizeof(win32_fiber_internal), MEMORY_TAG_ENGINE);
+    internal->fiber = fiber;
+    out_fiber->internal_data = internal;
+    return true;
+}
+
+void kfiber_thread_revert(kfiber* fiber) {
+    if (fiber && fiber->internal_data) {
+        ConvertFiberToThread();
+        kfree(fiber->internal_data, sizeof(win32_fiber_internal), MEMORY_TAG_ENGINE);
+        fiber->internal_data = 0;
+    }
+}
+
+b8 kfiber_create(u64 stack_size, pfn_fiber_start start_function_ptr, void* params, kfiber* out_fiber) {
+    if (!start_function_ptr || !out_fiber || !stack_size) {
+        return false;
+    }
+    win32_fiber_internal* internal = kallocate(sizeof(win32_fiber_internal), MEMORY_TAG_ENGINE);
+    internal->start_function_ptr = start_function_ptr;
+    internal->params = params;
+    internal->fiber = CreateFiber(stack_size, win32_fiber_entry, internal);
+    if (!internal->fiber) {
+        KERROR("kfiber_create failed to create fiber. Error: %u", GetLastError());
+        kfree(internal, sizeof(win32_fiber_internal), MEMORY_TAG_ENGINE);
+        return false;
+    }
+    out_fiber->internal_data = internal;
+    return true;
+}
+
+void kfiber_destroy(kfiber* fiber) {
+    if (fiber && fiber->internal_data) {
+        win32_fiber_internal* internal = fiber->internal_data;
+        DeleteFiber(internal->fiber);
+        kfree(internal, sizeof(win32_fiber_internal), MEMORY_TAG_ENGINE);
+        fiber->internal_data = 0;
+    }
+}
+
+void kfiber_switch(kfiber* from, kfiber* to) {
+    // SwitchToFiber saves the current context itself, so from isn't needed here.
+    (void)from;
+    win32_fiber_internal* internal = to->internal_data;
+    SwitchToFiber(internal->fiber);
+}
+
+// NOTE: End fibers.
+
 // NOTE: Begin mutexes
 b8 kmutex_create(kmutex* out_mutex) {
     if (!out_mutex) {
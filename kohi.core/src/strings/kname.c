@@ -1,58 +1,261 @@
 #include "kname.h"
 
-#include "containers/u64_bst.h"
 #include "debug/kassert.h"
 #include "logger.h"
+#include "memory/kmemory.h"
 #include "strings/kstring.h"
+#include "threads/katomic.h"
 #include "utils/crc64.h"
 
-// Global lookup table for saved names.
-static bt_node* string_lookup = 0;
+// The number of slots in the first intern table. Each further table is twice the size of the one before it.
+#define KNAME_INITIAL_TABLE_CAPACITY 4096
+// The size of each chunk of the string arena. Strings longer than this get a chunk of their own.
+#define KNAME_ARENA_CHUNK_SIZE KIBIBYTES(64)
+
+/**
+ * A slot in an intern table. The key is claimed first, then the string is published
+ * once it has been copied into the arena. Neither ever changes again afterward.
+ */
+typedef struct kname_slot {
+    kname name;
+    const char* str;
+} kname_slot;
+
+/**
+ * A fixed-size, open-addressed table of interned names. Once a table reaches its
+ * limit, new names go to the next table in the chain, which is never removed.
+ */
+typedef struct kname_table {
+    u32 capacity;
+    // The number of slots which may be claimed before names go to the next table.
+    u32 limit;
+    // The number of slots claimed or reserved for claiming. Never exceeds limit and never goes down, so a full table stays full.
+    u32 count;
+    // The number of threads part way through claiming a slot in this table.
+    u32 claiming;
+    struct kname_table* next;
+    kname_slot* slots;
+} kname_table;
+
+typedef struct kname_arena_chunk {
+    struct kname_arena_chunk* next;
+    u64 capacity;
+    u64 used;
+    char data[];
+} kname_arena_chunk;
+
+// The first table lives in static storage so that knames may be created before anything else is set up.
+static kname_slot initial_slots[KNAME_INITIAL_TABLE_CAPACITY];
+static kname_table initial_table = {
+    .capacity = KNAME_INITIAL_TABLE_CAPACITY,
+    .limit = (KNAME_INITIAL_TABLE_CAPACITY / 4) * 3,
+    .count = 0,
+    .claiming = 0,
+    .next = 0,
+    .slots = initial_slots};
+
+// The chunk the arena is currently handing out of.
+static kname_arena_chunk* arena_head = 0;
+
+// Hashes a lowercased version of the string, lowercasing a piece at a time on the stack.
+static kname hash_lowercase(const char* str, u64 length) {
+    char buffer[256];
+    u64 crc = 0;
+    for (u64 offset = 0; offset < length; offset += sizeof(buffer)) {
+        u64 piece_length = KMIN(length - offset, sizeof(buffer));
+        for (u64 i = 0; i < piece_length; ++i) {
+            char c = str[offset + i];
+            buffer[i] = codepoint_is_upper(c) ? c + ('a' - 'A') : c;
+        }
+        crc = crc64(crc, (const u8*)buffer, piece_length);
+    }
+    return crc;
+}
+
+// Copies the string into the arena, which is append-only and never freed.
+static const char* arena_copy(const char* str, u64 length) {
+    u64 size = length + 1;
+    for (;;) {
+        kname_arena_chunk* chunk = katomic_load_ptr((void* const*)&arena_head);
+        if (chunk) {
+            u64 offset = katomic_fetch_add_u64(&chunk->used, size);
+            if (offset + size <= chunk->capacity) {
+                char* copy = chunk->data + offset;
+                kcopy_memory(copy, str, length);
+                copy[length] = 0;
+                return copy;
+            }
+        }
+
+        // Out of room (or no chunk yet), so start a new one. Whatever was left over in the old chunk is abandoned.
+        u64 capacity = KMAX(KNAME_ARENA_CHUNK_SIZE, size);
+        kname_arena_chunk* new_chunk = kallocate(sizeof(kname_arena_chunk) + capacity, MEMORY_TAG_STRING);
+        new_chunk->next = chunk;
+        new_chunk->capacity = capacity;
+        new_chunk->used = 0;
+        if (!katomic_compare_exchange_ptr((void**)&arena_head, (void**)&chunk, new_chunk)) {
+            // Someone else started a new chunk first. Use theirs.
+            kfree(new_chunk, sizeof(kname_arena_chunk) + capacity, MEMORY_TAG_STRING);
+        }
+    }
+}
+
+// Mixes the name before using it as a slot index. The name is a CRC, whose low bits alone are not well spread.
+static KINLINE u32 slot_index_get(kname name, u32 mask) {
+    return (u32)((name * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+static kname_table* table_next_get(kname_table* table) {
+    kname_table* next = katomic_load_ptr((void* const*)&table->next);
+    if (next) {
+        return next;
+    }
+
+    u32 capacity = table->capacity * 2;
+    kname_table* new_table = kallocate(sizeof(kname_table) + (sizeof(kname_slot) * capacity), MEMORY_TAG_STRING);
+    new_table->capacity = capacity;
+    new_table->limit = (capacity / 4) * 3;
+    new_table->count = 0;
+    new_table->claiming = 0;
+    new_table->next = 0;
+    new_table->slots = (kname_slot*)((u8*)new_table + sizeof(kname_table));
+    if (!katomic_compare_exchange_ptr((void**)&table->next, (void**)&next, new_table)) {
+        // Someone else added one first. Use theirs.
+        kfree(new_table, sizeof(kname_table) + (sizeof(kname_slot) * capacity), MEMORY_TAG_STRING);
+        return next;
+    }
+    return new_table;
+}
+
+// Finds the slot holding the given name in the given table, or 0 if it is not there.
+static kname_slot* table_slot_find(kname_table* table, kname name) {
+    u32 mask = table->capacity - 1;
+    u32 index = slot_index_get(name, mask);
+    for (u32 i = 0; i < table->capacity; ++i) {
+        kname_slot* slot = &table->slots[index];
+        kname existing = katomic_load_u64(&slot->name);
+        if (existing == name) {
+            return slot;
+        }
+        if (existing == INVALID_KNAME) {
+            // Names are never removed, so the first empty slot ends the search in this table.
+            break;
+        }
+        index = (index + 1) & mask;
+    }
+    return 0;
+}
+
+// Finds the slot holding the given name, or 0 if it has not been interned.
+static kname_slot* slot_find(kname name) {
+    for (kname_table* table = &initial_table; table; table = katomic_load_ptr((void* const*)&table->next)) {
+        kname_slot* slot = table_slot_find(table, name);
+        if (slot) {
+            return slot;
+        }
+    }
+    return 0;
+}
+
+// Reserves room for one more name in the given table, unless it has reached its limit.
+static b8 table_reserve(kname_table* table) {
+    u32 count = katomic_load_u32(&table->count);
+    while (count < table->limit) {
+        if (katomic_compare_exchange_u32(&table->count, &count, count + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Claims a slot for the given name, or returns 0 if it was already claimed. Searching and claiming
+// are one step so that two threads interning the same name at once cannot both claim it in one table.
+static kname_slot* slot_claim(kname name) {
+    kname_table* table = &initial_table;
+    for (;;) {
+        // Announced before reserving, so a thread which then finds the table full knows to wait for this claim.
+        if (katomic_load_u32(&table->count) < table->limit) {
+            katomic_fetch_add_u32(&table->claiming, 1);
+            if (table_reserve(table)) {
+                // Fewer slots are claimed than reserved, and the limit is below capacity, so there is always an empty slot.
+                // NOTE: A reservation left unused because another thread claimed the same name is never given back,
+                // as that could reopen a full table. It only costs a slot, and only in that rare race.
+                u32 mask = table->capacity - 1;
+                u32 index = slot_index_get(name, mask);
+                for (u32 i = 0; i < table->capacity; ++i) {
+                    kname_slot* slot = &table->slots[index];
+                    kname existing = katomic_load_u64(&slot->name);
+                    if (existing == INVALID_KNAME && katomic_compare_exchange_u64(&slot->name, &existing, name)) {
+                        katomic_fetch_sub_u32(&table->claiming, 1);
+                        return slot;
+                    }
+                    if (existing == name) {
+                        // Already claimed, possibly by another thread just now.
+                        katomic_fetch_sub_u32(&table->claiming, 1);
+                        return 0;
+                    }
+                    index = (index + 1) & mask;
+                }
+            }
+            katomic_fetch_sub_u32(&table->claiming, 1);
+        }
+
+        // The table is full, and stays that way. Claims still underway in it may be for this same name, so
+        // let them land, then check once more before moving on. Otherwise the name could be claimed in both.
+        while (katomic_load_u32(&table->claiming)) {
+            katomic_cpu_relax();
+        }
+        if (table_slot_find(table, name)) {
+            return 0;
+        }
+        table = table_next_get(table);
+    }
+}
 
 kname kname_create(const char* str) {
-    if (!str || string_length(str) == 0) {
+    if (!str) {
+        return INVALID_KNAME;
+    }
+    u64 length = string_length(str);
+    if (length == 0) {
         return INVALID_KNAME;
     }
-
-    // Take a copy of the string to hash.
-    char* copy = string_duplicate(str);
-    // Convert it to lowercase _before_ hashing.
-    string_to_lower(copy);
 
     // Hash the lowercase string.
-    kname name = crc64(0, (const u8*)copy, string_length(copy));
+    kname name = hash_lowercase(str, length);
     // NOTE: A hash of 0 is never allowed.
-    KASSERT_MSG(name != 0, string_format("kname_create - provided string '%s' hashed to 0, an invalid value. Please change the string to something else to avoid this.", str));
-
-    // Dispose of the lowercase string.
-    string_free(copy);
+    KASSERT_MSG(name != 0, "kname_create - provided string hashed to 0, an invalid value. Please change the string to something else to avoid this.");
 
-    // Register in a global lookup table if not already there.
-    const bt_node* entry = u64_bst_find(string_lookup, name);
-    if (!entry) {
+    // Register in the global lookup table if not already there.
+    if (slot_find(name)) {
+        return name;
+    }
+    kname_slot* slot = slot_claim(name);
+    if (slot) {
         // Take a copy in case it was dynamically allocated and might
         // later be freed. Storing a copy of the *original* string for reference,
         // even though this is _not_ what is used for lookup.
-        bt_node_value value;
-        value.str = string_duplicate(str);
-        bt_node* inserted = u64_bst_insert(string_lookup, name, value);
-        if (!inserted) {
-            KERROR("Failed to save kname string '%s' to global lookup table.");
-        } else if (!string_lookup) {
-            string_lookup = inserted;
-        }
+        katomic_store_ptr((void**)&slot->str, (void*)arena_copy(str, length));
     }
     return name;
 }
 
 const char* kname_string_get(kname name) {
-
-    const bt_node* entry = u64_bst_find(string_lookup, name);
-    if (entry) {
-        // NOTE: For now, just return the existing pointer to the string.
-        // If this ever becomes a problem, return a copy instead.
-        return entry->value.str;
+    if (name == INVALID_KNAME) {
+        return 0;
+    }
+    kname_slot* slot = slot_find(name);
+    if (!slot) {
+        return 0;
     }
 
-    return 0;
+    // The name may have been claimed but its string not yet published. That only
+    // takes as long as copying the string, so wait it out.
+    const char* str;
+    while (!(str = katomic_load_ptr((void* const*)&slot->str))) {
+        katomic_cpu_relax();
+    }
+    // NOTE: For now, just return the existing pointer to the string.
+    // If this ever becomes a problem, return a copy instead.
+    return str;
 }
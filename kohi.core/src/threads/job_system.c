@@ -0,0 +1,1388 @@
+#include "job_system.h"
+
+#include "containers/bitset.h"
+#include "containers/mpmc_queue.h"
+#include "containers/mpsc_queue.h"
+#include "containers/ws_deque.h"
+#include "defines.h"
+#include "debug/kassert.h"
+#include "memory/kmemory.h"
+#include "platform/platform.h"
+#include "strings/kstring.h"
+#include "threads/katomic.h"
+#include "threads/kfiber.h"
+#include "threads/ksemaphore.h"
+#include "threads/kthread.h"
+#include "logger.h"
+
+// The max number of jobs which may be submitted but not yet started at once.
+#define MAX_JOBS 4096
+// The max number of jobs each job thread can hold in its own deque per priority.
+#define JOB_DEQUE_CAPACITY 1024
+// The number of job types (JOB_TYPE_GENERAL onward, one bit each).
+#define JOB_TYPE_COUNT 3
+// The number of job priorities.
+#define JOB_PRIORITY_COUNT 3
+// The max number of (dependency, dependent job) links which may be waiting at once.
+#define MAX_JOB_CONTINUATIONS (MAX_JOBS * 4)
+// Data too large to be held inline is held in blocks of this size, taken from a pool.
+#define JOB_DATA_BLOCK_SIZE 1024
+// The number of blocks in the pool. Data which doesn't fit, or arrives once the pool
+// has run dry, is allocated from the heap instead.
+#define JOB_DATA_BLOCK_COUNT 1024
+// The number of pooled result entries. As with data blocks, more are allocated if needed.
+#define JOB_RESULT_POOL_SIZE 1024
+// The max number of fibers that fiber jobs may be running (or suspended) on at once.
+// Each is created the first time it is needed.
+#define JOB_FIBER_COUNT 64
+// The stack size of each fiber.
+#define JOB_FIBER_STACK_SIZE KIBIBYTES(256)
+// The max number of jobs which may be created but not yet complete at once. Each such
+// job holds a slot, which is reused (with a new generation) once the job completes.
+#define JOB_SLOT_COUNT 16384
+// Stats are gathered per job thread, then one more set shared by all other threads.
+#define JOB_THREAD_STATS_COUNT (JOB_MAX_THREAD_COUNT + 1)
+#define OTHER_THREAD_STATS_INDEX JOB_MAX_THREAD_COUNT
+
+// Marks the continuation list of a job slot as empty.
+#define CONTINUATION_LIST_EMPTY INVALID_ID
+// Marks the continuation list of a job slot as closed, because the job has completed.
+#define CONTINUATION_LIST_SEALED (INVALID_ID - 1)
+
+// Each slot packs the generation of its current job together with the head of that
+// job's continuation list, so both can be changed in one atomic operation.
+#define SLOT_WORD(generation, head) (((u64)(generation) << 32) | (u64)(head))
+#define SLOT_WORD_GENERATION(word) ((u16)((word) >> 32))
+#define SLOT_WORD_HEAD(word) ((u32)(word))
+
+// Counters for the jobs run on one thread. Only ever added to, atomically.
+typedef struct job_thread_stats {
+    u64 jobs_run;
+    // Time spent running jobs, not counting jobs run while waiting within another job.
+    u64 busy_us;
+    u64 wait_histogram[JOB_LATENCY_BUCKET_COUNT];
+    u64 run_histogram[JOB_LATENCY_BUCKET_COUNT];
+} job_thread_stats;
+
+typedef struct job_thread {
+    u8 index;
+    kthread thread;
+
+    // Used to cause a thread to block until work is available.
+    ksemaphore semaphore;
+    // Nonzero while the thread is (about to be) blocked on its semaphore. Whoever
+    // changes it back to 0 is responsible for signaling the semaphore.
+    u32 sleeping;
+
+    // The types of jobs this thread can handle.
+    u32 type_mask;
+
+    // General jobs submitted by this thread, one deque per priority. Popped by this
+    // thread from the bottom, and stolen by other general job threads from the top.
+    ws_deque deques[JOB_PRIORITY_COUNT];
+} job_thread;
+
+struct job_fiber_host;
+
+// A fiber which fiber jobs are run on. Returned to the pool once its job completes.
+typedef struct job_fiber {
+    kfiber fiber;
+    u32 index;
+    // The job being run.
+    job_info info;
+    // The thread the fiber is currently running on. Set by whichever thread switches to it,
+    // since a suspended fiber may be resumed on a different thread than it started on.
+    struct job_fiber_host* host;
+} job_fiber;
+
+// Per-thread state for running fibers, for each thread which has run a fiber job.
+typedef struct job_fiber_host {
+    // The thread's own context, switched back to whenever a fiber completes or yields.
+    kfiber fiber;
+    b8 converted;
+    // The fiber running on this thread, if any.
+    job_fiber* current;
+    // Set by a fiber before switching back, to tell the thread it has completed its job.
+    job_fiber* completed;
+    // Set by a fiber before switching back, to have the thread suspend it until the given job completes.
+    job_fiber* yielded;
+    khandle16 yielded_until;
+} job_fiber_host;
+
+// Links a job waiting on a dependency into that dependency's continuation list.
+typedef struct job_continuation {
+    // The index of the waiting job in the job pool.
+    u32 job_index;
+    // The next continuation in the list.
+    u32 next;
+} job_continuation;
+
+// Describes a loop being split across job threads by job_system_parallel_for()/reduce().
+// Lives on the stack of the thread which started it.
+typedef struct parallel_task {
+    u32 count;
+    u32 grain;
+    u32 chunk_count;
+    // The next chunk to be taken. Incremented atomically by each participant.
+    u32 next_chunk;
+    // The number of participants which have started. Each takes the partial result of the same index.
+    u32 next_participant;
+    void* context;
+    pfn_job_parallel_for for_fn;
+    pfn_job_parallel_reduce reduce_fn;
+    // For reductions, one partial result per participant, result_size bytes apiece.
+    u8* partials;
+    u32 result_size;
+} parallel_task;
+
+// The largest combined size of partial results held on the stack during a reduce.
+#define PARALLEL_REDUCE_STACK_SIZE 1024
+// When no grain is given, loops are split into about this many chunks per participating thread.
+#define PARALLEL_CHUNKS_PER_THREAD 4
+
+// A completed job's callback, waiting to be run on the main thread. The job writes its
+// result straight into the entry, so it never needs to be copied.
+typedef struct job_result_entry {
+    // Must be first, so the entry can be recovered from the node.
+    mpsc_queue_node node;
+    pfn_job_on_complete callback;
+    u32 param_size;
+    // Either inline_data, or a data block when the result is too large for it.
+    void* params;
+    u8 inline_data[JOB_INLINE_DATA_SIZE];
+} job_result_entry;
+
+typedef struct job_system_state {
+    u32 running;
+    u8 thread_count;
+    job_thread job_threads[JOB_MAX_THREAD_COUNT];
+    // The number of job threads which take general jobs.
+    u8 general_thread_count;
+
+    // One bit per job slot, set from when a job is created until it completes.
+    bitset busy_slots;
+    // Per job slot, the generation and continuation list head of its job (see SLOT_WORD).
+    u64* slot_words;
+    // Where the next search for a free slot starts. Incremented atomically, since jobs
+    // may be created from any thread.
+    u32 next_slot_hint;
+
+    // Submitted jobs are held here until they run. Queues and deques refer to them by index.
+    job_info* jobs;
+    // Indices of unused entries in jobs.
+    mpmc_queue free_jobs;
+    // For each job in the pool, the number of dependencies (plus one while being
+    // submitted) yet to complete. The job is scheduled when this reaches 0.
+    u32* pending_counts;
+
+    job_continuation* continuations;
+    // Indices of unused entries in continuations.
+    mpmc_queue free_continuations;
+
+    // Jobs submitted from outside a job thread, or which must run on a specific type of
+    // thread. Indexed by type, then priority. Any thread of a matching type may take from these.
+    mpmc_queue queues[JOB_TYPE_COUNT][JOB_PRIORITY_COUNT];
+
+    // Completed jobs' callbacks, pushed by job threads and drained by the main thread.
+    mpsc_queue pending_results;
+    job_result_entry* result_pool;
+    // Indices of unused entries in result_pool.
+    mpmc_queue free_results;
+
+    // For each job in the pool, when it was made ready to run, in microseconds.
+    u64* ready_times;
+    job_thread_stats thread_stats[JOB_THREAD_STATS_COUNT];
+    u64 submitted_counts[JOB_TYPE_COUNT];
+    u64 completed_counts[JOB_TYPE_COUNT];
+    // When the stats were last reset, in microseconds.
+    u64 stats_start_us;
+
+    // Fibers for fiber jobs to run on, created as needed.
+    job_fiber* fibers;
+    // The number of fibers created so far. May briefly overshoot JOB_FIBER_COUNT.
+    u32 fiber_count;
+    // Indices of idle fibers.
+    mpmc_queue free_fibers;
+    // For each job in the pool, the suspended fiber to resume if this is a resumption
+    // rather than a new job. 0 otherwise.
+    job_fiber** resume_fibers;
+
+    // Blocks of JOB_DATA_BLOCK_SIZE for data too large to be held inline.
+    u8* data_blocks;
+    // Indices of unused blocks in data_blocks.
+    mpmc_queue free_data_blocks;
+} job_system_state;
+
+static job_system_state* state_ptr;
+
+// The job thread the current thread is, if any.
+static KTHREAD_LOCAL job_thread* current_job_thread = 0;
+
+// NOTE: A fiber may be resumed on a different thread than it was suspended on, so code
+// running on a fiber must not hold on to this (or any thread-local) across a switch.
+static KTHREAD_LOCAL job_fiber_host fiber_host;
+
+static KINLINE u64 time_now_us(void) {
+    return (u64)(platform_get_absolute_time() * 1000000.0);
+}
+
+// The stats of the calling thread.
+static job_thread_stats* thread_stats_get(void) {
+    job_thread* self = current_job_thread;
+    return &state_ptr->thread_stats[self ? self->index : OTHER_THREAD_STATS_INDEX];
+}
+
+// Bucket 0 holds durations under 1us, and bucket i holds [2^(i-1), 2^i)us. The last holds everything beyond.
+static u32 latency_bucket_get(u64 us) {
+    u32 bucket = 0;
+    while (us && bucket < JOB_LATENCY_BUCKET_COUNT - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static b8 type_index_get(job_type type, u32* out_index) {
+    switch (type) {
+    case JOB_TYPE_GENERAL:
+        *out_index = 0;
+        return true;
+    case JOB_TYPE_RESOURCE_LOAD:
+        *out_index = 1;
+        return true;
+    case JOB_TYPE_GPU_RESOURCE:
+        *out_index = 2;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Obtains a block of at least the given size, from the pool if possible.
+static void* job_data_allocate(u32 size) {
+    u32 index;
+    if (size <= JOB_DATA_BLOCK_SIZE && mpmc_queue_dequeue(&state_ptr->free_data_blocks, &index)) {
+        return state_ptr->data_blocks + ((u64)JOB_DATA_BLOCK_SIZE * index);
+    }
+    return kallocate(size, MEMORY_TAG_JOB);
+}
+
+static void job_data_free(void* block, u32 size) {
+    u8* data = block;
+    u8* pool_end = state_ptr->data_blocks + ((u64)JOB_DATA_BLOCK_SIZE * JOB_DATA_BLOCK_COUNT);
+    if (data >= state_ptr->data_blocks && data < pool_end) {
+        u32 index = (u32)((data - state_ptr->data_blocks) / JOB_DATA_BLOCK_SIZE);
+        mpmc_queue_enqueue(&state_ptr->free_data_blocks, &index);
+    } else {
+        kfree(block, size, MEMORY_TAG_JOB);
+    }
+}
+
+// Obtains the data to be passed to the job's entry point.
+static void* job_params_get(job_info* info) {
+    // Param data with no size is borrowed (see job_system_parallel_for()), and passed as-is.
+    if (info->param_data_size && info->param_data_size <= JOB_INLINE_DATA_SIZE) {
+        return info->inline_data;
+    }
+    return info->param_data;
+}
+
+static const khandle16* job_dependencies_get(const job_info* info) {
+    return info->dependency_count <= JOB_INLINE_DEPENDENCY_COUNT ? info->inline_dependencies : info->dependency_ids;
+}
+
+static void job_info_free(job_info* info) {
+    // Param data with no size is borrowed, not owned.
+    if (info->param_data && info->param_data_size) {
+        job_data_free(info->param_data, info->param_data_size);
+    }
+    if (info->dependency_ids) {
+        job_data_free(info->dependency_ids, sizeof(khandle16) * info->dependency_count);
+    }
+    kzero_memory(info, sizeof(job_info));
+}
+
+// Obtains a zeroed result entry with room for a result of the given size, from the pool if possible.
+static job_result_entry* result_entry_acquire(u32 param_size) {
+    job_result_entry* entry;
+    u32 index;
+    if (mpmc_queue_dequeue(&state_ptr->free_results, &index)) {
+        entry = &state_ptr->result_pool[index];
+        kzero_memory(entry, sizeof(job_result_entry));
+    } else {
+        entry = kallocate(sizeof(job_result_entry), MEMORY_TAG_JOB);
+    }
+    entry->param_size = param_size;
+    if (param_size > JOB_INLINE_DATA_SIZE) {
+        entry->params = job_data_allocate(param_size);
+        kzero_memory(entry->params, param_size);
+    } else {
+        entry->params = entry->inline_data;
+    }
+    return entry;
+}
+
+static void result_entry_release(job_result_entry* entry) {
+    if (entry->params != entry->inline_data) {
+        job_data_free(entry->params, entry->param_size);
+    }
+    if (entry >= state_ptr->result_pool && entry < state_ptr->result_pool + JOB_RESULT_POOL_SIZE) {
+        u32 index = (u32)(entry - state_ptr->result_pool);
+        mpmc_queue_enqueue(&state_ptr->free_results, &index);
+    } else {
+        kfree(entry, sizeof(job_result_entry), MEMORY_TAG_JOB);
+    }
+}
+
+// Runs the callbacks of the given results, oldest first, and releases them.
+static void results_process(mpsc_queue_node* node) {
+    while (node) {
+        job_result_entry* entry = (job_result_entry*)node;
+        node = node->next;
+        entry->callback(entry->param_size ? entry->params : 0);
+        result_entry_release(entry);
+    }
+}
+
+// Wakes one sleeping job thread which can handle the given type of job, other than the one given.
+static void wake_thread(u32 type, const job_thread* except) {
+    // Pairs with the fence a thread makes between flagging itself as sleeping and
+    // checking for work one last time, so either it sees the new job or it is seen here.
+    katomic_thread_fence();
+    for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+        job_thread* thread = &state_ptr->job_threads[i];
+        if (thread == except || (thread->type_mask & type) == 0 || !katomic_load_u32(&thread->sleeping)) {
+            continue;
+        }
+        if (katomic_exchange_u32(&thread->sleeping, 0)) {
+            ksemaphore_signal(&thread->semaphore);
+            return;
+        }
+    }
+}
+
+// Makes the job at the given index available to be run.
+static void job_schedule(u32 job_index) {
+    job_info* info = &state_ptr->jobs[job_index];
+    state_ptr->ready_times[job_index] = time_now_us();
+    u32 type_index = 0;
+    type_index_get(info->type, &type_index);
+    u32 priority = (u32)info->priority < JOB_PRIORITY_COUNT ? (u32)info->priority : JOB_PRIORITY_NORMAL;
+
+    // General jobs submitted from a general job thread stay with that thread (which is
+    // likely to have the data they need in cache) unless another thread steals them.
+    job_thread* self = current_job_thread;
+    if (self && info->type == JOB_TYPE_GENERAL && (self->type_mask & JOB_TYPE_GENERAL)) {
+        if (ws_deque_push(&self->deques[priority], job_index)) {
+            wake_thread(JOB_TYPE_GENERAL, self);
+            return;
+        }
+    }
+
+    // NOTE: The queue is lock-free, since the job may be submitted from another job/thread.
+    // Its capacity matches the job pool, so it cannot be full.
+    if (!mpmc_queue_enqueue(&state_ptr->queues[type_index][priority], &job_index)) {
+        KERROR("Job queue is full. Job will not be run.");
+        return;
+    }
+    wake_thread(info->type, 0);
+}
+
+/**
+ * Looks for a job of the given types, highest priority first. Within a priority, the
+ * thread's own deque (if it is a job thread) is checked first, then the shared queues,
+ * then other threads' deques.
+ */
+static b8 job_find(job_thread* thread, u32 type_mask, u32* out_job_index) {
+    b8 general = (type_mask & JOB_TYPE_GENERAL) != 0;
+    for (i32 p = JOB_PRIORITY_COUNT - 1; p >= 0; --p) {
+        u64 value;
+        if (thread && general && ws_deque_pop(&thread->deques[p], &value)) {
+            *out_job_index = (u32)value;
+            return true;
+        }
+
+        for (u32 t = 0; t < JOB_TYPE_COUNT; ++t) {
+            if ((type_mask & (JOB_TYPE_GENERAL << t)) && mpmc_queue_dequeue(&state_ptr->queues[t][p], out_job_index)) {
+                return true;
+            }
+        }
+
+        // Only general jobs are ever held in deques, so only general threads steal.
+        if (general) {
+            u8 start = thread ? thread->index : 0;
+            for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+                job_thread* victim = &state_ptr->job_threads[(start + i) % state_ptr->thread_count];
+                if (victim != thread && ws_deque_steal(&victim->deques[p], &value)) {
+                    *out_job_index = (u32)value;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// Counts down one of the things the job at the given index is waiting on, scheduling it if that was the last.
+static void job_release(u32 job_index) {
+    if (katomic_fetch_sub_u32(&state_ptr->pending_counts[job_index], 1) == 1) {
+        job_schedule(job_index);
+    }
+}
+
+/**
+ * Adds the job at the given index to the list of jobs to be released when the job with
+ * the given handle completes. Returns false if that job has already completed, in which
+ * case nothing is added.
+ */
+static b8 continuation_add(khandle16 dependency, u32 job_index) {
+    u32 continuation_index;
+    if (!mpmc_queue_dequeue(&state_ptr->free_continuations, &continuation_index)) {
+        // Should not happen in practice. Fall back to waiting it out.
+        KERROR("Too many job dependencies are pending (max %u). Waiting for job %u to complete before continuing.", MAX_JOB_CONTINUATIONS, dependency.handle_index);
+        job_system_wait_for_jobs(1, &dependency);
+        return false;
+    }
+    job_continuation* continuation = &state_ptr->continuations[continuation_index];
+    continuation->job_index = job_index;
+
+    u64* word = &state_ptr->slot_words[dependency.handle_index];
+    u64 current = katomic_load_u64(word);
+    do {
+        if (SLOT_WORD_GENERATION(current) != dependency.generation || SLOT_WORD_HEAD(current) == CONTINUATION_LIST_SEALED) {
+            // Already complete, and perhaps the slot has since been reused.
+            mpmc_queue_enqueue(&state_ptr->free_continuations, &continuation_index);
+            return false;
+        }
+        continuation->next = SLOT_WORD_HEAD(current);
+    } while (!katomic_compare_exchange_u64(word, &current, SLOT_WORD(dependency.generation, continuation_index)));
+    return true;
+}
+
+/**
+ * Takes a free job slot, and gives it a new generation for the job about to be created.
+ * A slot is free once its last job completed, so outstanding handles to that job simply
+ * see it as complete from then on.
+ */
+static khandle16 slot_acquire(void) {
+    u32 start = katomic_fetch_add_u32(&state_ptr->next_slot_hint, 1) % JOB_SLOT_COUNT;
+    b8 warned = false;
+    while (true) {
+        u32 slot;
+        if (bitset_find_first_clear(&state_ptr->busy_slots, start, &slot) || bitset_find_first_clear(&state_ptr->busy_slots, 0, &slot)) {
+            if (bitset_set_atomic(&state_ptr->busy_slots, slot)) {
+                // Another thread got there first. Look again.
+                continue;
+            }
+
+            u16 generation = SLOT_WORD_GENERATION(katomic_load_u64(&state_ptr->slot_words[slot])) + 1;
+            if (generation == INVALID_ID_U16) {
+                generation = 0;
+            }
+            katomic_store_u64(&state_ptr->slot_words[slot], SLOT_WORD(generation, CONTINUATION_LIST_EMPTY));
+            return khandle16_create_with_u16_generation((u16)slot, generation);
+        }
+
+        // Every slot is taken. Wait for some jobs to complete rather than failing.
+        if (!warned) {
+            KERROR("Too many jobs are incomplete (max %u). Waiting for one to complete before creating another.", JOB_SLOT_COUNT);
+            warned = true;
+        }
+        kthread_yield();
+    }
+}
+
+// Marks the job with the given handle as complete, releases every job waiting on it, then frees its slot.
+static void job_complete(khandle16 handle) {
+    // Sealing the list means nothing more can be added to it, so it can be walked freely.
+    // The generation stays the same, so the job reads as complete from here on.
+    u64* word = &state_ptr->slot_words[handle.handle_index];
+    u64 current = katomic_load_u64(word);
+    while (!katomic_compare_exchange_u64(word, &current, SLOT_WORD(handle.generation, CONTINUATION_LIST_SEALED))) {
+    }
+
+    u32 index = SLOT_WORD_HEAD(current);
+    while (index != CONTINUATION_LIST_EMPTY && index != CONTINUATION_LIST_SEALED) {
+        job_continuation* continuation = &state_ptr->continuations[index];
+        u32 next = continuation->next;
+        u32 job_index = continuation->job_index;
+        mpmc_queue_enqueue(&state_ptr->free_continuations, &index);
+        job_release(job_index);
+        index = next;
+    }
+
+    bitset_clear_atomic(&state_ptr->busy_slots, handle.handle_index);
+}
+
+// Runs the given job to completion on the current context, then frees it.
+static void job_execute(job_info* job) {
+    job_info info = *job;
+
+    // If the result is going to be handed to a callback, it is written straight into the
+    // entry which carries it to the main thread. Otherwise it just needs somewhere to go.
+    job_result_entry* entry = 0;
+    void* result_data = 0;
+    u8 local_result[JOB_INLINE_DATA_SIZE];
+    if (info.on_success || info.on_fail) {
+        entry = result_entry_acquire(info.result_data_size);
+        result_data = entry->params;
+    } else if (info.result_data_size > JOB_INLINE_DATA_SIZE) {
+        result_data = job_data_allocate(info.result_data_size);
+        kzero_memory(result_data, info.result_data_size);
+    } else if (info.result_data_size) {
+        kzero_memory(local_result, info.result_data_size);
+        result_data = local_result;
+    }
+
+    b8 result = info.entry_point(job_params_get(&info), info.result_data_size ? result_data : 0);
+
+    if (entry) {
+        // Queue the result to be handed to the callback on the main thread later.
+        entry->callback = result ? info.on_success : info.on_fail;
+        if (entry->callback) {
+            // NOTE: Lock-free and unbounded, so this never waits on the main thread and no result is dropped.
+            mpsc_queue_push(&state_ptr->pending_results, &entry->node);
+        } else {
+            result_entry_release(entry);
+        }
+    } else if (result_data && result_data != local_result) {
+        job_data_free(result_data, info.result_data_size);
+    }
+
+    u32 type_index = 0;
+    type_index_get(info.type, &type_index);
+    katomic_fetch_add_u64(&state_ptr->completed_counts[type_index], 1);
+
+    // Clear the param data and dependencies.
+    khandle16 id = info.id;
+    job_info_free(&info);
+
+    // Update the job status for this job, and start anything which was waiting on it.
+    job_complete(id);
+}
+
+static void job_fiber_main(void* params) {
+    job_fiber* fiber = params;
+    while (true) {
+        job_execute(&fiber->info);
+
+        // Hand the fiber back to whichever thread it is on by now, to be returned to the pool.
+        job_fiber_host* host = fiber->host;
+        host->completed = fiber;
+        kfiber_switch(&fiber->fiber, &host->fiber);
+    }
+}
+
+// Obtains the fiber state of the calling thread, preparing it to run fibers if it hasn't yet.
+static job_fiber_host* fiber_host_get(void) {
+    job_fiber_host* host = &fiber_host;
+    if (!host->converted) {
+        if (!kfiber_thread_convert(&host->fiber)) {
+            return 0;
+        }
+        host->converted = true;
+    }
+    return host;
+}
+
+// Obtains an idle fiber, creating one if needed. Returns 0 if the limit has been reached.
+static job_fiber* fiber_acquire(void) {
+    u32 index;
+    if (mpmc_queue_dequeue(&state_ptr->free_fibers, &index)) {
+        return &state_ptr->fibers[index];
+    }
+
+    index = katomic_fetch_add_u32(&state_ptr->fiber_count, 1);
+    if (index >= JOB_FIBER_COUNT) {
+        katomic_fetch_sub_u32(&state_ptr->fiber_count, 1);
+        return 0;
+    }
+    job_fiber* fiber = &state_ptr->fibers[index];
+    fiber->index = index;
+    if (!kfiber_create(JOB_FIBER_STACK_SIZE, job_fiber_main, fiber, &fiber->fiber)) {
+        // The slot stays unused.
+        KERROR("Failed to create a fiber for fiber jobs.");
+        return 0;
+    }
+    return fiber;
+}
+
+static void job_run(u32 job_index);
+
+// Suspends the given fiber until the job with the given handle completes, then schedules it to be resumed.
+static void fiber_suspend(job_fiber* fiber, khandle16 until) {
+    // The fiber is resumed from the job pool like any other job, so the right type of thread picks it up.
+    u32 job_index;
+    while (!mpmc_queue_dequeue(&state_ptr->free_jobs, &job_index)) {
+        // Should not happen in practice. Run other jobs until one frees up an entry.
+        job_thread* self = current_job_thread;
+        u32 other_index;
+        if (job_find(self, self ? self->type_mask : JOB_TYPE_GENERAL, &other_index)) {
+            job_run(other_index);
+        } else {
+            kthread_yield();
+        }
+    }
+    kzero_memory(&state_ptr->jobs[job_index], sizeof(job_info));
+    state_ptr->jobs[job_index].type = fiber->info.type;
+    state_ptr->jobs[job_index].priority = fiber->info.priority;
+    state_ptr->resume_fibers[job_index] = fiber;
+
+    katomic_store_u32(&state_ptr->pending_counts[job_index], 1);
+    if (!continuation_add(until, job_index)) {
+        // Already complete.
+        job_release(job_index);
+    }
+}
+
+// Switches to the given fiber, then deals with whatever it left for this thread to do when it switched back.
+static void fiber_enter(job_fiber_host* host, job_fiber* fiber) {
+    fiber->host = host;
+    host->current = fiber;
+    kfiber_switch(&host->fiber, &fiber->fiber);
+    host->current = 0;
+
+    // NOTE: This only happens once the fiber has switched away, so nothing else can resume
+    // it while its context is still being saved.
+    if (host->completed) {
+        job_fiber* completed = host->completed;
+        host->completed = 0;
+        mpmc_queue_enqueue(&state_ptr->free_fibers, &completed->index);
+    } else if (host->yielded) {
+        job_fiber* yielded = host->yielded;
+        host->yielded = 0;
+        fiber_suspend(yielded, host->yielded_until);
+    }
+}
+
+// Starts the job at the given index, or resumes it if it is a fiber job which yielded.
+static void job_dispatch(u32 job_index) {
+    // Dependencies are complete by the time a job is scheduled.
+    job_info info = state_ptr->jobs[job_index];
+    job_fiber* resume = state_ptr->resume_fibers[job_index];
+
+    // The job has been copied out, so its entry can be reused.
+    kzero_memory(&state_ptr->jobs[job_index], sizeof(job_info));
+    state_ptr->resume_fibers[job_index] = 0;
+    mpmc_queue_enqueue(&state_ptr->free_jobs, &job_index);
+
+    if (resume) {
+        // A fiber job which yielded, and whatever it was waiting on is complete.
+        job_fiber_host* host = fiber_host_get();
+        if (!host) {
+            KFATAL("Unable to resume fiber job, as this thread cannot run fibers.");
+            return;
+        }
+        fiber_enter(host, resume);
+        return;
+    }
+
+    if (info.flags & JOB_FLAG_FIBER) {
+        job_fiber_host* host = fiber_host_get();
+        job_fiber* fiber = host ? fiber_acquire() : 0;
+        if (fiber) {
+            fiber->info = info;
+            fiber_enter(host, fiber);
+            return;
+        }
+        // No fiber to be had, so run it here. If it yields, it simply waits instead.
+    }
+
+    job_execute(&info);
+}
+
+// Frees a job which will not be run, and completes it so nothing waits on it forever.
+static void job_discard(job_info* info) {
+    khandle16 id = info->id;
+    job_info_free(info);
+    if (!khandle16_is_invalid(id) && id.handle_index < JOB_SLOT_COUNT) {
+        job_complete(id);
+    }
+}
+
+// Runs the job at the given index, recording how long it waited and ran for.
+static void job_run(u32 job_index) {
+    u64 start = time_now_us();
+    u64 ready = state_ptr->ready_times[job_index];
+    job_dispatch(job_index);
+    u64 end = time_now_us();
+
+    job_thread_stats* stats = thread_stats_get();
+    katomic_fetch_add_u64(&stats->jobs_run, 1);
+    katomic_fetch_add_u64(&stats->wait_histogram[latency_bucket_get(start > ready ? start - ready : 0)], 1);
+    katomic_fetch_add_u64(&stats->run_histogram[latency_bucket_get(end - start)], 1);
+}
+
+// Runs the job at the given index on a job thread, counting the time towards the thread's busy time.
+static void job_thread_job_run(job_thread* thread, u32 job_index) {
+    u64 start = time_now_us();
+    job_run(job_index);
+    katomic_fetch_add_u64(&state_ptr->thread_stats[thread->index].busy_us, time_now_us() - start);
+}
+
+static u32 job_thread_run(void* params) {
+    u32 index = *(u8*)params;
+    job_thread* thread = &state_ptr->job_threads[index];
+    current_job_thread = thread;
+    KTRACE("Starting job thread #%i (id=%#x, type=%#x).", thread->index, thread->thread.thread_id, thread->type_mask);
+
+    // Run until shut down, taking jobs as they become available.
+    while (true) {
+        u32 job_index;
+        if (job_find(thread, thread->type_mask, &job_index)) {
+            job_thread_job_run(thread, job_index);
+            continue;
+        }
+
+        // Nothing to do, so flag this thread as sleeping and check one last time, in case
+        // a job was submitted before the flag could be seen.
+        katomic_store_u32(&thread->sleeping, 1);
+        katomic_thread_fence();
+        if (job_find(thread, thread->type_mask, &job_index)) {
+            if (!katomic_exchange_u32(&thread->sleeping, 0)) {
+                // Someone else cleared the flag and signaled. Take the signal so it doesn't linger.
+                ksemaphore_wait(&thread->semaphore, 0xFFFFFFFF);
+            }
+            job_thread_job_run(thread, job_index);
+            continue;
+        }
+
+        // If no longer running, shut down the thread.
+        if (!katomic_load_u32(&state_ptr->running)) {
+            break;
+        }
+
+        // Wait for the semaphore to be signaled.
+        ksemaphore_wait(&thread->semaphore, 0xFFFFFFFF);
+    }
+
+    current_job_thread = 0;
+    if (fiber_host.converted) {
+        kfiber_thread_revert(&fiber_host.fiber);
+        fiber_host.converted = false;
+    }
+
+    // Hand any cached small allocations back before the thread goes away.
+    kmemory_thread_cache_flush();
+
+    return 1;
+}
+
+u8 job_system_default_thread_count(void) {
+    // One thread per physical core, as threads sharing a core compete for the same execution
+    // units. Fall back to the logical processor count if the topology isn't known. Subtract 1
+    // to account for the main thread already being in use.
+    u32 core_count = 0;
+    platform_get_physical_core_affinity_masks(&core_count, 0);
+    i32 thread_count = (core_count ? (i32)core_count : platform_get_processor_count()) - 1;
+    return (u8)KCLAMP(thread_count, 1, JOB_MAX_THREAD_COUNT);
+}
+
+b8 job_system_initialize(u64* job_system_memory_requirement, void* state, void* config) {
+    // No config means the defaults: a thread per physical core (less one), each running every type of job.
+    job_system_config default_config = {0};
+    job_system_config* typed_config = config ? (job_system_config*)config : &default_config;
+    u64 busy_slots_size = bitset_memory_requirement(JOB_SLOT_COUNT);
+    *job_system_memory_requirement = sizeof(job_system_state) + busy_slots_size + (sizeof(u64) * JOB_SLOT_COUNT);
+    if (state == 0) {
+        return true;
+    }
+
+    kzero_memory(state, sizeof(job_system_state));
+
+    state_ptr = state;
+    state_ptr->running = true;
+    bitset_create(JOB_SLOT_COUNT, (void*)((u64)state_ptr + sizeof(job_system_state)), &state_ptr->busy_slots);
+    state_ptr->slot_words = (void*)((u64)state_ptr + sizeof(job_system_state) + busy_slots_size);
+    for (u32 i = 0; i < JOB_SLOT_COUNT; ++i) {
+        state_ptr->slot_words[i] = SLOT_WORD(0, CONTINUATION_LIST_SEALED);
+    }
+
+    state_ptr->jobs = kallocate(sizeof(job_info) * MAX_JOBS, MEMORY_TAG_JOB);
+    mpmc_queue_create(sizeof(u32), MAX_JOBS, 0, &state_ptr->free_jobs);
+    for (u32 i = 0; i < MAX_JOBS; ++i) {
+        mpmc_queue_enqueue(&state_ptr->free_jobs, &i);
+    }
+    state_ptr->pending_counts = kallocate(sizeof(u32) * MAX_JOBS, MEMORY_TAG_JOB);
+    state_ptr->continuations = kallocate(sizeof(job_continuation) * MAX_JOB_CONTINUATIONS, MEMORY_TAG_JOB);
+    mpmc_queue_create(sizeof(u32), MAX_JOB_CONTINUATIONS, 0, &state_ptr->free_continuations);
+    for (u32 i = 0; i < MAX_JOB_CONTINUATIONS; ++i) {
+        mpmc_queue_enqueue(&state_ptr->free_continuations, &i);
+    }
+    for (u32 t = 0; t < JOB_TYPE_COUNT; ++t) {
+        for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+            mpmc_queue_create(sizeof(u32), MAX_JOBS, 0, &state_ptr->queues[t][p]);
+        }
+    }
+    state_ptr->result_pool = kallocate(sizeof(job_result_entry) * JOB_RESULT_POOL_SIZE, MEMORY_TAG_JOB);
+    mpmc_queue_create(sizeof(u32), JOB_RESULT_POOL_SIZE, 0, &state_ptr->free_results);
+    for (u32 i = 0; i < JOB_RESULT_POOL_SIZE; ++i) {
+        mpmc_queue_enqueue(&state_ptr->free_results, &i);
+    }
+    state_ptr->ready_times = kallocate(sizeof(u64) * MAX_JOBS, MEMORY_TAG_JOB);
+    state_ptr->stats_start_us = time_now_us();
+    state_ptr->fibers = kallocate(sizeof(job_fiber) * JOB_FIBER_COUNT, MEMORY_TAG_JOB);
+    mpmc_queue_create(sizeof(u32), JOB_FIBER_COUNT, 0, &state_ptr->free_fibers);
+    state_ptr->resume_fibers = kallocate(sizeof(job_fiber*) * MAX_JOBS, MEMORY_TAG_JOB);
+    state_ptr->data_blocks = kallocate((u64)JOB_DATA_BLOCK_SIZE * JOB_DATA_BLOCK_COUNT, MEMORY_TAG_JOB);
+    mpmc_queue_create(sizeof(u32), JOB_DATA_BLOCK_COUNT, 0, &state_ptr->free_data_blocks);
+    for (u32 i = 0; i < JOB_DATA_BLOCK_COUNT; ++i) {
+        mpmc_queue_enqueue(&state_ptr->free_data_blocks, &i);
+    }
+    state_ptr->thread_count = typed_config->max_job_thread_count ? typed_config->max_job_thread_count : job_system_default_thread_count();
+    if (state_ptr->thread_count > JOB_MAX_THREAD_COUNT) {
+        KWARN("Requested %u job threads, but the job system supports at most %u.", state_ptr->thread_count, JOB_MAX_THREAD_COUNT);
+        state_ptr->thread_count = JOB_MAX_THREAD_COUNT;
+    }
+
+    KDEBUG("Main thread id is: %#x", platform_current_thread_id());
+
+    KDEBUG("Spawning %i job threads.", state_ptr->thread_count);
+
+    // Everything a thread may touch must exist before any of them start, since jobs can be
+    // submitted to (and stolen from) any of them as soon as they do.
+    for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+        job_thread* thread = &state_ptr->job_threads[i];
+        thread->index = i;
+        // Without type masks, every thread takes every type of job.
+        thread->type_mask = typed_config->type_masks ? typed_config->type_masks[i] : (JOB_TYPE_GENERAL | JOB_TYPE_RESOURCE_LOAD | JOB_TYPE_GPU_RESOURCE);
+        if (thread->type_mask & JOB_TYPE_GENERAL) {
+            state_ptr->general_thread_count++;
+        }
+        if (!ksemaphore_create(&thread->semaphore, MAX_JOBS, 0)) {
+            KERROR("Failed to create job thread semaphore!");
+            return false;
+        }
+        for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+            ws_deque_create(JOB_DEQUE_CAPACITY, 0, &thread->deques[p]);
+        }
+    }
+
+    // Place threads one per physical core, leaving the first to the main thread unless there
+    // are more threads than cores. Threads aren't pinned where the topology isn't known.
+    u64 core_masks[64];
+    u32 core_count = 0;
+    platform_get_physical_core_affinity_masks(&core_count, 0);
+    if (core_count && core_count <= 64) {
+        platform_get_physical_core_affinity_masks(&core_count, core_masks);
+    } else {
+        core_count = 0;
+    }
+
+    for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+        job_thread* thread = &state_ptr->job_threads[i];
+        kthread_options options = {0};
+        if (core_count) {
+            options.affinity_mask = core_masks[(i + 1) % core_count];
+        }
+        if (!(thread->type_mask & JOB_TYPE_GENERAL) && (thread->type_mask & JOB_TYPE_RESOURCE_LOAD)) {
+            // Threads dedicated to loading resources spend most of their time waiting on I/O, so
+            // should get straight back to it when it completes.
+            options.name = string_format("kohi_io_%u", i);
+            options.priority = KTHREAD_PRIORITY_HIGH;
+        } else if (!(thread->type_mask & JOB_TYPE_GENERAL) && (thread->type_mask & JOB_TYPE_GPU_RESOURCE)) {
+            options.name = string_format("kohi_gpu_%u", i);
+        } else {
+            options.name = string_format("kohi_job_%u", i);
+        }
+
+        b8 created = kthread_create_with_options(job_thread_run, &thread->index, &options, false, &thread->thread);
+        string_free(options.name);
+        if (!created) {
+            KFATAL("OS Error in creating job thread. Application cannot continue.");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void job_system_shutdown(void* state) {
+    if (state_ptr) {
+        katomic_store_u32(&state_ptr->running, false);
+        katomic_thread_fence();
+
+        u64 thread_count = state_ptr->thread_count;
+
+        // Wake any sleeping threads so they notice, then wait for them all to finish.
+        for (u8 i = 0; i < thread_count; ++i) {
+            job_thread* thread = &state_ptr->job_threads[i];
+            if (katomic_exchange_u32(&thread->sleeping, 0)) {
+                ksemaphore_signal(&thread->semaphore);
+            }
+        }
+        for (u8 i = 0; i < thread_count; ++i) {
+            kthread_wait(&state_ptr->job_threads[i].thread);
+        }
+        // Threads steal from each other, so nothing can be destroyed until all have finished.
+        for (u8 i = 0; i < thread_count; ++i) {
+            job_thread* thread = &state_ptr->job_threads[i];
+            ksemaphore_destroy(&thread->semaphore);
+            for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+                ws_deque_destroy(&thread->deques[p]);
+            }
+        }
+
+        // Release anything belonging to jobs which never ran. Free entries are zeroed.
+        for (u32 i = 0; i < MAX_JOBS; ++i) {
+            job_info_free(&state_ptr->jobs[i]);
+        }
+        kfree(state_ptr->jobs, sizeof(job_info) * MAX_JOBS, MEMORY_TAG_JOB);
+        mpmc_queue_destroy(&state_ptr->free_jobs);
+        kfree(state_ptr->pending_counts, sizeof(u32) * MAX_JOBS, MEMORY_TAG_JOB);
+        kfree(state_ptr->continuations, sizeof(job_continuation) * MAX_JOB_CONTINUATIONS, MEMORY_TAG_JOB);
+        mpmc_queue_destroy(&state_ptr->free_continuations);
+        for (u32 t = 0; t < JOB_TYPE_COUNT; ++t) {
+            for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+                mpmc_queue_destroy(&state_ptr->queues[t][p]);
+            }
+        }
+        bitset_destroy(&state_ptr->busy_slots);
+
+        // Results nobody will see are released without running their callbacks.
+        mpsc_queue_node* node = mpsc_queue_take_all(&state_ptr->pending_results);
+        while (node) {
+            job_result_entry* entry = (job_result_entry*)node;
+            node = node->next;
+            result_entry_release(entry);
+        }
+        kfree(state_ptr->result_pool, sizeof(job_result_entry) * JOB_RESULT_POOL_SIZE, MEMORY_TAG_JOB);
+        mpmc_queue_destroy(&state_ptr->free_results);
+        // Any fiber jobs still suspended will never complete, so are simply dropped.
+        u32 fiber_count = KMIN(state_ptr->fiber_count, (u32)JOB_FIBER_COUNT);
+        for (u32 i = 0; i < fiber_count; ++i) {
+            kfiber_destroy(&state_ptr->fibers[i].fiber);
+        }
+        kfree(state_ptr->fibers, sizeof(job_fiber) * JOB_FIBER_COUNT, MEMORY_TAG_JOB);
+        kfree(state_ptr->ready_times, sizeof(u64) * MAX_JOBS, MEMORY_TAG_JOB);
+        mpmc_queue_destroy(&state_ptr->free_fibers);
+        kfree(state_ptr->resume_fibers, sizeof(job_fiber*) * MAX_JOBS, MEMORY_TAG_JOB);
+        if (fiber_host.converted) {
+            // This thread helped out with fiber jobs at some point.
+            kfiber_thread_revert(&fiber_host.fiber);
+            fiber_host.converted = false;
+        }
+        kfree(state_ptr->data_blocks, (u64)JOB_DATA_BLOCK_SIZE * JOB_DATA_BLOCK_COUNT, MEMORY_TAG_JOB);
+        mpmc_queue_destroy(&state_ptr->free_data_blocks);
+
+        state_ptr = 0;
+    }
+}
+
+b8 job_system_update(void* state, struct frame_data* p_frame_data) {
+    if (!state_ptr || !katomic_load_u32(&state_ptr->running)) {
+        return false;
+    }
+
+    // NOTE: Job threads take work for themselves as it is submitted, so only
+    // completion callbacks are handled here, on the main thread.
+
+    // Process pending results. Everything completed so far is taken at once, and
+    // nothing is touched beyond a single load if nothing has.
+    results_process(mpsc_queue_take_all(&state_ptr->pending_results));
+
+    return true;
+}
+
+void job_system_submit(job_info info) {
+    u32 type_index;
+    if (!type_index_get(info.type, &type_index)) {
+        KERROR("job_system_submit - job has an unknown type (%#x). Job will not be run.", info.type);
+        job_discard(&info);
+        return;
+    }
+
+    katomic_fetch_add_u64(&state_ptr->submitted_counts[type_index], 1);
+
+    u32 job_index;
+    if (!mpmc_queue_dequeue(&state_ptr->free_jobs, &job_index)) {
+        KERROR("Too many jobs are waiting to run (max %u). Job will not be run.", MAX_JOBS);
+        job_discard(&info);
+        return;
+    }
+
+    state_ptr->jobs[job_index] = info;
+    if (!info.dependency_count) {
+        job_schedule(job_index);
+        KTRACE("Job queued.");
+        return;
+    }
+
+    // Hold an extra count while hooking up dependencies, so the job can't be started
+    // (and its entry reused) by a dependency completing part way through.
+    katomic_store_u32(&state_ptr->pending_counts[job_index], (u32)info.dependency_count + 1);
+    const khandle16* dependencies = job_dependencies_get(&info);
+    for (u8 i = 0; i < info.dependency_count; ++i) {
+        khandle16 dependency = dependencies[i];
+        if (khandle16_is_invalid(dependency) || dependency.handle_index >= JOB_SLOT_COUNT || !continuation_add(dependency, job_index)) {
+            // Nothing to wait for.
+            job_release(job_index);
+        }
+    }
+    job_release(job_index);
+    KTRACE("Job submitted with %u dependencies.", info.dependency_count);
+}
+
+job_info job_create(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, u32 param_data_size, u32 result_data_size) {
+    return job_create_priority(entry_point, on_success, on_fail, param_data, param_data_size, result_data_size, JOB_TYPE_GENERAL, JOB_PRIORITY_NORMAL);
+}
+
+job_info job_create_type(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, u32 param_data_size, u32 result_data_size, job_type type) {
+    return job_create_priority(entry_point, on_success, on_fail, param_data, param_data_size, result_data_size, type, JOB_PRIORITY_NORMAL);
+}
+
+job_info job_create_priority(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, u32 param_data_size, u32 result_data_size, job_type type, job_priority priority) {
+    return job_create_with_dependencies(entry_point, on_success, on_fail, param_data, param_data_size, result_data_size, type, priority, 0, 0);
+}
+
+job_info job_create_with_dependencies(
+    pfn_job_start entry_point,
+    pfn_job_on_complete on_success,
+    pfn_job_on_complete on_fail,
+    void* param_data,
+    u32 param_data_size,
+    u32 result_data_size,
+    job_type type,
+    job_priority priority,
+    u8 dependency_count,
+    khandle16* dependencies) {
+    job_info job;
+    job.entry_point = entry_point;
+    job.on_success = on_success;
+    job.on_fail = on_fail;
+    job.type = type;
+    job.priority = priority;
+    job.flags = JOB_FLAG_NONE;
+
+    // Technically jobs can be created in the middle of other jobs (i.e. on a different thread),
+    // so the slot is taken atomically. It is held until the job completes, then reused.
+    job.id = slot_acquire();
+
+    // Small params (the usual case) are held in the job itself, so need no allocation.
+    job.param_data_size = param_data_size;
+    if (param_data_size > JOB_INLINE_DATA_SIZE) {
+        job.param_data = job_data_allocate(param_data_size);
+        kcopy_memory(job.param_data, param_data, param_data_size);
+    } else {
+        job.param_data = 0;
+        if (param_data_size) {
+            kcopy_memory(job.inline_data, param_data, param_data_size);
+        }
+    }
+
+    // Result data is only needed once the job runs, so is obtained then.
+    job.result_data_size = result_data_size;
+
+    job.dependency_count = dependency_count;
+    job.dependency_ids = 0;
+    if (dependency_count > JOB_INLINE_DEPENDENCY_COUNT) {
+        job.dependency_ids = job_data_allocate(sizeof(khandle16) * dependency_count);
+        kcopy_memory(job.dependency_ids, dependencies, sizeof(khandle16) * dependency_count);
+    } else if (dependency_count) {
+        kcopy_memory(job.inline_dependencies, dependencies, sizeof(khandle16) * dependency_count);
+    }
+
+    return job;
+}
+
+b8 job_system_query_job_complete(khandle16 job_id) {
+    if (khandle16_is_invalid(job_id) || job_id.handle_index >= JOB_SLOT_COUNT) {
+        return false;
+    }
+    // Once the slot moves on to a newer job, this one must have completed.
+    u64 word = katomic_load_u64(&state_ptr->slot_words[job_id.handle_index]);
+    return SLOT_WORD_GENERATION(word) != job_id.generation || SLOT_WORD_HEAD(word) == CONTINUATION_LIST_SEALED;
+}
+
+b8 job_system_wait_for_jobs(u8 job_count, const khandle16* job_ids) {
+    if (!state_ptr || (job_count && !job_ids)) {
+        return false;
+    }
+
+    // A fiber job gives up its thread instead, which then runs other jobs as usual.
+    if (fiber_host.current) {
+        for (u8 i = 0; i < job_count; ++i) {
+            if (!job_yield_until(job_ids[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // A job thread can run anything it normally would. Any other thread only helps
+    // with general jobs, since other types are tied to specific threads.
+    job_thread* self = current_job_thread;
+    u32 type_mask = self ? self->type_mask : JOB_TYPE_GENERAL;
+
+    for (u8 i = 0; i < job_count; ++i) {
+        if (khandle16_is_invalid(job_ids[i]) || job_ids[i].handle_index >= JOB_SLOT_COUNT) {
+            KERROR("job_system_wait_for_jobs - invalid job id provided.");
+            return false;
+        }
+        // Run other jobs while waiting, rather than blocking. The awaited job is
+        // likely among them, and this thread would otherwise sit idle.
+        while (!job_system_query_job_complete(job_ids[i])) {
+            u32 job_index;
+            if (job_find(self, type_mask, &job_index)) {
+                job_run(job_index);
+            } else {
+                kthread_yield();
+            }
+        }
+    }
+
+    return true;
+}
+
+b8 job_yield_until(khandle16 job_id) {
+    if (!state_ptr || khandle16_is_invalid(job_id) || job_id.handle_index >= JOB_SLOT_COUNT) {
+        KERROR("job_yield_until - invalid job id provided.");
+        return false;
+    }
+
+    job_fiber_host* host = &fiber_host;
+    job_fiber* self = host->current;
+    if (!self) {
+        // Not on a fiber, so the thread can't be given up. Help out while waiting instead.
+        return job_system_wait_for_jobs(1, &job_id);
+    }
+
+    while (!job_system_query_job_complete(job_id)) {
+        // The thread suspends this fiber once it has switched away from it.
+        host->yielded = self;
+        host->yielded_until = job_id;
+        kfiber_switch(&self->fiber, &host->fiber);
+        // Resumed, perhaps on another thread, so the host from before may no longer be this thread's.
+        host = self->host;
+    }
+    return true;
+}
+
+// Takes chunks of the task until there are none left.
+static void parallel_task_run(parallel_task* task) {
+    u32 participant = katomic_fetch_add_u32(&task->next_participant, 1);
+    void* partial = task->partials ? task->partials + ((u64)task->result_size * participant) : 0;
+    while (true) {
+        u32 chunk = katomic_fetch_add_u32(&task->next_chunk, 1);
+        if (chunk >= task->chunk_count) {
+            break;
+        }
+        u32 start = chunk * task->grain;
+        u32 end = KMIN(start + task->grain, task->count);
+        if (task->reduce_fn) {
+            task->reduce_fn(start, end, task->context, partial);
+        } else {
+            task->for_fn(start, end, task->context);
+        }
+    }
+}
+
+static b8 parallel_task_job_entry(void* params, void* result_data) {
+    parallel_task_run(params);
+    return true;
+}
+
+// Splits the task into chunks, runs them across the calling thread and any available general job threads, then waits for all to finish.
+static void parallel_task_execute(parallel_task* task, u32 max_participants) {
+    if (!task->grain) {
+        u32 target_chunks = (u32)(state_ptr ? state_ptr->general_thread_count + 1 : 1) * PARALLEL_CHUNKS_PER_THREAD;
+        task->grain = KMAX(1u, (task->count + target_chunks - 1) / target_chunks);
+    }
+    task->chunk_count = (task->count + task->grain - 1) / task->grain;
+
+    // One helper job per general job thread at most, and no more than there are chunks to share.
+    // The helpers don't own anything, so nothing is allocated for them.
+    u32 helper_count = 0;
+    khandle16 helper_ids[JOB_MAX_THREAD_COUNT];
+    if (state_ptr) {
+        helper_count = KMIN((u32)state_ptr->general_thread_count, task->chunk_count - 1);
+        helper_count = KMIN(helper_count, max_participants - 1);
+    }
+    for (u32 i = 0; i < helper_count; ++i) {
+        job_info helper = job_create_priority(parallel_task_job_entry, 0, 0, 0, 0, 0, JOB_TYPE_GENERAL, JOB_PRIORITY_HIGH);
+        helper.param_data = task;
+        helper_ids[i] = helper.id;
+        job_system_submit(helper);
+    }
+
+    // This thread does its share too, then waits for the helpers (running any that haven't
+    // started yet itself), as they refer to the task on this thread's stack.
+    parallel_task_run(task);
+    if (helper_count) {
+        job_system_wait_for_jobs((u8)helper_count, helper_ids);
+    }
+}
+
+void job_system_parallel_for(u32 count, u32 grain, pfn_job_parallel_for fn, void* context) {
+    if (!fn) {
+        KERROR("job_system_parallel_for requires a function to run.");
+        return;
+    }
+    if (!count) {
+        return;
+    }
+
+    parallel_task task = {0};
+    task.count = count;
+    task.grain = grain;
+    task.context = context;
+    task.for_fn = fn;
+    parallel_task_execute(&task, JOB_MAX_THREAD_COUNT);
+}
+
+void job_system_parallel_reduce(u32 count, u32 grain, u32 result_size, const void* identity, pfn_job_parallel_reduce fn, pfn_job_reduce_combine combine, void* context, void* out_result) {
+    if (!fn || !combine || !result_size || !identity || !out_result) {
+        KERROR("job_system_parallel_reduce requires a function, combine function, result size, identity and out_result.");
+        return;
+    }
+
+    if (result_size > PARALLEL_REDUCE_STACK_SIZE) {
+        KERROR("job_system_parallel_reduce - result_size must be no more than %u bytes.", PARALLEL_REDUCE_STACK_SIZE);
+        return;
+    }
+
+    kcopy_memory(out_result, identity, result_size);
+    if (!count) {
+        return;
+    }
+
+    // One partial result per participant (this thread plus helpers), each starting at identity.
+    // Large results limit the number of participants rather than being allocated.
+    u32 participant_count = (state_ptr ? state_ptr->general_thread_count : 0) + 1;
+    participant_count = KMIN(participant_count, PARALLEL_REDUCE_STACK_SIZE / result_size);
+    u8 stack_partials[PARALLEL_REDUCE_STACK_SIZE];
+    for (u32 i = 0; i < participant_count; ++i) {
+        kcopy_memory(stack_partials + ((u64)result_size * i), identity, result_size);
+    }
+
+    parallel_task task = {0};
+    task.count = count;
+    task.grain = grain;
+    task.context = context;
+    task.reduce_fn = fn;
+    task.partials = stack_partials;
+    task.result_size = result_size;
+    parallel_task_execute(&task, participant_count);
+
+    // Only participants which actually started have anything to contribute.
+    u32 started = KMIN(task.next_participant, participant_count);
+    for (u32 i = 0; i < started; ++i) {
+        combine(out_result, stack_partials + ((u64)result_size * i), context);
+    }
+}
+
+b8 job_system_stats_get(job_system_stats* out_stats) {
+    if (!state_ptr || !out_stats) {
+        return false;
+    }
+    kzero_memory(out_stats, sizeof(job_system_stats));
+
+    u64 now = time_now_us();
+    u64 start = katomic_load_u64(&state_ptr->stats_start_us);
+    out_stats->elapsed_seconds = now > start ? (f64)(now - start) / 1000000.0 : 0.0;
+
+    for (u32 i = 0; i < JOB_THREAD_STATS_COUNT; ++i) {
+        job_thread_stats* stats = &state_ptr->thread_stats[i];
+        for (u32 b = 0; b < JOB_LATENCY_BUCKET_COUNT; ++b) {
+            out_stats->wait_histogram[b] += katomic_load_u64(&stats->wait_histogram[b]);
+            out_stats->run_histogram[b] += katomic_load_u64(&stats->run_histogram[b]);
+        }
+    }
+    // Jobs run by other threads (i.e. the main thread, while waiting on jobs).
+    out_stats->other_thread_jobs_run = katomic_load_u64(&state_ptr->thread_stats[OTHER_THREAD_STATS_INDEX].jobs_run);
+
+    out_stats->thread_count = state_ptr->thread_count;
+    for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+        job_thread_stats* stats = &state_ptr->thread_stats[i];
+        job_system_thread_stats* thread_stats = &out_stats->threads[i];
+        thread_stats->type_mask = state_ptr->job_threads[i].type_mask;
+        thread_stats->jobs_run = katomic_load_u64(&stats->jobs_run);
+        thread_stats->busy_seconds = (f64)katomic_load_u64(&stats->busy_us) / 1000000.0;
+        thread_stats->idle_seconds = KMAX(out_stats->elapsed_seconds - thread_stats->busy_seconds, 0.0);
+        thread_stats->utilization = out_stats->elapsed_seconds > 0.0 ? (f32)(thread_stats->busy_seconds / out_stats->elapsed_seconds) : 0.0f;
+    }
+
+    for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+        for (u32 t = 0; t < JOB_TYPE_COUNT; ++t) {
+            out_stats->queue_depths[p] += mpmc_queue_length(&state_ptr->queues[t][p]);
+        }
+        for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+            out_stats->queue_depths[p] += ws_deque_length(&state_ptr->job_threads[i].deques[p]);
+        }
+    }
+
+    for (u32 t = 0; t < JOB_TYPE_COUNT; ++t) {
+        out_stats->submitted_counts[t] = katomic_load_u64(&state_ptr->submitted_counts[t]);
+        out_stats->completed_counts[t] = katomic_load_u64(&state_ptr->completed_counts[t]);
+    }
+
+    return true;
+}
+
+void job_system_stats_reset(void) {
+    if (!state_ptr) {
+        return;
+    }
+    // NOTE: Counters may be added to while this happens, so a few jobs may be counted from before the reset.
+    for (u32 i = 0; i < JOB_THREAD_STATS_COUNT; ++i) {
+        job_thread_stats* stats = &state_ptr->thread_stats[i];
+        katomic_store_u64(&stats->jobs_run, 0);
+        katomic_store_u64(&stats->busy_us, 0);
+        for (u32 b = 0; b < JOB_LATENCY_BUCKET_COUNT; ++b) {
+            katomic_store_u64(&stats->wait_histogram[b], 0);
+            katomic_store_u64(&stats->run_histogram[b], 0);
+        }
+    }
+    for (u32 t = 0; t < JOB_TYPE_COUNT; ++t) {
+        katomic_store_u64(&state_ptr->submitted_counts[t], 0);
+        katomic_store_u64(&state_ptr->completed_counts[t], 0);
+    }
+    katomic_store_u64(&state_ptr->stats_start_us, time_now_us());
+}
+
+// Logs a latency histogram, one line per nonempty bucket.
+static void histogram_print(const char* name, const u64* histogram) {
+    u64 total = 0;
+    for (u32 b = 0; b < JOB_LATENCY_BUCKET_COUNT; ++b) {
+        total += histogram[b];
+    }
+    KINFO("%s (%llu jobs):", name, total);
+    for (u32 b = 0; b < JOB_LATENCY_BUCKET_COUNT; ++b) {
+        if (!histogram[b]) {
+            continue;
+        }
+        f32 percent = (f32)histogram[b] * 100.0f / (f32)total;
+        if (b == 0) {
+            KINFO("  <1us: %llu (%.1f%%)", histogram[b], percent);
+        } else if (b == JOB_LATENCY_BUCKET_COUNT - 1) {
+            KINFO("  >=%lluus: %llu (%.1f%%)", 1ull << (b - 1), histogram[b], percent);
+        } else {
+            KINFO("  %llu-%lluus: %llu (%.1f%%)", 1ull << (b - 1), (1ull << b) - 1, histogram[b], percent);
+        }
+    }
+}
+
+void job_system_stats_log(void) {
+    job_system_stats stats;
+    if (!job_system_stats_get(&stats)) {
+        return;
+    }
+
+    static const char* type_names[JOB_TYPE_COUNT] = {"general", "resource_load", "gpu_resource"};
+    static const char* priority_names[JOB_PRIORITY_COUNT] = {"low", "normal", "high"};
+
+    KINFO("Job system stats over the last %.2fs:", stats.elapsed_seconds);
+    for (u8 i = 0; i < stats.thread_count; ++i) {
+        job_system_thread_stats* t = &stats.threads[i];
+        KINFO("  Thread #%u (type=%#x): %llu jobs, busy %.3fs, idle %.3fs, utilization %.1f%%", i, t->type_mask, t->jobs_run, t->busy_seconds, t->idle_seconds, t->utilization * 100.0f);
+    }
+    KINFO("  Other threads: %llu jobs", stats.other_thread_jobs_run);
+    for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+        KINFO("  Queue depth (%s): %u", priority_names[p], stats.queue_depths[p]);
+    }
+    for (u32 t = 0; t < JOB_TYPE_COUNT; ++t) {
+        KINFO("  Jobs (%s): %llu submitted, %llu completed", type_names[t], stats.submitted_counts[t], stats.completed_counts[t]);
+    }
+    histogram_print("Wait time (ready to start)", stats.wait_histogram);
+    histogram_print("Run time (start to finish)", stats.run_histogram);
+}
@@ -0,0 +1,390 @@
+#pragma once
+
+#include "defines.h"
+#include "identifiers/khandle.h"
+
+/** @brief A function pointer definition for jobs. */
+typedef b8 (*pfn_job_start)(void*, void*);
+
+/** @brief A function pointer definition for completion of a job. */
+typedef void (*pfn_job_on_complete)(void*);
+
+/**
+ * @brief A function pointer definition for the body of a parallel loop.
+ * Invoked once per chunk of the loop, with the range of indices [start, end) to process.
+ */
+typedef void (*pfn_job_parallel_for)(u32 start, u32 end, void* context);
+
+/**
+ * @brief A function pointer definition for the body of a parallel reduction.
+ * Invoked once per chunk of the loop, with the range of indices [start, end) to process.
+ * The result of the chunk should be folded into accumulator.
+ */
+typedef void (*pfn_job_parallel_reduce)(u32 start, u32 end, void* context, void* accumulator);
+
+/**
+ * @brief A function pointer definition for combining the partial results of a parallel reduction.
+ * Should fold partial into accumulator.
+ */
+typedef void (*pfn_job_reduce_combine)(void* accumulator, const void* partial, void* context);
+
+struct frame_data;
+
+/**
+ * @brief Param data up to this size is held within the job itself, as are the results
+ * of jobs with completion callbacks. Larger data is held in blocks owned by the job system.
+ */
+#define JOB_INLINE_DATA_SIZE 128
+
+/** @brief The number of dependencies which may be held within the job itself. */
+#define JOB_INLINE_DEPENDENCY_COUNT 4
+
+/** @brief The max number of job threads. */
+#define JOB_MAX_THREAD_COUNT 32
+
+/**
+ * @brief The number of buckets in each job latency histogram. Bucket 0 counts jobs under
+ * 1 microsecond, bucket i counts jobs from 2^(i-1) up to 2^i microseconds, and the last
+ * bucket counts everything beyond.
+ */
+#define JOB_LATENCY_BUCKET_COUNT 24
+
+/** @brief Describes a type of job */
+typedef enum job_type {
+    /**
+     * @brief A general job that does not have any specific thread requirements.
+     * This means it matters little which job thread this job runs on.
+     */
+    JOB_TYPE_GENERAL = 0x02,
+
+    /**
+     * @brief A resource loading job. Resources should always load on the same thread
+     * to avoid potential disk thrashing.
+     */
+    JOB_TYPE_RESOURCE_LOAD = 0x04,
+
+    /**
+     * @brief Jobs using GPU resources should be bound to a thread using this job type. Multithreaded
+     * renderers will use a specific job thread, and this type of job will run on that thread.
+     * For single-threaded renderers, this will be on the main thread.
+     */
+    JOB_TYPE_GPU_RESOURCE = 0x08,
+} job_type;
+
+/**
+ * @brief Determines which job queue a job uses. The high-priority queue is always
+ * exhausted first before processing the normal-priority queue, which must also
+ * be exhausted before processing the low-priority queue.
+ */
+typedef enum job_priority {
+    /** @brief The lowest-priority job, used for things that can wait to be done if need be, such as log flushing. */
+    JOB_PRIORITY_LOW,
+    /** @brief A normal-priority job. Should be used for medium-priority tasks such as loading assets. */
+    JOB_PRIORITY_NORMAL,
+    /** @brief The highest-priority job. Should be used sparingly, and only for time-critical operations.*/
+    JOB_PRIORITY_HIGH
+} job_priority;
+
+/** @brief Flags which change how a job is run. */
+typedef enum job_flags {
+    /** @brief No flags. */
+    JOB_FLAG_NONE = 0x00,
+    /**
+     * @brief Runs the job on a fiber (a separate stack which can be suspended and resumed),
+     * so it may call job_yield_until() to wait on other jobs without holding up its thread.
+     * The thread moves on to other work, and the job later resumes where it left off, possibly
+     * on another thread of the same type. This allows a chain of dependent work (i.e. read,
+     * then process, then upload) to be written as one straight-line job. Fiber jobs must not
+     * hold thread-local data, or locks, across a yield.
+     */
+    JOB_FLAG_FIBER = 0x01,
+} job_flags;
+
+/**
+ * @brief Describes a job to be run.
+ */
+typedef struct job_info {
+    /** @brief The type of job. Used to determine which thread the job executes on. */
+    job_type type;
+
+    /**
+     * @brief The handle of this job. Refers to a slot which is reused once the job completes,
+     * along with the generation of the slot, so stale handles never match a newer job.
+     */
+    khandle16 id;
+
+    /** @brief The priority of this job. Higher priority jobs obviously run sooner. */
+    job_priority priority;
+
+    /** @brief Flags which change how the job is run (see job_flags). Set after creating the job, before submitting it. */
+    u32 flags;
+
+    /** @brief A function pointer to be invoked when the job starts. Required. */
+    pfn_job_start entry_point;
+
+    /** @brief A function pointer to be invoked when the job successfully completes. Optional. */
+    pfn_job_on_complete on_success;
+
+    /** @brief A function pointer to be invoked when the job successfully fails. Optional. */
+    pfn_job_on_complete on_fail;
+
+    /**
+     * @brief Data to be passed to the entry point upon execution, if larger than
+     * JOB_INLINE_DATA_SIZE. Smaller data is held in inline_data, and this is 0.
+     */
+    void* param_data;
+
+    /** @brief The size of the data passed to the job. */
+    u32 param_data_size;
+
+    /** @brief The size of the data passed to the success/fail function. */
+    u32 result_data_size;
+
+    /** @brief A count of job identifiers that must be complete before this job starts. */
+    u8 dependency_count;
+
+    /**
+     * @brief An array of job handles that must be complete before this job starts, if there
+     * are more than JOB_INLINE_DEPENDENCY_COUNT. Otherwise they are held in inline_dependencies, and this is 0.
+     */
+    khandle16* dependency_ids;
+
+    /** @brief Holds the dependencies, when no more than JOB_INLINE_DEPENDENCY_COUNT. */
+    khandle16 inline_dependencies[JOB_INLINE_DEPENDENCY_COUNT];
+
+    /** @brief Holds the param data, when no larger than JOB_INLINE_DATA_SIZE. */
+    u8 inline_data[JOB_INLINE_DATA_SIZE];
+} job_info;
+
+/** @brief Stats for a single job thread. */
+typedef struct job_system_thread_stats {
+    /** @brief The types of jobs the thread handles. */
+    u32 type_mask;
+    /** @brief The number of jobs run. */
+    u64 jobs_run;
+    /** @brief Time spent running jobs, in seconds. */
+    f64 busy_seconds;
+    /** @brief Time spent with nothing to do, in seconds. */
+    f64 idle_seconds;
+    /** @brief The fraction of the time spent running jobs, from 0 to 1. */
+    f32 utilization;
+} job_system_thread_stats;
+
+/**
+ * @brief A snapshot of job system stats, gathered since startup or the last call to
+ * job_system_stats_reset(). Jobs are indexed by type in the order general, resource
+ * load, GPU resource, and queues by job_priority.
+ */
+typedef struct job_system_stats {
+    /** @brief The time covered by these stats, in seconds. */
+    f64 elapsed_seconds;
+    /** @brief The number of job threads. */
+    u8 thread_count;
+    /** @brief Stats per job thread. */
+    job_system_thread_stats threads[JOB_MAX_THREAD_COUNT];
+    /** @brief The number of jobs run by threads other than job threads, such as the main thread while waiting on jobs. */
+    u64 other_thread_jobs_run;
+    /** @brief The number of jobs ready to run but not yet started, per priority. */
+    u32 queue_depths[3];
+    /** @brief The number of jobs submitted, per type. */
+    u64 submitted_counts[3];
+    /** @brief The number of jobs completed, per type. */
+    u64 completed_counts[3];
+    /** @brief A histogram of the time from jobs being ready to run (submitted, with all dependencies complete) until starting. See JOB_LATENCY_BUCKET_COUNT. */
+    u64 wait_histogram[JOB_LATENCY_BUCKET_COUNT];
+    /** @brief A histogram of the time from jobs starting until finishing (or yielding, for fiber jobs). See JOB_LATENCY_BUCKET_COUNT. */
+    u64 run_histogram[JOB_LATENCY_BUCKET_COUNT];
+} job_system_stats;
+
+typedef struct job_system_config {
+    /**
+     * @param max_job_thread_count The maximum number of job threads to be spun up.
+     * Should be no more than the number of cores on the CPU, minus one to account for the main thread.
+     * Pass 0 to use job_system_default_thread_count().
+     */
+    u8 max_job_thread_count;
+    /**
+     * @param type_masks A collection of type masks for each job thread. Must match max_job_thread_count.
+     * Optional. If 0, every thread runs every type of job.
+     */
+    u32* type_masks;
+} job_system_config;
+
+/**
+ * @brief Obtains the number of job threads which makes best use of this machine: one per
+ * physical core, less one for the main thread.
+ * @returns The default number of job threads, between 1 and JOB_MAX_THREAD_COUNT.
+ */
+KAPI u8 job_system_default_thread_count(void);
+
+/**
+ * @brief Initializes the job system. Call once to retrieve job_system_memory_requirement, passing 0 to state. Then
+ * call a second time with allocated state memory block.
+ * @param job_system_memory_requirement A pointer to hold the memory required for the job system state in bytes.
+ * @param state A block of memory to hold the state of the job system.
+ * @param config A pointer to the configuration (job_system_config) of this system. Optional. If 0, the defaults are used.
+ * @returns True if the job system started up successfully; otherwise false.
+ */
+KAPI b8 job_system_initialize(u64* job_system_memory_requirement, void* state, void* config);
+
+/**
+ * @brief Shuts the job system down.
+ */
+KAPI void job_system_shutdown(void* state);
+
+/**
+ * @brief Updates the job system. Should happen once an update cycle.
+ */
+KAPI b8 job_system_update(void* state, struct frame_data* p_frame_data);
+
+/**
+ * @brief Submits the provided job to be queued for execution.
+ * @param info The description of the job to be executed.
+ */
+KAPI void job_system_submit(job_info info);
+
+/**
+ * @brief Creates a new job with default type (Generic) and priority (Normal).
+ * @param entry_point A pointer to a function to be invoked when the job starts. Required.
+ * @param on_success A pointer to a function to be invoked when the job completes successfully. Optional.
+ * @param on_fail A pointer to a function to be invoked when the job fails. Optional.
+ * @param param_data Data to be passed to the entry point upon execution.
+ * @param param_data_size The data to be passed on to entry_point callback. Pass 0 if not used.
+ * @param result_data_size The size of result data to be passed on to success callback. Pass 0 if not used.
+ * @returns The newly created job information to be submitted for execution.
+ */
+KAPI job_info job_create(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, u32 param_data_size, u32 result_data_size);
+
+/**
+ * @brief Creates a new job with default priority (Normal).
+ * @param entry_point A pointer to a function to be invoked when the job starts. Required.
+ * @param on_success A pointer to a function to be invoked when the job completes successfully. Optional.
+ * @param on_fail A pointer to a function to be invoked when the job fails. Optional.
+ * @param param_data Data to be passed to the entry point upon execution.
+ * @param param_data_size The data to be passed on to entry_point callback. Pass 0 if not used.
+ * @param result_data_size The size of result data to be passed on to success callback. Pass 0 if not used.
+ * @param type The type of job. Used to determine which thread the job executes on.
+ * @returns The newly created job information to be submitted for execution.
+ */
+KAPI job_info job_create_type(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, u32 param_data_size, u32 result_data_size, job_type type);
+
+/**
+ * @brief Creates a new job with the provided priority.
+ * @param entry_point A pointer to a function to be invoked when the job starts. Required.
+ * @param on_success A pointer to a function to be invoked when the job completes successfully. Optional.
+ * @param on_fail A pointer to a function to be invoked when the job fails. Optional.
+ * @param param_data Data to be passed to the entry point upon execution.
+ * @param param_data_size The data to be passed on to entry_point callback. Pass 0 if not used.
+ * @param result_data_size The size of result data to be passed on to success callback. Pass 0 if not used.
+ * @param type The type of job. Used to determine which thread the job executes on.
+ * @param priority The priority of this job. Higher priority jobs obviously run sooner.
+ * @returns The newly created job information to be submitted for execution.
+ */
+KAPI job_info job_create_priority(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, u32 param_data_size, u32 result_data_size, job_type type, job_priority priority);
+
+/**
+ * @brief Creates a new job with the provided type, priority, and dependencies. The job holds
+ * a slot from here until it completes, so every job created must also be submitted.
+ * @param entry_point A pointer to a function to be invoked when the job starts. Required.
+ * @param on_success A pointer to a function to be invoked when the job completes successfully. Optional.
+ * @param on_fail A pointer to a function to be invoked when the job fails. Optional.
+ * @param param_data Data to be passed to the entry point upon execution.
+ * @param param_data_size The data to be passed on to entry_point callback. Pass 0 if not used.
+ * @param result_data_size The size of result data to be passed on to success callback. Pass 0 if not used.
+ * @param type The type of job. Used to determine which thread the job executes on.
+ * @param priority The priority of this job. Higher priority jobs obviously run sooner.
+ * @param dependency_count The number of job handles which must be complete before this job runs.
+ * @param dependencies An array of job handles which must be complete before this job runs.
+ * @returns The newly created job information to be submitted for execution.
+ */
+KAPI job_info job_create_with_dependencies(
+    pfn_job_start entry_point,
+    pfn_job_on_complete on_success,
+    pfn_job_on_complete on_fail,
+    void* param_data,
+    u32 param_data_size,
+    u32 result_data_size,
+    job_type type,
+    job_priority priority,
+    u8 dependency_count,
+    khandle16* dependencies);
+
+/**
+ * @brief Returns whether or not the job with the given handle has completed. Handles remain
+ * usable indefinitely; once the job completes (and its slot is reused) this keeps returning true.
+ * @param job_id The handle of the job, as held in job_info.id.
+ * @returns True if the job has completed; false if not, or if the handle is invalid.
+ */
+KAPI b8 job_system_query_job_complete(khandle16 job_id);
+
+/**
+ * @brief Waits for the jobs with the given identifiers to complete. Rather than blocking,
+ * the calling thread runs other queued jobs while it waits (only general jobs, unless
+ * called from a job thread), so this may be used to fan work out and join on it within
+ * a frame. Note that completion callbacks still run on the main thread during
+ * job_system_update(), so may not have been run yet when this returns.
+ * @param job_count The number of job handles in job_ids.
+ * @param job_ids An array of handles of the jobs to wait for.
+ * Called from a fiber job, this yields as job_yield_until() does instead.
+ * @returns True once all of the jobs have completed; false if any handle is invalid.
+ */
+KAPI b8 job_system_wait_for_jobs(u8 job_count, const khandle16* job_ids);
+
+/**
+ * @brief Suspends the calling fiber job (see JOB_FLAG_FIBER) until the job with the given
+ * handle completes, leaving its thread free to run other jobs in the meantime. Returns
+ * immediately if that job has already completed. Called from anything other than a fiber
+ * job, this behaves as job_system_wait_for_jobs().
+ * @param job_id The handle of the job to wait for.
+ * @returns True once the job has completed; false if the handle is invalid.
+ */
+KAPI b8 job_yield_until(khandle16 job_id);
+
+/**
+ * @brief Runs fn over the indices [0, count), split into chunks which are spread across
+ * the calling thread and the general job threads. Returns once every chunk is done, so
+ * this is synchronous from the caller's point of view and may be used from the main
+ * thread within a frame, or from inside a job. Nothing is allocated per chunk.
+ * Chunks may run in any order, and at the same time as each other.
+ * @param count The number of indices in the loop.
+ * @param grain The number of indices per chunk. Pass 0 to choose automatically based on the number of job threads.
+ * @param fn The function to be invoked for each chunk.
+ * @param context Passed through to fn.
+ */
+KAPI void job_system_parallel_for(u32 count, u32 grain, pfn_job_parallel_for fn, void* context);
+
+/**
+ * @brief Reduces the indices [0, count) to a single result, split into chunks the same way
+ * as job_system_parallel_for(). Each participating thread folds its chunks into its own
+ * accumulator, starting from identity, and these are then combined into out_result on
+ * the calling thread. Which thread takes which chunk varies, so combine should be
+ * associative and commutative (bear this in mind for floating-point sums).
+ * @param count The number of indices in the loop.
+ * @param grain The number of indices per chunk. Pass 0 to choose automatically.
+ * @param result_size The size of the result in bytes. No more than 1KiB.
+ * @param identity The starting value of each accumulator (i.e. 0 for a sum).
+ * @param fn The function to be invoked for each chunk.
+ * @param combine The function used to combine accumulators.
+ * @param context Passed through to fn and combine.
+ * @param out_result A pointer to hold the result.
+ */
+KAPI void job_system_parallel_reduce(u32 count, u32 grain, u32 result_size, const void* identity, pfn_job_parallel_reduce fn, pfn_job_reduce_combine combine, void* context, void* out_result);
+
+/**
+ * @brief Obtains a snapshot of the job system stats, for sizing the number of job threads
+ * and their type masks.
+ * @param out_stats A pointer to hold the stats.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 job_system_stats_get(job_system_stats* out_stats);
+
+/**
+ * @brief Resets the job system stats, so subsequent stats only cover what happens from
+ * here on.
+ */
+KAPI void job_system_stats_reset(void);
+
+/**
+ * @brief Logs a readable summary of the job system stats.
+ */
+KAPI void job_system_stats_log(void);
@@ -0,0 +1,325 @@
+/**
+ * @file katomic.h
+ * @author Travis Vroman (travis@kohiengine.com)
+ * @brief Thin wrappers around compiler atomic intrinsics, used by lock-free
+ * code paths throughout the engine.
+ *
+ * @details Loads use acquire semantics, stores use release semantics and
+ * read-modify-write operations use acquire/release semantics unless the
+ * function name says otherwise (i.e. "_relaxed"). These are intended to be
+ * used on naturally-aligned values only.
+ *
+ * @version 1.0
+ * @date 2024-11-02
+ *
+ * @copyright Kohi Game Engine is Copyright (c) Travis Vroman 2021-2024
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+#if defined(__clang__) || defined(__gcc__) || defined(__GNUC__)
+
+/** @brief Atomically loads the value at ptr. */
+KINLINE u32 katomic_load_u32(const u32* ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+/** @brief Atomically loads the value at ptr. */
+KINLINE u64 katomic_load_u64(const u64* ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+/** @brief Atomically loads the pointer at ptr. */
+KINLINE void* katomic_load_ptr(void* const* ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+/** @brief Atomically stores value at ptr. */
+KINLINE void katomic_store_u32(u32* ptr, u32 value) {
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+/** @brief Atomically stores value at ptr. */
+KINLINE void katomic_store_u64(u64* ptr, u64 value) {
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+/** @brief Atomically stores the pointer value at ptr. */
+KINLINE void katomic_store_ptr(void** ptr, void* value) {
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+/** @brief Atomically adds value to the value at ptr. @returns The value held _before_ the add. */
+KINLINE u32 katomic_fetch_add_u32(u32* ptr, u32 value) {
+    return __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+/** @brief Atomically adds value to the value at ptr. @returns The value held _before_ the add. */
+KINLINE u64 katomic_fetch_add_u64(u64* ptr, u64 value) {
+    return __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+/** @brief Atomically subtracts value from the value at ptr. @returns The value held _before_ the subtraction. */
+KINLINE u32 katomic_fetch_sub_u32(u32* ptr, u32 value) {
+    return __atomic_fetch_sub(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+/** @brief Atomically subtracts value from the value at ptr. @returns The value held _before_ the subtraction. */
+KINLINE u64 katomic_fetch_sub_u64(u64* ptr, u64 value) {
+    return __atomic_fetch_sub(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+/**
+ * @brief Adds value to the value at ptr with no ordering guarantees. Useful for
+ * statistics counters, which only need to be eventually correct.
+ */
+KINLINE void katomic_add_u64_relaxed(u64* ptr, u64 value) {
+    __atomic_fetch_add(ptr, value, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Subtracts value from the value at ptr with no ordering guarantees. Useful for
+ * statistics counters, which only need to be eventually correct.
+ */
+KINLINE void katomic_sub_u64_relaxed(u64* ptr, u64 value) {
+    __atomic_fetch_sub(ptr, value, __ATOMIC_RELAXED);
+}
+
+/** @brief Atomically ORs value into the value at ptr. @returns The value held _before_ the operation. */
+KINLINE u64 katomic_fetch_or_u64(u64* ptr, u64 value) {
+    return __atomic_fetch_or(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+/** @brief Atomically ANDs value into the value at ptr. @returns The value held _before_ the operation. */
+KINLINE u64 katomic_fetch_and_u64(u64* ptr, u64 value) {
+    return __atomic_fetch_and(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+/** @brief Atomically replaces the value at ptr. @returns The value held _before_ the exchange. */
+KINLINE u32 katomic_exchange_u32(u32* ptr, u32 value) {
+    return __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+/** @brief Atomically replaces the pointer at ptr. @returns The pointer held _before_ the exchange. */
+KINLINE void* katomic_exchange_ptr(void** ptr, void* value) {
+    return __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+/**
+ * @brief Atomically replaces the value at ptr with desired, but only if it currently
+ * holds the value pointed to by expected. On failure, expected is updated to hold the
+ * current value.
+ * @returns True if the exchange took place; otherwise false.
+ */
+KINLINE b8 katomic_compare_exchange_u32(u32* ptr, u32* expected, u32 desired) {
+    return __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Atomically replaces the value at ptr with desired, but only if it currently
+ * holds the value pointed to by expected. On failure, expected is updated to hold the
+ * current value.
+ * @returns True if the exchange took place; otherwise false.
+ */
+KINLINE b8 katomic_compare_exchange_u64(u64* ptr, u64* expected, u64 desired) {
+    return __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Atomically replaces the pointer at ptr with desired, but only if it currently
+ * holds the pointer pointed to by expected. On failure, expected is updated to hold the
+ * current pointer.
+ * @returns True if the exchange took place; otherwise false.
+ */
+KINLINE b8 katomic_compare_exchange_ptr(void** ptr, void** expected, void* desired) {
+    return __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/** @brief A full memory barrier. */
+KINLINE void katomic_thread_fence(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/** @brief Hints to the CPU that the calling thread is in a spin-wait loop. */
+KINLINE void katomic_cpu_relax(void) {
+#    if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#    elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#    endif
+}
+
+#elif defined(_MSC_VER)
+
+// MSVC has no ordering-specific intrinsics on x64, so the _Interlocked* family (full barriers)
+// stands in for every read-modify-write and store. Loads are plain volatile reads of
+// naturally-aligned values followed by a barrier. Only 64-bit targets (x64/ARM64) are supported.
+#    include <intrin.h>
+
+#    if defined(_M_ARM64)
+#        define KATOMIC_ACQUIRE_BARRIER() __dmb(_ARM64_BARRIER_ISH)
+#    else
+#        define KATOMIC_ACQUIRE_BARRIER() _ReadWriteBarrier()
+#    endif
+
+/** @brief Atomically loads the value at ptr. */
+KINLINE u32 katomic_load_u32(const u32* ptr) {
+    u32 value = *(const volatile u32*)ptr;
+    KATOMIC_ACQUIRE_BARRIER();
+    return value;
+}
+
+/** @brief Atomically loads the value at ptr. */
+KINLINE u64 katomic_load_u64(const u64* ptr) {
+    u64 value = *(const volatile u64*)ptr;
+    KATOMIC_ACQUIRE_BARRIER();
+    return value;
+}
+
+/** @brief Atomically loads the pointer at ptr. */
+KINLINE void* katomic_load_ptr(void* const* ptr) {
+    void* value = *(void* const volatile*)ptr;
+    KATOMIC_ACQUIRE_BARRIER();
+    return value;
+}
+
+/** @brief Atomically stores value at ptr. */
+KINLINE void katomic_store_u32(u32* ptr, u32 value) {
+    _InterlockedExchange((volatile long*)ptr, (long)value);
+}
+
+/** @brief Atomically stores value at ptr. */
+KINLINE void katomic_store_u64(u64* ptr, u64 value) {
+    _InterlockedExchange64((volatile __int64*)ptr, (__int64)value);
+}
+
+/** @brief Atomically stores the pointer value at ptr. */
+KINLINE void katomic_store_ptr(void** ptr, void* value) {
+    _InterlockedExchangePointer((void* volatile*)ptr, value);
+}
+
+/** @brief Atomically adds value to the value at ptr. @returns The value held _before_ the add. */
+KINLINE u32 katomic_fetch_add_u32(u32* ptr, u32 value) {
+    return (u32)_InterlockedExchangeAdd((volatile long*)ptr, (long)value);
+}
+
+/** @brief Atomically adds value to the value at ptr. @returns The value held _before_ the add. */
+KINLINE u64 katomic_fetch_add_u64(u64* ptr, u64 value) {
+    return (u64)_InterlockedExchangeAdd64((volatile __int64*)ptr, (__int64)value);
+}
+
+/** @brief Atomically subtracts value from the value at ptr. @returns The value held _before_ the subtraction. */
+KINLINE u32 katomic_fetch_sub_u32(u32* ptr, u32 value) {
+    return (u32)_InterlockedExchangeAdd((volatile long*)ptr, -(long)value);
+}
+
+/** @brief Atomically subtracts value from the value at ptr. @returns The value held _before_ the subtraction. */
+KINLINE u64 katomic_fetch_sub_u64(u64* ptr, u64 value) {
+    return (u64)_InterlockedExchangeAdd64((volatile __int64*)ptr, -(__int64)value);
+}
+
+/**
+ * @brief Adds value to the value at ptr with no ordering guarantees. Useful for
+ * statistics counters, which only need to be eventually correct.
+ */
+KINLINE void katomic_add_u64_relaxed(u64* ptr, u64 value) {
+    _InterlockedExchangeAdd64((volatile __int64*)ptr, (__int64)value);
+}
+
+/**
+ * @brief Subtracts value from the value at ptr with no ordering guarantees. Useful for
+ * statistics counters, which only need to be eventually correct.
+ */
+KINLINE void katomic_sub_u64_relaxed(u64* ptr, u64 value) {
+    _InterlockedExchangeAdd64((volatile __int64*)ptr, -(__int64)value);
+}
+
+/** @brief Atomically ORs value into the value at ptr. @returns The value held _before_ the operation. */
+KINLINE u64 katomic_fetch_or_u64(u64* ptr, u64 value) {
+    return (u64)_InterlockedOr64((volatile __int64*)ptr, (__int64)value);
+}
+
+/** @brief Atomically ANDs value into the value at ptr. @returns The value held _before_ the operation. */
+KINLINE u64 katomic_fetch_and_u64(u64* ptr, u64 value) {
+    return (u64)_InterlockedAnd64((volatile __int64*)ptr, (__int64)value);
+}
+
+/** @brief Atomically replaces the value at ptr. @returns The value held _before_ the exchange. */
+KINLINE u32 katomic_exchange_u32(u32* ptr, u32 value) {
+    return (u32)_InterlockedExchange((volatile long*)ptr, (long)value);
+}
+
+/** @brief Atomically replaces the pointer at ptr. @returns The pointer held _before_ the exchange. */
+KINLINE void* katomic_exchange_ptr(void** ptr, void* value) {
+    return _InterlockedExchangePointer((void* volatile*)ptr, value);
+}
+
+/**
+ * @brief Atomically replaces the value at ptr with desired, but only if it currently
+ * holds the value pointed to by expected. On failure, expected is updated to hold the
+ * current value.
+ * @returns True if the exchange took place; otherwise false.
+ */
+KINLINE b8 katomic_compare_exchange_u32(u32* ptr, u32* expected, u32 desired) {
+    u32 previous = (u32)_InterlockedCompareExchange((volatile long*)ptr, (long)desired, (long)*expected);
+    if (previous == *expected) {
+        return true;
+    }
+    *expected = previous;
+    return false;
+}
+
+/**
+ * @brief Atomically replaces the value at ptr with desired, but only if it currently
+ * holds the value pointed to by expected. On failure, expected is updated to hold the
+ * current value.
+ * @returns True if the exchange took place; otherwise false.
+ */
+KINLINE b8 katomic_compare_exchange_u64(u64* ptr, u64* expected, u64 desired) {
+    u64 previous = (u64)_InterlockedCompareExchange64((volatile __int64*)ptr, (__int64)desired, (__int64)*expected);
+    if (previous == *expected) {
+        return true;
+    }
+    *expected = previous;
+    return false;
+}
+
+/**
+ * @brief Atomically replaces the pointer at ptr with desired, but only if it currently
+ * holds the pointer pointed to by expected. On failure, expected is updated to hold the
+ * current pointer.
+ * @returns True if the exchange took place; otherwise false.
+ */
+KINLINE b8 katomic_compare_exchange_ptr(void** ptr, void** expected, void* desired) {
+    void* previous = _InterlockedCompareExchangePointer((void* volatile*)ptr, desired, *expected);
+    if (previous == *expected) {
+        return true;
+    }
+    *expected = previous;
+    return false;
+}
+
+/** @brief A full memory barrier. */
+KINLINE void katomic_thread_fence(void) {
+#    if defined(_M_ARM64)
+    __dmb(_ARM64_BARRIER_ISH);
+#    else
+    __faststorefence();
+#    endif
+}
+
+/** @brief Hints to the CPU that the calling thread is in a spin-wait loop. */
+KINLINE void katomic_cpu_relax(void) {
+#    if defined(_M_ARM64)
+    __yield();
+#    else
+    _mm_pause();
+#    endif
+}
+
+#else
+#    error "katomic.h - Unsupported compiler - don't know how to define atomic operations!"
+#endif
@@ -0,0 +1,63 @@
+#ifndef _K_FIBER_H_
+#define _K_FIBER_H_
+
+#include "defines.h"
+
+/**
+ * A fiber is an execution context (registers plus its own stack) which is switched
+ * to explicitly, rather than being scheduled by the OS. A thread runs one fiber at a
+ * time, and a fiber may be switched to from any thread, so work can be suspended part
+ * way through and resumed later elsewhere without holding up the thread it ran on.
+ * This calls to the platform-specific fiber implementation (ucontext on *nix, native
+ * fibers on Windows).
+ */
+typedef struct kfiber {
+    void *internal_data;
+} kfiber;
+
+/**
+ * A function pointer to be invoked when a fiber is first switched to. It must never
+ * return; when its work is done, it should switch to another fiber instead.
+ */
+typedef void (*pfn_fiber_start)(void *);
+
+/**
+ * Prepares the calling thread to switch between fibers, and creates a fiber representing
+ * the thread's own context so it can be switched back to. Must be called on a thread
+ * before it switches to any fiber.
+ * @param out_fiber A pointer to hold the fiber representing the calling thread.
+ * @returns true on success; otherwise false.
+ */
+KAPI b8 kfiber_thread_convert(kfiber *out_fiber);
+
+/**
+ * Undoes kfiber_thread_convert(). Must be called from the same thread, while running on
+ * its own context (i.e. not on another fiber).
+ * @param fiber A pointer to the fiber obtained from kfiber_thread_convert().
+ */
+KAPI void kfiber_thread_revert(kfiber *fiber);
+
+/**
+ * Creates a new fiber with its own stack. It does not run until switched to.
+ * @param stack_size The size of the fiber's stack in bytes.
+ * @param start_function_ptr The function to be invoked when the fiber is first switched to. Required, and must never return.
+ * @param params A pointer to any data to be passed to start_function_ptr. Optional.
+ * @param out_fiber A pointer to hold the created fiber.
+ * @returns true on success; otherwise false.
+ */
+KAPI b8 kfiber_create(u64 stack_size, pfn_fiber_start start_function_ptr, void *params, kfiber *out_fiber);
+
+/**
+ * Destroys the given fiber, releasing its stack. Must not be the fiber currently running.
+ */
+KAPI void kfiber_destroy(kfiber *fiber);
+
+/**
+ * Saves the current context into from, and continues running to. Returns once something
+ * switches back to from, which may be on another thread.
+ * @param from A pointer to the fiber currently running on this thread.
+ * @param to A pointer to the fiber to be run.
+ */
+KAPI void kfiber_switch(kfiber *from, kfiber *to);
+
+#endif
@@ -17,6 +17,43 @@ typedef struct kthread {
 // A function pointer to be invoked when the thread starts.
 typedef u32 (*pfn_thread_start)(void *);
 
+/** @brief The max length of a thread name, including the null terminator. Longer names are truncated. */
+#define KTHREAD_NAME_MAX_LENGTH 16
+
+/**
+ * @brief The scheduling class of a thread. Mapped to the closest equivalent the platform
+ * offers. Raising priority may require privileges on some platforms (i.e. CAP_SYS_NICE on
+ * Linux), in which case the thread runs at normal priority and a warning is logged.
+ */
+typedef enum kthread_priority {
+    /** @brief The default for new threads. */
+    KTHREAD_PRIORITY_NORMAL = 0,
+    /** @brief Background work, which should give way to everything else. */
+    KTHREAD_PRIORITY_LOW,
+    /** @brief Latency-critical work such as audio mixing or I/O, which should run as soon as it is ready. */
+    KTHREAD_PRIORITY_HIGH
+} kthread_priority;
+
+/**
+ * @brief Optional settings for a new thread. A zeroed structure gives the same thread
+ * kthread_create() does.
+ */
+typedef struct kthread_options {
+    /**
+     * @brief The name shown for the thread in debuggers and profilers. Copied, and truncated
+     * to KTHREAD_NAME_MAX_LENGTH - 1 characters. Optional.
+     */
+    const char *name;
+    /**
+     * @brief A mask of the logical processors the thread may run on, where bit n is processor n.
+     * See platform_get_physical_core_affinity_masks(). 0 lets the thread run anywhere. Not
+     * supported on macOS, where it is ignored.
+     */
+    u64 affinity_mask;
+    /** @brief The scheduling class of the thread. */
+    kthread_priority priority;
+} kthread_options;
+
 /**
  * Creates a new thread, immediately calling the function pointed to.
  * @param start_function_ptr The pointer to the function to be invoked immediately. Required.
@@ -27,6 +64,18 @@ typedef u32 (*pfn_thread_start)(void *);
  */
 KAPI b8 kthread_create(pfn_thread_start start_function_ptr, void *params, b8 auto_detach, kthread *out_thread);
 
+/**
+ * Creates a new thread with the given options, immediately calling the function pointed to.
+ * The options are applied on the new thread before start_function_ptr is invoked.
+ * @param start_function_ptr The pointer to the function to be invoked immediately. Required.
+ * @param params A pointer to any data to be passed to the start_function_ptr. Optional. Pass 0/NULL if not used.
+ * @param options A pointer to the options for the thread. Optional. Pass 0/NULL for defaults.
+ * @param auto_detach Indicates if the thread should immediately release its resources when the work is complete. If true, out_thread is not set.
+ * @param out_thread A pointer to hold the created thread, if auto_detach is false.
+ * @returns true if successfully created; otherwise false.
+ */
+KAPI b8 kthread_create_with_options(pfn_thread_start start_function_ptr, void *params, const kthread_options *options, b8 auto_detach, kthread *out_thread);
+
 /**
  * Destroys the given thread.
  */
@@ -70,6 +119,12 @@ KAPI b8 kthread_is_active(kthread *thread);
  */
 KAPI void kthread_sleep(kthread *thread, u64 ms);
 
+/**
+ * Gives up the remainder of the calling thread's time slice, allowing other threads
+ * to run. Useful in spin-wait loops which may otherwise starve the thread being waited on.
+ */
+KAPI void kthread_yield(void);
+
 /**
  * @brief Obtains the identifier for the current thread.
  */
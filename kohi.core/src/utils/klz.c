@@ -0,0 +1,240 @@
+#include "klz.h"
+
+#include "memory/kmemory.h"
+
+// Copies here are short and frequent, so go straight to memcpy rather than through kcopy_memory.
+#include <string.h>
+
+#define KLZ_MIN_MATCH 4
+#define KLZ_MAX_OFFSET 65535
+#define KLZ_HASH_BITS 12
+// The last bytes of a block are always literals.
+#define KLZ_LAST_LITERALS 5
+// Matches are not searched for this close to the end of a block.
+#define KLZ_MATCH_SEARCH_LIMIT 12
+// Once this many bytes in a row have failed to match, matches are searched for less often,
+// so data which doesn't compress is passed over quickly.
+#define KLZ_SKIP_SHIFT 6
+
+static KINLINE u32 read_u32(const u8* p) {
+    u32 value;
+    memcpy(&value, p, sizeof(u32));
+    return value;
+}
+
+static KINLINE u64 read_u64(const u8* p) {
+    u64 value;
+    memcpy(&value, p, sizeof(u64));
+    return value;
+}
+
+// Copies 8 bytes at a time until at least size bytes have been copied. May write up to 7
+// bytes past dest + size, so callers make sure there is room.
+static KINLINE void wild_copy(u8* dest, const u8* source, u64 size) {
+    u8* end = dest + size;
+    do {
+        memcpy(dest, source, 8);
+        dest += 8;
+        source += 8;
+    } while (dest < end);
+}
+
+static KINLINE u32 hash_u32(u32 value) {
+    return (value * 2654435761U) >> (32 - KLZ_HASH_BITS);
+}
+
+// The number of bytes needed to hold the extra length bytes of a length field.
+static KINLINE u64 length_extra_size(u64 length) {
+    return length >= 15 ? (length - 15) / 255 + 1 : 0;
+}
+
+static KINLINE u8* length_extra_write(u8* op, u64 length) {
+    if (length >= 15) {
+        length -= 15;
+        while (length >= 255) {
+            *op++ = 255;
+            length -= 255;
+        }
+        *op++ = (u8)length;
+    }
+    return op;
+}
+
+// Writes a sequence. A match_length of 0 writes the final, literal-only sequence. Returns 0 if there isn't room.
+static u8* sequence_write(u8* op, const u8* op_end, const u8* literals, u64 literal_length, u32 offset, u64 match_length) {
+    u64 match_code = match_length ? match_length - KLZ_MIN_MATCH : 0;
+    u64 required = 1 + length_extra_size(literal_length) + literal_length;
+    if (match_length) {
+        required += 2 + length_extra_size(match_code);
+    }
+    if (required > (u64)(op_end - op)) {
+        return 0;
+    }
+
+    *op++ = (u8)((KMIN(literal_length, 15) << 4) | KMIN(match_code, 15));
+    op = length_extra_write(op, literal_length);
+    memcpy(op, literals, literal_length);
+    op += literal_length;
+    if (match_length) {
+        *op++ = (u8)(offset & 0xFF);
+        *op++ = (u8)(offset >> 8);
+        op = length_extra_write(op, match_code);
+    }
+    return op;
+}
+
+u64 klz_compress_bound(u64 size) {
+    return size + size / 255 + 16;
+}
+
+u64 klz_compress(const void* source, u64 source_size, void* dest, u64 dest_capacity) {
+    if (!source || !dest || source_size > U32_MAX) {
+        return 0;
+    }
+
+    const u8* src = source;
+    const u8* ip = src;
+    const u8* anchor = src;
+    const u8* end = src + source_size;
+    u8* op = dest;
+    const u8* op_end = op + dest_capacity;
+
+    if (source_size > KLZ_MATCH_SEARCH_LIMIT) {
+        const u8* search_end = end - KLZ_MATCH_SEARCH_LIMIT;
+        const u8* match_end = end - KLZ_LAST_LITERALS;
+
+        // The position of the last occurrence of each hashed 4 bytes.
+        u32 table[1 << KLZ_HASH_BITS];
+        kzero_memory(table, sizeof(table));
+
+        while (ip < search_end) {
+            u32 sequence = read_u32(ip);
+            u32 hash = hash_u32(sequence);
+            const u8* ref = src + table[hash];
+            table[hash] = (u32)(ip - src);
+
+            if (ref >= ip || ip - ref > KLZ_MAX_OFFSET || read_u32(ref) != sequence) {
+                ip += 1 + ((u64)(ip - anchor) >> KLZ_SKIP_SHIFT);
+                continue;
+            }
+
+            // Extend the match forward, then back over any literals which also match.
+            const u8* mp = ip + KLZ_MIN_MATCH;
+            const u8* rp = ref + KLZ_MIN_MATCH;
+            while (mp + 8 <= match_end && read_u64(mp) == read_u64(rp)) {
+                mp += 8;
+                rp += 8;
+            }
+            while (mp < match_end && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+
+            op = sequence_write(op, op_end, anchor, (u64)(ip - anchor), (u32)(ip - ref), (u64)(mp - ip));
+            if (!op) {
+                return 0;
+            }
+
+            // Note a position inside the match, so repeats of its tail are found too.
+            table[hash_u32(read_u32(mp - 2))] = (u32)(mp - 2 - src);
+            ip = mp;
+            anchor = ip;
+        }
+    }
+
+    op = sequence_write(op, op_end, anchor, (u64)(end - anchor), 0, 0);
+    if (!op) {
+        return 0;
+    }
+    return (u64)(op - (u8*)dest);
+}
+
+b8 klz_decompress(const void* source, u64 source_size, void* dest, u64 dest_size) {
+    if (!source || !dest) {
+        return false;
+    }
+
+    const u8* ip = source;
+    const u8* ip_end = ip + source_size;
+    u8* op = dest;
+    u8* op_end = op + dest_size;
+
+    while (ip < ip_end) {
+        u8 token = *ip++;
+
+        // Literals.
+        u64 literal_length = token >> 4;
+        if (literal_length == 15) {
+            u8 b;
+            do {
+                if (ip >= ip_end) {
+                    return false;
+                }
+                b = *ip++;
+                literal_length += b;
+            } while (b == 255);
+        }
+        if (literal_length > (u64)(ip_end - ip) || literal_length > (u64)(op_end - op)) {
+            return false;
+        }
+        // Most runs are short. Away from the ends of the buffers, copy them in whole words.
+        if ((u64)(ip_end - ip) >= literal_length + 8 && (u64)(op_end - op) >= literal_length + 8) {
+            wild_copy(op, ip, literal_length);
+        } else {
+            memcpy(op, ip, literal_length);
+        }
+        ip += literal_length;
+        op += literal_length;
+
+        // The last sequence has no match.
+        if (ip == ip_end) {
+            break;
+        }
+
+        // Match.
+        if (ip_end - ip < 2) {
+            return false;
+        }
+        u32 offset = (u32)ip[0] | ((u32)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (u64)(op - (u8*)dest)) {
+            return false;
+        }
+        u64 match_length = token & 15;
+        if (match_length == 15) {
+            u8 b;
+            do {
+                if (ip >= ip_end) {
+                    return false;
+                }
+                b = *ip++;
+                match_length += b;
+            } while (b == 255);
+        }
+        match_length += KLZ_MIN_MATCH;
+        if (match_length > (u64)(op_end - op)) {
+            return false;
+        }
+
+        const u8* match = op - offset;
+        if (offset >= 8 && (u64)(op_end - op) >= match_length + 8) {
+            // Far enough back that each word read has already been written.
+            wild_copy(op, match, match_length);
+            op += match_length;
+        } else if (offset >= match_length) {
+            memcpy(op, match, match_length);
+            op += match_length;
+        } else {
+            // The match overlaps the bytes being written (i.e. a repeating pattern), so copy forward one at a time.
+            for (u64 i = 0; i < match_length; ++i) {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    return op == op_end;
+}
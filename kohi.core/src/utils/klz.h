@@ -0,0 +1,60 @@
+/**
+ * @file klz.h
+ * @author Travis Vroman (travis@kohiengine.com)
+ * @brief A fast LZ77-family block compressor.
+ * @details Favours decompression speed over ratio, so compressed assets may be read
+ * faster than the uncompressed originals could be. Each block is independent and must
+ * be decompressed whole, so large data should be split into blocks which may then be
+ * (de)compressed in parallel.
+ *
+ * A block is a series of sequences, each made of a token byte, some literal bytes to
+ * be copied as-is, and a match to be copied from earlier in the output:
+ * - Token: the high 4 bits are the literal length, and the low 4 bits the match length
+ *   less 4. A value of 15 means more length bytes follow (each adds up to 255; a byte
+ *   below 255 ends the run).
+ * - The literal length bytes, if any, then the literals.
+ * - A 2-byte little-endian offset back into the output to copy the match from (1-65535).
+ * - The match length bytes, if any.
+ * The last sequence has literals only, and ends the block.
+ * @version 1.0
+ * @date 2024-11-20
+ *
+ * @copyright Kohi Game Engine is Copyright (c) Travis Vroman 2021-2024
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief Obtains the largest possible compressed size of a block of the given size.
+ *
+ * @param size The uncompressed size in bytes.
+ * @returns The largest size the block could compress to, in bytes.
+ */
+KAPI u64 klz_compress_bound(u64 size);
+
+/**
+ * @brief Compresses the given data as one block.
+ *
+ * @param source The data to compress.
+ * @param source_size The size of the data in bytes. Must be no greater than U32_MAX.
+ * @param dest The block of memory to hold the compressed data.
+ * @param dest_capacity The size of dest in bytes. If less than klz_compress_bound(source_size),
+ * compression fails if the result doesn't fit, which may be used to only accept data which compresses.
+ * @returns The compressed size in bytes, or 0 on failure.
+ */
+KAPI u64 klz_compress(const void* source, u64 source_size, void* dest, u64 dest_capacity);
+
+/**
+ * @brief Decompresses a block produced by klz_compress(). Corrupt data is detected
+ * rather than read or written out of bounds.
+ *
+ * @param source The compressed block.
+ * @param source_size The size of the compressed block in bytes.
+ * @param dest The block of memory to hold the decompressed data.
+ * @param dest_size The exact decompressed size in bytes.
+ * @returns True on success; false if the block is corrupt or does not decompress to dest_size bytes.
+ */
+KAPI b8 klz_decompress(const void* source, u64 source_size, void* dest, u64 dest_size);
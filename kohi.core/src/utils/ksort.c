@@ -2,50 +2,154 @@
 
 #include "memory/kmemory.h"
 
+// Ranges of this many elements or fewer are insertion sorted.
+#define KSORT_INSERTION_THRESHOLD 16
+// Elements up to this size use stack scratch memory rather than allocating.
+#define KSORT_STACK_SCRATCH_SIZE 256
+
+// Radix sorting is done a byte at a time.
+#define KRADIX_DIGIT_COUNT 256
+
 void ptr_swap(void* scratch_mem, u64 size, void* a, void* b) {
     kcopy_memory(scratch_mem, a, size);
     kcopy_memory(a, b, size);
     kcopy_memory(b, scratch_mem, size);
 }
 
-static void* data_at_index(void* block, u64 element_size, u32 index) {
-    u64 addr = (u64)block;
-    addr += (element_size * index);
-    return (void*)(addr);
+static KINLINE void* data_at_index(void* block, u64 element_size, i32 index) {
+    return (u8*)block + (element_size * (u64)index);
+}
+
+// True if a should be placed before b.
+static KINLINE b8 sort_before(PFN_kquicksort_compare compare_pfn, void* a, void* b) {
+    return compare_pfn(a, b) > 0;
+}
+
+static void insertion_sort(void* temp, u64 size, void* data, i32 low_index, i32 high_index, PFN_kquicksort_compare compare_pfn) {
+    for (i32 i = low_index + 1; i <= high_index; ++i) {
+        kcopy_memory(temp, data_at_index(data, size, i), size);
+        i32 j = i;
+        while (j > low_index && sort_before(compare_pfn, temp, data_at_index(data, size, j - 1))) {
+            kcopy_memory(data_at_index(data, size, j), data_at_index(data, size, j - 1), size);
+            --j;
+        }
+        if (j != i) {
+            kcopy_memory(data_at_index(data, size, j), temp, size);
+        }
+    }
+}
+
+// Sifts the element at root down the heap held in [low_index, low_index + heap_count).
+static void heap_sift_down(void* temp, u64 size, void* data, i32 low_index, i32 root, i32 heap_count, PFN_kquicksort_compare compare_pfn) {
+    for (;;) {
+        i32 child = (root * 2) + 1;
+        if (child >= heap_count) {
+            break;
+        }
+        void* child_data = data_at_index(data, size, low_index + child);
+        if (child + 1 < heap_count) {
+            void* right_data = data_at_index(data, size, low_index + child + 1);
+            if (sort_before(compare_pfn, child_data, right_data)) {
+                ++child;
+                child_data = right_data;
+            }
+        }
+        void* root_data = data_at_index(data, size, low_index + root);
+        if (!sort_before(compare_pfn, root_data, child_data)) {
+            break;
+        }
+        ptr_swap(temp, size, root_data, child_data);
+        root = child;
+    }
+}
+
+static void heap_sort(void* temp, u64 size, void* data, i32 low_index, i32 high_index, PFN_kquicksort_compare compare_pfn) {
+    i32 count = high_index - low_index + 1;
+    for (i32 i = (count / 2) - 1; i >= 0; --i) {
+        heap_sift_down(temp, size, data, low_index, i, count, compare_pfn);
+    }
+    for (i32 end = count - 1; end > 0; --end) {
+        ptr_swap(temp, size, data_at_index(data, size, low_index), data_at_index(data, size, low_index + end));
+        heap_sift_down(temp, size, data, low_index, 0, end, compare_pfn);
+    }
 }
 
-static i32 kquick_sort_partition(void* scratch_mem, u64 size, void* data, i32 low_index, i32 high_index, PFN_kquicksort_compare compare_pfn) {
-    void* pivot = data_at_index(data, size, high_index);
-    i32 i = (low_index - 1);
+// Orders the low, middle and high elements and partitions around the middle one.
+// Returns the last index of the lower partition, which is always in [low_index, high_index).
+static i32 partition(void* temp, void* pivot, u64 size, void* data, i32 low_index, i32 high_index, PFN_kquicksort_compare compare_pfn) {
+    i32 mid_index = low_index + ((high_index - low_index) / 2);
+    void* low = data_at_index(data, size, low_index);
+    void* mid = data_at_index(data, size, mid_index);
+    void* high = data_at_index(data, size, high_index);
+    if (sort_before(compare_pfn, mid, low)) {
+        ptr_swap(temp, size, mid, low);
+    }
+    if (sort_before(compare_pfn, high, mid)) {
+        ptr_swap(temp, size, high, mid);
+        if (sort_before(compare_pfn, mid, low)) {
+            ptr_swap(temp, size, mid, low);
+        }
+    }
+    kcopy_memory(pivot, mid, size);
 
-    for (i32 j = low_index; j <= high_index - 1; ++j) {
-        void* dataj = data_at_index(data, size, j);
-        i32 result = compare_pfn(dataj, pivot);
-        if (result > 0) {
+    // Hoare partitioning. Elements equal to the pivot stop both scans, so runs of
+    // equal elements are split evenly rather than all ending up on one side.
+    i32 i = low_index - 1;
+    i32 j = high_index + 1;
+    for (;;) {
+        do {
             ++i;
-            void* datai = data_at_index(data, size, i);
-            ptr_swap(scratch_mem, size, datai, dataj);
+        } while (sort_before(compare_pfn, data_at_index(data, size, i), pivot));
+        do {
+            --j;
+        } while (sort_before(compare_pfn, pivot, data_at_index(data, size, j)));
+        if (i >= j) {
+            return j;
         }
+        ptr_swap(temp, size, data_at_index(data, size, i), data_at_index(data, size, j));
     }
-    ptr_swap(scratch_mem, size, data_at_index(data, size, i + 1), data_at_index(data, size, high_index));
-    return i + 1;
 }
 
-static void kquick_sort_internal(void* scratch_mem, u64 size, void* data, i32 low_index, i32 high_index, PFN_kquicksort_compare compare_pfn) {
-    if (low_index < high_index) {
-        i32 partition_index = kquick_sort_partition(scratch_mem, size, data, low_index, high_index, compare_pfn);
-        kquick_sort_internal(scratch_mem, size, data, low_index, partition_index - 1, compare_pfn);
-        kquick_sort_internal(scratch_mem, size, data, partition_index + 1, high_index, compare_pfn);
+static void introsort(void* temp, void* pivot, u64 size, void* data, i32 low_index, i32 high_index, u32 depth_limit, PFN_kquicksort_compare compare_pfn) {
+    while (high_index - low_index + 1 > KSORT_INSERTION_THRESHOLD) {
+        if (depth_limit == 0) {
+            // Partitioning is going badly for this input, so finish with a guaranteed O(n log n).
+            heap_sort(temp, size, data, low_index, high_index, compare_pfn);
+            return;
+        }
+        depth_limit--;
+
+        i32 split = partition(temp, pivot, size, data, low_index, high_index, compare_pfn);
+        // Recurse into the smaller side and loop on the larger, which bounds the stack to O(log n).
+        if (split - low_index < high_index - split) {
+            introsort(temp, pivot, size, data, low_index, split, depth_limit, compare_pfn);
+            low_index = split + 1;
+        } else {
+            introsort(temp, pivot, size, data, split + 1, high_index, depth_limit, compare_pfn);
+            high_index = split;
+        }
     }
+    insertion_sort(temp, size, data, low_index, high_index, compare_pfn);
 }
 
 void kquick_sort(u64 type_size, void* data, i32 low_index, i32 high_index, PFN_kquicksort_compare compare_pfn) {
-    if (low_index < high_index) {
-        void* scratch_mem = kallocate(type_size, MEMORY_TAG_ARRAY);
-        i32 partition_index = kquick_sort_partition(scratch_mem, type_size, data, low_index, high_index, compare_pfn);
-        kquick_sort_internal(scratch_mem, type_size, data, low_index, partition_index - 1, compare_pfn);
-        kquick_sort_internal(scratch_mem, type_size, data, partition_index + 1, high_index, compare_pfn);
-        kfree(scratch_mem, type_size, MEMORY_TAG_ARRAY);
+    if (!data || !type_size || !compare_pfn || low_index >= high_index) {
+        return;
+    }
+
+    // Room for a temporary element for swaps/shifts and a copy of the current pivot.
+    u8 stack_scratch[KSORT_STACK_SCRATCH_SIZE];
+    u64 scratch_size = type_size * 2;
+    void* scratch_mem = scratch_size <= KSORT_STACK_SCRATCH_SIZE ? stack_scratch : kallocate(scratch_size, MEMORY_TAG_ARRAY);
+
+    u32 depth_limit = 0;
+    for (u32 n = (u32)(high_index - low_index + 1); n > 1; n >>= 1) {
+        depth_limit += 2;
+    }
+    introsort(scratch_mem, (u8*)scratch_mem + type_size, type_size, data, low_index, high_index, depth_limit, compare_pfn);
+
+    if (scratch_mem != stack_scratch) {
+        kfree(scratch_mem, scratch_size, MEMORY_TAG_ARRAY);
     }
 }
 
@@ -70,3 +174,159 @@ i32 kquicksort_compare_u32(void* a, void* b) {
     }
     return 0;
 }
+
+static KINLINE u64 radix_key_get(const void* keys, u32 key_size, u32 index) {
+    return key_size == sizeof(u64) ? ((const u64*)keys)[index] : ((const u32*)keys)[index];
+}
+
+static KINLINE void radix_key_set(void* keys, u32 key_size, u32 index, u64 value) {
+    if (key_size == sizeof(u64)) {
+        ((u64*)keys)[index] = value;
+    } else {
+        ((u32*)keys)[index] = (u32)value;
+    }
+}
+
+/**
+ * Builds the histogram of every byte of the keys in a single read, then turns each
+ * into starting offsets. Bytes for which every key falls into the same bucket would
+ * not change the order, so they are left out. Returns the number of bytes which need
+ * a pass, which are listed in out_pass_bytes.
+ */
+static u32 radix_offsets_build(const void* keys, u32 key_size, u32 count, u32 offsets[][KRADIX_DIGIT_COUNT], u32* out_pass_bytes) {
+    kzero_memory(offsets, sizeof(u32) * KRADIX_DIGIT_COUNT * key_size);
+    for (u32 i = 0; i < count; ++i) {
+        u64 key = radix_key_get(keys, key_size, i);
+        for (u32 b = 0; b < key_size; ++b) {
+            offsets[b][(key >> (b * 8)) & 0xFF]++;
+        }
+    }
+
+    u32 pass_count = 0;
+    for (u32 b = 0; b < key_size; ++b) {
+        if (offsets[b][(radix_key_get(keys, key_size, 0) >> (b * 8)) & 0xFF] == count) {
+            continue;
+        }
+        u32 total = 0;
+        for (u32 d = 0; d < KRADIX_DIGIT_COUNT; ++d) {
+            u32 bucket_count = offsets[b][d];
+            offsets[b][d] = total;
+            total += bucket_count;
+        }
+        out_pass_bytes[pass_count++] = b;
+    }
+    return pass_count;
+}
+
+static void radix_sort(void* keys, u32 key_size, u32 count, void* scratch) {
+    if (!keys || count < 2) {
+        return;
+    }
+
+    u32 offsets[sizeof(u64)][KRADIX_DIGIT_COUNT];
+    u32 pass_bytes[sizeof(u64)];
+    u32 pass_count = radix_offsets_build(keys, key_size, count, offsets, pass_bytes);
+    if (!pass_count) {
+        return;
+    }
+
+    u64 scratch_size = (u64)key_size * count;
+    void* temp = scratch ? scratch : kallocate(scratch_size, MEMORY_TAG_ARRAY);
+
+    void* source = keys;
+    void* dest = temp;
+    for (u32 p = 0; p < pass_count; ++p) {
+        u32 shift = pass_bytes[p] * 8;
+        u32* pass_offsets = offsets[pass_bytes[p]];
+        for (u32 i = 0; i < count; ++i) {
+            u64 key = radix_key_get(source, key_size, i);
+            radix_key_set(dest, key_size, pass_offsets[(key >> shift) & 0xFF]++, key);
+        }
+        void* swap = source;
+        source = dest;
+        dest = swap;
+    }
+
+    // After an odd number of passes, the sorted keys are in the scratch memory.
+    if (source != keys) {
+        kcopy_memory(keys, source, scratch_size);
+    }
+
+    if (!scratch) {
+        kfree(temp, scratch_size, MEMORY_TAG_ARRAY);
+    }
+}
+
+static void radix_sort_indices(const void* keys, u32 key_size, u32 count, u32* out_indices, void* scratch) {
+    if (!keys || !out_indices || !count) {
+        return;
+    }
+
+    u32 offsets[sizeof(u64)][KRADIX_DIGIT_COUNT];
+    u32 pass_bytes[sizeof(u64)];
+    u32 pass_count = count > 1 ? radix_offsets_build(keys, key_size, count, offsets, pass_bytes) : 0;
+    if (!pass_count) {
+        for (u32 i = 0; i < count; ++i) {
+            out_indices[i] = i;
+        }
+        return;
+    }
+
+    u64 scratch_size = ((u64)key_size * 2 + sizeof(u32)) * count;
+    u8* temp = scratch ? scratch : kallocate(scratch_size, MEMORY_TAG_ARRAY);
+    void* keys_a = temp;
+    void* keys_b = temp + ((u64)key_size * count);
+    u32* indices_b = (u32*)(temp + ((u64)key_size * 2 * count));
+
+    // The keys are moved along with their indices, since each pass reads the order
+    // left by the one before. The buffers are alternated such that the last pass
+    // writes into out_indices. The first pass reads the caller's keys directly.
+    const void* source_keys = keys;
+    const u32* source_indices = 0;
+    for (u32 p = 0; p < pass_count; ++p) {
+        b8 to_out = ((pass_count - 1 - p) % 2) == 0;
+        void* dest_keys = to_out ? keys_a : keys_b;
+        u32* dest_indices = to_out ? out_indices : indices_b;
+        u32 shift = pass_bytes[p] * 8;
+        u32* pass_offsets = offsets[pass_bytes[p]];
+        for (u32 i = 0; i < count; ++i) {
+            u64 key = radix_key_get(source_keys, key_size, i);
+            u32 dest_index = pass_offsets[(key >> shift) & 0xFF]++;
+            radix_key_set(dest_keys, key_size, dest_index, key);
+            dest_indices[dest_index] = source_indices ? source_indices[i] : i;
+        }
+        source_keys = dest_keys;
+        source_indices = dest_indices;
+    }
+
+    if (!scratch) {
+        kfree(temp, scratch_size, MEMORY_TAG_ARRAY);
+    }
+}
+
+void kradix_sort_u32(u32* keys, u32 count, u32* scratch) {
+    radix_sort(keys, sizeof(u32), count, scratch);
+}
+
+void kradix_sort_u64(u64* keys, u32 count, u64* scratch) {
+    radix_sort(keys, sizeof(u64), count, scratch);
+}
+
+void kradix_sort_u32_indices(const u32* keys, u32 count, u32* out_indices, void* scratch) {
+    radix_sort_indices(keys, sizeof(u32), count, out_indices, scratch);
+}
+
+void kradix_sort_u64_indices(const u64* keys, u32 count, u32* out_indices, void* scratch) {
+    radix_sort_indices(keys, sizeof(u64), count, out_indices, scratch);
+}
+
+void ksort_gather(u64 type_size, const void* source, const u32* indices, u32 count, void* dest) {
+    if (!source || !indices || !dest) {
+        return;
+    }
+    const u8* source_bytes = source;
+    u8* dest_bytes = dest;
+    for (u32 i = 0; i < count; ++i) {
+        kcopy_memory(dest_bytes + (type_size * i), source_bytes + (type_size * indices[i]), type_size);
+    }
+}
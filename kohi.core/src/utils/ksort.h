@@ -2,11 +2,108 @@
 
 #include "defines.h"
 
+/**
+ * @brief Compares two elements for sorting. Should return a positive value if a
+ * should be placed before b, a negative value if b should be placed before a, or 0
+ * if their order does not matter.
+ */
 typedef i32 (*PFN_kquicksort_compare)(void* a, void* b);
 
 KAPI void ptr_swap(void* scratch_mem, u64 size, void* a, void* b);
 
+/**
+ * @brief Sorts the elements from low_index to high_index (inclusive) in place using the
+ * given comparison. Uses an introsort: quicksort with a median-of-three pivot, falling
+ * back to heapsort if partitioning goes badly and to insertion sort for small ranges.
+ * This keeps the worst case at O(n log n) time and O(log n) stack. Not stable.
+ *
+ * NOTE: Every swap moves whole elements. For large elements, consider sorting keys
+ * with kradix_sort_u32_indices()/kradix_sort_u64_indices() and gathering instead.
+ *
+ * @param type_size The size of each element in bytes.
+ * @param data The elements to be sorted.
+ * @param low_index The index of the first element to be sorted.
+ * @param high_index The index of the last element to be sorted.
+ * @param compare_pfn The comparison to sort by.
+ */
 KAPI void kquick_sort(u64 type_size, void* data, i32 low_index, i32 high_index, PFN_kquicksort_compare compare_pfn);
 
 KAPI i32 kquicksort_compare_u32_desc(void* a, void* b);
 KAPI i32 kquicksort_compare_u32(void* a, void* b);
+
+/** @brief The size in bytes of the scratch memory needed to sort count keys of key_type with the _indices radix sorts. */
+#define KRADIX_SORT_INDICES_SCRATCH_SIZE(key_type, count) (((sizeof(key_type) * 2) + sizeof(u32)) * (u64)(count))
+
+/**
+ * @brief Sorts the given keys in place into ascending order using an LSD radix sort.
+ * O(n) for any input. Byte positions which are the same across all keys are skipped.
+ *
+ * @param keys The keys to be sorted.
+ * @param count The number of keys.
+ * @param scratch Room for count keys to be used while sorting. If 0, it is allocated internally.
+ */
+KAPI void kradix_sort_u32(u32* keys, u32 count, u32* scratch);
+
+/**
+ * @brief Sorts the given keys in place into ascending order using an LSD radix sort.
+ * O(n) for any input. Byte positions which are the same across all keys are skipped.
+ *
+ * @param keys The keys to be sorted.
+ * @param count The number of keys.
+ * @param scratch Room for count keys to be used while sorting. If 0, it is allocated internally.
+ */
+KAPI void kradix_sort_u64(u64* keys, u32 count, u64* scratch);
+
+/**
+ * @brief Obtains the order the given keys would be in if sorted ascending, without moving
+ * them. out_indices[i] is the index of the key which belongs at position i. The sort is
+ * stable, so equal keys keep their original relative order. Apply the result to the
+ * data the keys were taken from with ksort_gather().
+ *
+ * @param keys The keys to sort by. Not modified.
+ * @param count The number of keys.
+ * @param out_indices An array of count indices to hold the sorted order.
+ * @param scratch KRADIX_SORT_INDICES_SCRATCH_SIZE(u32, count) bytes to be used while sorting. If 0, it is allocated internally.
+ */
+KAPI void kradix_sort_u32_indices(const u32* keys, u32 count, u32* out_indices, void* scratch);
+
+/**
+ * @brief Obtains the order the given keys would be in if sorted ascending, without moving
+ * them. out_indices[i] is the index of the key which belongs at position i. The sort is
+ * stable, so equal keys keep their original relative order. Apply the result to the
+ * data the keys were taken from with ksort_gather().
+ *
+ * @param keys The keys to sort by. Not modified.
+ * @param count The number of keys.
+ * @param out_indices An array of count indices to hold the sorted order.
+ * @param scratch KRADIX_SORT_INDICES_SCRATCH_SIZE(u64, count) bytes to be used while sorting. If 0, it is allocated internally.
+ */
+KAPI void kradix_sort_u64_indices(const u64* keys, u32 count, u32* out_indices, void* scratch);
+
+/**
+ * @brief Copies elements from source into dest in the order given by indices, such that
+ * dest[i] = source[indices[i]]. source and dest must not overlap.
+ *
+ * @param type_size The size of each element in bytes.
+ * @param source The elements to be copied from.
+ * @param indices The index in source of each element of dest.
+ * @param count The number of elements to copy.
+ * @param dest The array to copy into. Must have room for count elements.
+ */
+KAPI void ksort_gather(u64 type_size, const void* source, const u32* indices, u32 count, void* dest);
+
+/**
+ * @brief Converts a float into a u32 key which sorts in the same order as the float
+ * does (i.e. -1.0f < 0.0f < 1.0f), for use with radix sorting. NaNs sort to the ends.
+ */
+KINLINE u32 kradix_key_from_f32(f32 value) {
+    union {
+        f32 f;
+        u32 u;
+    } bits;
+    bits.f = value;
+    // Negative values have all bits flipped so larger magnitudes sort first. Positive
+    // values only have the sign bit flipped so they sort after all negative ones.
+    u32 mask = (u32)(-(i32)(bits.u >> 31)) | 0x80000000u;
+    return bits.u ^ mask;
+}
@@ -17,6 +17,7 @@
 #include <math/kmath.h>
 #include <memory/kmemory.h>
 #include <platform/platform.h>
+#include <strings/kstring.h>
 #include <threads/kmutex.h>
 #include <threads/kthread.h>
 
@@ -29,7 +30,7 @@
 // Runtime
 #include <audio/kaudio_types.h>
 #include <core_audio_types.h>
-#include <systems/job_system.h>
+#include <threads/job_system.h>
 #include <utils/audio_utils.h>
 
 // The number of buffers used for streaming music file data.
@@ -797,6 +798,8 @@ static u32 source_work_thread(void* params) {
     }
 
     KDEBUG("Audio source thread shutting down.");
+    // Hand any cached small allocations back before the thread goes away.
+    kmemory_thread_cache_flush();
     return 0;
 }
 
@@ -851,7 +854,12 @@ static b8 openal_backend_channel_create(kaudio_backend_interface* backend, kaudi
     ksource_work_thread_params* params = kallocate(sizeof(ksource_work_thread_params), MEMORY_TAG_AUDIO);
     params->source = out_source;
     params->backend = backend;
-    kthread_create(source_work_thread, params, true, &out_source->thread);
+    // Audio falls silent if a source isn't fed in time, so its thread is latency-critical.
+    kthread_options options = {0};
+    options.name = string_format("kohi_audio_%u", out_source->id);
+    options.priority = KTHREAD_PRIORITY_HIGH;
+    kthread_create_with_options(source_work_thread, params, &options, true, &out_source->thread);
+    string_free(options.name);
 
     return true;
 }
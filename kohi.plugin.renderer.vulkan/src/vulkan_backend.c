@@ -4272,7 +4272,7 @@ static b8 setup_frequency_state(renderer_backend_interface* backend, vulkan_shad
         u64 size = frequency_info->ubo_stride;
         if (size > 0) {
             for (u32 i = 0; i < VULKAN_RESOURCE_IMAGE_COUNT; ++i) {
-                if (!renderer_renderbuffer_allocate(&internal->uniform_buffers[i], size, &frequency_state->offset)) {
+                if (!renderer_renderbuffer_allocate_aligned(&internal->uniform_buffers[i], size, context->device.properties.limits.minUniformBufferOffsetAlignment, &frequency_state->offset)) {
                     KERROR("setup_frequency_state failed to acquire %s ubo space", frequency_text);
                     return false;
                 }
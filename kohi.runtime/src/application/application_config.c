@@ -49,6 +49,14 @@ b8 application_config_parse_file_content(const char* file_content, application_c
         out_config->app_frame_data_size = (u64)iapp_frame_data_size;
     }
 
+    // job_thread_count is optional. The default of 0 sizes the job system to suit the machine.
+    i64 ijob_thread_count = 0;
+    if (kson_object_property_value_get_int(&app_config_tree.root, "job_thread_count", &ijob_thread_count) && ijob_thread_count > 0) {
+        out_config->job_thread_count = (u32)ijob_thread_count;
+    } else {
+        out_config->job_thread_count = 0;
+    }
+
     // Asset manifest file path
     if (!kson_object_property_value_get_string(&app_config_tree.root, "manifest_file_path", &out_config->manifest_file_path)) {
         KERROR("'manifest_file_path' is a required field in application config. Cannot continue.");
@@ -66,6 +66,9 @@ typedef struct application_config {
     /** @brief The size of the application-specific frame data. Set to 0 if not used. */
     u64 app_frame_data_size;
 
+    /** @brief The number of job threads to use. 0 uses one per physical core, less one for the main thread. */
+    u32 job_thread_count;
+
     /** @brief The asset manifest file path. */
     const char* manifest_file_path;
 
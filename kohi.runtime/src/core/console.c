@@ -2,10 +2,12 @@
 
 #include "containers/darray.h"
 #include "containers/stack.h"
+#include "containers/u64_hashmap.h"
 #include "debug/kassert.h"
 #include "defines.h"
 #include "logger.h"
 #include "memory/kmemory.h"
+#include "strings/kname.h"
 #include "strings/kstring.h"
 
 typedef struct console_consumer {
@@ -37,6 +39,11 @@ typedef struct console_state {
 
     // darray of registered console objects.
     console_object* registered_objects;
+
+    // Maps the kname of each registered command to its index in registered_commands.
+    u64_hashmap command_lookup;
+    // Maps the kname of each registered object to its index in registered_objects.
+    u64_hashmap object_lookup;
 } console_state;
 
 const u32 MAX_CONSUMER_COUNT = 10;
@@ -56,6 +63,8 @@ b8 console_initialize(u64* memory_requirement, struct console_state* memory, voi
 
     state_ptr->registered_commands = darray_create(console_command);
     state_ptr->registered_objects = darray_create(console_object);
+    u64_hashmap_create(sizeof(u32), 64, &state_ptr->command_lookup);
+    u64_hashmap_create(sizeof(u32), 64, &state_ptr->object_lookup);
 
     // Tell the logger about the console.
     logger_console_write_hook_set(console_write);
@@ -67,6 +76,8 @@ void console_shutdown(struct console_state* state) {
     if (state_ptr) {
         darray_destroy(state_ptr->registered_commands);
         darray_destroy(state_ptr->registered_objects);
+        u64_hashmap_destroy(&state_ptr->command_lookup);
+        u64_hashmap_destroy(&state_ptr->object_lookup);
 
         kzero_memory(state, sizeof(console_state) + (sizeof(console_consumer) * MAX_CONSUMER_COUNT));
     }
@@ -112,12 +123,10 @@ b8 console_command_register(const char* command, u8 arg_count, void* listener, P
     KASSERT_MSG(state_ptr && command, "console_register_command requires state and valid command");
 
     // Make sure it doesn't already exist.
-    u32 command_count = darray_length(state_ptr->registered_commands);
-    for (u32 i = 0; i < command_count; ++i) {
-        if (strings_equali(state_ptr->registered_commands[i].name, command)) {
-            KERROR("Command already registered: %s", command);
-            return false;
-        }
+    kname key = kname_create(command);
+    if (u64_hashmap_contains(&state_ptr->command_lookup, key)) {
+        KERROR("Command already registered: %s", command);
+        return false;
     }
 
     console_command new_command = {
@@ -127,7 +136,9 @@ b8 console_command_register(const char* command, u8 arg_count, void* listener, P
         .listener = listener,
     };
 
+    u32 index = darray_length(state_ptr->registered_commands);
     darray_push(state_ptr->registered_commands, new_command);
+    u64_hashmap_set(&state_ptr->command_lookup, key, &index);
 
     return true;
 }
@@ -136,17 +147,22 @@ b8 console_command_unregister(const char* command) {
     KASSERT_MSG(state_ptr && command, "console_update_command requires state and valid command");
 
     // Make sure it doesn't already exist.
+    u32 index;
+    if (!u64_hashmap_remove(&state_ptr->command_lookup, kname_create(command), &index)) {
+        return false;
+    }
+
+    // Command found, remove it.
+    console_command popped_command;
+    darray_pop_at(state_ptr->registered_commands, index, &popped_command);
+
+    // Everything after it has moved down a slot.
     u32 command_count = darray_length(state_ptr->registered_commands);
-    for (u32 i = 0; i < command_count; ++i) {
-        if (strings_equali(state_ptr->registered_commands[i].name, command)) {
-            // Command found, remove it.
-            console_command popped_command;
-            darray_pop_at(state_ptr->registered_commands, i, &popped_command);
-            return true;
-        }
+    for (u32 i = index; i < command_count; ++i) {
+        u64_hashmap_set(&state_ptr->command_lookup, kname_create(state_ptr->registered_commands[i].name), &i);
     }
 
-    return false;
+    return true;
 }
 
 static console_object* console_object_get(console_object* parent, const char* name) {
@@ -159,12 +175,9 @@ static console_object* console_object_get(console_object* parent, const char* na
             }
         }
     } else {
-        u32 registered_object_len = darray_length(state_ptr->registered_objects);
-        for (u32 i = 0; i < registered_object_len; ++i) {
-            console_object* obj = &state_ptr->registered_objects[i];
-            if (strings_equali(obj->name, name)) {
-                return obj;
-            }
+        u32 index;
+        if (u64_hashmap_get(&state_ptr->object_lookup, kname_create(name), &index)) {
+            return &state_ptr->registered_objects[index];
         }
     }
     return 0;
@@ -1109,41 +1122,37 @@ b8 console_command_execute(const char* command) {
     string_format_unsafe(temp, "-->%s", command);
     console_write(LOG_LEVEL_INFO, temp);
 
-    // Yep, strings are slow. But it's a console. It doesn't need to be lightning fast...
+    // Look up the registered command by name.
     b8 command_found = false;
-    u32 command_count = darray_length(state_ptr->registered_commands);
-    // Look through registered commands for a match.
-    for (u32 i = 0; i < command_count; ++i) {
-        console_command* cmd = &state_ptr->registered_commands[i];
-        if (strings_equali(cmd->name, parts[0])) {
-            command_found = true;
-            u8 arg_count = part_count - 1;
-            // Provided argument count must match expected number of arguments for the command.
-            if (state_ptr->registered_commands[i].arg_count != arg_count) {
-                KERROR("The console command '%s' requires %u arguments but %u were provided.", cmd->name, cmd->arg_count, arg_count);
-                has_error = true;
-            } else {
-                // Execute it, passing along arguments if needed.
-                console_command_context context = {0};
-                context.command = string_duplicate(command);
-                context.command_name = string_duplicate(cmd->name);
-                context.argument_count = cmd->arg_count;
-                if (context.argument_count > 0) {
-                    context.arguments = kallocate(sizeof(console_command_argument) * cmd->arg_count, MEMORY_TAG_ARRAY);
-                    for (u8 j = 0; j < cmd->arg_count; ++j) {
-                        context.arguments[j].value = parts[j + 1];
-                    }
+    u32 index;
+    if (u64_hashmap_get(&state_ptr->command_lookup, kname_create(parts[0]), &index)) {
+        console_command* cmd = &state_ptr->registered_commands[index];
+        command_found = true;
+        u8 arg_count = part_count - 1;
+        // Provided argument count must match expected number of arguments for the command.
+        if (cmd->arg_count != arg_count) {
+            KERROR("The console command '%s' requires %u arguments but %u were provided.", cmd->name, cmd->arg_count, arg_count);
+            has_error = true;
+        } else {
+            // Execute it, passing along arguments if needed.
+            console_command_context context = {0};
+            context.command = string_duplicate(command);
+            context.command_name = string_duplicate(cmd->name);
+            context.argument_count = cmd->arg_count;
+            if (context.argument_count > 0) {
+                context.arguments = kallocate(sizeof(console_command_argument) * cmd->arg_count, MEMORY_TAG_ARRAY);
+                for (u8 j = 0; j < cmd->arg_count; ++j) {
+                    context.arguments[j].value = parts[j + 1];
                 }
+            }
 
-                context.listener = cmd->listener;
+            context.listener = cmd->listener;
 
-                cmd->func(context);
+            cmd->func(context);
 
-                if (context.arguments) {
-                    kfree(context.arguments, sizeof(console_command_argument) * cmd->arg_count, MEMORY_TAG_ARRAY);
-                }
+            if (context.arguments) {
+                kfree(context.arguments, sizeof(console_command_argument) * cmd->arg_count, MEMORY_TAG_ARRAY);
             }
-            break;
         }
     }
 
@@ -1166,12 +1175,10 @@ b8 console_object_register(const char* object_name, void* object, console_object
     }
 
     // Make sure it doesn't already exist.
-    u32 object_count = darray_length(state_ptr->registered_objects);
-    for (u32 i = 0; i < object_count; ++i) {
-        if (strings_equali(state_ptr->registered_objects[i].name, object_name)) {
-            KERROR("Console object already registered: '%s'.", object_name);
-            return false;
-        }
+    kname key = kname_create(object_name);
+    if (u64_hashmap_contains(&state_ptr->object_lookup, key)) {
+        KERROR("Console object already registered: '%s'.", object_name);
+        return false;
     }
 
     console_object new_object = {};
@@ -1179,7 +1186,9 @@ b8 console_object_register(const char* object_name, void* object, console_object
     new_object.type = type;
     new_object.block = object;
     new_object.properties = 0;
+    u32 index = darray_length(state_ptr->registered_objects);
     darray_push(state_ptr->registered_objects, new_object);
+    u64_hashmap_set(&state_ptr->object_lookup, key, &index);
 
     return true;
 }
@@ -1191,17 +1200,22 @@ b8 console_object_unregister(const char* object_name) {
     }
 
     // Make sure it exists.
+    u32 index;
+    if (!u64_hashmap_remove(&state_ptr->object_lookup, kname_create(object_name), &index)) {
+        return false;
+    }
+
+    // Object found, remove it.
+    console_object popped_object;
+    darray_pop_at(state_ptr->registered_objects, index, &popped_object);
+
+    // Everything after it has moved down a slot.
     u32 object_count = darray_length(state_ptr->registered_objects);
-    for (u32 i = 0; i < object_count; ++i) {
-        if (strings_equali(state_ptr->registered_objects[i].name, object_name)) {
-            // Object found, remove it.
-            console_object popped_object;
-            darray_pop_at(state_ptr->registered_objects, i, &popped_object);
-            return true;
-        }
+    for (u32 i = index; i < object_count; ++i) {
+        u64_hashmap_set(&state_ptr->object_lookup, kname_create(state_ptr->registered_objects[i].name), &i);
     }
 
-    return false;
+    return true;
 }
 
 b8 console_object_add_property(const char* object_name, const char* property_name, void* property, console_object_type type) {
@@ -1211,37 +1225,34 @@ b8 console_object_add_property(const char* object_name, const char* property_nam
     }
 
     // Make sure the object exists first.
-    u32 object_count = darray_length(state_ptr->registered_objects);
-    for (u32 i = 0; i < object_count; ++i) {
-        if (strings_equali(state_ptr->registered_objects[i].name, object_name)) {
-            console_object* obj = &state_ptr->registered_objects[i];
-            // Found the object, now make sure a property with that name does not exist.
-            if (obj->properties) {
-                u32 property_count = darray_length(obj->properties);
-                for (u32 j = 0; j < property_count; ++j) {
-                    if (strings_equali(obj->properties[j].name, property_name)) {
-                        KERROR("Object '%s' already has a property named '%s'.", object_name, property_name);
-                        return false;
-                    }
-                }
-            } else {
-                obj->properties = darray_create(console_object);
-            }
-
-            // Create the new property, which is just another object.
-            console_object new_object = {};
-            new_object.name = string_duplicate(property_name);
-            new_object.type = type;
-            new_object.block = property;
-            new_object.properties = 0;
-            darray_push(obj->properties, new_object);
+    console_object* obj = console_object_get(0, object_name);
+    if (!obj) {
+        KERROR("Console object not found: '%s'.", object_name);
+        return false;
+    }
 
-            return true;
+    // Found the object, now make sure a property with that name does not exist.
+    if (obj->properties) {
+        u32 property_count = darray_length(obj->properties);
+        for (u32 j = 0; j < property_count; ++j) {
+            if (strings_equali(obj->properties[j].name, property_name)) {
+                KERROR("Object '%s' already has a property named '%s'.", object_name, property_name);
+                return false;
+            }
         }
+    } else {
+        obj->properties = darray_create(console_object);
     }
 
-    KERROR("Console object not found: '%s'.", object_name);
-    return false;
+    // Create the new property, which is just another object.
+    console_object new_object = {};
+    new_object.name = string_duplicate(property_name);
+    new_object.type = type;
+    new_object.block = property;
+    new_object.properties = 0;
+    darray_push(obj->properties, new_object);
+
+    return true;
 }
 
 static void console_object_destroy(console_object* obj) {
@@ -1264,28 +1275,25 @@ b8 console_object_remove_property(const char* object_name, const char* property_
     }
 
     // Make sure the object exists first.
-    u32 object_count = darray_length(state_ptr->registered_objects);
-    for (u32 i = 0; i < object_count; ++i) {
-        if (strings_equali(state_ptr->registered_objects[i].name, object_name)) {
-            console_object* obj = &state_ptr->registered_objects[i];
-            // Found the object, now make sure a property with that name does not exist.
-            if (obj->properties) {
-                u32 property_count = darray_length(obj->properties);
-                for (u32 j = 0; j < property_count; ++j) {
-                    if (strings_equali(obj->properties[j].name, property_name)) {
-                        console_object popped_property;
-                        darray_pop_at(obj->properties, j, &popped_property);
-                        console_object_destroy(&popped_property);
-                        return true;
-                    }
-                }
-            }
+    console_object* obj = console_object_get(0, object_name);
+    if (!obj) {
+        KERROR("Console object not found: '%s'.", object_name);
+        return false;
+    }
 
-            KERROR("Property '%s' not found on console object '%s'.", object_name, property_name);
-            return false;
+    // Found the object, now make sure a property with that name does not exist.
+    if (obj->properties) {
+        u32 property_count = darray_length(obj->properties);
+        for (u32 j = 0; j < property_count; ++j) {
+            if (strings_equali(obj->properties[j].name, property_name)) {
+                console_object popped_property;
+                darray_pop_at(obj->properties, j, &popped_property);
+                console_object_destroy(&popped_property);
+                return true;
+            }
         }
     }
 
-    KERROR("Console object not found: '%s'.", object_name);
+    KERROR("Property '%s' not found on console object '%s'.", object_name, property_name);
     return false;
 }
@@ -7,10 +7,12 @@
 #include <logger.h>
 #include <memory/allocators/linear_allocator.h>
 #include <memory/kmemory.h>
+#include <platform/async_io.h>
 #include <platform/filesystem.h>
 #include <platform/platform.h>
 #include <platform/vfs.h>
 #include <strings/kstring.h>
+#include <threads/job_system.h>
 #include <time/kclock.h>
 
 // Version reporting
@@ -33,7 +35,6 @@
 #include "systems/asset_system.h"
 #include "systems/camera_system.h"
 #include "systems/font_system.h"
-#include "systems/job_system.h"
 #include "systems/light_system.h"
 #include "systems/material_system.h"
 #include "systems/plugin_system.h"
@@ -110,6 +111,8 @@ static void engine_on_process_mouse_move(i16 x, i16 y);
 static void engine_on_process_mouse_wheel(i8 z_delta);
 static b8 engine_log_file_write(void* engine, log_level level, const char* message);
 static b8 engine_platform_console_write(void* platform, log_level level, const char* message);
+static void engine_on_job_system_stats(console_command_context context);
+static void engine_on_job_system_stats_reset(console_command_context context);
 
 b8 engine_create(application* app) {
     if (app->engine_state) {
@@ -120,6 +123,13 @@ b8 engine_create(application* app) {
     // Memory system must be the first thing to be stood up.
     memory_system_configuration memory_system_config = {};
     memory_system_config.total_alloc_size = GIBIBYTES(2);
+    memory_system_config.small_alloc_pool_size = MEBIBYTES(64);
+#if KPLATFORM_LINUX
+    // Reserve plenty of address space, but only commit what is actually used.
+    memory_system_config.total_alloc_size = GIBIBYTES(8);
+    memory_system_config.use_virtual_memory = true;
+    memory_system_config.use_huge_pages = true;
+#endif
     if (!memory_system_initialize(memory_system_config)) {
         KERROR("Failed to initialize memory system; shutting down.");
         return false;
@@ -203,6 +213,17 @@ b8 engine_create(application* app) {
 #endif
     KINFO("Kohi Runtime %s (%s)", KVERSION, build_type);
 
+    // Async I/O - must come before the VFS, which reads assets through it.
+    {
+        async_io_config async_io_sys_config = {0};
+        async_io_system_initialize(&systems->async_io_system_memory_requirement, 0, 0);
+        systems->async_io_system = kallocate(systems->async_io_system_memory_requirement, MEMORY_TAG_ENGINE);
+        if (!async_io_system_initialize(&systems->async_io_system_memory_requirement, systems->async_io_system, &async_io_sys_config)) {
+            KERROR("Failed to initialize async I/O system. See logs for details.");
+            return false;
+        }
+    }
+
     // Virtual File System
     {
         // TODO: Get the generic config from application config first.
@@ -329,33 +350,31 @@ b8 engine_create(application* app) {
     {
         b8 renderer_multithreaded = renderer_is_multithreaded();
 
-        // This is really a core count. Subtract 1 to account for the main thread already being in use.
-        i32 thread_count = platform_get_processor_count() - 1;
-        if (thread_count < 1) {
-            KFATAL("Error: Platform reported processor count (minus one for main thread) as %i. Need at least one additional thread for the job system.", thread_count);
-            return false;
-        } else {
-            KTRACE("Available threads: %i", thread_count);
-        }
+        // Sized to suit the machine unless the application config says otherwise.
+        i32 thread_count = app->app_config.job_thread_count ? (i32)app->app_config.job_thread_count : job_system_default_thread_count();
+        KTRACE("Available threads: %i", thread_count);
 
         // Cap the thread count.
-        const i32 max_thread_count = 15;
-        if (thread_count > max_thread_count) {
-            KTRACE("Available threads on the system is %i, but will be capped at %i.", thread_count, max_thread_count);
-            thread_count = max_thread_count;
+        if (thread_count > JOB_MAX_THREAD_COUNT) {
+            if (app->app_config.job_thread_count) {
+                KWARN("Application config asks for %i job threads, but this will be capped at %i.", thread_count, JOB_MAX_THREAD_COUNT);
+            } else {
+                KTRACE("Available threads on the system is %i, but will be capped at %i.", thread_count, JOB_MAX_THREAD_COUNT);
+            }
+            thread_count = JOB_MAX_THREAD_COUNT;
         }
 
         // Initialize the job system.
         // Requires knowledge of renderer multithread support, so should be initialized here.
-        u32 job_thread_types[15];
-        for (u32 i = 0; i < 15; ++i) {
+        u32 job_thread_types[JOB_MAX_THREAD_COUNT];
+        for (u32 i = 0; i < JOB_MAX_THREAD_COUNT; ++i) {
             job_thread_types[i] = JOB_TYPE_GENERAL;
         }
 
-        if (max_thread_count == 1 || !renderer_multithreaded) {
+        if (thread_count == 1 || !renderer_multithreaded) {
             // Everything on one job thread.
             job_thread_types[0] |= (JOB_TYPE_GPU_RESOURCE | JOB_TYPE_RESOURCE_LOAD);
-        } else if (max_thread_count == 2) {
+        } else if (thread_count == 2) {
             // Split things between the 2 threads
             job_thread_types[0] |= JOB_TYPE_GPU_RESOURCE;
             job_thread_types[1] |= JOB_TYPE_RESOURCE_LOAD;
@@ -375,6 +394,9 @@ b8 engine_create(application* app) {
             KERROR("Failed to initialize job system.");
             return false;
         }
+
+        console_command_register("job_system_stats", 0, 0, engine_on_job_system_stats);
+        console_command_register("job_system_stats_reset", 0, 0, engine_on_job_system_stats_reset);
     }
 
     // Audio system
@@ -639,6 +661,7 @@ b8 engine_run(application* app) {
             engine_state->p_frame_data.allocator.free_all();
 
             // TODO: Update systems here that need them.
+            async_io_system_update(engine_state->systems.async_io_system, &engine_state->p_frame_data);
             job_system_update(engine_state->systems.job_system, &engine_state->p_frame_data);
             plugin_system_update_plugins(engine_state->systems.plugin_system, &engine_state->p_frame_data);
             kaudio_system_update(engine_state->systems.audio_system, &engine_state->p_frame_data);
@@ -818,6 +841,7 @@ b8 engine_run(application* app) {
         shader_system_shutdown(systems->shader_system);
         renderer_system_shutdown(systems->renderer_system);
         job_system_shutdown(systems->job_system);
+        async_io_system_shutdown(systems->async_io_system);
         input_system_shutdown(systems->input_system);
         event_system_shutdown(systems->event_system);
         kvar_system_shutdown(systems->kvar_system);
@@ -937,3 +961,12 @@ static b8 engine_platform_console_write(void* platform, log_level level, const c
     platform_console_write(platform, level, message);
     return true;
 }
+
+static void engine_on_job_system_stats(console_command_context context) {
+    job_system_stats_log();
+}
+
+static void engine_on_job_system_stats_reset(console_command_context context) {
+    job_system_stats_reset();
+    KINFO("Job system stats reset.");
+}
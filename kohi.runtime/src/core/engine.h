@@ -31,6 +31,7 @@ struct resource_state;
 struct shader_system_state;
 struct renderer_system_state;
 struct job_system_state;
+struct async_io_state;
 struct kaudio_system_state;
 struct xform_system_state;
 struct texture_system_state;
@@ -73,6 +74,9 @@ typedef struct engine_system_states {
     u64 job_system_memory_requirement;
     struct job_system_state* job_system;
 
+    u64 async_io_system_memory_requirement;
+    struct async_io_state* async_io_system;
+
     u64 kaudio_system_memory_requirement;
     struct kaudio_system_state* audio_system;
 
@@ -1,8 +1,10 @@
 #include "kvar.h"
 
+#include "containers/u64_hashmap.h"
 #include "core/event.h"
 #include "logger.h"
 #include "memory/kmemory.h"
+#include "strings/kname.h"
 #include "strings/kstring.h"
 
 #include "core/console.h"
@@ -19,6 +21,10 @@ typedef struct kvar_entry {
 
 typedef struct kvar_state {
     kvar_entry values[KVAR_MAX_COUNT];
+    // The number of entries in values which are in use.
+    u32 entry_count;
+    // Maps the kname of each kvar to its index in values.
+    u64_hashmap lookup;
 } kvar_state;
 
 static kvar_state* state_ptr;
@@ -36,6 +42,11 @@ b8 kvar_system_initialize(u64* memory_requirement, struct kvar_state* memory, vo
 
     kzero_memory(state_ptr, sizeof(kvar_state));
 
+    if (!u64_hashmap_create(sizeof(u32), KVAR_MAX_COUNT, &state_ptr->lookup)) {
+        KERROR("Failed to create kvar lookup table.");
+        return false;
+    }
+
     kvar_console_commands_register(memory);
 
     return true;
@@ -54,6 +65,7 @@ void kvar_system_shutdown(struct kvar_state* state) {
                 string_free(entry->value.s);
             }
         }
+        u64_hashmap_destroy(&state->lookup);
         kzero_memory(state, sizeof(kvar_state));
     }
     state_ptr = 0;
@@ -61,22 +73,19 @@ void kvar_system_shutdown(struct kvar_state* state) {
 
 static kvar_entry* get_entry_by_name(kvar_state* state, const char* name) {
     // Check if kvar exists with the name.
-    for (u32 i = 0; i < KVAR_MAX_COUNT; ++i) {
-        kvar_entry* entry = &state->values[i];
-        if (entry->name && strings_equali(name, entry->name)) {
-            // Name matches, return.
-            return entry;
-        }
+    kname key = kname_create(name);
+    u32 index;
+    if (u64_hashmap_get(&state->lookup, key, &index)) {
+        return &state->values[index];
     }
 
     // No match found. Try getting a new one.
-    for (u32 i = 0; i < KVAR_MAX_COUNT; ++i) {
-        kvar_entry* entry = &state->values[i];
-        if (!entry->name) {
-            // No name means this one is free. Set its name here.
-            entry->name = string_duplicate(name);
-            return entry;
-        }
+    if (state->entry_count < KVAR_MAX_COUNT) {
+        index = state->entry_count++;
+        kvar_entry* entry = &state->values[index];
+        entry->name = string_duplicate(name);
+        u64_hashmap_set(&state->lookup, key, &index);
+        return entry;
     }
 
     KERROR("Unable to find existing kvar named '%s' and cannot create new kvar because the table has no room left.", name);
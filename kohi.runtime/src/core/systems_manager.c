@@ -15,7 +15,6 @@
 #include "systems/audio_system.h"
 #include "systems/camera_system.h"
 #include "systems/geometry_system.h"
-#include "systems/job_system.h"
 #include "systems/light_system.h"
 #include "systems/material_system.h"
 #include "systems/resource_system.h"
@@ -27,6 +26,7 @@
 // Version reporting.
 #include "kohi.runtime_version.h"
 #include "systems/xform_system.h"
+#include "threads/job_system.h"
 
 static b8 register_known_systems_pre_boot(systems_manager_state* state, application_config* app_config);
 static b8 register_known_systems_post_boot(systems_manager_state* state, application_config* app_config);
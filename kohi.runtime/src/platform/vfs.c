@@ -7,14 +7,16 @@
 #include <defines.h>
 #include <logger.h>
 #include <memory/kmemory.h>
+#include <platform/async_io.h>
 #include <platform/filesystem.h>
 #include <platform/kpackage.h>
 #include <platform/platform.h>
 #include <strings/kname.h>
 #include <strings/kstring.h>
-#include <systems/job_system.h>
+#include <threads/job_system.h>
 
 static b8 process_manifest_refs(vfs_state* state, const asset_manifest* manifest);
+static b8 package_create(const asset_manifest* manifest, kpackage* out_package);
 
 b8 vfs_initialize(u64* memory_requirement, vfs_state* state, const vfs_config* config) {
     if (!memory_requirement) {
@@ -32,7 +34,6 @@ b8 vfs_initialize(u64* memory_requirement, vfs_state* state, const vfs_config* c
 
     state->packages = darray_create(kpackage);
 
-    // TODO: For release builds, look at binary file.
     asset_manifest manifest = {0};
     if (!kpackage_parse_manifest_file_content(config->manifest_file_path, &manifest)) {
         KERROR("Failed to parse primary asset manifest. See logs for details.");
@@ -40,7 +41,7 @@ b8 vfs_initialize(u64* memory_requirement, vfs_state* state, const vfs_config* c
     }
 
     kpackage primary_package = {0};
-    if (!kpackage_create_from_manifest(&manifest, &primary_package)) {
+    if (!package_create(&manifest, &primary_package)) {
         KERROR("Failed to create package from primary asset manifest. See logs for details.");
         return false;
     }
@@ -72,66 +73,234 @@ void vfs_shutdown(vfs_state* state) {
     }
 }
 
-typedef struct vfs_asset_job_params {
-    vfs_state* state;
-    vfs_request_info info;
-} vfs_asset_job_params;
-
-typedef struct vfs_asset_job_result {
+// A request being read by the async I/O system.
+typedef struct vfs_read {
     vfs_state* state;
+    PFN_on_asset_loaded_callback callback;
+    b8 is_binary;
+    // Set for direct disk requests, whose callback is made even if the read fails.
+    b8 direct;
+    // The package the asset is in, and where. Not used for direct disk requests.
+    const kpackage* package;
+    kpackage_asset_location location;
+    // Filled out as the request goes, then handed to the callback. Holds the copy of the context.
     vfs_asset_data data;
-    vfs_request_info info;
-} vfs_asset_job_result;
+} vfs_read;
+
+// Decompression of an asset which has been read, run as a job.
+typedef struct vfs_decode_job_params {
+    vfs_read* read;
+    u64 stored_size;
+    void* stored;
+} vfs_decode_job_params;
+
+typedef struct vfs_decode_job_result {
+    vfs_read* read;
+    u64 size;
+    const void* data;
+} vfs_decode_job_result;
+
+static vfs_read* vfs_read_create(vfs_state* state, PFN_on_asset_loaded_callback callback, b8 is_binary, u32 context_size, const void* context) {
+    vfs_read* read = KALLOC_TYPE(vfs_read, MEMORY_TAG_PLATFORM);
+    read->state = state;
+    read->callback = callback;
+    read->is_binary = is_binary;
+
+    // Take a copy of the context if provided. This is freed once the callback is made.
+    if (context_size) {
+        KASSERT_MSG(context, "Called vfs_request_asset with a context_size, but not a context. Check yourself before you wreck yourself.");
+        read->data.context_size = context_size;
+        read->data.context = kallocate(context_size, MEMORY_TAG_PLATFORM);
+        kcopy_memory(read->data.context, context, context_size);
+    }
+    return read;
+}
+
+static void vfs_read_destroy(vfs_read* read) {
+    if (read->data.context && read->data.context_size) {
+        kfree(read->data.context, read->data.context_size, MEMORY_TAG_PLATFORM);
+        read->data.context = 0;
+        read->data.context_size = 0;
+    }
+    if (read->data.path) {
+        string_free(read->data.path);
+    }
+    vfs_asset_data_cleanup(&read->data);
+    KFREE_TYPE(read, vfs_read, MEMORY_TAG_PLATFORM);
+}
+
+// Hands the loaded data (taking ownership of it) to the callback, then releases the request.
+static void vfs_read_deliver(vfs_read* read, u64 size, const void* data) {
+    read->data.size = size;
+    read->data.bytes = data;
+    if (read->is_binary) {
+        read->data.flags |= VFS_ASSET_FLAG_BINARY_BIT;
+    }
+    read->data.result = VFS_REQUEST_RESULT_SUCCESS;
+
+    if (read->callback) {
+        read->callback(read->state, read->data);
+    }
+
+    // The callback is done with the data, so release it along with the context.
+    vfs_read_destroy(read);
+}
 
-b8 vfs_asset_job_start(void* params, void* out_result_data) {
-    vfs_asset_job_params* job_params = (vfs_asset_job_params*)params;
-    vfs_asset_job_result* out_result = (vfs_asset_job_result*)out_result_data;
-    out_result->data = vfs_request_asset_sync(job_params->state, job_params->info);
-    out_result->state = job_params->state;
-    out_result->info = job_params->info;
+// Reports a request which could not be fulfilled, then releases it. Only direct disk requests make the callback.
+static void vfs_read_fail(vfs_read* read, vfs_request_result result) {
+    if (read->direct) {
+        KERROR("VFS request direct from disk failed for file: '%s'.", read->data.path);
+        read->data.result = result;
+        if (read->callback) {
+            read->callback(read->state, read->data);
+        }
+    } else {
+        // FIXME: notify?
+        KERROR("VFS asset (name='%s', package='%s') load failed. See logs for details.", kname_string_get(read->data.asset_name), kname_string_get(read->data.package_name));
+    }
+    vfs_read_destroy(read);
+}
+
+static b8 vfs_decode_job_start(void* params, void* out_result_data) {
+    vfs_decode_job_params* job_params = (vfs_decode_job_params*)params;
+    vfs_decode_job_result* out_result = (vfs_decode_job_result*)out_result_data;
+    vfs_read* read = job_params->read;
+    out_result->read = read;
+
+    kpackage_result result = kpackage_asset_decode(read->package, read->data.asset_name, read->is_binary, job_params->stored_size, job_params->stored, &out_result->size, &out_result->data);
+    if (job_params->stored) {
+        kfree(job_params->stored, job_params->stored_size, MEMORY_TAG_ASSET);
+    }
+    return result == KPACKAGE_RESULT_SUCCESS;
+}
 
-    return out_result->data.result == VFS_REQUEST_RESULT_SUCCESS;
+// Invoked on decode job success.
+static void vfs_decode_job_success(void* result_params) {
+    vfs_decode_job_result* result = result_params;
+    vfs_read_deliver(result->read, result->size, result->data);
 }
 
-// Invoked on asset job success.
-void vfs_asset_job_success(void* result_params) {
-    vfs_asset_job_result* result = result_params;
+// Invoked on decode job failure.
+static void vfs_decode_job_fail(void* result_params) {
+    vfs_decode_job_result* result = result_params;
+    vfs_read_fail(result->read, VFS_REQUEST_RESULT_INTERNAL_FAILURE);
+}
+
+// Decompression is left to the job system, so the main thread doesn't do it. Takes ownership of stored.
+static void vfs_decode_submit(vfs_read* read, u64 stored_size, void* stored) {
+    vfs_decode_job_params job_params = {
+        .read = read,
+        .stored_size = stored_size,
+        .stored = stored};
+    job_info job = job_create(vfs_decode_job_start, vfs_decode_job_success, vfs_decode_job_fail, &job_params, sizeof(vfs_decode_job_params), sizeof(vfs_decode_job_result));
+    job_system_submit(job);
+}
 
-    // Issue the callback with the data, if present.
-    if (result->info.vfs_callback) {
-        result->info.vfs_callback(result->state, result->data);
+// Invoked on the main thread by the async I/O system once a read completes.
+static void vfs_on_read_complete(async_io_completion* completion) {
+    vfs_read* read = completion->context;
+
+    switch (completion->result) {
+    case ASYNC_IO_RESULT_SUCCESS:
+        break;
+    case ASYNC_IO_RESULT_CANCELLED:
+        // Cancelled requests go quietly.
+        vfs_read_destroy(read);
+        return;
+    case ASYNC_IO_RESULT_FILE_NOT_FOUND:
+        vfs_read_fail(read, VFS_REQUEST_RESULT_FILE_DOES_NOT_EXIST);
+        return;
+    default:
+    case ASYNC_IO_RESULT_READ_ERROR:
+        vfs_read_fail(read, VFS_REQUEST_RESULT_READ_ERROR);
+        return;
     }
 
-    // Cleanup context.
-    if (result->data.context && result->data.context_size) {
-        kfree(result->data.context, result->data.context_size, MEMORY_TAG_PLATFORM);
-        result->data.context = 0;
-        result->data.context_size = 0;
+    // Take the data, which now belongs to the request.
+    u64 size = completion->size;
+    void* data = completion->data;
+    completion->data = 0;
+
+    if (read->location.compressed) {
+        vfs_decode_submit(read, size, data);
+    } else if (read->location.packed && !kpackage_asset_verify(read->package, read->data.asset_name, size, data)) {
+        kfree(data, size, MEMORY_TAG_ASSET);
+        vfs_read_fail(read, VFS_REQUEST_RESULT_INTERNAL_FAILURE);
+    } else {
+        vfs_read_deliver(read, size, data);
     }
 }
 
-// Invoked on asset job failure.
-void vfs_asset_job_fail(void* result_params) {
-    vfs_asset_job_result* result = result_params;
+// Queues the read of the given request at its location. Returns the id of the read.
+static u64 vfs_read_submit(vfs_read* read, async_io_priority priority) {
+    async_io_read_request request = {0};
+    request.path = read->location.path;
+    request.offset = read->location.offset;
+    request.size = read->location.stored_size;
+    request.priority = priority;
+    // Compressed text is terminated once decompressed instead.
+    if (!read->is_binary && !read->location.compressed) {
+        request.flags |= ASYNC_IO_READ_FLAG_ZERO_TERMINATE_BIT;
+    }
+    request.callback = vfs_on_read_complete;
+    request.context = read;
 
-    // FIXME: notify?
-    KERROR("VFS asset (name='%s', package='%s') load failed. See logs for details.", kname_string_get(result->info.asset_name), kname_string_get(result->info.package_name));
-    if (result) {
-        //
+    u64 id = async_io_read(&request);
+    if (id == ASYNC_IO_INVALID_ID) {
+        KERROR("Failed to queue the read of '%s'.", request.path);
+        vfs_read_fail(read, VFS_REQUEST_RESULT_INTERNAL_FAILURE);
     }
+    return id;
 }
 
-void vfs_request_asset(vfs_state* state, vfs_request_info info) {
+u64 vfs_request_asset(vfs_state* state, vfs_request_info info) {
     if (!state) {
         KERROR("vfs_request_asset requires state to be provided.");
+        return ASYNC_IO_INVALID_ID;
     }
 
-    // Async asset requests are jobifyed.
-    vfs_asset_job_params job_params = {
-        .info = info,
-        .state = state};
-    job_info job = job_create(vfs_asset_job_start, vfs_asset_job_success, vfs_asset_job_fail, &job_params, sizeof(vfs_asset_job_params), sizeof(vfs_asset_job_result));
-    job_system_submit(job);
+    const char* asset_name_str = kname_string_get(info.asset_name);
+
+    // Find the first package holding the asset, or the given one.
+    const kpackage* package = 0;
+    kpackage_asset_location location = {0};
+    u32 package_count = darray_length(state->packages);
+    for (u32 i = 0; i < package_count; ++i) {
+        if (info.package_name == INVALID_KNAME || state->packages[i].name == info.package_name) {
+            if (kpackage_asset_location_get(&state->packages[i], info.asset_name, &location) == KPACKAGE_RESULT_SUCCESS) {
+                package = &state->packages[i];
+                break;
+            }
+            if (info.package_name != INVALID_KNAME) {
+                break;
+            }
+        }
+    }
+    if (!package) {
+        KERROR("No asset named '%s' exists in any package. Nothing was done.", asset_name_str);
+        return ASYNC_IO_INVALID_ID;
+    }
+
+    KDEBUG("Loading asset '%s' from package '%s'...", asset_name_str, kname_string_get(package->name));
+
+    vfs_read* read = vfs_read_create(state, info.vfs_callback, info.is_binary, info.context_size, info.context);
+    read->package = package;
+    read->location = location;
+    read->data.asset_name = info.asset_name;
+    // Keep the package name in case an importer needs it later.
+    read->data.package_name = package->name;
+    read->data.path = kpackage_path_for_asset(package, info.asset_name);
+
+    if (location.packed && !location.stored_size) {
+        // Nothing to read, so the asset goes straight to be decoded (i.e. empty text).
+        vfs_decode_submit(read, 0, 0);
+        return ASYNC_IO_INVALID_ID;
+    }
+    return vfs_read_submit(read, info.priority);
+}
+
+b8 vfs_request_cancel(vfs_state* state, u64 request_id) {
+    return async_io_cancel(request_id);
 }
 
 vfs_asset_data vfs_request_asset_sync(vfs_state* state, vfs_request_info info) {
@@ -172,7 +341,13 @@ vfs_asset_data vfs_request_asset_sync(vfs_state* state, vfs_request_info info) {
             // Determine if the asset type is text.
             kpackage_result result = KPACKAGE_RESULT_INTERNAL_FAILURE;
             if (info.is_binary) {
-                result = kpackage_asset_bytes_get(package, info.asset_name, &out_data.size, &out_data.bytes);
+                // Binary assets are obtained as views, so large ones are mapped rather than copied onto the heap.
+                kpackage_asset_view view = {0};
+                result = kpackage_asset_bytes_view_get(package, info.asset_name, &view);
+                out_data.size = view.size;
+                out_data.bytes = view.data;
+                out_data.release = view.release;
+                out_data.release_context = view.release_context;
                 out_data.flags |= VFS_ASSET_FLAG_BINARY_BIT;
             } else {
                 result = kpackage_asset_text_get(package, info.asset_name, &out_data.size, &out_data.text);
@@ -235,25 +410,28 @@ const char* vfs_source_path_for_asset(vfs_state* state, kname package_name, knam
     return 0;
 }
 
-void vfs_request_direct_from_disk(vfs_state* state, const char* path, b8 is_binary, u32 context_size, const void* context, PFN_on_asset_loaded_callback callback) {
+u64 vfs_request_direct_from_disk(vfs_state* state, const char* path, b8 is_binary, u32 context_size, const void* context, PFN_on_asset_loaded_callback callback) {
     if (!state || !path || !callback) {
         KERROR("vfs_request_direct_from_disk requires state, path and callback to be provided.");
+        return ASYNC_IO_INVALID_ID;
     }
 
-    // TODO: Jobify this call.
-    vfs_asset_data data = {0};
-    vfs_request_direct_from_disk_sync(state, path, is_binary, context_size, context, &data);
+    vfs_read* read = vfs_read_create(state, callback, is_binary, context_size, context);
+    read->direct = true;
+    const char* filename = string_filename_no_extension_from_path(path);
+    read->data.asset_name = kname_create(filename);
+    string_free(filename);
+    read->data.package_name = 0;
+    read->data.path = string_duplicate(path);
+    // The whole file is read.
+    read->location.path = read->data.path;
 
-    // TODO: This should be the job result
-    // Issue the callback with the data.
-    callback(state, data);
+    return vfs_read_submit(read, ASYNC_IO_PRIORITY_NORMAL);
+}
 
-    // Cleanup the context.
-    if (data.context && data.context_size) {
-        kfree(data.context, data.context_size, MEMORY_TAG_PLATFORM);
-        data.context = 0;
-        data.context_size = 0;
-    }
+static void vfs_asset_data_release_mapping(void* release_context, u64 size, const void* data) {
+    file_mapping mapping = {.data = data, .size = size};
+    filesystem_unmap(&mapping);
 }
 
 void vfs_request_direct_from_disk_sync(vfs_state* state, const char* path, b8 is_binary, u32 context_size, const void* context, vfs_asset_data* out_data) {
@@ -292,7 +470,14 @@ void vfs_request_direct_from_disk_sync(vfs_state* state, const char* path, b8 is
     }
 
     if (is_binary) {
-        out_data->bytes = filesystem_read_entire_binary_file(path, &out_data->size);
+        file_mapping mapping = {0};
+        if (filesystem_map(path, &mapping)) {
+            out_data->bytes = mapping.data;
+            out_data->size = mapping.size;
+            out_data->release = vfs_asset_data_release_mapping;
+        } else {
+            out_data->bytes = filesystem_read_entire_binary_file(path, &out_data->size);
+        }
         if (!out_data->bytes) {
             out_data->size = 0;
             KERROR("vfs_request_direct_from_disk_sync: Error reading from file: '%s'.", path);
@@ -352,7 +537,9 @@ b8 vfs_asset_write_text(vfs_state* state, kname asset_name, kname package_name,
 
 void vfs_asset_data_cleanup(vfs_asset_data* data) {
     if (data) {
-        if (data->size && data->bytes) {
+        if (data->release) {
+            data->release(data->release_context, data->size, data->bytes);
+        } else if (data->size && data->bytes) {
             kfree((void*)data->bytes, data->size, MEMORY_TAG_ASSET);
         }
         if (data->context || data->context_size) {
@@ -455,7 +642,7 @@ static b8 process_manifest_refs(vfs_state* state, const asset_manifest* manifest
             }
 
             kpackage package = {0};
-            if (!kpackage_create_from_manifest(&new_manifest, &package)) {
+            if (!package_create(&new_manifest, &package)) {
                 KERROR("Failed to create package from asset manifest. See logs for details.");
                 return false;
             }
@@ -476,3 +663,25 @@ static b8 process_manifest_refs(vfs_state* state, const asset_manifest* manifest
 
     return success;
 }
+
+// Creates the package described by the given manifest. If a binary package named after the
+// package sits alongside the manifest (i.e. "<manifest dir>/<package name>.kpackage"), it is
+// used, so all assets come from that one file. Otherwise, assets are loaded from their own files.
+static b8 package_create(const asset_manifest* manifest, kpackage* out_package) {
+    const char* binary_path = string_format("%s/%s.kpackage", manifest->path, kname_string_get(manifest->name));
+    b8 result = false;
+    if (filesystem_exists(binary_path)) {
+        result = kpackage_create_from_binary_file(binary_path, out_package);
+        if (result) {
+            KINFO("Package '%s' loaded from binary package '%s'.", kname_string_get(manifest->name), binary_path);
+        } else {
+            KWARN("Failed to load binary package '%s'. Falling back to the asset manifest.", binary_path);
+        }
+    }
+    string_free(binary_path);
+
+    if (!result) {
+        result = kpackage_create_from_manifest(manifest, out_package);
+    }
+    return result;
+}
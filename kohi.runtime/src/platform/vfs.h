@@ -12,6 +12,7 @@
 
 #include "assets/kasset_types.h"
 #include "defines.h"
+#include "platform/async_io.h"
 #include "strings/kname.h"
 
 struct kpackage;
@@ -48,6 +49,15 @@ typedef enum vfs_request_result {
     VFS_REQUEST_RESULT_INTERNAL_FAILURE,
 } vfs_request_result;
 
+/**
+ * @brief Releases asset data which was not allocated by the VFS, such as a view of a file mapped into memory.
+ *
+ * @param release_context The release_context of the asset data.
+ * @param size The size of the data in bytes.
+ * @param data The data to be released.
+ */
+typedef void (*PFN_vfs_asset_data_release)(void* release_context, u64 size, const void* data);
+
 /**
  * @brief Represents data and properties from an asset loaded from the VFS.
  */
@@ -70,6 +80,14 @@ typedef struct vfs_asset_data {
     /** @brief Various flags for the given asset. */
     vfs_asset_flags flags;
 
+    /**
+     * @brief Releases the data, if it is a read-only view (i.e. of a file mapped into memory) rather
+     * than an allocation. 0 if the data is allocated. Invoked by vfs_asset_data_cleanup().
+     */
+    PFN_vfs_asset_data_release release;
+    /** @brief Passed through to release. */
+    void* release_context;
+
     /** The result of the asset load operation. */
     vfs_request_result result;
 
@@ -97,6 +115,8 @@ typedef struct vfs_request_info {
     kname asset_name;
     /** @brief Indicates if the asset is binary. If not, the asset is loaded as text. */
     b8 is_binary;
+    /** @brief The priority of the read from disk. Normal priority if left zeroed. */
+    async_io_priority priority;
     /** @brief The size of the context in bytes. */
     u32 context_size;
     /** @param context A constant pointer to the context to be used for this call. This is passed through to the result callback. NOTE: A copy of this is taken immediately, so lifetime of this isn't important. */
@@ -125,12 +145,26 @@ KAPI void vfs_shutdown(vfs_state* state);
 
 /**
  * @brief Requests an asset from the VFS, issuing the callback when complete. This call is asynchronous.
+ * The asset is read by the async I/O system, so no thread waits on the disk, and compressed assets are
+ * then decompressed on the job system. The callback is made on the main thread, and only if the asset
+ * was loaded; failures are logged.
  *
  * @param state A pointer to the system state. Required.
- * @param info The information detailing specifics about the VFS asset request.
- * @param callback The callback to be made once the asset load is complete. Required.
+ * @param info The information detailing specifics about the VFS asset request, including the callback.
+ * @returns The id of the request, which may be passed to vfs_request_cancel(). ASYNC_IO_INVALID_ID if the
+ * request failed, or if the asset needed nothing read from disk (and so can't be cancelled).
+ */
+KAPI u64 vfs_request_asset(vfs_state* state, vfs_request_info info);
+
+/**
+ * @brief Cancels an asynchronous request made via vfs_request_asset() or vfs_request_direct_from_disk().
+ * The callback of a cancelled request is never made, and its copy of the context is freed.
+ *
+ * @param state A pointer to the system state. Required.
+ * @param request_id The id of the request to cancel.
+ * @returns True if the request was cancelled; false if it has already been read (or the id is invalid).
  */
-KAPI void vfs_request_asset(vfs_state* state, vfs_request_info info);
+KAPI b8 vfs_request_cancel(vfs_state* state, u64 request_id);
 
 /**
  * @brief Requests an asset from the VFS synchronously. NOTE: This should be used sparingly as it performs device I/O directly.
@@ -164,6 +198,7 @@ KAPI const char* vfs_source_path_for_asset(vfs_state* state, kname package_name,
 
 /**
  * @brief Requests an asset directly a disk path via the VFS, issuing the callback when complete. This call is asynchronous.
+ * The file is read by the async I/O system, and the callback is made on the main thread, even if the read fails.
  *
  * @param state A pointer to the system state. Required.
  * @param path The path to the file to load (can be relative or absolute). Required.
@@ -171,8 +206,9 @@ KAPI const char* vfs_source_path_for_asset(vfs_state* state, kname package_name,
  * @param context_size The size of the context in bytes.
  * @param context A pointer to the context to be used for this call. This is passed through to the result callback. NOTE: A copy of this is taken immediately, so lifetime of this isn't important.
  * @param callback The callback to be made once the asset load is complete. Required.
+ * @returns The id of the request, which may be passed to vfs_request_cancel(). ASYNC_IO_INVALID_ID if the request failed.
  */
-KAPI void vfs_request_direct_from_disk(vfs_state* state, const char* path, b8 is_binary, u32 context_size, const void* context, PFN_on_asset_loaded_callback callback);
+KAPI u64 vfs_request_direct_from_disk(vfs_state* state, const char* path, b8 is_binary, u32 context_size, const void* context, PFN_on_asset_loaded_callback callback);
 
 /**
  * @brief Requests an asset directly a disk path via the VFS synchronously. NOTE: This should be used sparingly as it performs device I/O directly.
@@ -212,7 +248,9 @@ KAPI b8 vfs_asset_write_binary(vfs_state* state, kname asset_name, kname package
 KAPI b8 vfs_asset_write_text(vfs_state* state, kname asset_name, kname package_name, const char* text);
 
 /**
- * @brief Releases resources held by data. NOTE: This does _NOT_ account for any dynamic allocations made within said context!
+ * @brief Releases resources held by data. Data handed to a PFN_on_asset_loaded_callback is released automatically once the
+ * callback returns, so it must be copied if needed beyond that. Binary data may be a read-only view of a file mapped into memory.
+ * NOTE: This does _NOT_ account for any dynamic allocations made within said context!
  *
  * @param data A pointer to the VFS data to be released.
  */
@@ -1127,22 +1127,26 @@ b8 renderer_renderbuffer_resize(renderbuffer* buffer, u64 new_total_size) {
 }
 
 b8 renderer_renderbuffer_allocate(renderbuffer* buffer, u64 size, u64* out_offset) {
-    if (!buffer || !size || !out_offset) {
-        KERROR("renderer_renderbuffer_allocate requires valid buffer, a nonzero size and valid pointer to hold offset.");
+    return renderer_renderbuffer_allocate_aligned(buffer, size, 1, out_offset);
+}
+
+b8 renderer_renderbuffer_allocate_aligned(renderbuffer* buffer, u64 size, u64 alignment, u64* out_offset) {
+    if (!buffer || !size || !alignment || !out_offset) {
+        KERROR("renderer_renderbuffer_allocate_aligned requires valid buffer, a nonzero size and alignment and valid pointer to hold offset.");
         return false;
     }
 
     if (buffer->track_type == RENDERBUFFER_TRACK_TYPE_NONE) {
-        KWARN("renderer_renderbuffer_allocate called on a buffer not using freelists. Offset will not be valid. Call renderer_renderbuffer_load_range instead.");
+        KWARN("renderer_renderbuffer_allocate_aligned called on a buffer not using freelists. Offset will not be valid. Call renderer_renderbuffer_load_range instead.");
         *out_offset = 0;
         return true;
     } else if (buffer->track_type == RENDERBUFFER_TRACK_TYPE_LINEAR) {
-        *out_offset = buffer->offset;
-        buffer->offset += size;
+        *out_offset = get_aligned(buffer->offset, alignment);
+        buffer->offset = *out_offset + size;
         return true;
     }
 
-    return freelist_allocate_block(&buffer->buffer_freelist, size, out_offset);
+    return freelist_allocate_block_aligned(&buffer->buffer_freelist, size, alignment, out_offset);
 }
 
 b8 renderer_renderbuffer_free(renderbuffer* buffer, u64 size, u64 offset) {
@@ -802,6 +802,18 @@ KAPI b8 renderer_renderbuffer_resize(renderbuffer* buffer, u64 new_total_size);
  */
 KAPI b8 renderer_renderbuffer_allocate(renderbuffer* buffer, u64 size, u64* out_offset);
 
+/**
+ * @brief Attempts to allocate memory from the given buffer at an offset which is a multiple
+ * of the given alignment. Should only be used on buffers that were created with use_freelist = true.
+ *
+ * @param buffer A pointer to the buffer to be allocated from.
+ * @param size The size in bytes to allocate.
+ * @param alignment The alignment in bytes of the offset. Must be a power of two.
+ * @param out_offset A pointer to hold the offset in bytes of the allocation from the beginning of the buffer.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 renderer_renderbuffer_allocate_aligned(renderbuffer* buffer, u64 size, u64 alignment, u64* out_offset);
+
 /**
  * @brief Frees memory from the given buffer.
  *
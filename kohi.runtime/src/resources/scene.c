@@ -102,21 +102,42 @@ typedef struct geometry_distance {
     f32 distance;
 } geometry_distance;
 
-static i32 geometry_render_data_compare(void* a, void* b) {
-    geometry_render_data* a_typed = a;
-    geometry_render_data* b_typed = b;
-    return a_typed->material.material.handle_index - b_typed->material.material.handle_index;
-}
+/**
+ * Sorts opaque geometries by material so draws using the same one are adjacent, then appends
+ * the transparent geometries sorted nearest first. Only small keys are sorted; each
+ * geometry is then moved once into place rather than being swapped around during the sort.
+ */
+static void geometries_sort(struct frame_data* p_frame_data, geometry_render_data** geometries, geometry_distance* transparent_geometries) {
+    u32 opaque_count = darray_length(*geometries);
+    u32 transparent_count = darray_length(transparent_geometries);
+    u32 max_count = KMAX(opaque_count, transparent_count);
+    if (!max_count) {
+        return;
+    }
+
+    u32* keys = p_frame_data->allocator.allocate(sizeof(u32) * max_count);
+    u32* indices = p_frame_data->allocator.allocate(sizeof(u32) * max_count);
+    void* scratch = p_frame_data->allocator.allocate(KRADIX_SORT_INDICES_SCRATCH_SIZE(u32, max_count));
 
-static i32 geometry_distance_compare(void* a, void* b) {
-    geometry_distance* a_typed = a;
-    geometry_distance* b_typed = b;
-    if (a_typed->distance > b_typed->distance) {
-        return 1;
-    } else if (a_typed->distance < b_typed->distance) {
-        return -1;
+    if (opaque_count > 1) {
+        for (u32 i = 0; i < opaque_count; ++i) {
+            keys[i] = (*geometries)[i].material.material.handle_index;
+        }
+        kradix_sort_u32_indices(keys, opaque_count, indices, scratch);
+        geometry_render_data* sorted = p_frame_data->allocator.allocate(sizeof(geometry_render_data) * opaque_count);
+        ksort_gather(sizeof(geometry_render_data), *geometries, indices, opaque_count, sorted);
+        kcopy_memory(*geometries, sorted, sizeof(geometry_render_data) * opaque_count);
+    }
+
+    if (transparent_count) {
+        for (u32 i = 0; i < transparent_count; ++i) {
+            keys[i] = kradix_key_from_f32(transparent_geometries[i].distance);
+        }
+        kradix_sort_u32_indices(keys, transparent_count, indices, scratch);
+        for (u32 i = 0; i < transparent_count; ++i) {
+            darray_push(*geometries, transparent_geometries[indices[i]].g);
+        }
     }
-    return 0;
 }
 
 b8 scene_create(kasset_scene* config, scene_flags flags, scene* out_scene) {
@@ -2012,15 +2033,8 @@ b8 scene_mesh_render_data_query_from_line(const scene* scene, vec3 direction, ve
         }
     }
 
-    // Sort opaque geometries by material.
-    kquick_sort(sizeof(geometry_render_data), *out_geometries, 0, darray_length(*out_geometries) - 1, geometry_render_data_compare);
-
-    // Sort transparent geometries, then add them to the ext_data->geometries array.
-    u32 transparent_geometry_count = darray_length(transparent_geometries);
-    kquick_sort(sizeof(geometry_distance), transparent_geometries, 0, transparent_geometry_count - 1, geometry_distance_compare);
-    for (u32 i = 0; i < transparent_geometry_count; ++i) {
-        darray_push(*out_geometries, transparent_geometries[i].g);
-    }
+    // Sort opaque geometries by material, then add the transparent geometries sorted by distance.
+    geometries_sort(p_frame_data, out_geometries, transparent_geometries);
 
     *out_count = darray_length(*out_geometries);
 
@@ -2209,15 +2223,8 @@ b8 scene_mesh_render_data_query(const scene* scene, const frustum* f, vec3 cente
         }
     }
 
-    // Sort opaque geometries by material.
-    kquick_sort(sizeof(geometry_render_data), *out_geometries, 0, darray_length(*out_geometries) - 1, geometry_render_data_compare);
-
-    // Sort transparent geometries, then add them to the ext_data->geometries array.
-    u32 transparent_geometry_count = darray_length(transparent_geometries);
-    kquick_sort(sizeof(geometry_distance), transparent_geometries, 0, transparent_geometry_count - 1, geometry_distance_compare);
-    for (u32 i = 0; i < transparent_geometry_count; ++i) {
-        darray_push(*out_geometries, transparent_geometries[i].g);
-    }
+    // Sort opaque geometries by material, then add the transparent geometries sorted by distance.
+    geometries_sort(p_frame_data, out_geometries, transparent_geometries);
 
     *out_count = darray_length(*out_geometries);
 
@@ -2580,7 +2587,9 @@ static void scene_actual_unload(scene* s) {
     // Update the state to show the scene is unloaded.
     s->state = SCENE_STATE_UNLOADED;
 
-    KDEBUG("Scene unloading done.");
+    // Give the memory the scene was occupying back to the OS.
+    u64 trimmed = kmemory_trim();
+    KDEBUG("Scene unloading done. Returned %llu bytes to the OS.", trimmed);
 }
 
 static b8 scene_serialize_node(const scene* s, const hierarchy_graph_view* view, const hierarchy_graph_view_node* view_node, kson_property* node) {
@@ -274,6 +274,7 @@ kasset_binary* asset_system_request_binary_from_package_sync(struct asset_system
     out_asset->size = data.size;
     void* content = kallocate(out_asset->size, MEMORY_TAG_ASSET);
     kcopy_memory(content, data.bytes, out_asset->size);
+    vfs_asset_data_cleanup(&data);
     out_asset->content = content;
 
     return out_asset;
@@ -312,6 +313,7 @@ kasset_text* asset_system_request_text_from_package_sync(struct asset_system_sta
     vfs_asset_data data = vfs_request_asset_sync(state->vfs, info);
 
     out_asset->content = string_duplicate(data.text);
+    vfs_asset_data_cleanup(&data);
 
     return out_asset;
 }
@@ -399,6 +401,7 @@ kasset_image* asset_system_request_image_from_package_sync(struct asset_system_s
     vfs_asset_data data = vfs_request_asset_sync(state->vfs, info);
 
     b8 result = kasset_image_deserialize(data.size, data.bytes, out_asset);
+    vfs_asset_data_cleanup(&data);
     if (!result) {
         KERROR("Failed to deserialize image asset. See logs for details.");
         KFREE_TYPE(out_asset, kasset_image, MEMORY_TAG_ASSET);
@@ -445,6 +448,7 @@ kasset_bitmap_font* asset_system_request_bitmap_font_from_package_sync(struct as
     vfs_asset_data data = vfs_request_asset_sync(state->vfs, info);
 
     b8 result = kasset_bitmap_font_deserialize(data.size, data.bytes, out_asset);
+    vfs_asset_data_cleanup(&data);
     if (!result) {
         KERROR("Failed to deserialize bitmap font asset. See logs for details.");
         KFREE_TYPE(out_asset, kasset_bitmap_font, MEMORY_TAG_ASSET);
@@ -489,6 +493,7 @@ kasset_system_font* asset_system_request_system_font_from_package_sync(struct as
     vfs_asset_data data = vfs_request_asset_sync(state->vfs, info);
 
     b8 result = kasset_system_font_deserialize(data.text, out_asset);
+    vfs_asset_data_cleanup(&data);
     if (!result) {
         KERROR("Failed to deserialize system font asset. See logs for details.");
         KFREE_TYPE(out_asset, kasset_system_font, MEMORY_TAG_ASSET);
@@ -598,6 +603,7 @@ kasset_static_mesh* asset_system_request_static_mesh_from_package_sync(struct as
     vfs_asset_data data = vfs_request_asset_sync(state->vfs, info);
 
     b8 result = kasset_static_mesh_deserialize(data.size, data.bytes, out_asset);
+    vfs_asset_data_cleanup(&data);
     if (!result) {
         KERROR("Failed to deserialize static_mesh asset. See logs for details.");
         KFREE_TYPE(out_asset, kasset_static_mesh, MEMORY_TAG_ASSET);
@@ -695,6 +701,7 @@ kasset_heightmap_terrain* asset_system_request_heightmap_terrain_from_package_sy
     vfs_asset_data data = vfs_request_asset_sync(state->vfs, info);
 
     b8 result = kasset_heightmap_terrain_deserialize(data.text, out_asset);
+    vfs_asset_data_cleanup(&data);
     if (!result) {
         KERROR("Failed to deserialize heightmap_terrain asset. See logs for details.");
         KFREE_TYPE(out_asset, kasset_heightmap_terrain, MEMORY_TAG_ASSET);
@@ -789,6 +796,7 @@ kasset_material* asset_system_request_material_from_package_sync(struct asset_sy
     vfs_asset_data data = vfs_request_asset_sync(state->vfs, info);
 
     b8 result = kasset_material_deserialize(data.text, out_asset);
+    vfs_asset_data_cleanup(&data);
     if (!result) {
         KERROR("Failed to deserialize material asset. See logs for details.");
         KFREE_TYPE(out_asset, kasset_material, MEMORY_TAG_ASSET);
@@ -884,6 +892,7 @@ kasset_audio* asset_system_request_audio_from_package_sync(struct asset_system_s
     vfs_asset_data data = vfs_request_asset_sync(state->vfs, info);
 
     b8 result = kasset_audio_deserialize(data.size, data.bytes, out_asset);
+    vfs_asset_data_cleanup(&data);
     if (!result) {
         KERROR("Failed to deserialize audio asset. See logs for details.");
         KFREE_TYPE(out_asset, kasset_audio, MEMORY_TAG_ASSET);
@@ -930,6 +939,7 @@ kasset_scene* asset_system_request_scene_from_package_sync(struct asset_system_s
     vfs_asset_data data = vfs_request_asset_sync(state->vfs, info);
 
     b8 result = kasset_scene_deserialize(data.text, out_asset);
+    vfs_asset_data_cleanup(&data);
     if (!result) {
         KERROR("Failed to deserialize scene asset. See logs for details.");
         KFREE_TYPE(out_asset, kasset_scene, MEMORY_TAG_ASSET);
@@ -1021,6 +1031,7 @@ kasset_shader* asset_system_request_shader_from_package_sync(struct asset_system
     vfs_asset_data data = vfs_request_asset_sync(state->vfs, info);
 
     b8 result = kasset_shader_deserialize(data.text, out_asset);
+    vfs_asset_data_cleanup(&data);
     if (!result) {
         KERROR("Failed to deserialize shader asset. See logs for details.");
         KFREE_TYPE(out_asset, kasset_shader, MEMORY_TAG_ASSET);
@@ -2,6 +2,7 @@
 
 #include <assets/kasset_types.h>
 #include <containers/darray.h>
+#include <containers/u64_hashmap.h>
 #include <core_render_types.h>
 #include <defines.h>
 #include <identifiers/khandle.h>
@@ -36,6 +37,9 @@ typedef struct kshader {
     /** @brief An array of uniforms in this shader. Darray. */
     shader_uniform* uniforms;
 
+    /** @brief Maps the name of each uniform to its location (u16). */
+    u64_hashmap uniform_lookup;
+
     /** @brief An array of attributes. Darray. */
     shader_attribute* attributes;
 
@@ -289,6 +293,8 @@ static void internal_shader_destroy(khandle* shader) {
 
     kshader* s = &state_ptr->shaders[shader->handle_index];
 
+    u64_hashmap_destroy(&s->uniform_lookup);
+
     // Set it to be unusable right away.
     s->state = SHADER_STATE_NOT_CREATED;
 
@@ -343,11 +349,9 @@ u16 shader_system_uniform_location(khandle shader, kname uniform_name) {
     }
     kshader* next_shader = &state_ptr->shaders[shader.handle_index];
 
-    u32 uniform_count = darray_length(next_shader->uniforms);
-    for (u32 i = 0; i < uniform_count; ++i) {
-        if (next_shader->uniforms[i].name == uniform_name) {
-            return next_shader->uniforms[i].location;
-        }
+    u16 location;
+    if (u64_hashmap_get(&next_shader->uniform_lookup, uniform_name, &location)) {
+        return location;
     }
 
     // Not found.
@@ -603,6 +607,7 @@ static b8 internal_uniform_add(kshader* shader, const shader_uniform_config* con
     entry.name = config->name;
 
     darray_push(shader->uniforms, entry);
+    u64_hashmap_set(&shader->uniform_lookup, entry.name, &entry.location);
 
     // Count regular uniforms only, as the others are counted in the functions called before this for
     // textures and samplers.
@@ -631,12 +636,9 @@ static b8 uniform_name_valid(kshader* shader, kname uniform_name) {
         KERROR("Uniform name is invalid.");
         return false;
     }
-    u32 uniform_count = darray_length(shader->uniforms);
-    for (u32 i = 0; i < uniform_count; ++i) {
-        if (shader->uniforms[i].name == uniform_name) {
-            KERROR("A uniform by the name '%s' already exists on shader '%s'.", uniform_name, shader->name);
-            return false;
-        }
+    if (u64_hashmap_contains(&shader->uniform_lookup, uniform_name)) {
+        KERROR("A uniform by the name '%s' already exists on shader '%s'.", kname_string_get(uniform_name), kname_string_get(shader->name));
+        return false;
     }
 
     return true;
@@ -667,6 +669,7 @@ static khandle shader_create(const kasset_shader* asset) {
     out_shader->shader_stage_count = asset->stage_count;
     out_shader->stage_configs = kallocate(sizeof(shader_stage_config) * asset->stage_count, MEMORY_TAG_ARRAY);
     out_shader->uniforms = darray_create(shader_uniform);
+    u64_hashmap_create(sizeof(u16), state_ptr->config.max_uniform_count, &out_shader->uniform_lookup);
     out_shader->attributes = darray_create(shader_attribute);
 
     // Invalidate frequency bound ids
@@ -1,7 +1,7 @@
 #include "timeline_system.h"
 
+#include "containers/slot_map.h"
 #include "core/engine.h"
-#include "debug/kassert.h"
 #include "defines.h"
 #include "identifiers/khandle.h"
 #include "logger.h"
@@ -22,32 +22,14 @@ typedef struct timeline_data {
 } timeline_data;
 
 typedef struct timeline_system_state {
-    timeline_data* timelines;
-    u64* handle_uuids;
-    u32 entry_count;
+    /** @brief The timelines, held as timeline_data. */
+    slot_map timelines;
+    /** @brief The default engine timeline. */
+    khandle engine_timeline;
+    /** @brief The default game timeline. */
+    khandle game_timeline;
 } timeline_system_state;
 
-static void ensure_allocated(timeline_system_state* state, u32 entry_count) {
-    if (state->entry_count < entry_count) {
-        {
-            u64 old_size = sizeof(timeline_data) * state->entry_count;
-            u64 new_size = sizeof(timeline_data) * entry_count;
-            state->timelines = kreallocate(state->timelines, old_size, new_size, MEMORY_TAG_ARRAY);
-        }
-        {
-            u64 old_size = sizeof(u64) * state->entry_count;
-            u64 new_size = sizeof(u64) * entry_count;
-            state->handle_uuids = kreallocate(state->handle_uuids, old_size, new_size, MEMORY_TAG_ARRAY);
-        }
-        // Invalidate all new "slots" by setting the handle uuid to INVALID_ID_U64.
-        for (u32 i = state->entry_count; i < entry_count; ++i) {
-            state->handle_uuids[i] = INVALID_ID_U64;
-        }
-
-        state->entry_count = entry_count;
-    }
-}
-
 b8 timeline_system_initialize(u64* memory_requirement, void* memory, void* config) {
     if (!memory_requirement) {
         KERROR("timeline_system_initialize requires a valid pointer to memory_requirement.");
@@ -62,42 +44,32 @@ b8 timeline_system_initialize(u64* memory_requirement, void* memory, void* confi
     timeline_system_state* state = memory;
     // TODO: Maybe read this from config?
     const u32 start_entry_count = 4;
-    ensure_allocated(state, start_entry_count); // Prevent lots of early reallocs.
-    state->entry_count = start_entry_count;
+    if (!slot_map_create(sizeof(timeline_data), start_entry_count, &state->timelines)) { // Prevent lots of early reallocs.
+        KERROR("Failed to create timeline storage.");
+        return false;
+    }
 
     // Setup default timelines.
-    timeline_system_create(1.0f); // engine
-    timeline_system_create(1.0f); // game
+    state->engine_timeline = timeline_system_create(1.0f);
+    state->game_timeline = timeline_system_create(1.0f);
 
     return true;
 }
 
 void timeline_system_shutdown(void* state) {
     timeline_system_state* typed_state = state;
-    if (typed_state->timelines) {
-        kfree(typed_state->timelines, sizeof(timeline_data) * typed_state->entry_count, MEMORY_TAG_ARRAY);
-        typed_state->timelines = 0;
-    }
-
-    if (typed_state->handle_uuids) {
-        kfree(typed_state->handle_uuids, sizeof(u64) * typed_state->entry_count, MEMORY_TAG_ARRAY);
-        typed_state->handle_uuids = 0;
-    }
-
-    typed_state->entry_count = 0;
+    slot_map_destroy(&typed_state->timelines);
 }
 
 b8 timeline_system_update(void* state, f32 engine_delta_time) {
     timeline_system_state* typed_state = state;
-    if (typed_state->timelines && typed_state->handle_uuids) {
-        for (u32 i = 0; i < typed_state->entry_count; ++i) {
-            // Only update slots that contain active timelines.
-            if (typed_state->handle_uuids[i] != INVALID_ID_U64) {
-                f32 scaled_delta = (engine_delta_time * typed_state->timelines[i].time_scale);
-                typed_state->timelines[i].delta_time = scaled_delta;
-                typed_state->timelines[i].total_time += scaled_delta;
-            }
-        }
+    // Only active timelines are held, so they can all be updated without checking.
+    timeline_data* timelines = slot_map_elements(&typed_state->timelines);
+    u32 count = slot_map_count(&typed_state->timelines);
+    for (u32 i = 0; i < count; ++i) {
+        f32 scaled_delta = (engine_delta_time * timelines[i].time_scale);
+        timelines[i].delta_time = scaled_delta;
+        timelines[i].total_time += scaled_delta;
     }
 
     return true;
@@ -106,54 +78,25 @@ b8 timeline_system_update(void* state, f32 engine_delta_time) {
 khandle timeline_system_create(f32 scale) {
     khandle new_handle;
     timeline_system_state* state = engine_systems_get()->timeline_system;
-    for (u32 i = 0; i < state->entry_count; ++i) {
-        if (state->handle_uuids[i] == INVALID_ID_U64) {
-            // Found a free slot. Use it.
-            new_handle = khandle_create(i);
-
-            state->handle_uuids[i] = new_handle.unique_id.uniqueid;
-            state->timelines[i].total_time = 0;
-            state->timelines[i].delta_time = 0;
-            state->timelines[i].time_scale = scale;
-
-            return new_handle;
-        }
+    timeline_data* timeline = slot_map_acquire(&state->timelines, &new_handle);
+    if (!timeline) {
+        return khandle_invalid();
     }
 
-    // No free slot available, realloc and use the next new slot.
-    u32 old_count = state->entry_count;
-
-    ensure_allocated(state, old_count * 2);
-
-    // Found a free slot. Use it.
-    new_handle = khandle_create(old_count);
-
-    state->handle_uuids[old_count] = new_handle.unique_id.uniqueid;
-    state->timelines[old_count].total_time = 0;
-    state->timelines[old_count].delta_time = 0;
-    state->timelines[old_count].time_scale = scale;
+    timeline->time_scale = scale;
 
     return new_handle;
 }
 
 void timeline_system_destroy(khandle timeline) {
-    if (timeline.handle_index < 2) {
-        KERROR("timeline_system_destroy cannot be called for default engine or game timelines.");
-        return;
-    }
-    if (khandle_is_invalid(timeline)) {
-        return;
-    }
     timeline_system_state* state = engine_systems_get()->timeline_system;
-    // Check that the passed-in handle is not stale.
-    if (state->handle_uuids[timeline.handle_index] != timeline.unique_id.uniqueid) {
-        // It's stale, do nothing.
+    if (timeline.handle_index == state->engine_timeline.handle_index || timeline.handle_index == state->game_timeline.handle_index) {
+        KERROR("timeline_system_destroy cannot be called for default engine or game timelines.");
         return;
     }
 
-    // Clear the data and Invalidate the handle.
-    kzero_memory(&state->timelines[timeline.handle_index], sizeof(timeline_data));
-    state->handle_uuids[timeline.handle_index] = INVALID_ID_U64;
+    // Stale or invalid handles are ignored.
+    slot_map_release(&state->timelines, timeline);
 }
 
 static timeline_data* timeline_get_at(khandle timeline) {
@@ -163,16 +106,12 @@ static timeline_data* timeline_get_at(khandle timeline) {
     }
 
     timeline_system_state* state = engine_systems_get()->timeline_system;
-    KASSERT_MSG(timeline.handle_index < state->entry_count, "Provided handle index is out of range.");
-
-    // Check that the passed-in handle is not stale.
-    if (state->handle_uuids[timeline.handle_index] == timeline.unique_id.uniqueid) {
-        return &state->timelines[timeline.handle_index];
+    timeline_data* data = slot_map_get(&state->timelines, timeline);
+    if (!data) {
+        // Stale, return null.
+        KWARN("Attempting to get a timeline with a stale handle. No timeline will be returned.");
     }
-
-    // Stale, return null.
-    KWARN("Attempting to get a timeline with a stale handle. No timeline will be returned.");
-    return 0;
+    return data;
 }
 
 f32 timeline_system_scale_get(khandle timeline) {
@@ -183,8 +122,9 @@ f32 timeline_system_scale_get(khandle timeline) {
     return data->time_scale;
 }
 void timeline_system_scale_set(khandle timeline, f32 scale) {
-    if (timeline.handle_index == 0) {
-        // NOTE: 0 is always the engine scale, which should never be modified!
+    timeline_system_state* state = engine_systems_get()->timeline_system;
+    if (timeline.handle_index == state->engine_timeline.handle_index) {
+        // NOTE: The engine scale should never be modified!
         KWARN("timeline_system_scale_set cannot be used against the default engine timeline");
         return;
     }
@@ -212,16 +152,10 @@ f32 timeline_system_delta_get(khandle timeline) {
 
 khandle timeline_system_get_engine(void) {
     timeline_system_state* state = engine_systems_get()->timeline_system;
-    khandle handle;
-    handle.handle_index = 0;
-    handle.unique_id.uniqueid = state->handle_uuids[0];
-    return handle;
+    return state->engine_timeline;
 }
 
 khandle timeline_system_get_game(void) {
     timeline_system_state* state = engine_systems_get()->timeline_system;
-    khandle handle;
-    handle.handle_index = 1;
-    handle.unique_id.uniqueid = state->handle_uuids[1];
-    return handle;
+    return state->game_timeline;
 }
@@ -11,6 +11,7 @@
 #include "platform/filesystem.h"
 #include "platform/kpackage.h"
 #include "strings/kstring.h"
+#include "threads/job_system.h"
 #include "utils/render_type_utils.h"
 
 /*
@@ -27,6 +28,9 @@ static i16 get_option_index(const char* name, u8 option_count, const import_opti
 static const char* get_option_value(const char* name, u8 option_count, const import_option* options);
 static b8 extension_is_audio(const char* extension);
 static b8 extension_is_image(const char* extension);
+static void import_manifest_assets_independent(u32 start, u32 end, void* context);
+static b8 import_is_independent(const char* source_path);
+static b8 import_manifest_asset(const asset_manifest* manifest, const asset_manifest_asset* asset);
 
 b8 obj_2_ksm(const char* source_path, const char* target_path, const char* mtl_target_dir, const char* package_name) {
     KDEBUG("Executing %s...", __FUNCTION__);
@@ -222,72 +226,86 @@ b8 import_all_from_manifest(const char* manifest_path) {
 
     KINFO("Asset manifest '%s' has a total listing of %u assets.", manifest_path, asset_count);
 
+    // Imports which only write their own asset run in parallel on the job system (if it is
+    // running). The rest may write files shared with other imports (i.e. the materials of a
+    // mesh), so they run one at a time afterward.
+    job_system_parallel_for(asset_count, 1, import_manifest_assets_independent, &manifest);
     for (u32 i = 0; i < asset_count; ++i) {
         asset_manifest_asset* asset = &manifest.assets[i];
         if (!asset->source_path) {
             KTRACE("Asset '%s' (%s) does NOT have a source_path. Nothing to import.", kname_string_get(asset->name), asset->path);
-        } else {
-            KINFO("Asset '%s' (%s) DOES have a source_path of '%s'. Importing...", kname_string_get(asset->name), asset->path, asset->source_path);
-
-            // The source file extension dictates what importer is used.
-            const char* source_extension = string_extension_from_path(asset->source_path, true);
-            if (!source_extension) {
-                KWARN("Unable to determine source extension for path '%s'. Skipping import.", asset->source_path);
-                continue;
-            }
-
-            if (strings_equali(source_extension, ".obj")) {
-                // NOTE: Using defaults for this.
-                const char* mtl_target_dir = string_format("%s/%s", manifest.path, "assets/materials/");
-                const char* package_name = kname_string_get(manifest.name);
-
-                if (!obj_2_ksm(asset->source_path, asset->path, mtl_target_dir, package_name)) {
-                    goto import_all_from_manifest_cleanup;
-                }
-            } else if (strings_equali(source_extension, ".mtl")) {
-                const char* mtl_target_dir = string_directory_from_path(asset->path);
-                if (!mtl_target_dir) {
-                    KERROR("mtl_2_kmt requires property 'mtl_target_path' to be set.");
-                    goto import_all_from_manifest_cleanup;
-                }
-
-                const char* package_name = kname_string_get(manifest.name);
-                if (!mtl_2_kmt(asset->source_path, asset->path, mtl_target_dir, package_name)) {
-                    goto import_all_from_manifest_cleanup;
-                }
-            } else if (extension_is_audio(source_extension)) {
-                if (!source_audio_2_kaf(asset->source_path, asset->path)) {
-                    goto import_all_from_manifest_cleanup;
-                }
-            } else if (extension_is_image(source_extension)) {
-                // Always assume y should be flipped on import.
-                b8 flip_y = true;
-                // NOTE: When importing this way, always use the pixel format as provided by the asset.
-                kpixel_format output_format = KPIXEL_FORMAT_UNKNOWN;
-
-                if (!source_image_2_kbi(asset->source_path, asset->path, flip_y, output_format)) {
-                    goto import_all_from_manifest_cleanup;
-                }
-            } else if (strings_equali(source_extension, ".fnt")) {
-                if (!fnt_2_kbf(asset->source_path, asset->path)) {
-                    goto import_all_from_manifest_cleanup;
-                }
-            } else {
-                KERROR("Unknown file extension (%s) provided in import path '%s'", source_extension, asset->source_path);
-                goto import_all_from_manifest_cleanup;
-            }
-
-        import_all_from_manifest_cleanup:
-
-            if (source_extension) {
-                string_free(source_extension);
-            }
+        } else if (!import_is_independent(asset->source_path)) {
+            import_manifest_asset(&manifest, asset);
         }
     }
 
     return true;
 }
 
+static void import_manifest_assets_independent(u32 start, u32 end, void* context) {
+    const asset_manifest* manifest = context;
+    for (u32 i = start; i < end; ++i) {
+        const asset_manifest_asset* asset = &manifest->assets[i];
+        if (asset->source_path && import_is_independent(asset->source_path)) {
+            import_manifest_asset(manifest, asset);
+        }
+    }
+}
+
+static b8 import_is_independent(const char* source_path) {
+    const char* source_extension = string_extension_from_path(source_path, true);
+    if (!source_extension) {
+        return false;
+    }
+    b8 independent = extension_is_audio(source_extension) || extension_is_image(source_extension);
+    string_free(source_extension);
+    return independent;
+}
+
+static b8 import_manifest_asset(const asset_manifest* manifest, const asset_manifest_asset* asset) {
+    KINFO("Asset '%s' (%s) DOES have a source_path of '%s'. Importing...", kname_string_get(asset->name), asset->path, asset->source_path);
+
+    // The source file extension dictates what importer is used.
+    const char* source_extension = string_extension_from_path(asset->source_path, true);
+    if (!source_extension) {
+        KWARN("Unable to determine source extension for path '%s'. Skipping import.", asset->source_path);
+        return false;
+    }
+
+    b8 result = false;
+    if (strings_equali(source_extension, ".obj")) {
+        // NOTE: Using defaults for this.
+        const char* mtl_target_dir = string_format("%s/%s", manifest->path, "assets/materials/");
+        const char* package_name = kname_string_get(manifest->name);
+
+        result = obj_2_ksm(asset->source_path, asset->path, mtl_target_dir, package_name);
+    } else if (strings_equali(source_extension, ".mtl")) {
+        const char* mtl_target_dir = string_directory_from_path(asset->path);
+        if (!mtl_target_dir) {
+            KERROR("mtl_2_kmt requires property 'mtl_target_path' to be set.");
+        } else {
+            const char* package_name = kname_string_get(manifest->name);
+            result = mtl_2_kmt(asset->source_path, asset->path, mtl_target_dir, package_name);
+        }
+    } else if (extension_is_audio(source_extension)) {
+        result = source_audio_2_kaf(asset->source_path, asset->path);
+    } else if (extension_is_image(source_extension)) {
+        // Always assume y should be flipped on import.
+        b8 flip_y = true;
+        // NOTE: When importing this way, always use the pixel format as provided by the asset.
+        kpixel_format output_format = KPIXEL_FORMAT_UNKNOWN;
+
+        result = source_image_2_kbi(asset->source_path, asset->path, flip_y, output_format);
+    } else if (strings_equali(source_extension, ".fnt")) {
+        result = fnt_2_kbf(asset->source_path, asset->path);
+    } else {
+        KERROR("Unknown file extension (%s) provided in import path '%s'", source_extension, asset->source_path);
+    }
+
+    string_free(source_extension);
+    return result;
+}
+
 // Returns the index of the option. -1 if not found.
 static i16 get_option_index(const char* name, u8 option_count, const import_option* options) {
     if (!name || !option_count || !options) {
@@ -0,0 +1,272 @@
+#include "kpackage_builder.h"
+
+#include "containers/darray.h"
+#include "logger.h"
+#include "memory/kmemory.h"
+#include "platform/filesystem.h"
+#include "platform/kpackage.h"
+#include "strings/kname.h"
+#include "strings/kstring.h"
+#include "threads/job_system.h"
+#include "utils/crc64.h"
+#include "utils/klz.h"
+#include "utils/ksort.h"
+
+// Assets smaller than this are never compressed, as there is too little to gain.
+#define COMPRESSION_MIN_SIZE 512
+
+// Types of asset which are never compressed. Everything else is, as raw pixels, vertices, PCM audio,
+// glyph data and text all compress well. Formats which are already compressed would only be made slower to load.
+static const char* uncompressed_extensions[] = {
+    "png",
+    "jpg",
+    "ogg",
+    "mp3",
+    "kpackage",
+};
+
+typedef struct package_asset {
+    const asset_manifest_asset* source;
+    file_mapping mapping;
+    kpackage_binary_entry entry;
+    // If compressed, the data to store in place of the mapping.
+    u8* stored;
+} package_asset;
+
+typedef struct compress_context {
+    const u8* data;
+    u64 size;
+    // Each block is compressed into its own slot of this size in blocks.
+    u64 slot_size;
+    u8* blocks;
+    u32* block_sizes;
+} compress_context;
+
+static b8 compression_wanted(const char* path) {
+    b8 result = true;
+    const char* extension = string_extension_from_path(path, false);
+    if (extension) {
+        for (u32 i = 0; i < sizeof(uncompressed_extensions) / sizeof(const char*); ++i) {
+            if (strings_equali(extension, uncompressed_extensions[i])) {
+                result = false;
+                break;
+            }
+        }
+        string_free(extension);
+    }
+    return result;
+}
+
+static void compress_blocks(u32 start, u32 end, void* context) {
+    compress_context* ctx = context;
+    for (u32 i = start; i < end; ++i) {
+        u64 offset = (u64)i * KPACKAGE_BINARY_BLOCK_SIZE;
+        u64 size = KMIN(ctx->size - offset, (u64)KPACKAGE_BINARY_BLOCK_SIZE);
+        u8* slot = ctx->blocks + ctx->slot_size * i;
+        // Only accept blocks which get smaller; the rest are stored as-is.
+        u64 compressed_size = klz_compress(ctx->data + offset, size, slot, size - 1);
+        if (compressed_size) {
+            ctx->block_sizes[i] = (u32)compressed_size;
+        } else {
+            kcopy_memory(slot, ctx->data + offset, size);
+            ctx->block_sizes[i] = (u32)size | KPACKAGE_BINARY_BLOCK_STORED_BIT;
+        }
+    }
+}
+
+// Compresses the asset's data in blocks, spread across the job system. Keeps the result
+// only if it is worth it.
+static void asset_compress(package_asset* a) {
+    u64 size = a->mapping.size;
+    u32 block_count = (u32)((size + KPACKAGE_BINARY_BLOCK_SIZE - 1) / KPACKAGE_BINARY_BLOCK_SIZE);
+
+    compress_context context = {0};
+    context.data = a->mapping.data;
+    context.size = size;
+    context.slot_size = KMIN(size, (u64)KPACKAGE_BINARY_BLOCK_SIZE);
+    context.blocks = kallocate(context.slot_size * block_count, MEMORY_TAG_ARRAY);
+    context.block_sizes = kallocate(sizeof(u32) * block_count, MEMORY_TAG_ARRAY);
+    job_system_parallel_for(block_count, 1, compress_blocks, &context);
+
+    // Pack the block table and blocks together.
+    u64 stored_size = sizeof(u32) * block_count;
+    for (u32 i = 0; i < block_count; ++i) {
+        stored_size += context.block_sizes[i] & ~KPACKAGE_BINARY_BLOCK_STORED_BIT;
+    }
+    // Decompressing costs time, so it has to save a reasonable amount of space.
+    if (stored_size < size - size / 16) {
+        a->stored = kallocate(stored_size, MEMORY_TAG_ARRAY);
+        kcopy_memory(a->stored, context.block_sizes, sizeof(u32) * block_count);
+        u64 offset = sizeof(u32) * block_count;
+        for (u32 i = 0; i < block_count; ++i) {
+            u64 block_size = context.block_sizes[i] & ~KPACKAGE_BINARY_BLOCK_STORED_BIT;
+            kcopy_memory(a->stored + offset, context.blocks + context.slot_size * i, block_size);
+            offset += block_size;
+        }
+        a->entry.stored_size = stored_size;
+        a->entry.flags |= KPACKAGE_BINARY_ENTRY_FLAG_COMPRESSED_BIT;
+    }
+
+    kfree(context.blocks, context.slot_size * block_count, MEMORY_TAG_ARRAY);
+    kfree(context.block_sizes, sizeof(u32) * block_count, MEMORY_TAG_ARRAY);
+}
+
+// Writes zeroes to the file until it reaches the given offset.
+static b8 write_padding(file_handle* f, u64* offset, u64 target) {
+    static const u8 zeroes[KPACKAGE_BINARY_ALIGNMENT] = {0};
+    while (*offset < target) {
+        u64 size = KMIN(target - *offset, (u64)KPACKAGE_BINARY_ALIGNMENT);
+        u64 written = 0;
+        if (!filesystem_write(f, size, zeroes, &written) || written != size) {
+            return false;
+        }
+        *offset += size;
+    }
+    return true;
+}
+
+static b8 write_block(file_handle* f, u64* offset, u64 size, const void* data) {
+    if (!size) {
+        return true;
+    }
+    u64 written = 0;
+    if (!filesystem_write(f, size, data, &written) || written != size) {
+        return false;
+    }
+    *offset += size;
+    return true;
+}
+
+b8 kpackage_build_from_manifest(const char* manifest_path, const char* out_path, b8 compress) {
+    asset_manifest manifest = {0};
+    if (!kpackage_parse_manifest_file_content(manifest_path, &manifest)) {
+        KERROR("Failed to parse asset manifest '%s'. See logs for details.", manifest_path);
+        return false;
+    }
+
+    b8 success = false;
+    u32 asset_count = manifest.assets ? darray_length(manifest.assets) : 0;
+    package_asset* assets = asset_count ? kallocate(sizeof(package_asset) * asset_count, MEMORY_TAG_ARRAY) : 0;
+    package_asset* sorted = asset_count ? kallocate(sizeof(package_asset) * asset_count, MEMORY_TAG_ARRAY) : 0;
+    u64* names = asset_count ? kallocate(sizeof(u64) * asset_count, MEMORY_TAG_ARRAY) : 0;
+    u32* order = asset_count ? kallocate(sizeof(u32) * asset_count, MEMORY_TAG_ARRAY) : 0;
+    char* strings = 0;
+    const char* package_path = out_path ? string_duplicate(out_path) : string_format("%s/%s.kpackage", manifest.path, kname_string_get(manifest.name));
+    file_handle f = {0};
+
+    // Map every asset, which gives its size and lets its hash be taken without copying it.
+    for (u32 i = 0; i < asset_count; ++i) {
+        package_asset* a = &assets[i];
+        a->source = &manifest.assets[i];
+        if (!filesystem_map(a->source->path, &a->mapping)) {
+            // Empty files can't be mapped, but are still valid assets.
+            if (!filesystem_exists(a->source->path)) {
+                KERROR("Asset '%s' does not exist at path '%s'.", kname_string_get(a->source->name), a->source->path);
+                goto build_cleanup;
+            }
+        }
+        a->entry.name = a->source->name;
+        a->entry.size = a->mapping.size;
+        a->entry.stored_size = a->mapping.size;
+        a->entry.content_hash = crc64(0, a->mapping.data, a->mapping.size);
+        a->entry.flags = KPACKAGE_BINARY_ENTRY_FLAG_NONE;
+        names[i] = a->entry.name;
+
+        if (compress && a->mapping.size >= COMPRESSION_MIN_SIZE && compression_wanted(a->source->path)) {
+            asset_compress(a);
+        }
+    }
+
+    // Sort the table of contents by name.
+    if (asset_count) {
+        kradix_sort_u64_indices(names, asset_count, order, 0);
+        ksort_gather(sizeof(package_asset), assets, order, asset_count, sorted);
+    }
+
+    // Build the string table, starting with the package name.
+    u64 strings_size = string_length(kname_string_get(manifest.name)) + 1;
+    for (u32 i = 0; i < asset_count; ++i) {
+        strings_size += string_length(kname_string_get(sorted[i].entry.name)) + 1;
+    }
+    strings = kallocate(strings_size, MEMORY_TAG_STRING);
+    u64 string_offset = 0;
+    const char* package_name = kname_string_get(manifest.name);
+    u32 package_name_offset = (u32)string_offset;
+    kcopy_memory(strings + string_offset, package_name, string_length(package_name) + 1);
+    string_offset += string_length(package_name) + 1;
+    for (u32 i = 0; i < asset_count; ++i) {
+        const char* name = kname_string_get(sorted[i].entry.name);
+        sorted[i].entry.name_offset = (u32)string_offset;
+        kcopy_memory(strings + string_offset, name, string_length(name) + 1);
+        string_offset += string_length(name) + 1;
+    }
+
+    // Lay out the file. Each asset starts on an aligned boundary so it can be used in place once mapped.
+    kpackage_binary_header header = {0};
+    header.magic = KPACKAGE_BINARY_MAGIC;
+    header.version = KPACKAGE_BINARY_VERSION;
+    header.name = manifest.name;
+    header.entry_count = asset_count;
+    header.name_offset = package_name_offset;
+    header.toc_offset = sizeof(kpackage_binary_header);
+    header.strings_offset = header.toc_offset + sizeof(kpackage_binary_entry) * asset_count;
+    header.strings_size = strings_size;
+    header.payload_offset = get_aligned(header.strings_offset + strings_size, KPACKAGE_BINARY_ALIGNMENT);
+    u64 offset = header.payload_offset;
+    for (u32 i = 0; i < asset_count; ++i) {
+        sorted[i].entry.offset = offset;
+        offset = get_aligned(offset + sorted[i].entry.stored_size, KPACKAGE_BINARY_ALIGNMENT);
+    }
+    header.file_size = asset_count ? sorted[asset_count - 1].entry.offset + sorted[asset_count - 1].entry.stored_size : header.payload_offset;
+
+    // Write it out.
+    if (!filesystem_open(package_path, FILE_MODE_WRITE, true, &f)) {
+        KERROR("Failed to open binary package '%s' for writing.", package_path);
+        goto build_cleanup;
+    }
+    u64 written = 0;
+    b8 write_result = write_block(&f, &written, sizeof(header), &header);
+    for (u32 i = 0; i < asset_count && write_result; ++i) {
+        write_result = write_block(&f, &written, sizeof(kpackage_binary_entry), &sorted[i].entry);
+    }
+    write_result = write_result && write_block(&f, &written, strings_size, strings);
+    for (u32 i = 0; i < asset_count && write_result; ++i) {
+        const void* data = sorted[i].stored ? sorted[i].stored : sorted[i].mapping.data;
+        write_result = write_padding(&f, &written, sorted[i].entry.offset) &&
+                       write_block(&f, &written, sorted[i].entry.stored_size, data);
+    }
+    if (!write_result) {
+        KERROR("Failed to write binary package '%s'.", package_path);
+        goto build_cleanup;
+    }
+
+    u64 total_size = 0;
+    u32 compressed_count = 0;
+    for (u32 i = 0; i < asset_count; ++i) {
+        total_size += sorted[i].entry.size;
+        compressed_count += sorted[i].stored ? 1 : 0;
+    }
+    KINFO("Built binary package '%s' with %u assets (%u compressed): %llu bytes of assets in %llu bytes.", package_path, asset_count, compressed_count, total_size, header.file_size);
+    success = true;
+
+build_cleanup:
+    filesystem_close(&f);
+    for (u32 i = 0; i < asset_count; ++i) {
+        filesystem_unmap(&assets[i].mapping);
+        if (assets[i].stored) {
+            kfree(assets[i].stored, assets[i].entry.stored_size, MEMORY_TAG_ARRAY);
+        }
+    }
+    if (asset_count) {
+        kfree(assets, sizeof(package_asset) * asset_count, MEMORY_TAG_ARRAY);
+        kfree(sorted, sizeof(package_asset) * asset_count, MEMORY_TAG_ARRAY);
+        kfree(names, sizeof(u64) * asset_count, MEMORY_TAG_ARRAY);
+        kfree(order, sizeof(u32) * asset_count, MEMORY_TAG_ARRAY);
+    }
+    if (strings) {
+        kfree(strings, strings_size, MEMORY_TAG_STRING);
+    }
+    string_free(package_path);
+    kpackage_manifest_destroy(&manifest);
+    return success;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <defines.h>
+
+/**
+ * Builds a binary package (.kpackage) holding every asset listed in the asset manifest
+ * at the given path, so the package can be loaded from a single file. See kpackage_binary_header
+ * for the format.
+ *
+ * @param manifest_path The path to the asset manifest of the package.
+ * @param out_path The path to write the binary package to. If 0, it is written alongside the
+ * manifest as "<package name>.kpackage", which is where the VFS looks for it.
+ * @param compress Indicates if assets should be compressed, for those types which benefit from it.
+ * @returns True on success; otherwise false.
+ */
+b8 kpackage_build_from_manifest(const char* manifest_path, const char* out_path, b8 compress);
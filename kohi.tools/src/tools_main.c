@@ -1,8 +1,10 @@
 #include <containers/darray.h>
 #include <defines.h>
 #include <logger.h>
+#include <memory/kmemory.h>
 #include <stdio.h>
 #include <strings/kstring.h>
+#include <threads/job_system.h>
 #include <utils/crc64.h>
 
 // For executing shell commands.
@@ -15,9 +17,12 @@
 #include "vendor/stb_image_write.h"
 
 #include "kasset_importer.h"
+#include "kpackage_builder.h"
 
 void print_help(void);
 i32 combine_texture_maps(i32 argc, char** argv);
+static void* job_system_start(i32 argc, char** argv, u64* out_memory_requirement);
+static void job_system_stop(void* state, u64 memory_requirement);
 
 // sed -E 's|(KNAME\(\")(.*?)(\"\))|echo "value of: \2"|g' file.c
 // sed -E 's|(KNAME\(\")(.*?)(\"\))|../kohi.tools -crc "\1"|ge' ../kohi.runtime/src/core/metrics.h
@@ -47,11 +52,39 @@ i32 main(i32 argc, char** argv) {
             return -3;
         }
         const char* manifest_path = argv[2];
-        if (!import_all_from_manifest(manifest_path)) {
+        u64 job_system_memory_requirement = 0;
+        void* job_system_state = job_system_start(argc, argv, &job_system_memory_requirement);
+        b8 result = import_all_from_manifest(manifest_path);
+        job_system_stop(job_system_state, job_system_memory_requirement);
+        if (!result) {
             KERROR("Manifest import error. See logs for details.");
             return -4;
         }
 
+    } else if (strings_equali(argv[1], "buildpackage") || strings_equali(argv[1], "bpkg")) {
+        if (argc < 3) {
+            KERROR("buildpackage command requires an argument specifying the manifest path.");
+            return -3;
+        }
+        const char* out_path = 0;
+        b8 compress = true;
+        for (i32 i = 3; i < argc; ++i) {
+            if (strings_equali(argv[i], "compression=off")) {
+                compress = false;
+            } else if (!string_starts_withi(argv[i], "compression=") && !string_starts_withi(argv[i], "threads=")) {
+                out_path = argv[i];
+            }
+        }
+        // Assets are compressed in blocks spread across all cores.
+        u64 job_system_memory_requirement = 0;
+        void* job_system_state = job_system_start(argc, argv, &job_system_memory_requirement);
+        b8 result = kpackage_build_from_manifest(argv[2], out_path, compress);
+        job_system_stop(job_system_state, job_system_memory_requirement);
+        if (!result) {
+            KERROR("Package build error. See logs for details.");
+            return -4;
+        }
+
     } else {
         KERROR("Unrecognized argument '%s'.", argv[1]);
         print_help();
@@ -61,6 +94,37 @@ i32 main(i32 argc, char** argv) {
     return 0;
 }
 
+// Starts the job system, so work can be spread across all cores. An optional "threads=N" argument
+// sets the number of job threads; otherwise it suits the machine. Returns the state, or 0 if the
+// job system could not be started, in which case work just runs on this thread.
+static void* job_system_start(i32 argc, char** argv, u64* out_memory_requirement) {
+    job_system_config config = {0};
+    for (i32 i = 3; i < argc; ++i) {
+        if (string_starts_withi(argv[i], "threads=")) {
+            if (!string_to_u8(argv[i] + 8, &config.max_job_thread_count)) {
+                KWARN("Invalid thread count '%s'. Using the default.", argv[i] + 8);
+                config.max_job_thread_count = 0;
+            }
+        }
+    }
+
+    job_system_initialize(out_memory_requirement, 0, &config);
+    void* state = kallocate(*out_memory_requirement, MEMORY_TAG_ENGINE);
+    if (!job_system_initialize(out_memory_requirement, state, &config)) {
+        KWARN("Failed to start the job system. Work will run on the main thread only.");
+        kfree(state, *out_memory_requirement, MEMORY_TAG_ENGINE);
+        return 0;
+    }
+    return state;
+}
+
+static void job_system_stop(void* state, u64 memory_requirement) {
+    if (state) {
+        job_system_shutdown(state);
+        kfree(state, memory_requirement, MEMORY_TAG_ENGINE);
+    }
+}
+
 typedef enum map_type {
     MAP_TYPE_METALLIC,
     MAP_TYPE_ROUGHNESS,
@@ -219,6 +283,17 @@ void print_help(void) {
   usage:  tools%s <mode> [arguments...]\n\
   \n\
   modes:\n\
+    importmanifest - Imports every asset with a source_path in the given manifest,\n\
+                    using all cores. For example:\n\
+                        importmanifest <manifest path> [threads=N]\n\
+                    threads sets the number of worker threads to use (default: one per\n\
+                    physical core, less one).\n\
+    buildpackage -  Builds a binary package holding every asset in the given manifest,\n\
+                    so it may be loaded from a single file. For example:\n\
+                        buildpackage <manifest path> [output path] [compression=on|off] [threads=N]\n\
+                    By default, the package is written alongside the manifest as\n\
+                    <package name>.kpackage, where it is picked up in place of the manifest.\n\
+                    Assets are compressed by default, depending on their type.\n\
     buildshaders -  Builds shaders provided in arguments. For example,\n\
                     to compile Vulkan shaders to .spv from GLSL, a list of filenames\n\
                     should be provided that all end in <stage>.glsl, where <stage> is\n\